@@ -0,0 +1,56 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "api/audio/audio_frame_pool.h"
+
+#include <limits>
+
+namespace webrtc {
+
+AudioFramePool::AudioFramePool()
+    : AudioFramePool(std::numeric_limits<size_t>::max()) {}
+AudioFramePool::AudioFramePool(size_t max_number_of_frames)
+    : max_number_of_frames_(max_number_of_frames) {}
+AudioFramePool::~AudioFramePool() = default;
+
+void AudioFramePool::Release() {
+  rtc::CritScope lock(&crit_);
+  frames_.clear();
+}
+
+AudioFramePool::Stats AudioFramePool::GetStats() const {
+  rtc::CritScope lock(&crit_);
+  return stats_;
+}
+
+rtc::scoped_refptr<SharedAudioFrame> AudioFramePool::CreateFrame() {
+  rtc::CritScope lock(&crit_);
+  for (const rtc::scoped_refptr<PooledAudioFrame>& frame : frames_) {
+    // If the frame is in use, the ref count will be >= 2, one from the list we
+    // are looping over and one from the application. If the ref count is 1,
+    // then the list we are looping over holds the only reference and it's safe
+    // to reuse.
+    if (frame->HasOneRef()) {
+      frame->mutable_frame()->ResetWithoutMuting();
+      ++stats_.num_reused_frames;
+      return frame;
+    }
+  }
+
+  if (frames_.size() >= max_number_of_frames_)
+    return nullptr;
+  // Allocate new frame.
+  rtc::scoped_refptr<PooledAudioFrame> frame = new PooledAudioFrame();
+  frames_.push_back(frame);
+  ++stats_.num_allocated_frames;
+  return frame;
+}
+
+}  // namespace webrtc
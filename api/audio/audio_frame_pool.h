@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef API_AUDIO_AUDIO_FRAME_POOL_H_
+#define API_AUDIO_AUDIO_FRAME_POOL_H_
+
+#include <vector>
+
+#include "api/audio/audio_frame.h"
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/refcount.h"
+#include "rtc_base/refcountedobject.h"
+#include "rtc_base/scoped_ref_ptr.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// An AudioFrame that is shared by reference instead of being copied, e.g. by
+// all the streams that send the same captured audio. It is filled through
+// mutable_frame() by the holder of the only reference, and must not be
+// modified once it has been shared.
+class SharedAudioFrame : public rtc::RefCountInterface {
+ public:
+  const AudioFrame& frame() const { return frame_; }
+  AudioFrame* mutable_frame() { return &frame_; }
+
+ protected:
+  SharedAudioFrame() = default;
+  ~SharedAudioFrame() override = default;
+
+ private:
+  AudioFrame frame_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(SharedAudioFrame);
+};
+
+// Simple pool to avoid allocating a SharedAudioFrame every 10 ms on the audio
+// thread. When the last reference to a frame returned from CreateFrame is
+// released, the frame is returned to the pool for use by subsequent calls to
+// CreateFrame. The pool is thread safe, and the frames may be released on any
+// thread, e.g. on the task queues that encode them.
+class AudioFramePool {
+ public:
+  struct Stats {
+    // Number of frames allocated by CreateFrame.
+    int num_allocated_frames = 0;
+    // Number of frames CreateFrame returned from the pool.
+    int num_reused_frames = 0;
+  };
+
+  AudioFramePool();
+  explicit AudioFramePool(size_t max_number_of_frames);
+  ~AudioFramePool();
+
+  // Returns a frame that no one else references. A frame returned from the
+  // pool is reset with AudioFrame::ResetWithoutMuting(), so its samples must be
+  // written before they are read. If all the frames of the pool are in use and
+  // there are less than |max_number_of_frames|, a frame is created. Returns
+  // null otherwise.
+  rtc::scoped_refptr<SharedAudioFrame> CreateFrame();
+  // Clears all frames. Frames in use are freed when they are released.
+  void Release();
+
+  Stats GetStats() const;
+
+ private:
+  // Explicitly use a RefCountedObject to get access to HasOneRef,
+  // needed by the pool to check exclusive access.
+  using PooledAudioFrame = rtc::RefCountedObject<SharedAudioFrame>;
+
+  rtc::CriticalSection crit_;
+  std::vector<rtc::scoped_refptr<PooledAudioFrame>> frames_
+      RTC_GUARDED_BY(crit_);
+  Stats stats_ RTC_GUARDED_BY(crit_);
+  // Max number of frames this pool can have pending.
+  const size_t max_number_of_frames_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(AudioFramePool);
+};
+
+}  // namespace webrtc
+
+#endif  // API_AUDIO_AUDIO_FRAME_POOL_H_
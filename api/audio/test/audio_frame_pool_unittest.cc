@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2018 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "api/audio/audio_frame_pool.h"
+
+#include "test/gtest.h"
+
+namespace webrtc {
+
+TEST(AudioFramePoolTest, SimpleFrameReuse) {
+  AudioFramePool pool;
+  rtc::scoped_refptr<SharedAudioFrame> frame = pool.CreateFrame();
+  ASSERT_TRUE(frame);
+  const SharedAudioFrame* frame_ptr = frame.get();
+  frame = nullptr;
+  frame = pool.CreateFrame();
+  EXPECT_EQ(frame_ptr, frame.get());
+
+  AudioFramePool::Stats stats = pool.GetStats();
+  EXPECT_EQ(1, stats.num_allocated_frames);
+  EXPECT_EQ(1, stats.num_reused_frames);
+}
+
+TEST(AudioFramePoolTest, FailToReuseSharedFrame) {
+  AudioFramePool pool;
+  rtc::scoped_refptr<SharedAudioFrame> frame = pool.CreateFrame();
+  rtc::scoped_refptr<const SharedAudioFrame> shared_frame = frame;
+  frame = nullptr;
+  frame = pool.CreateFrame();
+  EXPECT_NE(shared_frame.get(), frame.get());
+  EXPECT_EQ(2, pool.GetStats().num_allocated_frames);
+}
+
+TEST(AudioFramePoolTest, ReusedFrameIsReset) {
+  AudioFramePool pool;
+  rtc::scoped_refptr<SharedAudioFrame> frame = pool.CreateFrame();
+  AudioFrame* audio_frame = frame->mutable_frame();
+  audio_frame->timestamp_ = 27;
+  audio_frame->samples_per_channel_ = 160;
+  audio_frame->vad_activity_ = AudioFrame::kVadActive;
+  frame = nullptr;
+
+  frame = pool.CreateFrame();
+  EXPECT_EQ(0u, frame->frame().timestamp_);
+  EXPECT_EQ(0u, frame->frame().samples_per_channel_);
+  EXPECT_EQ(AudioFrame::kVadUnknown, frame->frame().vad_activity_);
+}
+
+TEST(AudioFramePoolTest, MaxNumberOfFrames) {
+  AudioFramePool pool(1);
+  rtc::scoped_refptr<SharedAudioFrame> frame = pool.CreateFrame();
+  EXPECT_TRUE(frame);
+  EXPECT_FALSE(pool.CreateFrame());
+}
+
+TEST(AudioFramePoolTest, FrameOutlivesPool) {
+  rtc::scoped_refptr<SharedAudioFrame> frame;
+  {
+    AudioFramePool pool;
+    frame = pool.CreateFrame();
+  }
+  frame->mutable_frame()->timestamp_ = 27;
+  EXPECT_EQ(27u, frame->frame().timestamp_);
+}
+
+}  // namespace webrtc
@@ -15,5 +15,10 @@ namespace video_coding {
 
 bool EncodedFrame::delayed_by_retransmission() const { return 0; }
 
+rtc::ArrayView<const rtc::ArrayView<const uint8_t>>
+EncodedFrame::GetBitstreamFragments() const {
+  return nullptr;
+}
+
 }  // namespace video_coding
 }  // namespace webrtc
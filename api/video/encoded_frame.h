@@ -11,6 +11,7 @@
 #ifndef API_VIDEO_ENCODED_FRAME_H_
 #define API_VIDEO_ENCODED_FRAME_H_
 
+#include "api/array_view.h"
 #include "modules/video_coding/encoded_frame.h"
 
 namespace webrtc {
@@ -58,6 +59,18 @@ class EncodedFrame : public webrtc::VCMEncodedFrame {
 
   virtual bool GetBitstream(uint8_t* destination) const = 0;
 
+  // The bitstream as a list of fragments, e.g. the payloads of the packets the
+  // frame was received in, for decoders that can consume a fragmented
+  // bitstream without having it copied into one buffer first. Empty if the
+  // frame only has its bitstream in Buffer().
+  virtual rtc::ArrayView<const rtc::ArrayView<const uint8_t>>
+  GetBitstreamFragments() const;
+
+  // Frames may keep their bitstream fragmented until it is needed in one
+  // piece. This makes it available through Buffer(), and must be called before
+  // the frame is passed to a decoder that needs contiguous input.
+  virtual void MakeBitstreamContiguous() {}
+
   // The capture timestamp of this frame.
   virtual uint32_t Timestamp() const = 0;
 
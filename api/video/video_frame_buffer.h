@@ -63,6 +63,13 @@ class VideoFrameBuffer : public rtc::RefCountInterface {
   // software encoders.
   virtual rtc::scoped_refptr<I420BufferInterface> ToI420() = 0;
 
+  // Returns this buffer scaled to |width| x |height|, if the buffer keeps
+  // scaled versions of itself that are shared by everyone asking for the same
+  // resolution, e.g. an I420BufferPyramid. Returns null otherwise, in which
+  // case the caller has to scale the buffer itself.
+  virtual rtc::scoped_refptr<I420BufferInterface> GetScaledI420(int width,
+                                                                int height);
+
   // These functions should only be called if type() is of the correct type.
   // Calling with a different type will result in a crash.
   // TODO(magjed): Return raw pointers for GetI420 once deprecated interface is
@@ -315,7 +315,8 @@ void AudioSendStream::Stop() {
   audio_state()->RemoveSendingStream(this);
 }
 
-void AudioSendStream::SendAudioData(std::unique_ptr<AudioFrame> audio_frame) {
+void AudioSendStream::SendAudioData(
+    rtc::scoped_refptr<const SharedAudioFrame> audio_frame) {
   RTC_CHECK_RUNS_SERIALIZED(&audio_capture_race_checker_);
   channel_proxy_->ProcessAndEncodeAudio(std::move(audio_frame));
 }
@@ -69,7 +69,8 @@ class AudioSendStream final : public webrtc::AudioSendStream,
   void Reconfigure(const webrtc::AudioSendStream::Config& config) override;
   void Start() override;
   void Stop() override;
-  void SendAudioData(std::unique_ptr<AudioFrame> audio_frame) override;
+  void SendAudioData(
+      rtc::scoped_refptr<const SharedAudioFrame> audio_frame) override;
   bool SendTelephoneEvent(int payload_type, int payload_frequency, int event,
                           int duration_ms) override;
   void SetMuted(bool muted) override;
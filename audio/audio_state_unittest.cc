@@ -8,7 +8,12 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <atomic>
+#include <cstdlib>
 #include <memory>
+#include <new>
+#include <set>
+#include <utility>
 #include <vector>
 
 #include "audio/audio_state.h"
@@ -16,9 +21,52 @@
 #include "modules/audio_device/include/mock_audio_device.h"
 #include "modules/audio_mixer/audio_mixer_impl.h"
 #include "modules/audio_processing/include/mock_audio_processing.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread_types.h"
 #include "rtc_base/refcountedobject.h"
+#include "rtc_base/timeutils.h"
 #include "test/gtest.h"
 
+namespace {
+
+// Counts the heap allocations made on one thread while a
+// ScopedAllocationCounter is alive on it.
+std::atomic<bool> g_count_allocations(false);
+rtc::PlatformThreadRef g_counting_thread;
+std::atomic<int> g_allocation_count(0);
+
+void* CountingAlloc(size_t size) {
+  if (g_count_allocations.load(std::memory_order_acquire) &&
+      rtc::IsThreadRefEqual(g_counting_thread, rtc::CurrentThreadRef())) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr)
+    std::abort();
+  return ptr;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountingAlloc(size);
+}
+void* operator new[](size_t size) {
+  return CountingAlloc(size);
+}
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
 namespace webrtc {
 namespace test {
 namespace {
@@ -56,6 +104,20 @@ class FakeAudioSource : public AudioMixer::Source {
                AudioFrameInfo(int sample_rate_hz, AudioFrame* audio_frame));
 };
 
+// Holds on to the last frame until the next one is sent, like a stream whose
+// encoding task hasn't run yet.
+class HoldingSendStream : public MockAudioSendStream {
+ public:
+  void SendAudioData(
+      rtc::scoped_refptr<const SharedAudioFrame> audio_frame) override {
+    last_frame_ = std::move(audio_frame);
+  }
+  const SharedAudioFrame* last_frame() const { return last_frame_.get(); }
+
+ private:
+  rtc::scoped_refptr<const SharedAudioFrame> last_frame_;
+};
+
 std::vector<int16_t> Create10msSilentTestData(int sample_rate_hz,
                                               size_t num_channels) {
   const int samples_per_channel = sample_rate_hz / 100;
@@ -78,7 +140,7 @@ std::vector<int16_t> Create10msTestData(int sample_rate_hz,
   return audio_data;
 }
 
-std::vector<uint32_t> ComputeChannelLevels(AudioFrame* audio_frame) {
+std::vector<uint32_t> ComputeChannelLevels(const AudioFrame* audio_frame) {
   const size_t num_channels = audio_frame->num_channels_;
   const size_t samples_per_channel = audio_frame->samples_per_channel_;
   std::vector<uint32_t> levels(num_channels, 0);
@@ -116,7 +178,7 @@ TEST(AudioStateTest, RecordedAudioArrivesAtSingleStream) {
       testing::Field(&AudioFrame::num_channels_, testing::Eq(2u)))))
           .WillOnce(
               // Verify that channels are not swapped by default.
-              testing::Invoke([](AudioFrame* audio_frame) {
+              testing::Invoke([](const AudioFrame* audio_frame) {
                 auto levels = ComputeChannelLevels(audio_frame);
                 EXPECT_LT(0u, levels[0]);
                 EXPECT_EQ(0u, levels[1]);
@@ -154,7 +216,7 @@ TEST(AudioStateTest, RecordedAudioArrivesAtMultipleStreams) {
       testing::Field(&AudioFrame::num_channels_, testing::Eq(1u)))))
           .WillOnce(
               // Verify that there is output signal.
-              testing::Invoke([](AudioFrame* audio_frame) {
+              testing::Invoke([](const AudioFrame* audio_frame) {
                 auto levels = ComputeChannelLevels(audio_frame);
                 EXPECT_LT(0u, levels[0]);
               }));
@@ -163,7 +225,7 @@ TEST(AudioStateTest, RecordedAudioArrivesAtMultipleStreams) {
       testing::Field(&AudioFrame::num_channels_, testing::Eq(1u)))))
           .WillOnce(
               // Verify that there is output signal.
-              testing::Invoke([](AudioFrame* audio_frame) {
+              testing::Invoke([](const AudioFrame* audio_frame) {
                 auto levels = ComputeChannelLevels(audio_frame);
                 EXPECT_LT(0u, levels[0]);
               }));
@@ -186,6 +248,123 @@ TEST(AudioStateTest, RecordedAudioArrivesAtMultipleStreams) {
   audio_state->RemoveSendingStream(&stream_2);
 }
 
+TEST(AudioStateTest, RecordedAudioFramesAreSharedAndReused) {
+  constexpr int kSampleRate = 16000;
+  constexpr size_t kNumChannels = 1;
+  constexpr size_t kNumStreams = 4;
+
+  ConfigHelper helper;
+  std::unique_ptr<internal::AudioState> audio_state(
+      new internal::AudioState(helper.config()));
+
+  std::vector<std::unique_ptr<HoldingSendStream>> streams;
+  for (size_t i = 0; i < kNumStreams; ++i) {
+    streams.emplace_back(new HoldingSendStream());
+    audio_state->AddSendingStream(streams.back().get(), kSampleRate,
+                                  kNumChannels);
+  }
+
+  auto audio_data = Create10msTestData(kSampleRate, kNumChannels);
+  std::set<const SharedAudioFrame*> frames;
+  for (int i = 0; i < 100; ++i) {
+    uint32_t new_mic_level = 667;
+    audio_state->audio_transport()->RecordedDataIsAvailable(
+        &audio_data[0], kSampleRate / 100, kNumChannels * 2,
+        kNumChannels, kSampleRate, 0, 0, 0, false, new_mic_level);
+    ASSERT_TRUE(streams[0]->last_frame());
+    for (const auto& stream : streams)
+      EXPECT_EQ(streams[0]->last_frame(), stream->last_frame());
+    frames.insert(streams[0]->last_frame());
+  }
+  // The streams hold on to a frame while the next one is recorded, so the
+  // pool hands out two frames and then reuses them.
+  EXPECT_EQ(2u, frames.size());
+
+  for (const auto& stream : streams)
+    audio_state->RemoveSendingStream(stream.get());
+}
+
+TEST(AudioStateTest, RecordedAudioFanOutDoesNotAllocate) {
+  constexpr int kSampleRate = 16000;
+  constexpr size_t kNumChannels = 1;
+  constexpr size_t kNumStreams = 4;
+  constexpr int kNumCallbacks = 100;
+
+  ConfigHelper helper;
+  std::unique_ptr<internal::AudioState> audio_state(
+      new internal::AudioState(helper.config()));
+
+  auto audio_data = Create10msTestData(kSampleRate, kNumChannels);
+  auto count_allocations = [&] {
+    // Let the frame pool fill up before counting.
+    for (int i = 0; i < 10 + kNumCallbacks; ++i) {
+      if (i == 10) {
+        g_counting_thread = rtc::CurrentThreadRef();
+        g_allocation_count = 0;
+        g_count_allocations.store(true, std::memory_order_release);
+      }
+      uint32_t new_mic_level = 667;
+      audio_state->audio_transport()->RecordedDataIsAvailable(
+          &audio_data[0], kSampleRate / 100, kNumChannels * 2,
+          kNumChannels, kSampleRate, 0, 0, 0, false, new_mic_level);
+    }
+    g_count_allocations.store(false, std::memory_order_release);
+    return g_allocation_count.load();
+  };
+
+  // The mock AudioProcessing allocates on every call, so compare against the
+  // same callbacks without any sending streams.
+  const int baseline_allocations = count_allocations();
+
+  std::vector<std::unique_ptr<HoldingSendStream>> streams;
+  for (size_t i = 0; i < kNumStreams; ++i) {
+    streams.emplace_back(new HoldingSendStream());
+    audio_state->AddSendingStream(streams.back().get(), kSampleRate,
+                                  kNumChannels);
+  }
+  EXPECT_EQ(baseline_allocations, count_allocations());
+
+  for (const auto& stream : streams)
+    audio_state->RemoveSendingStream(stream.get());
+}
+
+// Measures the time it takes to process the recorded audio and deliver it to
+// the sending streams.
+// Disabled by default, since it only logs timings.
+TEST(AudioStateTest, DISABLED_RecordedAudioFanOutBenchmark) {
+  constexpr int kSampleRate = 48000;
+  constexpr size_t kNumChannels = 2;
+  constexpr int kNumCallbacks = 10000;
+  auto audio_data = Create10msTestData(kSampleRate, kNumChannels);
+
+  for (size_t num_streams : {1, 4, 16}) {
+    ConfigHelper helper;
+    std::unique_ptr<internal::AudioState> audio_state(
+        new internal::AudioState(helper.config()));
+    std::vector<std::unique_ptr<HoldingSendStream>> streams;
+    for (size_t i = 0; i < num_streams; ++i) {
+      streams.emplace_back(new HoldingSendStream());
+      audio_state->AddSendingStream(streams.back().get(), kSampleRate,
+                                    kNumChannels);
+    }
+
+    const int64_t start_us = rtc::TimeMicros();
+    for (int i = 0; i < kNumCallbacks; ++i) {
+      uint32_t new_mic_level = 667;
+      audio_state->audio_transport()->RecordedDataIsAvailable(
+          &audio_data[0], kSampleRate / 100, kNumChannels * 2,
+          kNumChannels, kSampleRate, 0, 0, 0, false, new_mic_level);
+    }
+    const int64_t elapsed_us = rtc::TimeMicros() - start_us;
+    RTC_LOG(LS_INFO) << num_streams << " sending streams: "
+                     << static_cast<double>(elapsed_us) / kNumCallbacks
+                     << " us per recorded 10 ms.";
+
+    for (const auto& stream : streams)
+      audio_state->RemoveSendingStream(stream.get());
+  }
+}
+
 TEST(AudioStateTest, EnableChannelSwap) {
   constexpr int kSampleRate = 16000;
   constexpr size_t kNumChannels = 2;
@@ -201,7 +380,7 @@ TEST(AudioStateTest, EnableChannelSwap) {
   EXPECT_CALL(stream, SendAudioDataForMock(testing::_))
       .WillOnce(
           // Verify that channels are swapped.
-          testing::Invoke([](AudioFrame* audio_frame) {
+          testing::Invoke([](const AudioFrame* audio_frame) {
             auto levels = ComputeChannelLevels(audio_frame);
             EXPECT_EQ(0u, levels[0]);
             EXPECT_LT(0u, levels[1]);
@@ -11,7 +11,6 @@
 #include "audio/audio_transport_impl.h"
 
 #include <algorithm>
-#include <memory>
 #include <utility>
 
 #include "audio/remix_resample.h"
@@ -124,16 +123,19 @@ int32_t AudioTransportImpl::RecordedDataIsAvailable(
     swap_stereo_channels = swap_stereo_channels_;
   }
 
-  std::unique_ptr<AudioFrame> audio_frame(new AudioFrame());
+  // The pool has no limit on the number of frames, so it always returns one.
+  rtc::scoped_refptr<SharedAudioFrame> shared_frame =
+      capture_frame_pool_.CreateFrame();
+  AudioFrame* audio_frame = shared_frame->mutable_frame();
   InitializeCaptureFrame(sample_rate, send_sample_rate_hz,
                          number_of_channels, send_num_channels,
-                         audio_frame.get());
+                         audio_frame);
   voe::RemixAndResample(static_cast<const int16_t*>(audio_data),
                         number_of_frames, number_of_channels, sample_rate,
-                        &capture_resampler_, audio_frame.get());
+                        &capture_resampler_, audio_frame);
   ProcessCaptureFrame(audio_delay_milliseconds, key_pressed,
                       swap_stereo_channels, audio_processing_,
-                      audio_frame.get());
+                      audio_frame);
 
   // Typing detection (utilizes the APM/VAD decision). We let the VAD determine
   // if we're using this feature or not.
@@ -148,25 +150,17 @@ int32_t AudioTransportImpl::RecordedDataIsAvailable(
 
   // Measure audio level of speech after all processing.
   double sample_duration = static_cast<double>(number_of_frames) / sample_rate;
-  audio_level_.ComputeLevel(*audio_frame.get(), sample_duration);
+  audio_level_.ComputeLevel(*audio_frame, sample_duration);
 
-  // Copy frame and push to each sending stream. The copy is required since an
-  // encoding task will be posted internally to each stream.
+  // Push the frame to each sending stream. The streams only hold references
+  // to it until their encoding tasks have run, and don't modify it.
   {
     rtc::CritScope lock(&capture_lock_);
     typing_noise_detected_ = typing_detected;
 
     RTC_DCHECK_GT(audio_frame->samples_per_channel_, 0);
-    if (!sending_streams_.empty()) {
-      auto it = sending_streams_.begin();
-      while (++it != sending_streams_.end()) {
-        std::unique_ptr<AudioFrame> audio_frame_copy(new AudioFrame());
-        audio_frame_copy->CopyFrom(*audio_frame.get());
-        (*it)->SendAudioData(std::move(audio_frame_copy));
-      }
-      // Send the original frame to the first stream w/o copying.
-      (*sending_streams_.begin())->SendAudioData(std::move(audio_frame));
-    }
+    for (AudioSendStream* stream : sending_streams_)
+      stream->SendAudioData(shared_frame);
   }
 
   return 0;
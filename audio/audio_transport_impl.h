@@ -13,6 +13,7 @@
 
 #include <vector>
 
+#include "api/audio/audio_frame_pool.h"
 #include "api/audio/audio_mixer.h"
 #include "audio/audio_level.h"
 #include "common_audio/resampler/include/push_resampler.h"
@@ -82,6 +83,9 @@ class AudioTransportImpl : public AudioTransport {
   bool typing_noise_detected_ RTC_GUARDED_BY(capture_lock_) = false;
   bool swap_stereo_channels_ RTC_GUARDED_BY(capture_lock_) = false;
   PushResampler<int16_t> capture_resampler_;
+  // The captured frames, each shared by all the sending streams. The streams
+  // release them once encoded, so only a few frames are ever allocated.
+  AudioFramePool capture_frame_pool_;
   voe::AudioLevel audio_level_;
   TypingDetection typing_detection_;
 
@@ -54,6 +54,9 @@ namespace {
 constexpr double kAudioSampleDurationSeconds = 0.01;
 constexpr int64_t kMaxRetransmissionWindowMs = 1000;
 constexpr int64_t kMinRetransmissionWindowMs = 30;
+// The number of encoder tasks a sending channel keeps for reuse. More are
+// only needed while the encoder task queue is running late.
+constexpr size_t kMaxFreeEncodeTasks = 4;
 
 // Video Sync.
 constexpr int kVoiceEngineMinMinPlayoutDelayMs = 0;
@@ -270,23 +273,38 @@ class VoERtcpObserver : public RtcpBandwidthObserver {
   RtcpBandwidthObserver* bandwidth_observer_ RTC_GUARDED_BY(crit_);
 };
 
+// Posted for every frame, and handed back to the channel when it has run, so
+// that it can be posted again without being reallocated.
 class Channel::ProcessAndEncodeAudioTask : public rtc::QueuedTask {
  public:
-  ProcessAndEncodeAudioTask(std::unique_ptr<AudioFrame> audio_frame,
-                            Channel* channel)
-      : audio_frame_(std::move(audio_frame)), channel_(channel) {
+  explicit ProcessAndEncodeAudioTask(Channel* channel) : channel_(channel) {
     RTC_DCHECK(channel_);
   }
 
+  void SetAudioFrame(rtc::scoped_refptr<const SharedAudioFrame> audio_frame) {
+    RTC_DCHECK(audio_frame);
+    audio_frame_ = std::move(audio_frame);
+    enqueue_time_ms_ = rtc::TimeMillis();
+  }
+
  private:
   bool Run() override {
     RTC_DCHECK_RUN_ON(channel_->encoder_queue_);
-    channel_->ProcessAndEncodeAudioOnTaskQueue(audio_frame_.get());
-    return true;
+    channel_->ProcessAndEncodeAudioOnTaskQueue(audio_frame_->frame(),
+                                               enqueue_time_ms_);
+    // Give the frame back to its pool before the task waits to be reused.
+    audio_frame_ = nullptr;
+    // The task may be posted again as soon as the channel has it back, so it
+    // must not be touched after this. Returning false keeps the task queue
+    // from deleting it.
+    channel_->RecycleProcessAndEncodeAudioTask(
+        std::unique_ptr<ProcessAndEncodeAudioTask>(this));
+    return false;
   }
 
-  std::unique_ptr<AudioFrame> audio_frame_;
   Channel* const channel_;
+  rtc::scoped_refptr<const SharedAudioFrame> audio_frame_;
+  int64_t enqueue_time_ms_ = 0;
 };
 
 int32_t Channel::SendData(FrameType frameType,
@@ -566,6 +584,7 @@ Channel::Channel(ProcessThread* module_process_thread,
           webrtc::field_trial::FindFullName("UseTwccPlrForAna") == "Enabled") {
   RTC_DCHECK(module_process_thread);
   RTC_DCHECK(audio_device_module);
+  free_encode_tasks_.reserve(kMaxFreeEncodeTasks);
   AudioCodingModule::Config acm_config;
   acm_config.decoder_factory = decoder_factory;
   acm_config.neteq_config.codec_pair_id = codec_pair_id;
@@ -1223,32 +1242,59 @@ int Channel::ResendPackets(const uint16_t* sequence_numbers, int length) {
   return _rtpRtcpModule->SendNACK(sequence_numbers, length);
 }
 
-void Channel::ProcessAndEncodeAudio(std::unique_ptr<AudioFrame> audio_frame) {
+void Channel::ProcessAndEncodeAudio(
+    rtc::scoped_refptr<const SharedAudioFrame> audio_frame) {
   // Avoid posting any new tasks if sending was already stopped in StopSend().
   rtc::CritScope cs(&encoder_queue_lock_);
   if (!encoder_queue_is_active_) {
     return;
   }
-  // Profile time between when the audio frame is added to the task queue and
-  // when the task is actually executed.
-  audio_frame->UpdateProfileTimeStamp();
-  encoder_queue_->PostTask(std::unique_ptr<rtc::QueuedTask>(
-      new ProcessAndEncodeAudioTask(std::move(audio_frame), this)));
+  // Tasks are only allocated until there are enough of them to cover the
+  // frames that are waiting to be encoded.
+  std::unique_ptr<ProcessAndEncodeAudioTask> task;
+  if (free_encode_tasks_.empty()) {
+    task = rtc::MakeUnique<ProcessAndEncodeAudioTask>(this);
+  } else {
+    task = std::move(free_encode_tasks_.back());
+    free_encode_tasks_.pop_back();
+  }
+  // The task profiles the time between when the audio frame is added to the
+  // task queue and when the task is actually executed.
+  task->SetAudioFrame(std::move(audio_frame));
+  encoder_queue_->PostTask(std::move(task));
 }
 
-void Channel::ProcessAndEncodeAudioOnTaskQueue(AudioFrame* audio_input) {
+void Channel::RecycleProcessAndEncodeAudioTask(
+    std::unique_ptr<ProcessAndEncodeAudioTask> task) {
+  rtc::CritScope cs(&encoder_queue_lock_);
+  // Keeps the list from growing on the audio thread. Tasks beyond what the
+  // list has room for are deleted here, on the encoder task queue.
+  if (free_encode_tasks_.size() < free_encode_tasks_.capacity())
+    free_encode_tasks_.push_back(std::move(task));
+}
+
+void Channel::ProcessAndEncodeAudioOnTaskQueue(const AudioFrame& audio_frame,
+                                               int64_t enqueue_time_ms) {
   RTC_DCHECK_RUN_ON(encoder_queue_);
-  RTC_DCHECK_GT(audio_input->samples_per_channel_, 0);
-  RTC_DCHECK_LE(audio_input->num_channels_, 2);
+  RTC_DCHECK_GT(audio_frame.samples_per_channel_, 0);
+  RTC_DCHECK_LE(audio_frame.num_channels_, 2);
 
   // Measure time between when the audio frame is added to the task queue and
   // when the task is actually executed. Goal is to keep track of unwanted
   // extra latency added by the task queue.
   RTC_HISTOGRAM_COUNTS_10000("WebRTC.Audio.EncodingTaskQueueLatencyMs",
-                             audio_input->ElapsedProfileTimeMs());
+                             rtc::TimeMillis() - enqueue_time_ms);
 
+  // The frame is shared with the other sending channels, so it is only
+  // copied when it has to be muted or faded. The RTP timestamp is passed to
+  // the ACM separately.
   bool is_muted = InputMute();
-  AudioFrameOperations::Mute(audio_input, previous_frame_muted_, is_muted);
+  const AudioFrame* audio_input = &audio_frame;
+  if (is_muted || previous_frame_muted_) {
+    audio_input_.CopyFrom(audio_frame);
+    AudioFrameOperations::Mute(&audio_input_, previous_frame_muted_, is_muted);
+    audio_input = &audio_input_;
+  }
 
   if (_includeAudioLevelIndication) {
     size_t length =
@@ -1266,11 +1312,10 @@ void Channel::ProcessAndEncodeAudioOnTaskQueue(AudioFrame* audio_input) {
   // Add 10ms of raw (PCM) audio data to the encoder @ 32kHz.
 
   // The ACM resamples internally.
-  audio_input->timestamp_ = _timeStamp;
   // This call will trigger AudioPacketizationCallback::SendData if encoding
   // is done and payload is ready for packetization and transmission.
   // Otherwise, it will return without invoking the callback.
-  if (audio_coding_->Add10MsData(*audio_input) < 0) {
+  if (audio_coding_->Add10MsData(*audio_input, _timeStamp) < 0) {
     RTC_DLOG(LS_ERROR) << "ACM::Add10MsData() failed.";
     return;
   }
@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 
+#include "api/audio/audio_frame_pool.h"
 #include "api/audio/audio_mixer.h"
 #include "api/audio_codecs/audio_encoder.h"
 #include "api/call/audio_sink.h"
@@ -276,8 +277,10 @@ class Channel
   // The main reason for using a task queue here is to release the native,
   // OS-specific, audio capture thread as soon as possible to ensure that it
   // can go back to sleep and be prepared to deliver an new captured audio
-  // packet.
-  void ProcessAndEncodeAudio(std::unique_ptr<AudioFrame> audio_frame);
+  // packet. |audio_frame| may be shared with other channels, so it is only
+  // copied, on the queue, if it has to be muted. The posted tasks are reused.
+  void ProcessAndEncodeAudio(
+      rtc::scoped_refptr<const SharedAudioFrame> audio_frame);
 
   // Associate to a send channel.
   // Used for obtaining RTT for a receive-only channel.
@@ -332,8 +335,13 @@ class Channel
   int64_t GetRTT(bool allow_associate_channel) const;
 
   // Called on the encoder task queue when a new input audio frame is ready
-  // for encoding.
-  void ProcessAndEncodeAudioOnTaskQueue(AudioFrame* audio_input);
+  // for encoding. |enqueue_time_ms| is when the task was posted.
+  void ProcessAndEncodeAudioOnTaskQueue(const AudioFrame& audio_frame,
+                                        int64_t enqueue_time_ms);
+  // Called on the encoder task queue by a task that has run, so that
+  // ProcessAndEncodeAudio() can post it again.
+  void RecycleProcessAndEncodeAudioTask(
+      std::unique_ptr<ProcessAndEncodeAudioTask> task);
 
   rtc::CriticalSection _callbackCritSect;
   rtc::CriticalSection volume_settings_critsect_;
@@ -378,6 +386,8 @@ class Channel
   RmsLevel rms_level_ RTC_GUARDED_BY(encoder_queue_);
   bool input_mute_ RTC_GUARDED_BY(volume_settings_critsect_);
   bool previous_frame_muted_ RTC_GUARDED_BY(encoder_queue_);
+  // Copy of the frame being encoded, if it has to be muted.
+  AudioFrame audio_input_ RTC_GUARDED_BY(encoder_queue_);
   float _outputGain RTC_GUARDED_BY(volume_settings_critsect_);
   // VoeRTP_RTCP
   // TODO(henrika): can today be accessed on the main thread and on the
@@ -406,6 +416,8 @@ class Channel
 
   rtc::CriticalSection encoder_queue_lock_;
   bool encoder_queue_is_active_ RTC_GUARDED_BY(encoder_queue_lock_) = false;
+  std::vector<std::unique_ptr<ProcessAndEncodeAudioTask>> free_encode_tasks_
+      RTC_GUARDED_BY(encoder_queue_lock_);
   rtc::TaskQueue* encoder_queue_ = nullptr;
 };
 
@@ -239,7 +239,7 @@ int ChannelProxy::PreferredSampleRate() const {
 }
 
 void ChannelProxy::ProcessAndEncodeAudio(
-    std::unique_ptr<AudioFrame> audio_frame) {
+    rtc::scoped_refptr<const SharedAudioFrame> audio_frame) {
   RTC_DCHECK_RUNS_SERIALIZED(&audio_thread_race_checker_);
   return channel_->ProcessAndEncodeAudio(std::move(audio_frame));
 }
@@ -73,12 +73,8 @@ class MockVoEChannelProxy : public voe::ChannelProxy {
       AudioMixer::Source::AudioFrameInfo(int sample_rate_hz,
                                          AudioFrame* audio_frame));
   MOCK_CONST_METHOD0(PreferredSampleRate, int());
-  // GMock doesn't like move-only types, like std::unique_ptr.
-  virtual void ProcessAndEncodeAudio(std::unique_ptr<AudioFrame> audio_frame) {
-    ProcessAndEncodeAudioForMock(&audio_frame);
-  }
-  MOCK_METHOD1(ProcessAndEncodeAudioForMock,
-               void(std::unique_ptr<AudioFrame>* audio_frame));
+  MOCK_METHOD1(ProcessAndEncodeAudio,
+               void(rtc::scoped_refptr<const SharedAudioFrame> audio_frame));
   MOCK_METHOD1(SetTransportOverhead, void(int transport_overhead_per_packet));
   MOCK_METHOD1(AssociateSendChannel,
                void(const ChannelProxy& send_channel_proxy));
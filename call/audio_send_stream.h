@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 
+#include "api/audio/audio_frame_pool.h"
 #include "api/audio_codecs/audio_codec_pair_id.h"
 #include "api/audio_codecs/audio_encoder.h"
 #include "api/audio_codecs/audio_encoder_factory.h"
@@ -29,8 +30,6 @@
 
 namespace webrtc {
 
-class AudioFrame;
-
 class AudioSendStream {
  public:
   struct Stats {
@@ -145,9 +144,10 @@ class AudioSendStream {
   // When a stream is stopped, it can't receive, process or deliver packets.
   virtual void Stop() = 0;
 
-  // Encode and send audio.
+  // Encode and send audio. The frame may be shared with other streams, so it
+  // must not be modified.
   virtual void SendAudioData(
-      std::unique_ptr<webrtc::AudioFrame> audio_frame) = 0;
+      rtc::scoped_refptr<const SharedAudioFrame> audio_frame) = 0;
 
   // TODO(solenberg): Make payload_type a config property instead.
   virtual bool SendTelephoneEvent(int payload_type, int payload_frequency,
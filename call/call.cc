@@ -43,6 +43,7 @@
 #include "modules/rtp_rtcp/include/rtp_header_parser.h"
 #include "modules/rtp_rtcp/source/byte_io.h"
 #include "modules/rtp_rtcp/source/rtp_packet_received.h"
+#include "modules/rtp_rtcp/source/rtp_packet_view.h"
 #include "modules/utility/include/process_thread.h"
 #include "modules/video_coding/fec_controller_default.h"
 #include "rtc_base/basictypes.h"
@@ -64,6 +65,7 @@
 #include "system_wrappers/include/metrics.h"
 #include "video/call_stats.h"
 #include "video/send_delay_stats.h"
+#include "video/shared_decode_executor.h"
 #include "video/stats_counter.h"
 #include "video/video_receive_stream.h"
 #include "video/video_send_stream.h"
@@ -263,6 +265,9 @@ class Call : public webrtc::Call,
   const int num_cpu_cores_;
   const std::unique_ptr<ProcessThread> module_process_thread_;
   const std::unique_ptr<CallStats> call_stats_;
+  // Decodes the video receive streams if |shared_video_decode_threads| is set
+  // in the config.
+  const std::unique_ptr<SharedDecodeExecutor> decode_executor_;
   const std::unique_ptr<BitrateAllocator> bitrate_allocator_;
   Call::Config config_;
   rtc::SequencedTaskChecker configuration_sequence_checker_;
@@ -423,6 +428,9 @@ Call::Call(const Call::Config& config,
       num_cpu_cores_(CpuInfo::DetectNumberOfCores()),
       module_process_thread_(ProcessThread::Create("ModuleProcessThread")),
       call_stats_(new CallStats(clock_, module_process_thread_.get())),
+      decode_executor_(config.shared_video_decode_threads
+                           ? new SharedDecodeExecutor(clock_, num_cpu_cores_)
+                           : nullptr),
       bitrate_allocator_(new BitrateAllocator(this)),
       config_(config),
       audio_network_state_(kNetworkDown),
@@ -800,7 +808,7 @@ webrtc::VideoReceiveStream* Call::CreateVideoReceiveStream(
   VideoReceiveStream* receive_stream = new VideoReceiveStream(
       &video_receiver_controller_, num_cpu_cores_,
       transport_send_->packet_router(), std::move(configuration),
-      module_process_thread_.get(), call_stats_.get());
+      module_process_thread_.get(), call_stats_.get(), decode_executor_.get());
 
   const webrtc::VideoReceiveStream::Config& config = receive_stream->config();
   {
@@ -1229,7 +1237,27 @@ PacketReceiver::DeliveryStatus Call::DeliverRtp(MediaType media_type,
                                                 const PacketTime& packet_time) {
   TRACE_EVENT0("webrtc", "Call::DeliverRtp");
 
-  RtpPacketReceived parsed_packet;
+  // Only the fixed header is read until the packet is known to be for one of
+  // the receive streams, which also tells what its extensions are.
+  const RtpPacketView packet_view(
+      rtc::MakeArrayView(packet.cdata(), packet.size()));
+  if (!packet_view.IsValid())
+    return DELIVERY_PACKET_ERROR;
+
+  ReadLockScoped read_lock(*receive_crit_);
+  auto it = receive_rtp_config_.find(packet_view.Ssrc());
+  if (it == receive_rtp_config_.end()) {
+    RTC_LOG(LS_ERROR) << "receive_rtp_config_ lookup failed for ssrc "
+                      << packet_view.Ssrc();
+    // Destruction of the receive stream, including deregistering from the
+    // RtpDemuxer, is not protected by the |receive_crit_| lock. But
+    // deregistering in the |receive_rtp_config_| map is protected by that lock.
+    // So by not passing the packet on to demuxing in this case, we prevent
+    // incoming packets to be passed on via the demuxer to a receive stream
+    // which is being torned down.
+    return DELIVERY_UNKNOWN_SSRC;
+  }
+  RtpPacketReceived parsed_packet(&it->second.extensions);
   if (!parsed_packet.Parse(std::move(packet)))
     return DELIVERY_PACKET_ERROR;
 
@@ -1252,21 +1280,6 @@ PacketReceiver::DeliveryStatus Call::DeliverRtp(MediaType media_type,
   RTC_DCHECK(media_type == MediaType::AUDIO || media_type == MediaType::VIDEO ||
              is_keep_alive_packet);
 
-  ReadLockScoped read_lock(*receive_crit_);
-  auto it = receive_rtp_config_.find(parsed_packet.Ssrc());
-  if (it == receive_rtp_config_.end()) {
-    RTC_LOG(LS_ERROR) << "receive_rtp_config_ lookup failed for ssrc "
-                      << parsed_packet.Ssrc();
-    // Destruction of the receive stream, including deregistering from the
-    // RtpDemuxer, is not protected by the |receive_crit_| lock. But
-    // deregistering in the |receive_rtp_config_| map is protected by that lock.
-    // So by not passing the packet on to demuxing in this case, we prevent
-    // incoming packets to be passed on via the demuxer to a receive stream
-    // which is being torned down.
-    return DELIVERY_UNKNOWN_SSRC;
-  }
-  parsed_packet.IdentifyExtensions(it->second.extensions);
-
   NotifyBweOfReceivedPacket(parsed_packet, media_type);
 
   // RateCounters expect input parameter as int, save it as int,
@@ -45,6 +45,11 @@ struct CallConfig {
 
   // FecController to use for this call.
   FecControllerFactoryInterface* fec_controller_factory = nullptr;
+
+  // If true, the video receive streams of this call decode on a shared pool
+  // with a thread per cpu core, instead of on a thread each. Meant for calls
+  // that receive many streams, e.g. on a server that records them.
+  bool shared_video_decode_threads = false;
 };
 
 }  // namespace webrtc
@@ -10,6 +10,8 @@
 
 #include "call/rtp_demuxer.h"
 
+#include <algorithm>
+
 #include "call/rtp_packet_sink_interface.h"
 #include "call/rtp_rtcp_demuxer_helper.h"
 #include "call/ssrc_binding_observer.h"
@@ -19,6 +21,14 @@
 #include "rtc_base/logging.h"
 
 namespace webrtc {
+namespace {
+
+// The SSRC cache also holds SSRCs that are only known through a latched MID,
+// which aren't limited by kMaxSsrcBindings, so allow some headroom.
+constexpr size_t kMaxCachedSsrcs = 2 * RtpDemuxer::kMaxSsrcBindings;
+constexpr int kMinSsrcCacheCapacityBits = 4;
+
+}  // namespace
 
 RtpDemuxerCriteria::RtpDemuxerCriteria() = default;
 RtpDemuxerCriteria::~RtpDemuxerCriteria() = default;
@@ -71,6 +81,7 @@ bool RtpDemuxer::AddSink(const RtpDemuxerCriteria& criteria,
   }
 
   RefreshKnownMids();
+  sink_by_ssrc_cache_.Clear();
 
   return true;
 }
@@ -148,11 +159,38 @@ bool RtpDemuxer::RemoveSink(const RtpPacketSinkInterface* sink) {
                        RemoveFromMapByValue(&sink_by_mid_and_rsid_, sink) +
                        RemoveFromMapByValue(&sink_by_rsid_, sink);
   RefreshKnownMids();
+  sink_by_ssrc_cache_.Clear();
   return num_removed > 0;
 }
 
+void RtpDemuxer::set_use_mid(bool use_mid) {
+  use_mid_ = use_mid;
+  sink_by_ssrc_cache_.Clear();
+}
+
 bool RtpDemuxer::OnRtpPacket(const RtpPacketReceived& packet) {
-  RtpPacketSinkInterface* sink = ResolveSink(packet);
+  const uint32_t ssrc = packet.Ssrc();
+  // Packets without any of the ID extensions are routed based on their SSRC
+  // alone (possibly through a latched MID or RSID), so once an SSRC has been
+  // resolved the result can be reused until the sinks change.
+  const bool has_ids = (use_mid_ && packet.HasExtension<RtpMid>()) ||
+                       packet.HasExtension<RtpStreamId>() ||
+                       packet.HasExtension<RepairedRtpStreamId>();
+  RtpPacketSinkInterface* sink =
+      has_ids ? nullptr : sink_by_ssrc_cache_.Find(ssrc);
+  if (sink == nullptr) {
+    sink = ResolveSink(packet);
+    // The result only depends on the SSRC if the payload type fallback can't
+    // be reached for it, i.e. if the SSRC is bound to a sink or has a latched
+    // MID. A packet with ID extensions is resolved the same way as later
+    // packets without them would be, since the IDs have just been latched.
+    if (sink != nullptr && (sink_by_ssrc_.find(ssrc) != sink_by_ssrc_.end() ||
+                            mid_by_ssrc_.find(ssrc) != mid_by_ssrc_.end())) {
+      sink_by_ssrc_cache_.Insert(ssrc, sink);
+    } else {
+      sink_by_ssrc_cache_.Erase(ssrc);
+    }
+  }
   if (sink != nullptr) {
     sink->OnRtpPacket(packet);
     return true;
@@ -339,6 +377,15 @@ RtpPacketSinkInterface* RtpDemuxer::ResolveSinkByPayloadType(
 
 bool RtpDemuxer::AddSsrcSinkBinding(uint32_t ssrc,
                                     RtpPacketSinkInterface* sink) {
+  auto it = sink_by_ssrc_.find(ssrc);
+  if (it != sink_by_ssrc_.end()) {
+    if (it->second != sink) {
+      it->second = sink;
+      return true;
+    }
+    return false;
+  }
+
   if (sink_by_ssrc_.size() >= kMaxSsrcBindings) {
     RTC_LOG(LS_WARNING) << "New SSRC=" << ssrc
                         << " sink binding ignored; limit of" << kMaxSsrcBindings
@@ -346,17 +393,81 @@ bool RtpDemuxer::AddSsrcSinkBinding(uint32_t ssrc,
     return false;
   }
 
-  auto result = sink_by_ssrc_.emplace(ssrc, sink);
-  auto it = result.first;
-  bool inserted = result.second;
-  if (inserted) {
-    return true;
+  sink_by_ssrc_.emplace(ssrc, sink);
+  return true;
+}
+
+RtpDemuxer::SsrcSinkCache::SsrcSinkCache() = default;
+RtpDemuxer::SsrcSinkCache::~SsrcSinkCache() = default;
+
+void RtpDemuxer::SsrcSinkCache::Insert(uint32_t ssrc,
+                                       RtpPacketSinkInterface* sink) {
+  RTC_DCHECK(sink);
+  if ((size_ + 1) * 2 > slots_.size()) {
+    if (size_ >= kMaxCachedSsrcs) {
+      // Only update existing entries once the cache is full.
+      for (size_t i = SlotIndex(ssrc); slots_[i].sink != nullptr;
+           i = (i + 1) & (slots_.size() - 1)) {
+        if (slots_[i].ssrc == ssrc) {
+          slots_[i].sink = sink;
+          return;
+        }
+      }
+      return;
+    }
+    Resize(std::max(capacity_bits_ + 1, kMinSsrcCacheCapacityBits));
   }
-  if (it->second != sink) {
-    it->second = sink;
-    return true;
+
+  size_t i = SlotIndex(ssrc);
+  while (slots_[i].sink != nullptr && slots_[i].ssrc != ssrc)
+    i = (i + 1) & (slots_.size() - 1);
+  if (slots_[i].sink == nullptr)
+    ++size_;
+  slots_[i].ssrc = ssrc;
+  slots_[i].sink = sink;
+}
+
+void RtpDemuxer::SsrcSinkCache::Erase(uint32_t ssrc) {
+  if (size_ == 0)
+    return;
+  const size_t mask = slots_.size() - 1;
+  size_t i = SlotIndex(ssrc);
+  while (slots_[i].sink != nullptr && slots_[i].ssrc != ssrc)
+    i = (i + 1) & mask;
+  if (slots_[i].sink == nullptr)
+    return;
+
+  // Shift back following entries of the probe sequence into the hole, so that
+  // lookups don't need tombstones.
+  for (size_t j = (i + 1) & mask; slots_[j].sink != nullptr;
+       j = (j + 1) & mask) {
+    size_t home = SlotIndex(slots_[j].ssrc);
+    bool home_in_gap = i <= j ? (i < home && home <= j)
+                              : (i < home || home <= j);
+    if (!home_in_gap) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i].sink = nullptr;
+  --size_;
+}
+
+void RtpDemuxer::SsrcSinkCache::Clear() {
+  for (Slot& slot : slots_)
+    slot.sink = nullptr;
+  size_ = 0;
+}
+
+void RtpDemuxer::SsrcSinkCache::Resize(int capacity_bits) {
+  std::vector<Slot> old_slots(size_t{1} << capacity_bits, Slot{0, nullptr});
+  old_slots.swap(slots_);
+  capacity_bits_ = capacity_bits;
+  size_ = 0;
+  for (const Slot& slot : old_slots) {
+    if (slot.sink != nullptr)
+      Insert(slot.ssrc, slot.sink);
   }
-  return false;
 }
 
 void RtpDemuxer::RegisterSsrcBindingObserver(SsrcBindingObserver* observer) {
@@ -139,9 +139,49 @@ class RtpDemuxer {
 
   // Configure whether to look at the MID header extension when demuxing
   // incoming RTP packets. By default this is enabled.
-  void set_use_mid(bool use_mid) { use_mid_ = use_mid; }
+  void set_use_mid(bool use_mid);
 
  private:
+  // Open addressing hash table from SSRC to the sink that packets with that
+  // SSRC were last resolved to. Used to route packets without MID, RSID or
+  // RRID header extensions without running the full demux algorithm.
+  class SsrcSinkCache {
+   public:
+    SsrcSinkCache();
+    ~SsrcSinkCache();
+
+    // Returns null if |ssrc| isn't cached.
+    RtpPacketSinkInterface* Find(uint32_t ssrc) const {
+      if (slots_.empty())
+        return nullptr;
+      for (size_t i = SlotIndex(ssrc);; i = (i + 1) & (slots_.size() - 1)) {
+        const Slot& slot = slots_[i];
+        if (slot.sink == nullptr || slot.ssrc == ssrc)
+          return slot.sink;
+      }
+    }
+    void Insert(uint32_t ssrc, RtpPacketSinkInterface* sink);
+    void Erase(uint32_t ssrc);
+    void Clear();
+
+   private:
+    struct Slot {
+      uint32_t ssrc;
+      // Null for empty slots.
+      RtpPacketSinkInterface* sink;
+    };
+
+    size_t SlotIndex(uint32_t ssrc) const {
+      // Fibonacci hashing; the high bits of the product are the best mixed.
+      return (ssrc * 0x9E3779B1u) >> (32 - capacity_bits_);
+    }
+    void Resize(int capacity_bits);
+
+    std::vector<Slot> slots_;
+    int capacity_bits_ = 0;
+    size_t size_ = 0;
+  };
+
   // Returns true if adding a sink with the given criteria would cause conflicts
   // with the existing criteria and should be rejected.
   bool CriteriaWouldConflict(const RtpDemuxerCriteria& criteria) const;
@@ -202,6 +242,11 @@ class RtpDemuxer {
   // resolved by this object.
   std::vector<SsrcBindingObserver*> ssrc_binding_observers_;
 
+  // Sinks that packets without MID, RSID and RRID extensions are routed to.
+  // Entries are updated whenever ResolveSink() runs for an SSRC, and the whole
+  // cache is dropped when sinks are added or removed.
+  SsrcSinkCache sink_by_ssrc_cache_;
+
   bool use_mid_ = true;
 };
 
@@ -10,9 +10,11 @@
 
 #include "call/rtp_demuxer.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "call/ssrc_binding_observer.h"
 #include "call/test/mock_rtp_packet_sink_interface.h"
@@ -23,8 +25,10 @@
 #include "rtc_base/arraysize.h"
 #include "rtc_base/basictypes.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/ptr_util.h"
+#include "rtc_base/timeutils.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
 
@@ -1479,6 +1483,112 @@ TEST_F(RtpDemuxerTest, MaliciousPeerCannotCauseMemoryOveruse) {
   }
 }
 
+TEST_F(RtpDemuxerTest, RepeatedPacketsFollowSinkChanges) {
+  constexpr uint32_t ssrc = 10;
+  MockRtpPacketSink sink1;
+  MockRtpPacketSink sink2;
+  AddSinkOnlySsrc(ssrc, &sink1);
+
+  EXPECT_CALL(sink1, OnRtpPacket(_)).Times(2);
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+
+  RemoveSink(&sink1);
+  EXPECT_FALSE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+
+  AddSinkOnlySsrc(ssrc, &sink2);
+  EXPECT_CALL(sink2, OnRtpPacket(_)).Times(1);
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+}
+
+TEST_F(RtpDemuxerTest, RepeatedPacketsFollowNewMidForSameSsrc) {
+  constexpr uint32_t ssrc = 10;
+  const std::string mid1 = "a";
+  const std::string mid2 = "b";
+  MockRtpPacketSink sink1;
+  MockRtpPacketSink sink2;
+  AddSinkOnlyMid(mid1, &sink1);
+  AddSinkOnlyMid(mid2, &sink2);
+
+  InSequence seq;
+  EXPECT_CALL(sink1, OnRtpPacket(_)).Times(2);
+  EXPECT_CALL(sink2, OnRtpPacket(_)).Times(2);
+
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrcMid(ssrc, mid1)));
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrcMid(ssrc, mid2)));
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+}
+
+TEST_F(RtpDemuxerTest, UnknownMidIsDroppedEvenIfSsrcWasRoutedBefore) {
+  constexpr uint32_t ssrc = 10;
+  MockRtpPacketSink sink;
+  AddSinkOnlySsrc(ssrc, &sink);
+
+  EXPECT_CALL(sink, OnRtpPacket(_)).Times(2);
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+  EXPECT_FALSE(demuxer_.OnRtpPacket(*CreatePacketWithSsrcMid(ssrc, "x")));
+  EXPECT_TRUE(demuxer_.OnRtpPacket(*CreatePacketWithSsrc(ssrc)));
+}
+
+class CountingRtpPacketSink : public RtpPacketSinkInterface {
+ public:
+  void OnRtpPacket(const RtpPacketReceived& packet) override { ++count_; }
+  int count() const { return count_; }
+
+ private:
+  int count_ = 0;
+};
+
+// Measures how fast packets of many BUNDLEd streams are demuxed once their
+// SSRCs have been bound to the MID sinks.
+// Disabled because it only logs timings.
+TEST_F(RtpDemuxerTest, DISABLED_DemuxThroughputWithManyBundledSsrcs) {
+  const int kNumSsrcs = RtpDemuxer::kMaxSsrcBindings;
+  const int kNumRounds = 200;
+
+  std::vector<std::unique_ptr<CountingRtpPacketSink>> sinks;
+  std::vector<std::unique_ptr<RtpPacketReceived>> packets_with_mid;
+  std::vector<std::unique_ptr<RtpPacketReceived>> packets;
+  for (int i = 0; i < kNumSsrcs; ++i) {
+    const std::string mid = "m" + std::to_string(i);
+    const uint32_t ssrc = 0x10000 + 7919 * i;
+    sinks.push_back(rtc::MakeUnique<CountingRtpPacketSink>());
+    ASSERT_TRUE(AddSinkOnlyMid(mid, sinks.back().get()));
+    packets_with_mid.push_back(CreatePacketWithSsrcMid(ssrc, mid));
+    packets.push_back(CreatePacketWithSsrc(ssrc));
+  }
+
+  // Packets that carry the MID run the full demux algorithm every time.
+  int64_t start_us = rtc::TimeMicros();
+  for (int round = 0; round < kNumRounds; ++round) {
+    for (const auto& packet : packets_with_mid)
+      ASSERT_TRUE(demuxer_.OnRtpPacket(*packet));
+  }
+  const int64_t with_mid_us = rtc::TimeMicros() - start_us;
+
+  // Once bound, the MID is usually no longer sent.
+  start_us = rtc::TimeMicros();
+  for (int round = 0; round < kNumRounds; ++round) {
+    for (const auto& packet : packets)
+      ASSERT_TRUE(demuxer_.OnRtpPacket(*packet));
+  }
+  const int64_t without_mid_us = rtc::TimeMicros() - start_us;
+
+  for (const auto& sink : sinks)
+    EXPECT_EQ(2 * kNumRounds, sink->count());
+
+  const int64_t num_packets = kNumSsrcs * kNumRounds;
+  RTC_LOG(LS_INFO) << "Demuxed " << num_packets << " packets of " << kNumSsrcs
+                   << " SSRCs at "
+                   << num_packets * rtc::kNumMicrosecsPerSec /
+                          std::max<int64_t>(with_mid_us, 1)
+                   << " packets/s with MID and "
+                   << num_packets * rtc::kNumMicrosecsPerSec /
+                          std::max<int64_t>(without_mid_us, 1)
+                   << " packets/s without.";
+}
+
 #if RTC_DCHECK_IS_ON && GTEST_HAS_DEATH_TEST && !defined(WEBRTC_ANDROID)
 
 TEST_F(RtpDemuxerTest, CriteriaMustBeNonEmpty) {
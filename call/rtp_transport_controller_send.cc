@@ -12,14 +12,17 @@
 #include "call/rtp_transport_controller_send.h"
 #include "modules/congestion_controller/include/send_side_congestion_controller.h"
 #include "modules/congestion_controller/rtp/include/send_side_congestion_controller.h"
+#include "modules/pacing/shared_pacing_engine.h"
 #include "rtc_base/location.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/ptr_util.h"
 #include "system_wrappers/include/field_trial.h"
+#include "system_wrappers/include/metrics.h"
 
 namespace webrtc {
 namespace {
 const char kTaskQueueExperiment[] = "WebRTC-TaskQueueCongestionControl";
+const char kSharedPacingEngineExperiment[] = "WebRTC-Pacer-SharedPacingEngine";
 using TaskQueueController = webrtc::webrtc_cc::SendSideCongestionController;
 
 bool TaskQueueExperimentEnabled() {
@@ -58,6 +61,10 @@ RtpTransportControllerSend::RtpTransportControllerSend(
       pacer_(clock, &packet_router_, event_log),
       bitrate_configurator_(bitrate_config),
       process_thread_(ProcessThread::Create("SendControllerThread")),
+      shared_pacing_engine_(
+          field_trial::IsEnabled(kSharedPacingEngineExperiment)
+              ? SharedPacingEngine::GetDefault()
+              : nullptr),
       observer_(nullptr),
       send_side_cc_(CreateController(clock,
                                      event_log,
@@ -65,7 +72,11 @@ RtpTransportControllerSend::RtpTransportControllerSend(
                                      bitrate_config,
                                      TaskQueueExperimentEnabled())) {
   send_side_cc_ptr_ = send_side_cc_.get();
-  process_thread_->RegisterModule(&pacer_, RTC_FROM_HERE);
+  if (shared_pacing_engine_) {
+    shared_pacing_engine_->RegisterModule(&pacer_, RTC_FROM_HERE);
+  } else {
+    process_thread_->RegisterModule(&pacer_, RTC_FROM_HERE);
+  }
   process_thread_->RegisterModule(send_side_cc_.get(), RTC_FROM_HERE);
   process_thread_->Start();
 }
@@ -73,7 +84,20 @@ RtpTransportControllerSend::RtpTransportControllerSend(
 RtpTransportControllerSend::~RtpTransportControllerSend() {
   process_thread_->Stop();
   process_thread_->DeRegisterModule(send_side_cc_.get());
-  process_thread_->DeRegisterModule(&pacer_);
+  if (shared_pacing_engine_) {
+    rtc::Optional<SharedPacingEngine::SchedulingStats> stats =
+        shared_pacing_engine_->GetSchedulingStats(&pacer_);
+    shared_pacing_engine_->DeRegisterModule(&pacer_);
+    if (stats && stats->num_process_calls > 0) {
+      RTC_HISTOGRAM_COUNTS_1000(
+          "WebRTC.Call.PacerSchedulingLagMs",
+          static_cast<int>(stats->sum_lag_ms / stats->num_process_calls));
+      RTC_HISTOGRAM_COUNTS_1000("WebRTC.Call.PacerMaxSchedulingLagMs",
+                                static_cast<int>(stats->max_lag_ms));
+    }
+  } else {
+    process_thread_->DeRegisterModule(&pacer_);
+  }
 }
 
 void RtpTransportControllerSend::OnNetworkChanged(uint32_t bitrate_bps,
@@ -27,6 +27,7 @@
 namespace webrtc {
 class Clock;
 class RtcEventLog;
+class SharedPacingEngine;
 
 // TODO(nisse): When we get the underlying transports here, we should
 // have one object implementing RtpTransportControllerSendInterface
@@ -89,6 +90,9 @@ class RtpTransportControllerSend final
   RtpBitrateConfigurator bitrate_configurator_;
   std::map<std::string, rtc::NetworkRoute> network_routes_;
   const std::unique_ptr<ProcessThread> process_thread_;
+  // If set, |pacer_| is driven by this engine, which is shared with the pacers
+  // of other calls, instead of by |process_thread_|.
+  SharedPacingEngine* const shared_pacing_engine_;
   rtc::CriticalSection observer_crit_;
   TargetTransferRateObserver* observer_ RTC_GUARDED_BY(observer_crit_);
   // Caches send_side_cc_.get(), to avoid racing with destructor.
@@ -25,13 +25,13 @@ class MockAudioSendStream : public AudioSendStream {
   MOCK_METHOD1(Reconfigure, void(const Config& config));
   MOCK_METHOD0(Start, void());
   MOCK_METHOD0(Stop, void());
-  // GMock doesn't like move-only types, such as std::unique_ptr.
+  // Lets the expectations match the AudioFrame itself.
   virtual void SendAudioData(
-      std::unique_ptr<webrtc::AudioFrame> audio_frame) {
-    SendAudioDataForMock(audio_frame.get());
+      rtc::scoped_refptr<const webrtc::SharedAudioFrame> audio_frame) {
+    SendAudioDataForMock(&audio_frame->frame());
   }
   MOCK_METHOD1(SendAudioDataForMock,
-               void(webrtc::AudioFrame* audio_frame));
+               void(const webrtc::AudioFrame* audio_frame));
   MOCK_METHOD4(SendTelephoneEvent,
                bool(int payload_type, int payload_frequency, int event,
                     int duration_ms));
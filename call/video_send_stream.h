@@ -129,6 +129,12 @@ class VideoSendStream {
       // cpu adaptation.
       bool experiment_cpu_load_estimator = false;
 
+      // Encode frames on a task queue of their own, so that the next frame is
+      // cropped, converted and checked for adaptation while the previous one
+      // is encoded. The encoder must accept Encode() calls on another thread
+      // than its other methods; they are never called concurrently.
+      bool pipelined_encoding = false;
+
       // Ownership stays with WebrtcVideoEngine (delegated from PeerConnection).
       VideoEncoderFactory* encoder_factory = nullptr;
 
@@ -10,6 +10,8 @@
 
 #include "common_video/include/i420_buffer_pool.h"
 
+#include <algorithm>
+
 #include "rtc_base/checks.h"
 
 namespace webrtc {
@@ -23,39 +25,100 @@ I420BufferPool::I420BufferPool(bool zero_initialize,
       max_number_of_buffers_(max_number_of_buffers) {}
 I420BufferPool::~I420BufferPool() = default;
 
+constexpr size_t I420BufferPool::kMaxNumberOfResolutions;
+constexpr size_t I420BufferPool::kMaxIdleRequests;
+
 void I420BufferPool::Release() {
-  buffers_.clear();
+  rtc::CritScope lock(&crit_);
+  resolutions_.clear();
+  evicted_buffers_.clear();
+  num_buffers_ = 0;
+}
+
+I420BufferPool::Stats I420BufferPool::GetStats() const {
+  rtc::CritScope lock(&crit_);
+  return stats_;
 }
 
 rtc::scoped_refptr<I420Buffer> I420BufferPool::CreateBuffer(int width,
                                                             int height) {
-  RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
-  // Release buffers with wrong resolution.
-  for (auto it = buffers_.begin(); it != buffers_.end();) {
-    if ((*it)->width() != width || (*it)->height() != height)
-      it = buffers_.erase(it);
-    else
-      ++it;
+  rtc::CritScope lock(&crit_);
+  ++num_requests_;
+  auto it = resolutions_.begin();
+  while (it != resolutions_.end() &&
+         (it->width != width || it->height != height)) {
+    ++it;
   }
+  if (it == resolutions_.end()) {
+    // Release buffers of the least recently used resolution.
+    if (resolutions_.size() == kMaxNumberOfResolutions)
+      EvictResolution(resolutions_.size() - 1);
+    resolutions_.insert(resolutions_.begin(),
+                        Resolution{width, height, num_requests_, {}});
+  } else if (it != resolutions_.begin()) {
+    std::rotate(resolutions_.begin(), it, it + 1);
+  }
+  resolutions_.front().last_request = num_requests_;
+  ReleaseIdleBuffers();
+  Resolution& resolution = resolutions_.front();
+
   // Look for a free buffer.
-  for (const rtc::scoped_refptr<PooledI420Buffer>& buffer : buffers_) {
+  for (const rtc::scoped_refptr<PooledI420Buffer>& buffer :
+       resolution.buffers) {
     // If the buffer is in use, the ref count will be >= 2, one from the list we
     // are looping over and one from the application. If the ref count is 1,
     // then the list we are looping over holds the only reference and it's safe
     // to reuse.
-    if (buffer->HasOneRef())
+    if (buffer->HasOneRef()) {
+      ++stats_.num_reused_buffers;
       return buffer;
+    }
   }
 
-  if (buffers_.size() >= max_number_of_buffers_)
+  // Make room by releasing free buffers of other resolutions.
+  for (size_t i = resolutions_.size() - 1;
+       i > 0 && num_buffers_ >= max_number_of_buffers_; --i) {
+    ReleaseUnusedBuffers(&resolutions_[i].buffers);
+  }
+  if (num_buffers_ >= max_number_of_buffers_)
     return nullptr;
   // Allocate new buffer.
   rtc::scoped_refptr<PooledI420Buffer> buffer =
       new PooledI420Buffer(width, height);
   if (zero_initialize_)
     buffer->InitializeData();
-  buffers_.push_back(buffer);
+  resolution.buffers.push_back(buffer);
+  ++num_buffers_;
+  ++stats_.num_allocated_buffers;
   return buffer;
 }
 
+void I420BufferPool::ReleaseUnusedBuffers(BufferList* buffers) {
+  auto end = std::remove_if(
+      buffers->begin(), buffers->end(),
+      [](const rtc::scoped_refptr<PooledI420Buffer>& buffer) {
+        return buffer->HasOneRef();
+      });
+  num_buffers_ -= buffers->end() - end;
+  buffers->erase(end, buffers->end());
+}
+
+void I420BufferPool::EvictResolution(size_t index) {
+  BufferList& buffers = resolutions_[index].buffers;
+  ReleaseUnusedBuffers(&buffers);
+  // The buffers in use still count against |max_number_of_buffers_|, until
+  // they are returned and released by ReleaseIdleBuffers().
+  evicted_buffers_.insert(evicted_buffers_.end(), buffers.begin(),
+                          buffers.end());
+  resolutions_.erase(resolutions_.begin() + index);
+}
+
+void I420BufferPool::ReleaseIdleBuffers() {
+  ReleaseUnusedBuffers(&evicted_buffers_);
+  for (size_t i = resolutions_.size() - 1; i > 0; --i) {
+    if (num_requests_ - resolutions_[i].last_request > kMaxIdleRequests)
+      EvictResolution(i);
+  }
+}
+
 }  // namespace webrtc
@@ -9,8 +9,10 @@
  */
 
 #include <string>
+#include <vector>
 
 #include "common_video/include/i420_buffer_pool.h"
+#include "rtc_base/logging.h"
 #include "test/gtest.h"
 
 namespace webrtc {
@@ -70,4 +72,104 @@ TEST(TestI420BufferPool, MaxNumberOfBuffers) {
   EXPECT_EQ(nullptr, pool.CreateBuffer(16, 16).get());
 }
 
+TEST(TestI420BufferPool, ReusesBuffersAfterResolutionChange) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<I420Buffer> buffer = pool.CreateBuffer(16, 16);
+  const uint8_t* y_ptr = buffer->DataY();
+  buffer = pool.CreateBuffer(32, 16);
+  const uint8_t* other_y_ptr = buffer->DataY();
+  buffer = nullptr;
+
+  EXPECT_EQ(y_ptr, pool.CreateBuffer(16, 16)->DataY());
+  EXPECT_EQ(other_y_ptr, pool.CreateBuffer(32, 16)->DataY());
+  EXPECT_EQ(2, pool.GetStats().num_allocated_buffers);
+  EXPECT_EQ(2, pool.GetStats().num_reused_buffers);
+}
+
+TEST(TestI420BufferPool, ReleasesLeastRecentlyUsedResolution) {
+  I420BufferPool pool;
+  pool.CreateBuffer(16, 16);
+  for (size_t i = 1; i < I420BufferPool::kMaxNumberOfResolutions; ++i)
+    pool.CreateBuffer(16, 16 + 2 * i);
+  // Use 16x16 again, so that the resolution after it is the least recently
+  // used one.
+  pool.CreateBuffer(16, 16);
+  EXPECT_EQ(1, pool.GetStats().num_reused_buffers);
+  pool.CreateBuffer(64, 64);
+
+  pool.CreateBuffer(16, 16);
+  EXPECT_EQ(2, pool.GetStats().num_reused_buffers);
+  pool.CreateBuffer(16, 18);
+  EXPECT_EQ(2, pool.GetStats().num_reused_buffers);
+}
+
+TEST(TestI420BufferPool, MaxNumberOfBuffersReleasesOtherResolutions) {
+  I420BufferPool pool(false, 2);
+  rtc::scoped_refptr<I420Buffer> buffer = pool.CreateBuffer(16, 16);
+  pool.CreateBuffer(32, 32);
+  // The unused 32x32 buffer makes room for a second 16x16 buffer.
+  EXPECT_NE(nullptr, pool.CreateBuffer(16, 16).get());
+  EXPECT_EQ(3, pool.GetStats().num_allocated_buffers);
+}
+
+TEST(TestI420BufferPool, ReleasesBuffersOfIdleResolution) {
+  I420BufferPool pool;
+  rtc::scoped_refptr<I420Buffer> buffer = pool.CreateBuffer(16, 16);
+  const uint8_t* y_ptr = buffer->DataY();
+  buffer = nullptr;
+  for (size_t i = 0; i < I420BufferPool::kMaxIdleRequests; ++i)
+    pool.CreateBuffer(32, 32);
+  // Not idle for long enough yet.
+  buffer = pool.CreateBuffer(16, 16);
+  EXPECT_EQ(y_ptr, buffer->DataY());
+  buffer = nullptr;
+
+  for (size_t i = 0; i <= I420BufferPool::kMaxIdleRequests; ++i)
+    pool.CreateBuffer(32, 32);
+  pool.CreateBuffer(16, 16);
+  EXPECT_EQ(3, pool.GetStats().num_allocated_buffers);
+}
+
+TEST(TestI420BufferPool, EvictedBufferInUseCountsUntilReturned) {
+  I420BufferPool pool(false, 2);
+  rtc::scoped_refptr<I420Buffer> evicted = pool.CreateBuffer(16, 16);
+  for (size_t i = 1; i <= I420BufferPool::kMaxNumberOfResolutions; ++i)
+    pool.CreateBuffer(32, static_cast<int>(16 + 2 * i));
+  rtc::scoped_refptr<I420Buffer> buffer = pool.CreateBuffer(64, 64);
+  EXPECT_NE(nullptr, buffer.get());
+  EXPECT_EQ(nullptr, pool.CreateBuffer(128, 128).get());
+
+  evicted = nullptr;
+  EXPECT_NE(nullptr, pool.CreateBuffer(128, 128).get());
+}
+
+// Creates buffers for frames that alternate between the resolutions of three
+// simulcast layers, holding on to the last few of them like a decoder and a
+// renderer would, and logs how many buffers the pool allocates.
+TEST(TestI420BufferPool, SimulcastResolutionSwitchAllocations) {
+  const int kNumFrames = 3000;
+  const size_t kNumFramesHeld = 4;
+  const int kWidths[] = {320, 640, 1280};
+  const int kHeights[] = {180, 360, 720};
+
+  I420BufferPool pool;
+  std::vector<rtc::scoped_refptr<I420Buffer>> held_buffers(kNumFramesHeld);
+  for (int i = 0; i < kNumFrames; ++i) {
+    // Switch layer every 10 frames.
+    const int layer = (i / 10) % 3;
+    held_buffers[i % kNumFramesHeld] =
+        pool.CreateBuffer(kWidths[layer], kHeights[layer]);
+  }
+
+  const I420BufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(kNumFrames, stats.num_allocated_buffers + stats.num_reused_buffers);
+  // The held buffers, and the one being created, for each layer.
+  EXPECT_LE(stats.num_allocated_buffers,
+            3 * static_cast<int>(kNumFramesHeld + 1));
+  RTC_LOG(LS_INFO) << "Allocated " << stats.num_allocated_buffers
+                   << " buffers for " << kNumFrames << " frames, "
+                   << stats.num_reused_buffers * 100.0 / kNumFrames
+                   << "% reused.";
+}
+
 }  // namespace webrtc
@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "common_video/include/i420_buffer_pyramid.h"
+
+#include <utility>
+
+#include "api/video/i420_buffer.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/refcountedobject.h"
+
+namespace webrtc {
+namespace {
+
+int64_t PlaneBytes(const I420BufferInterface& buffer) {
+  return static_cast<int64_t>(buffer.width()) * buffer.height() +
+         2 * static_cast<int64_t>(buffer.ChromaWidth()) *
+             buffer.ChromaHeight();
+}
+
+// An I420 buffer that shares the scaled versions of itself.
+class PyramidI420Buffer : public I420BufferInterface {
+ public:
+  explicit PyramidI420Buffer(rtc::scoped_refptr<I420BufferInterface> buffer)
+      : buffer_(buffer), pyramid_(buffer) {}
+
+  int width() const override { return buffer_->width(); }
+  int height() const override { return buffer_->height(); }
+  const uint8_t* DataY() const override { return buffer_->DataY(); }
+  const uint8_t* DataU() const override { return buffer_->DataU(); }
+  const uint8_t* DataV() const override { return buffer_->DataV(); }
+  int StrideY() const override { return buffer_->StrideY(); }
+  int StrideU() const override { return buffer_->StrideU(); }
+  int StrideV() const override { return buffer_->StrideV(); }
+
+  rtc::scoped_refptr<I420BufferInterface> GetScaledI420(int width,
+                                                        int height) override {
+    if (width > buffer_->width() || height > buffer_->height())
+      return nullptr;
+    return pyramid_.GetScaled(width, height);
+  }
+
+ private:
+  const rtc::scoped_refptr<I420BufferInterface> buffer_;
+  I420BufferPyramid pyramid_;
+};
+
+}  // namespace
+
+I420BufferPyramid::I420BufferPyramid(
+    rtc::scoped_refptr<VideoFrameBuffer> source)
+    : source_(std::move(source)) {
+  RTC_DCHECK(source_);
+}
+
+I420BufferPyramid::~I420BufferPyramid() {}
+
+rtc::scoped_refptr<I420BufferInterface> I420BufferPyramid::GetScaled(
+    int width,
+    int height) {
+  rtc::scoped_refptr<I420BufferInterface> shared =
+      source_->GetScaledI420(width, height);
+  if (shared)
+    return shared;
+
+  rtc::CritScope lock(&crit_);
+  if (levels_.empty())
+    levels_.push_back(source_->ToI420());
+
+  // Find the smallest level that is at least as large as the requested size.
+  // If the source is smaller than that, it is scaled up directly.
+  rtc::scoped_refptr<I420BufferInterface> from = levels_[0];
+  for (const auto& level : levels_) {
+    if (level->width() == width && level->height() == height)
+      return level;
+    if (level->width() >= width && level->height() >= height &&
+        level->width() < from->width()) {
+      from = level;
+    }
+  }
+
+  // Go down one octave at a time, so that the intermediate resolutions can be
+  // reused for later requests.
+  while (true) {
+    const int half_width = (from->width() + 1) / 2;
+    const int half_height = (from->height() + 1) / 2;
+    if (half_width < width || half_height < height)
+      break;
+    from = ScaleLocked(from, half_width, half_height);
+    if (half_width == width && half_height == height)
+      return from;
+  }
+  return ScaleLocked(from, width, height);
+}
+
+int64_t I420BufferPyramid::bytes_read() const {
+  rtc::CritScope lock(&crit_);
+  return bytes_read_;
+}
+
+rtc::scoped_refptr<I420BufferInterface> I420BufferPyramid::ScaleLocked(
+    const rtc::scoped_refptr<I420BufferInterface>& from,
+    int width,
+    int height) {
+  rtc::scoped_refptr<I420Buffer> scaled = I420Buffer::Create(width, height);
+  scaled->ScaleFrom(*from);
+  bytes_read_ += PlaneBytes(*from);
+  levels_.push_back(scaled);
+  return scaled;
+}
+
+rtc::scoped_refptr<VideoFrameBuffer> AttachI420BufferPyramid(
+    rtc::scoped_refptr<VideoFrameBuffer> buffer) {
+  if (buffer->type() != VideoFrameBuffer::Type::kI420)
+    return buffer;
+  // Already shares its scaled versions.
+  if (buffer->GetScaledI420(buffer->width(), buffer->height()))
+    return buffer;
+  return new rtc::RefCountedObject<PyramidI420Buffer>(buffer->GetI420());
+}
+
+}  // namespace webrtc
@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "common_video/include/i420_buffer_pyramid.h"
+
+#include "api/video/i420_buffer.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int64_t I420Size(int width, int height) {
+  return static_cast<int64_t>(width) * height +
+         2 * static_cast<int64_t>((width + 1) / 2) * ((height + 1) / 2);
+}
+
+rtc::scoped_refptr<I420Buffer> CreateGradient(int width, int height) {
+  rtc::scoped_refptr<I420Buffer> buffer = I420Buffer::Create(width, height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x)
+      buffer->MutableDataY()[y * buffer->StrideY() + x] = (x + y) & 0xff;
+  }
+  for (int y = 0; y < buffer->ChromaHeight(); ++y) {
+    for (int x = 0; x < buffer->ChromaWidth(); ++x) {
+      buffer->MutableDataU()[y * buffer->StrideU() + x] = 128;
+      buffer->MutableDataV()[y * buffer->StrideV() + x] = 128;
+    }
+  }
+  return buffer;
+}
+
+}  // namespace
+
+TEST(I420BufferPyramidTest, ScalesOnlyOncePerResolution) {
+  I420BufferPyramid pyramid(CreateGradient(640, 360));
+  rtc::scoped_refptr<I420BufferInterface> scaled = pyramid.GetScaled(320, 180);
+  EXPECT_EQ(320, scaled->width());
+  EXPECT_EQ(180, scaled->height());
+  const int64_t bytes_read = pyramid.bytes_read();
+  EXPECT_EQ(I420Size(640, 360), bytes_read);
+
+  EXPECT_EQ(scaled.get(), pyramid.GetScaled(320, 180).get());
+  EXPECT_EQ(bytes_read, pyramid.bytes_read());
+}
+
+TEST(I420BufferPyramidTest, ScalesFromSmallerResolutions) {
+  I420BufferPyramid pyramid(CreateGradient(1280, 720));
+  // Going down two octaves goes through, and keeps, the halved resolution.
+  rtc::scoped_refptr<I420BufferInterface> quarter = pyramid.GetScaled(320, 180);
+  EXPECT_EQ(320, quarter->width());
+  EXPECT_EQ(180, quarter->height());
+  EXPECT_EQ(I420Size(1280, 720) + I420Size(640, 360), pyramid.bytes_read());
+
+  rtc::scoped_refptr<I420BufferInterface> half = pyramid.GetScaled(640, 360);
+  EXPECT_EQ(I420Size(1280, 720) + I420Size(640, 360), pyramid.bytes_read());
+
+  // Resolutions that aren't a power of two down are scaled from the smallest
+  // level that is large enough.
+  rtc::scoped_refptr<I420BufferInterface> odd = pyramid.GetScaled(480, 270);
+  EXPECT_EQ(480, odd->width());
+  EXPECT_EQ(270, odd->height());
+  EXPECT_EQ(I420Size(1280, 720) + 2 * I420Size(640, 360),
+            pyramid.bytes_read());
+}
+
+TEST(I420BufferPyramidTest, ScaledContentMatchesSource) {
+  rtc::scoped_refptr<I420Buffer> source = I420Buffer::Create(64, 64);
+  I420Buffer::SetBlack(source);
+  I420BufferPyramid pyramid(source);
+  rtc::scoped_refptr<I420BufferInterface> scaled = pyramid.GetScaled(16, 16);
+  for (int y = 0; y < 16; ++y) {
+    for (int x = 0; x < 16; ++x)
+      EXPECT_EQ(0, scaled->DataY()[y * scaled->StrideY() + x]);
+  }
+  for (int y = 0; y < 8; ++y) {
+    for (int x = 0; x < 8; ++x) {
+      EXPECT_EQ(128, scaled->DataU()[y * scaled->StrideU() + x]);
+      EXPECT_EQ(128, scaled->DataV()[y * scaled->StrideV() + x]);
+    }
+  }
+}
+
+TEST(I420BufferPyramidTest, ScalesUpFromSource) {
+  I420BufferPyramid pyramid(CreateGradient(160, 90));
+  rtc::scoped_refptr<I420BufferInterface> scaled = pyramid.GetScaled(320, 180);
+  EXPECT_EQ(320, scaled->width());
+  EXPECT_EQ(180, scaled->height());
+  EXPECT_EQ(I420Size(160, 90), pyramid.bytes_read());
+}
+
+TEST(I420BufferPyramidTest, AttachedPyramidIsSharedBetweenUsers) {
+  rtc::scoped_refptr<I420Buffer> source = CreateGradient(640, 360);
+  rtc::scoped_refptr<VideoFrameBuffer> buffer =
+      AttachI420BufferPyramid(source);
+  EXPECT_EQ(VideoFrameBuffer::Type::kI420, buffer->type());
+  EXPECT_EQ(source->DataY(), buffer->GetI420()->DataY());
+  EXPECT_FALSE(source->GetScaledI420(320, 180));
+
+  // Two users, e.g. the encoders of two send streams, get the same buffer.
+  I420BufferPyramid first(buffer);
+  I420BufferPyramid second(buffer);
+  rtc::scoped_refptr<I420BufferInterface> scaled = first.GetScaled(320, 180);
+  EXPECT_EQ(scaled.get(), second.GetScaled(320, 180).get());
+  EXPECT_EQ(0, first.bytes_read());
+  EXPECT_EQ(0, second.bytes_read());
+
+  // Attaching again doesn't add another pyramid.
+  EXPECT_EQ(buffer.get(), AttachI420BufferPyramid(buffer).get());
+}
+
+}  // namespace webrtc
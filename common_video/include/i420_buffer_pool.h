@@ -11,24 +11,40 @@
 #ifndef COMMON_VIDEO_INCLUDE_I420_BUFFER_POOL_H_
 #define COMMON_VIDEO_INCLUDE_I420_BUFFER_POOL_H_
 
-#include <list>
 #include <limits>
+#include <vector>
 
 #include "api/video/i420_buffer.h"
-#include "rtc_base/race_checker.h"
+#include "rtc_base/criticalsection.h"
 #include "rtc_base/refcountedobject.h"
+#include "rtc_base/thread_annotations.h"
 
 namespace webrtc {
 
 // Simple buffer pool to avoid unnecessary allocations of I420Buffer objects.
 // The pool manages the memory of the I420Buffer returned from CreateBuffer.
 // When the I420Buffer is destructed, the memory is returned to the pool for use
-// by subsequent calls to CreateBuffer. If the resolution passed to CreateBuffer
-// changes, old buffers will be purged from the pool.
-// Note that CreateBuffer will crash if more than kMaxNumberOfFramesBeforeCrash
-// are created. This is to prevent memory leaks where frames are not returned.
+// by subsequent calls to CreateBuffer. Buffers of the last
+// kMaxNumberOfResolutions resolutions are kept, so that switching between
+// e.g. simulcast layers or adapted resolutions doesn't reallocate them; the
+// buffers of the least recently used resolution are purged beyond that, and
+// so are those of a resolution that hasn't been requested in the last
+// kMaxIdleRequests calls to CreateBuffer. A purged buffer that is still in use
+// counts against |max_number_of_buffers| until it is returned.
+// The pool is thread safe, so it can be shared by several decoders.
 class I420BufferPool {
  public:
+  struct Stats {
+    // Number of buffers allocated by CreateBuffer.
+    int num_allocated_buffers = 0;
+    // Number of buffers CreateBuffer returned from the pool.
+    int num_reused_buffers = 0;
+  };
+
+  static constexpr size_t kMaxNumberOfResolutions = 4;
+  // About 10 seconds of 30 fps video.
+  static constexpr size_t kMaxIdleRequests = 300;
+
   I420BufferPool();
   explicit I420BufferPool(bool zero_initialize);
   I420BufferPool(bool zero_initialze, size_t max_number_of_buffers);
@@ -36,19 +52,50 @@ class I420BufferPool {
 
   // Returns a buffer from the pool. If no suitable buffer exist in the pool
   // and there are less than |max_number_of_buffers| pending, a buffer is
-  // created. Returns null otherwise.
+  // created, after purging unused buffers of other resolutions if the pool is
+  // full. Returns null otherwise.
   rtc::scoped_refptr<I420Buffer> CreateBuffer(int width, int height);
-  // Clears buffers_ and detaches the thread checker so that it can be reused
-  // later from another thread.
+  // Clears all buffers. Buffers that are still in use no longer count against
+  // |max_number_of_buffers|.
   void Release();
 
+  Stats GetStats() const;
+
  private:
   // Explicitly use a RefCountedObject to get access to HasOneRef,
   // needed by the pool to check exclusive access.
   using PooledI420Buffer = rtc::RefCountedObject<I420Buffer>;
 
-  rtc::RaceChecker race_checker_;
-  std::list<rtc::scoped_refptr<PooledI420Buffer>> buffers_;
+  using BufferList = std::vector<rtc::scoped_refptr<PooledI420Buffer>>;
+
+  // The buffers of one resolution.
+  struct Resolution {
+    int width;
+    int height;
+    // The value of |num_requests_| when the resolution was last requested.
+    size_t last_request;
+    BufferList buffers;
+  };
+
+  // Removes the buffers that are not in use from |buffers|.
+  void ReleaseUnusedBuffers(BufferList* buffers)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Removes |resolutions_[index]|, after moving its buffers that are in use
+  // to |evicted_buffers_|.
+  void EvictResolution(size_t index) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Evicts the resolutions, other than the most recently used one, that are
+  // idle, and releases the evicted buffers that have been returned.
+  void ReleaseIdleBuffers() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  rtc::CriticalSection crit_;
+  // Most recently used first.
+  std::vector<Resolution> resolutions_ RTC_GUARDED_BY(crit_);
+  // Buffers that were in use when their resolution was evicted.
+  BufferList evicted_buffers_ RTC_GUARDED_BY(crit_);
+  // The number of buffers in |resolutions_| and |evicted_buffers_|.
+  size_t num_buffers_ RTC_GUARDED_BY(crit_) = 0;
+  size_t num_requests_ RTC_GUARDED_BY(crit_) = 0;
+  Stats stats_ RTC_GUARDED_BY(crit_);
   // If true, newly allocated buffers are zero-initialized. Note that recycled
   // buffers are not zero'd before reuse. This is required of buffers used by
   // FFmpeg according to http://crbug.com/390941, which only requires it for the
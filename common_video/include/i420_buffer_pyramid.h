@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef COMMON_VIDEO_INCLUDE_I420_BUFFER_PYRAMID_H_
+#define COMMON_VIDEO_INCLUDE_I420_BUFFER_PYRAMID_H_
+
+#include <vector>
+
+#include "api/video/video_frame_buffer.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/scoped_ref_ptr.h"
+
+namespace webrtc {
+
+// Lazily computed downscaled versions of a frame buffer. Each resolution is
+// only scaled once, and is derived from the smallest already scaled version
+// that is at least as large, rather than from the full resolution frame. To
+// make that possible for the common case of simulcast layers, where each layer
+// has half the resolution of the next, going down more than a factor of two
+// goes through the intermediate halved resolutions, which are cached too.
+//
+// If the source buffer itself hands out shared scaled versions, see
+// VideoFrameBuffer::GetScaledI420(), those are used instead.
+//
+// The pyramid may be used from several threads; scaling is done under a lock
+// so that each resolution is computed once.
+class I420BufferPyramid {
+ public:
+  explicit I420BufferPyramid(rtc::scoped_refptr<VideoFrameBuffer> source);
+  ~I420BufferPyramid();
+
+  // Returns the source buffer scaled to |width| x |height|.
+  rtc::scoped_refptr<I420BufferInterface> GetScaled(int width, int height);
+
+  // Number of bytes of plane data that scaling has read so far. Compare with
+  // the size of the source times the number of scaled resolutions to see how
+  // much memory bandwidth sharing intermediate resolutions saves.
+  int64_t bytes_read() const;
+
+ private:
+  rtc::scoped_refptr<I420BufferInterface> ScaleLocked(
+      const rtc::scoped_refptr<I420BufferInterface>& from,
+      int width,
+      int height) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  const rtc::scoped_refptr<VideoFrameBuffer> source_;
+  rtc::CriticalSection crit_;
+  // The I420 version of |source_| followed by the scaled versions, largest
+  // first. Empty until the first call to GetScaled().
+  std::vector<rtc::scoped_refptr<I420BufferInterface>> levels_
+      RTC_GUARDED_BY(crit_);
+  int64_t bytes_read_ RTC_GUARDED_BY(crit_) = 0;
+};
+
+// Returns a buffer with the same contents as |buffer| that hands out shared
+// scaled versions of itself from GetScaledI420(), so that sinks that each
+// need the frame at a lower resolution, e.g. the encoders of several send
+// streams, share the scaling work. Buffers that are not I420 are returned as
+// they are.
+rtc::scoped_refptr<VideoFrameBuffer> AttachI420BufferPyramid(
+    rtc::scoped_refptr<VideoFrameBuffer> buffer);
+
+}  // namespace webrtc
+
+#endif  // COMMON_VIDEO_INCLUDE_I420_BUFFER_PYRAMID_H_
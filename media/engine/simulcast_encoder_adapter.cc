@@ -11,19 +11,28 @@
 #include "media/engine/simulcast_encoder_adapter.h"
 
 #include <algorithm>
+#include <cstring>
 
 
 #include "api/video/i420_buffer.h"
 #include "api/video_codecs/video_encoder_factory.h"
+#include "common_video/include/i420_buffer_pyramid.h"
 #include "media/engine/scopedvideoencoder.h"
 #include "modules/video_coding/codecs/vp8/screenshare_layers.h"
 #include "modules/video_coding/codecs/vp8/simulcast_rate_allocator.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/event.h"
+#include "rtc_base/function_view.h"
+#include "rtc_base/platform_thread.h"
 #include "system_wrappers/include/clock.h"
-#include "third_party/libyuv/include/libyuv/scale.h"
+#include "system_wrappers/include/field_trial.h"
 
 namespace {
 
+const char kParallelEncodeFieldTrial[] =
+    "WebRTC-SimulcastEncoderAdapter-ParallelEncode";
+
 const unsigned int kDefaultMinQp = 2;
 const unsigned int kDefaultMaxQp = 56;
 // Max qp for lowest spatial resolution when doing simulcast.
@@ -107,9 +116,121 @@ class AdapterEncodedImageCallback : public webrtc::EncodedImageCallback {
 
 namespace webrtc {
 
+// A fixed set of threads that, together with the calling thread, runs the
+// encode calls of the different streams of a frame.
+class SimulcastEncoderAdapter::EncodeWorkers {
+ public:
+  explicit EncodeWorkers(size_t num_threads) {
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back(new Worker(this));
+      workers_.back()->thread.Start();
+    }
+  }
+
+  ~EncodeWorkers() {
+    {
+      rtc::CritScope lock(&crit_);
+      stop_ = true;
+    }
+    for (auto& worker : workers_) {
+      worker->wake_up.Set();
+      worker->thread.Stop();
+    }
+  }
+
+  size_t num_threads() const { return workers_.size(); }
+
+  // Runs |task| for each index in [0, num_tasks) and returns when all of them
+  // are done. Must not be called concurrently.
+  void ParallelFor(size_t num_tasks, rtc::FunctionView<void(size_t)> task) {
+    {
+      rtc::CritScope lock(&crit_);
+      RTC_DCHECK_EQ(num_tasks_, num_done_);
+      task_ = &task;
+      num_tasks_ = num_tasks;
+      next_task_ = 0;
+      num_done_ = 0;
+    }
+    // The calling thread takes part too, so one worker less is needed.
+    for (size_t i = 0; i + 1 < num_tasks && i < workers_.size(); ++i)
+      workers_[i]->wake_up.Set();
+    RunTasks();
+    while (true) {
+      {
+        rtc::CritScope lock(&crit_);
+        if (num_done_ == num_tasks_) {
+          task_ = nullptr;
+          return;
+        }
+      }
+      all_done_.Wait(rtc::Event::kForever);
+    }
+  }
+
+ private:
+  struct Worker {
+    explicit Worker(EncodeWorkers* workers)
+        : workers(workers),
+          wake_up(false, false),
+          thread(&EncodeWorkers::Run, this, "SimulcastEncoder") {}
+
+    EncodeWorkers* const workers;
+    rtc::Event wake_up;
+    rtc::PlatformThread thread;
+  };
+
+  static void Run(void* obj) {
+    Worker* worker = static_cast<Worker*>(obj);
+    while (true) {
+      worker->wake_up.Wait(rtc::Event::kForever);
+      {
+        rtc::CritScope lock(&worker->workers->crit_);
+        if (worker->workers->stop_)
+          return;
+      }
+      worker->workers->RunTasks();
+    }
+  }
+
+  // Runs tasks until there are no more to claim.
+  void RunTasks() {
+    while (true) {
+      rtc::FunctionView<void(size_t)>* task;
+      size_t index;
+      {
+        rtc::CritScope lock(&crit_);
+        if (!task_ || next_task_ == num_tasks_)
+          return;
+        task = task_;
+        index = next_task_++;
+      }
+      (*task)(index);
+      rtc::CritScope lock(&crit_);
+      if (++num_done_ == num_tasks_)
+        all_done_.Set();
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  rtc::Event all_done_{false, false};
+  rtc::CriticalSection crit_;
+  bool stop_ RTC_GUARDED_BY(crit_) = false;
+  rtc::FunctionView<void(size_t)>* task_ RTC_GUARDED_BY(crit_) = nullptr;
+  size_t num_tasks_ RTC_GUARDED_BY(crit_) = 0;
+  size_t next_task_ RTC_GUARDED_BY(crit_) = 0;
+  size_t num_done_ RTC_GUARDED_BY(crit_) = 0;
+};
+
 SimulcastEncoderAdapter::SimulcastEncoderAdapter(VideoEncoderFactory* factory)
+    : SimulcastEncoderAdapter(
+          factory,
+          field_trial::IsEnabled(kParallelEncodeFieldTrial)) {}
+
+SimulcastEncoderAdapter::SimulcastEncoderAdapter(VideoEncoderFactory* factory,
+                                                 bool parallel_encode)
     : inited_(0),
       factory_(factory),
+      parallel_encode_(parallel_encode),
       encoded_complete_callback_(nullptr),
       implementation_name_("SimulcastEncoderAdapter") {
   RTC_DCHECK(factory_);
@@ -251,6 +372,18 @@ int SimulcastEncoderAdapter::InitEncode(const VideoCodec* inst,
   // To save memory, don't store encoders that we don't use.
   DestroyStoredEncoders();
 
+  // The calling thread encodes one of the streams itself.
+  const size_t num_encode_threads =
+      parallel_encode_ && doing_simulcast
+          ? std::min(number_of_streams, number_of_cores) - 1
+          : 0;
+  if (num_encode_threads == 0) {
+    encode_workers_.reset();
+  } else if (!encode_workers_ ||
+             encode_workers_->num_threads() != num_encode_threads) {
+    encode_workers_.reset(new EncodeWorkers(num_encode_threads));
+  }
+
   rtc::AtomicOps::ReleaseStore(&inited_, 1);
 
   return WEBRTC_VIDEO_CODEC_OK;
@@ -288,69 +421,120 @@ int SimulcastEncoderAdapter::Encode(
     }
   }
 
-  int src_width = input_image.width();
-  int src_height = input_image.height();
+  const FrameType frame_type =
+      send_key_frame ? kVideoFrameKey : kVideoFrameDelta;
+  if (encode_workers_ && input_image.video_frame_buffer()->type() !=
+                             VideoFrameBuffer::Type::kNative) {
+    return EncodeStreamsInParallel(input_image, codec_specific_info,
+                                   frame_type);
+  }
+
+  // The lower resolution streams are scaled from each other rather than all
+  // from the input frame.
+  I420BufferPyramid pyramid(input_image.video_frame_buffer());
   for (size_t stream_idx = 0; stream_idx < streaminfos_.size(); ++stream_idx) {
     // Don't encode frames in resolutions that we don't intend to send.
     if (!streaminfos_[stream_idx].send_stream) {
       continue;
     }
-
-    std::vector<FrameType> stream_frame_types;
     if (send_key_frame) {
-      stream_frame_types.push_back(kVideoFrameKey);
       streaminfos_[stream_idx].key_frame_request = false;
-    } else {
-      stream_frame_types.push_back(kVideoFrameDelta);
     }
-
-    int dst_width = streaminfos_[stream_idx].width;
-    int dst_height = streaminfos_[stream_idx].height;
-    // If scaling isn't required, because the input resolution
-    // matches the destination or the input image is empty (e.g.
-    // a keyframe request for encoders with internal camera
-    // sources) or the source image has a native handle, pass the image on
-    // directly. Otherwise, we'll scale it to match what the encoder expects
-    // (below).
-    // For texture frames, the underlying encoder is expected to be able to
-    // correctly sample/scale the source texture.
-    // TODO(perkj): ensure that works going forward, and figure out how this
-    // affects webrtc:5683.
-    if ((dst_width == src_width && dst_height == src_height) ||
-        input_image.video_frame_buffer()->type() ==
-            VideoFrameBuffer::Type::kNative) {
-      int ret = streaminfos_[stream_idx].encoder->Encode(
-          input_image, codec_specific_info, &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
-      }
-    } else {
-      rtc::scoped_refptr<I420Buffer> dst_buffer =
-          I420Buffer::Create(dst_width, dst_height);
-      rtc::scoped_refptr<I420BufferInterface> src_buffer =
-          input_image.video_frame_buffer()->ToI420();
-      libyuv::I420Scale(src_buffer->DataY(), src_buffer->StrideY(),
-                        src_buffer->DataU(), src_buffer->StrideU(),
-                        src_buffer->DataV(), src_buffer->StrideV(), src_width,
-                        src_height, dst_buffer->MutableDataY(),
-                        dst_buffer->StrideY(), dst_buffer->MutableDataU(),
-                        dst_buffer->StrideU(), dst_buffer->MutableDataV(),
-                        dst_buffer->StrideV(), dst_width, dst_height,
-                        libyuv::kFilterBilinear);
-
-      int ret = streaminfos_[stream_idx].encoder->Encode(
-          VideoFrame(dst_buffer, input_image.timestamp(),
-                     input_image.render_time_ms(), webrtc::kVideoRotation_0),
-          codec_specific_info, &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
-      }
+    int ret = EncodeStream(stream_idx, input_image, &pyramid,
+                           codec_specific_info, frame_type);
+    if (ret != WEBRTC_VIDEO_CODEC_OK) {
+      return ret;
     }
   }
 
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
+int SimulcastEncoderAdapter::EncodeStreamsInParallel(
+    const VideoFrame& input_image,
+    const CodecSpecificInfo* codec_specific_info,
+    FrameType frame_type) {
+  streams_to_encode_.clear();
+  for (size_t stream_idx = 0; stream_idx < streaminfos_.size(); ++stream_idx) {
+    StreamInfo& stream_info = streaminfos_[stream_idx];
+    if (!stream_info.send_stream) {
+      continue;
+    }
+    if (frame_type == kVideoFrameKey) {
+      stream_info.key_frame_request = false;
+    }
+    stream_info.defer_encoded_images = true;
+    stream_info.num_deferred_images = 0;
+    streams_to_encode_.push_back(stream_idx);
+  }
+
+  // Shared by the encode threads, so that the input is only converted to
+  // I420 once and each resolution is scaled once.
+  I420BufferPyramid pyramid(input_image.video_frame_buffer());
+  int results[kMaxSimulcastStreams];
+  encode_workers_->ParallelFor(
+      streams_to_encode_.size(), [&](size_t i) {
+        results[i] = EncodeStream(streams_to_encode_[i], input_image, &pyramid,
+                                  codec_specific_info, frame_type);
+      });
+
+  // Deliver the encoded images in stream order, and report the first error
+  // like a sequential encode would.
+  int ret = WEBRTC_VIDEO_CODEC_OK;
+  for (size_t i = 0; i < streams_to_encode_.size(); ++i) {
+    const size_t stream_idx = streams_to_encode_[i];
+    StreamInfo& stream_info = streaminfos_[stream_idx];
+    stream_info.defer_encoded_images = false;
+    for (size_t j = 0; j < stream_info.num_deferred_images; ++j) {
+      const DeferredImage& deferred = *stream_info.deferred_images[j];
+      OnEncodedImage(stream_idx, deferred.encoded_image,
+                     &deferred.codec_specific_info,
+                     deferred.has_fragmentation ? &deferred.fragmentation
+                                                : nullptr);
+    }
+    stream_info.num_deferred_images = 0;
+    if (ret == WEBRTC_VIDEO_CODEC_OK) {
+      ret = results[i];
+    }
+  }
+  return ret;
+}
+
+int SimulcastEncoderAdapter::EncodeStream(
+    size_t stream_idx,
+    const VideoFrame& input_image,
+    I420BufferPyramid* pyramid,
+    const CodecSpecificInfo* codec_specific_info,
+    FrameType frame_type) {
+  std::vector<FrameType> stream_frame_types(1, frame_type);
+  int src_width = input_image.width();
+  int src_height = input_image.height();
+  int dst_width = streaminfos_[stream_idx].width;
+  int dst_height = streaminfos_[stream_idx].height;
+  // If scaling isn't required, because the input resolution
+  // matches the destination or the input image is empty (e.g.
+  // a keyframe request for encoders with internal camera
+  // sources) or the source image has a native handle, pass the image on
+  // directly. Otherwise, we'll scale it to match what the encoder expects
+  // (below).
+  // For texture frames, the underlying encoder is expected to be able to
+  // correctly sample/scale the source texture.
+  // TODO(perkj): ensure that works going forward, and figure out how this
+  // affects webrtc:5683.
+  if ((dst_width == src_width && dst_height == src_height) ||
+      input_image.video_frame_buffer()->type() ==
+          VideoFrameBuffer::Type::kNative) {
+    return streaminfos_[stream_idx].encoder->Encode(
+        input_image, codec_specific_info, &stream_frame_types);
+  }
+
+  return streaminfos_[stream_idx].encoder->Encode(
+      VideoFrame(pyramid->GetScaled(dst_width, dst_height),
+                 input_image.timestamp(), input_image.render_time_ms(),
+                 webrtc::kVideoRotation_0),
+      codec_specific_info, &stream_frame_types);
+}
+
 int SimulcastEncoderAdapter::RegisterEncodeCompleteCallback(
     EncodedImageCallback* callback) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&encoder_queue_);
@@ -430,6 +614,14 @@ EncodedImageCallback::Result SimulcastEncoderAdapter::OnEncodedImage(
     const EncodedImage& encodedImage,
     const CodecSpecificInfo* codecSpecificInfo,
     const RTPFragmentationHeader* fragmentation) {
+  if (streaminfos_[stream_idx].defer_encoded_images) {
+    // Called on an encode thread, see EncodeStreamsInParallel().
+    DeferEncodedImage(&streaminfos_[stream_idx], encodedImage,
+                      codecSpecificInfo, fragmentation);
+    return EncodedImageCallback::Result(EncodedImageCallback::Result::OK,
+                                        encodedImage._timeStamp);
+  }
+
   CodecSpecificInfo stream_codec_specific = *codecSpecificInfo;
   stream_codec_specific.codec_name = implementation_name_.c_str();
   CodecSpecificInfoVP8* vp8Info = &(stream_codec_specific.codecSpecific.VP8);
@@ -439,6 +631,30 @@ EncodedImageCallback::Result SimulcastEncoderAdapter::OnEncodedImage(
       encodedImage, &stream_codec_specific, fragmentation);
 }
 
+void SimulcastEncoderAdapter::DeferEncodedImage(
+    StreamInfo* stream_info,
+    const EncodedImage& encoded_image,
+    const CodecSpecificInfo* codec_specific_info,
+    const RTPFragmentationHeader* fragmentation) {
+  if (stream_info->num_deferred_images == stream_info->deferred_images.size()) {
+    stream_info->deferred_images.emplace_back(new DeferredImage());
+  }
+  DeferredImage* deferred =
+      stream_info->deferred_images[stream_info->num_deferred_images++].get();
+  // The encoder may reuse its buffer as soon as this returns, so the payload
+  // is copied to a buffer that is kept between frames.
+  deferred->encoded_image = encoded_image;
+  deferred->buffer.assign(encoded_image._buffer,
+                          encoded_image._buffer + encoded_image._length);
+  deferred->encoded_image._buffer = deferred->buffer.data();
+  deferred->encoded_image._size = deferred->buffer.size();
+  deferred->codec_specific_info = *codec_specific_info;
+  deferred->has_fragmentation = fragmentation != nullptr;
+  if (fragmentation) {
+    deferred->fragmentation.CopyFrom(*fragmentation);
+  }
+}
+
 void SimulcastEncoderAdapter::PopulateStreamCodec(
     const webrtc::VideoCodec& inst,
     int stream_index,
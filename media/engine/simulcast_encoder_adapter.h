@@ -19,12 +19,14 @@
 #include <vector>
 
 #include "media/engine/webrtcvideoencoderfactory.h"
+#include "modules/include/module_common_types.h"
 #include "modules/video_coding/codecs/vp8/include/vp8.h"
 #include "rtc_base/atomicops.h"
 #include "rtc_base/sequenced_task_checker.h"
 
 namespace webrtc {
 
+class I420BufferPyramid;
 class SimulcastRateAllocator;
 class VideoEncoderFactory;
 
@@ -35,6 +37,12 @@ class VideoEncoderFactory;
 class SimulcastEncoderAdapter : public VP8Encoder {
  public:
   explicit SimulcastEncoderAdapter(VideoEncoderFactory* factory);
+  // If |parallel_encode| is true, the simulcast streams of a frame are scaled
+  // and encoded concurrently, on up to |number_of_cores| threads, instead of
+  // one after the other. Encode() still returns once all streams have been
+  // encoded, and the encoded images are delivered in stream order. Frames
+  // with native buffers are always encoded on the calling thread.
+  SimulcastEncoderAdapter(VideoEncoderFactory* factory, bool parallel_encode);
   virtual ~SimulcastEncoderAdapter();
 
   // Implements VideoEncoder.
@@ -65,6 +73,18 @@ class SimulcastEncoderAdapter : public VP8Encoder {
   const char* ImplementationName() const override;
 
  private:
+  class EncodeWorkers;
+
+  // An encoded image that is held back while the streams are encoded in
+  // parallel, so that images can be delivered in stream order.
+  struct DeferredImage {
+    EncodedImage encoded_image;
+    std::vector<uint8_t> buffer;
+    CodecSpecificInfo codec_specific_info;
+    bool has_fragmentation = false;
+    RTPFragmentationHeader fragmentation;
+  };
+
   struct StreamInfo {
     StreamInfo(std::unique_ptr<VideoEncoder> encoder,
                std::unique_ptr<EncodedImageCallback> callback,
@@ -83,6 +103,12 @@ class SimulcastEncoderAdapter : public VP8Encoder {
     uint16_t height;
     bool key_frame_request;
     bool send_stream;
+    // True while the stream is being encoded in parallel with other streams.
+    bool defer_encoded_images = false;
+    // Images held back while |defer_encoded_images| is true. Entries are
+    // reused between frames; only the first |num_deferred_images| are valid.
+    std::vector<std::unique_ptr<DeferredImage>> deferred_images;
+    size_t num_deferred_images = 0;
   };
 
   // Populate the codec settings for each simulcast stream.
@@ -96,8 +122,24 @@ class SimulcastEncoderAdapter : public VP8Encoder {
 
   void DestroyStoredEncoders();
 
+  // Scales |input_image| to the resolution of stream |stream_idx|, if needed,
+  // and encodes it. Scaled versions of the input are taken from |pyramid|.
+  int EncodeStream(size_t stream_idx,
+                   const VideoFrame& input_image,
+                   I420BufferPyramid* pyramid,
+                   const CodecSpecificInfo* codec_specific_info,
+                   FrameType frame_type);
+  int EncodeStreamsInParallel(const VideoFrame& input_image,
+                              const CodecSpecificInfo* codec_specific_info,
+                              FrameType frame_type);
+  void DeferEncodedImage(StreamInfo* stream_info,
+                         const EncodedImage& encoded_image,
+                         const CodecSpecificInfo* codec_specific_info,
+                         const RTPFragmentationHeader* fragmentation);
+
   volatile int inited_;  // Accessed atomically.
   VideoEncoderFactory* const factory_;
+  const bool parallel_encode_;
   VideoCodec codec_;
   std::vector<StreamInfo> streaminfos_;
   EncodedImageCallback* encoded_complete_callback_;
@@ -109,6 +151,12 @@ class SimulcastEncoderAdapter : public VP8Encoder {
   // Store encoders in between calls to Release and InitEncode, so they don't
   // have to be recreated. Remaining encoders are destroyed by the destructor.
   std::stack<std::unique_ptr<VideoEncoder>> stored_encoders_;
+
+  // Threads that encode streams in parallel with the encoder task queue. Only
+  // used if |parallel_encode_| is set and there is more than one core.
+  std::unique_ptr<EncodeWorkers> encode_workers_;
+  // Indices of the streams to encode for the current frame.
+  std::vector<size_t> streams_to_encode_;
 };
 
 }  // namespace webrtc
@@ -9,17 +9,23 @@
  */
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <vector>
 
 #include "api/video_codecs/sdp_video_format.h"
 #include "api/video_codecs/video_encoder_factory.h"
+#include "common_video/include/i420_buffer_pyramid.h"
 #include "common_video/include/video_frame_buffer.h"
 #include "media/engine/internalencoderfactory.h"
 #include "media/engine/simulcast_encoder_adapter.h"
 #include "modules/video_coding/codecs/vp8/simulcast_test_utility.h"
 #include "modules/video_coding/include/video_codec_interface.h"
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread_types.h"
 #include "rtc_base/ptr_util.h"
+#include "rtc_base/timeutils.h"
 #include "test/gmock.h"
 
 namespace webrtc {
@@ -814,5 +820,242 @@ TEST_F(TestSimulcastEncoderAdapterFake, TestInitFailureCleansUpEncoders) {
   EXPECT_TRUE(helper_->factory()->encoders().empty());
 }
 
+// Records the simulcast index of each encoded image, and the thread it was
+// delivered on.
+class SimulcastIndexRecorder : public EncodedImageCallback {
+ public:
+  Result OnEncodedImage(const EncodedImage& encoded_image,
+                        const CodecSpecificInfo* codec_specific_info,
+                        const RTPFragmentationHeader* fragmentation) override {
+    simulcast_indices_.push_back(
+        codec_specific_info->codecSpecific.VP8.simulcastIdx);
+    encoded_widths_.push_back(encoded_image._encodedWidth);
+    on_calling_thread_ &=
+        rtc::IsThreadRefEqual(calling_thread_, rtc::CurrentThreadRef());
+    return Result(Result::OK, encoded_image._timeStamp);
+  }
+
+  const std::vector<int>& simulcast_indices() const {
+    return simulcast_indices_;
+  }
+  const std::vector<uint32_t>& encoded_widths() const {
+    return encoded_widths_;
+  }
+  bool on_calling_thread() const { return on_calling_thread_; }
+
+ private:
+  const rtc::PlatformThreadRef calling_thread_ = rtc::CurrentThreadRef();
+  std::vector<int> simulcast_indices_;
+  std::vector<uint32_t> encoded_widths_;
+  bool on_calling_thread_ = true;
+};
+
+class TestSimulcastEncoderAdapterParallel : public ::testing::Test {
+ protected:
+  static constexpr int kNumberOfCores = 4;
+
+  TestSimulcastEncoderAdapterParallel() : adapter_(&factory_, true) {
+    TestVp8Simulcast::DefaultSettings(
+        &codec_, static_cast<const int*>(kTestTemporalLayerProfile));
+    EXPECT_EQ(0, adapter_.InitEncode(&codec_, kNumberOfCores, 1200));
+    adapter_.RegisterEncodeCompleteCallback(&recorder_);
+    SimulcastRateAllocator rate_allocator(codec_);
+    // Enough bitrate to send all streams.
+    adapter_.SetRateAllocation(rate_allocator.GetAllocation(5000 * 1000, 30),
+                               30);
+    input_buffer_ = I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+    input_buffer_->InitializeData();
+  }
+
+  ~TestSimulcastEncoderAdapterParallel() override { adapter_.Release(); }
+
+  int Encode() {
+    std::vector<FrameType> frame_types(3, kVideoFrameDelta);
+    return adapter_.Encode(
+        VideoFrame(input_buffer_, 90 * ++num_frames_, 0, kVideoRotation_0),
+        nullptr, &frame_types);
+  }
+
+  MockVideoEncoderFactory factory_;
+  SimulcastEncoderAdapter adapter_;
+  SimulcastIndexRecorder recorder_;
+  VideoCodec codec_;
+  rtc::scoped_refptr<I420Buffer> input_buffer_;
+  int num_frames_ = 0;
+};
+
+TEST_F(TestSimulcastEncoderAdapterParallel, EncodesStreamsConcurrently) {
+  std::vector<MockVideoEncoder*> encoders = factory_.encoders();
+  ASSERT_EQ(3u, encoders.size());
+
+  // The lowest stream can only finish once the highest stream has started,
+  // which would time out if the streams were encoded one after the other.
+  rtc::Event highest_stream_started(false, false);
+  bool waited_for_highest_stream = false;
+  EXPECT_CALL(*encoders[0], Encode(_, _, _))
+      .WillOnce(::testing::Invoke([&](const VideoFrame& frame,
+                                      const CodecSpecificInfo*,
+                                      const std::vector<FrameType>*) {
+        waited_for_highest_stream = highest_stream_started.Wait(5000);
+        encoders[0]->SendEncodedImage(frame.width(), frame.height());
+        return WEBRTC_VIDEO_CODEC_OK;
+      }));
+  EXPECT_CALL(*encoders[1], Encode(_, _, _))
+      .WillOnce(::testing::Invoke([&](const VideoFrame& frame,
+                                      const CodecSpecificInfo*,
+                                      const std::vector<FrameType>*) {
+        encoders[1]->SendEncodedImage(frame.width(), frame.height());
+        return WEBRTC_VIDEO_CODEC_OK;
+      }));
+  EXPECT_CALL(*encoders[2], Encode(_, _, _))
+      .WillOnce(::testing::Invoke([&](const VideoFrame& frame,
+                                      const CodecSpecificInfo*,
+                                      const std::vector<FrameType>*) {
+        highest_stream_started.Set();
+        encoders[2]->SendEncodedImage(frame.width(), frame.height());
+        return WEBRTC_VIDEO_CODEC_OK;
+      }));
+
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK, Encode());
+  EXPECT_TRUE(waited_for_highest_stream);
+  // Images are delivered in stream order, on the thread that called Encode().
+  EXPECT_THAT(recorder_.simulcast_indices(), ::testing::ElementsAre(0, 1, 2));
+  EXPECT_THAT(recorder_.encoded_widths(),
+              ::testing::ElementsAre(codec_.simulcastStream[0].width,
+                                     codec_.simulcastStream[1].width,
+                                     codec_.simulcastStream[2].width));
+  EXPECT_TRUE(recorder_.on_calling_thread());
+}
+
+TEST_F(TestSimulcastEncoderAdapterParallel, ReturnsErrorOfLowestStream) {
+  std::vector<MockVideoEncoder*> encoders = factory_.encoders();
+  ASSERT_EQ(3u, encoders.size());
+  EXPECT_CALL(*encoders[0], Encode(_, _, _))
+      .WillOnce(Return(WEBRTC_VIDEO_CODEC_OK));
+  EXPECT_CALL(*encoders[1], Encode(_, _, _))
+      .WillOnce(Return(WEBRTC_VIDEO_CODEC_FALLBACK_SOFTWARE));
+  EXPECT_CALL(*encoders[2], Encode(_, _, _))
+      .WillOnce(Return(WEBRTC_VIDEO_CODEC_ERROR));
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_FALLBACK_SOFTWARE, Encode());
+}
+
+// Compares the time it takes to encode a frame with the streams encoded one
+// after the other and in parallel, using fake encoders whose cost is
+// proportional to the number of pixels, like for a real encoder.
+// Disabled because it only logs timings. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(SimulcastEncoderAdapterBenchmark, DISABLED_EncodeLatency) {
+  const int kNumFrames = 30;
+  const int kPassesPerFrame = 20;
+  std::atomic<uint32_t> checksum(0);
+  int64_t latency_us[2];
+  for (bool parallel_encode : {false, true}) {
+    MockVideoEncoderFactory factory;
+    SimulcastEncoderAdapter adapter(&factory, parallel_encode);
+    VideoCodec codec;
+    TestVp8Simulcast::DefaultSettings(
+        &codec, static_cast<const int*>(kTestTemporalLayerProfile));
+    ASSERT_EQ(0, adapter.InitEncode(&codec, 4, 1200));
+    SimulcastIndexRecorder recorder;
+    adapter.RegisterEncodeCompleteCallback(&recorder);
+    SimulcastRateAllocator rate_allocator(codec);
+    adapter.SetRateAllocation(rate_allocator.GetAllocation(5000 * 1000, 30),
+                              30);
+    for (MockVideoEncoder* encoder : factory.encoders()) {
+      ON_CALL(*encoder, Encode(_, _, _))
+          .WillByDefault(::testing::Invoke([encoder, &checksum](
+              const VideoFrame& frame, const CodecSpecificInfo*,
+              const std::vector<FrameType>*) {
+            rtc::scoped_refptr<I420BufferInterface> buffer =
+                frame.video_frame_buffer()->ToI420();
+            uint32_t sum = 0;
+            for (int pass = 0; pass < kPassesPerFrame; ++pass) {
+              for (int y = 0; y < buffer->height(); ++y) {
+                const uint8_t* row = buffer->DataY() + y * buffer->StrideY();
+                for (int x = 0; x < buffer->width(); ++x)
+                  sum = sum * 31 + row[x] + pass;
+              }
+            }
+            checksum += sum;
+            encoder->SendEncodedImage(frame.width(), frame.height());
+            return WEBRTC_VIDEO_CODEC_OK;
+          }));
+    }
+
+    rtc::scoped_refptr<I420Buffer> input_buffer =
+        I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+    input_buffer->InitializeData();
+    std::vector<FrameType> frame_types(3, kVideoFrameDelta);
+    const int64_t start_us = rtc::TimeMicros();
+    for (int i = 0; i < kNumFrames; ++i) {
+      EXPECT_EQ(0, adapter.Encode(VideoFrame(input_buffer, 90 * i, 0,
+                                             kVideoRotation_0),
+                                  nullptr, &frame_types));
+    }
+    latency_us[parallel_encode] = (rtc::TimeMicros() - start_us) / kNumFrames;
+    EXPECT_EQ(3u * kNumFrames, recorder.simulcast_indices().size());
+    adapter.Release();
+  }
+  RTC_LOG(LS_INFO) << "Encode latency per frame: sequential "
+                   << latency_us[0] << " us, parallel " << latency_us[1]
+                   << " us.";
+}
+
+// Compares scaling the input to the resolutions of the lower streams directly
+// from the full resolution frame, like the adapter used to, with scaling
+// through an I420BufferPyramid.
+// Disabled by default, since it is a benchmark rather than a test.
+TEST(SimulcastEncoderAdapterBenchmark, DISABLED_ScalingMemoryBandwidth) {
+  const int kNumFrames = 30;
+  VideoCodec codec;
+  TestVp8Simulcast::DefaultSettings(
+      &codec, static_cast<const int*>(kTestTemporalLayerProfile));
+  rtc::scoped_refptr<I420Buffer> input_buffer =
+      I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+  input_buffer->InitializeData();
+  const int64_t input_size =
+      kDefaultWidth * kDefaultHeight +
+      2 * input_buffer->ChromaWidth() * input_buffer->ChromaHeight();
+
+  int64_t direct_bytes_read = 0;
+  const int64_t direct_start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumFrames; ++i) {
+    for (int stream = 0; stream < codec.numberOfSimulcastStreams - 1;
+         ++stream) {
+      rtc::scoped_refptr<I420Buffer> scaled = I420Buffer::Create(
+          codec.simulcastStream[stream].width,
+          codec.simulcastStream[stream].height);
+      scaled->ScaleFrom(*input_buffer);
+      direct_bytes_read += input_size;
+    }
+  }
+  const int64_t direct_us = rtc::TimeMicros() - direct_start_us;
+
+  int64_t pyramid_bytes_read = 0;
+  const int64_t pyramid_start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumFrames; ++i) {
+    I420BufferPyramid pyramid(input_buffer);
+    // The adapter encodes the lowest stream first.
+    for (int stream = 0; stream < codec.numberOfSimulcastStreams - 1;
+         ++stream) {
+      rtc::scoped_refptr<I420BufferInterface> scaled =
+          pyramid.GetScaled(codec.simulcastStream[stream].width,
+                            codec.simulcastStream[stream].height);
+      EXPECT_EQ(codec.simulcastStream[stream].width, scaled->width());
+    }
+    pyramid_bytes_read += pyramid.bytes_read();
+  }
+  const int64_t pyramid_us = rtc::TimeMicros() - pyramid_start_us;
+
+  EXPECT_LT(pyramid_bytes_read, direct_bytes_read);
+  RTC_LOG(LS_INFO) << "Scaling per frame: direct "
+                   << direct_bytes_read / kNumFrames << " bytes read in "
+                   << direct_us / kNumFrames << " us, pyramid "
+                   << pyramid_bytes_read / kNumFrames << " bytes read in "
+                   << pyramid_us / kNumFrames << " us, saving "
+                   << (direct_bytes_read - pyramid_bytes_read) / kNumFrames
+                   << " bytes per frame.";
+}
+
 }  // namespace testing
 }  // namespace webrtc
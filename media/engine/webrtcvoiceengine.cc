@@ -19,6 +19,7 @@
 #include <utility>
 #include <vector>
 
+#include "api/audio/audio_frame_pool.h"
 #include "api/audio_codecs/audio_codec_pair_id.h"
 #include "api/call/audio_sink.h"
 #include "media/base/audiosource.h"
@@ -912,7 +913,9 @@ class WebRtcVoiceMediaChannel::WebRtcAudioSendStream
     RTC_DCHECK_EQ(16, bits_per_sample);
     RTC_CHECK_RUNS_SERIALIZED(&audio_capture_race_checker_);
     RTC_DCHECK(stream_);
-    std::unique_ptr<webrtc::AudioFrame> audio_frame(new webrtc::AudioFrame());
+    rtc::scoped_refptr<webrtc::SharedAudioFrame> shared_frame =
+        audio_frame_pool_.CreateFrame();
+    webrtc::AudioFrame* audio_frame = shared_frame->mutable_frame();
     audio_frame->UpdateFrame(audio_frame->timestamp_,
                              static_cast<const int16_t*>(audio_data),
                              number_of_frames,
@@ -920,7 +923,7 @@ class WebRtcVoiceMediaChannel::WebRtcAudioSendStream
                              audio_frame->speech_type_,
                              audio_frame->vad_activity_,
                              number_of_channels);
-    stream_->SendAudioData(std::move(audio_frame));
+    stream_->SendAudioData(shared_frame);
   }
 
   // Callback from the |source_| when it is going away. In case Start() has
@@ -1090,6 +1093,8 @@ class WebRtcVoiceMediaChannel::WebRtcAudioSendStream
 
   rtc::ThreadChecker worker_thread_checker_;
   rtc::RaceChecker audio_capture_race_checker_;
+  // Avoids allocating a frame for each 10 ms of audio on the audio thread.
+  webrtc::AudioFramePool audio_frame_pool_;
   webrtc::Call* call_ = nullptr;
   webrtc::AudioSendStream::Config config_;
   const bool send_side_bwe_with_overhead_;
@@ -70,6 +70,7 @@ class AudioCodingModuleImpl final : public AudioCodingModule {
 
   // Add 10 ms of raw (PCM) audio data to the encoder.
   int Add10MsData(const AudioFrame& audio_frame) override;
+  int Add10MsData(const AudioFrame& audio_frame, uint32_t timestamp) override;
 
   /////////////////////////////////////////
   // (RED) Redundant Coding
@@ -233,7 +234,9 @@ class AudioCodingModuleImpl final : public AudioCodingModule {
       rtc::FunctionView<std::unique_ptr<AudioDecoder>()> isac_factory)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(acm_crit_sect_);
 
-  int Add10MsDataInternal(const AudioFrame& audio_frame, InputData* input_data)
+  int Add10MsDataInternal(const AudioFrame& audio_frame,
+                          uint32_t timestamp,
+                          InputData* input_data)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(acm_crit_sect_);
   int Encode(const InputData& input_data)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(acm_crit_sect_);
@@ -247,6 +250,7 @@ class AudioCodingModuleImpl final : public AudioCodingModule {
   // required, before pushing audio into encoder's buffer.
   //
   // in_frame: input audio-frame
+  // in_timestamp: timestamp of |in_frame|, used instead of its |timestamp_|.
   // ptr_out: pointer to output audio_frame. If no preprocessing is required
   //          |ptr_out| will be pointing to |in_frame|, otherwise pointing to
   //          |preprocess_frame_|.
@@ -255,6 +259,7 @@ class AudioCodingModuleImpl final : public AudioCodingModule {
   //   -1: if encountering an error.
   //    0: otherwise.
   int PreprocessToAddData(const AudioFrame& in_frame,
+                          uint32_t in_timestamp,
                           const AudioFrame** ptr_out)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(acm_crit_sect_);
 
@@ -655,13 +660,19 @@ int AudioCodingModuleImpl::RegisterTransportCallback(
 
 // Add 10MS of raw (PCM) audio data to the encoder.
 int AudioCodingModuleImpl::Add10MsData(const AudioFrame& audio_frame) {
+  return Add10MsData(audio_frame, audio_frame.timestamp_);
+}
+
+int AudioCodingModuleImpl::Add10MsData(const AudioFrame& audio_frame,
+                                       uint32_t timestamp) {
   InputData input_data;
   rtc::CritScope lock(&acm_crit_sect_);
-  int r = Add10MsDataInternal(audio_frame, &input_data);
+  int r = Add10MsDataInternal(audio_frame, timestamp, &input_data);
   return r < 0 ? r : Encode(input_data);
 }
 
 int AudioCodingModuleImpl::Add10MsDataInternal(const AudioFrame& audio_frame,
+                                               uint32_t timestamp,
                                                InputData* input_data) {
   if (audio_frame.samples_per_channel_ == 0) {
     assert(false);
@@ -698,7 +709,7 @@ int AudioCodingModuleImpl::Add10MsDataInternal(const AudioFrame& audio_frame,
   // performed before resampling (a down mix prior to resampling will take
   // place if both primary and secondary encoders are mono and input is in
   // stereo).
-  if (PreprocessToAddData(audio_frame, &ptr_frame) < 0) {
+  if (PreprocessToAddData(audio_frame, timestamp, &ptr_frame) < 0) {
     return -1;
   }
 
@@ -726,7 +737,8 @@ int AudioCodingModuleImpl::Add10MsDataInternal(const AudioFrame& audio_frame,
     ptr_audio = input_data->buffer;
 
   // TODO(yujo): Skip encode of muted frames.
-  input_data->input_timestamp = ptr_frame->timestamp_;
+  input_data->input_timestamp =
+      ptr_frame == &audio_frame ? timestamp : ptr_frame->timestamp_;
   input_data->audio = ptr_audio;
   input_data->length_per_channel = ptr_frame->samples_per_channel_;
   input_data->audio_channel = current_num_channels;
@@ -741,6 +753,7 @@ int AudioCodingModuleImpl::Add10MsDataInternal(const AudioFrame& audio_frame,
 // is required, |*ptr_out| points to |in_frame|.
 // TODO(yujo): Make this more efficient for muted frames.
 int AudioCodingModuleImpl::PreprocessToAddData(const AudioFrame& in_frame,
+                                               uint32_t in_timestamp,
                                                const AudioFrame** ptr_out) {
   const bool resample =
       in_frame.sample_rate_hz_ != encoder_stack_->SampleRateHz();
@@ -753,18 +766,18 @@ int AudioCodingModuleImpl::PreprocessToAddData(const AudioFrame& in_frame,
       in_frame.num_channels_ == 2 && encoder_stack_->NumChannels() == 1;
 
   if (!first_10ms_data_) {
-    expected_in_ts_ = in_frame.timestamp_;
-    expected_codec_ts_ = in_frame.timestamp_;
+    expected_in_ts_ = in_timestamp;
+    expected_codec_ts_ = in_timestamp;
     first_10ms_data_ = true;
-  } else if (in_frame.timestamp_ != expected_in_ts_) {
-    RTC_LOG(LS_WARNING) << "Unexpected input timestamp: " << in_frame.timestamp_
+  } else if (in_timestamp != expected_in_ts_) {
+    RTC_LOG(LS_WARNING) << "Unexpected input timestamp: " << in_timestamp
                         << ", expected: " << expected_in_ts_;
     expected_codec_ts_ +=
-        (in_frame.timestamp_ - expected_in_ts_) *
+        (in_timestamp - expected_in_ts_) *
         static_cast<uint32_t>(
             static_cast<double>(encoder_stack_->SampleRateHz()) /
             static_cast<double>(in_frame.sample_rate_hz_));
-    expected_in_ts_ = in_frame.timestamp_;
+    expected_in_ts_ = in_timestamp;
   }
 
 
@@ -1316,4 +1329,14 @@ bool AudioCodingModule::IsCodecValid(const CodecInst& codec) {
   return valid;
 }
 
+int32_t AudioCodingModule::Add10MsData(const AudioFrame& audio_frame,
+                                       uint32_t timestamp) {
+  if (audio_frame.timestamp_ == timestamp)
+    return Add10MsData(audio_frame);
+  AudioFrame frame;
+  frame.CopyFrom(audio_frame);
+  frame.timestamp_ = timestamp;
+  return Add10MsData(frame);
+}
+
 }  // namespace webrtc
@@ -285,6 +285,17 @@ class AudioCodingModule {
   //
   virtual int32_t Add10MsData(const AudioFrame& audio_frame) = 0;
 
+  ///////////////////////////////////////////////////////////////////////////
+  // int32_t Add10MsData()
+  // Same as above, but |timestamp| is used as the timestamp of |audio_frame|
+  // instead of its |timestamp_|. This lets a frame that is shared with other
+  // encoders be encoded without first being copied to set its timestamp.
+  // The default implementation copies the frame if the timestamps differ, and
+  // calls the function above.
+  //
+  virtual int32_t Add10MsData(const AudioFrame& audio_frame,
+                              uint32_t timestamp);
+
   ///////////////////////////////////////////////////////////////////////////
   // (RED) Redundant Coding
   //
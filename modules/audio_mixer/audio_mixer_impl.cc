@@ -17,8 +17,11 @@
 
 #include "modules/audio_mixer/audio_frame_manipulator.h"
 #include "modules/audio_mixer/default_output_rate_calculator.h"
+#include "rtc_base/event.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
 #include "rtc_base/refcountedobject.h"
+#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/field_trial.h"
 
 namespace webrtc {
@@ -90,6 +93,22 @@ AudioMixerImpl::SourceStatusList::const_iterator FindSourceInList(
       });
 }
 
+// Conceals the frame of a source that wasn't fetched in time by fading out its
+// last frame. A source that is late again is muted until it catches up, as is
+// a source whose last frame doesn't have the current mixing rate.
+AudioMixer::Source::AudioFrameInfo ConcealLateFrame(
+    int sample_rate_hz,
+    AudioMixerImpl::SourceStatus* source_status) {
+  if (!source_status->can_conceal ||
+      source_status->last_frame->sample_rate_hz_ != sample_rate_hz) {
+    source_status->can_conceal = false;
+    return AudioMixer::Source::AudioFrameInfo::kMuted;
+  }
+  Ramp(1.0f, 0.0f, source_status->last_frame);
+  source_status->can_conceal = false;
+  return AudioMixer::Source::AudioFrameInfo::kNormal;
+}
+
 FrameCombiner::LimiterType ChooseLimiterType(bool use_limiter) {
   using LimiterType = FrameCombiner::LimiterType;
   if (!use_limiter) {
@@ -102,14 +121,198 @@ FrameCombiner::LimiterType ChooseLimiterType(bool use_limiter) {
 }
 }  // namespace
 
+// Fetches the audio of the sources on worker threads, so that a source that is
+// slow to decode holds up neither the other sources nor, past the deadline,
+// the mixing.
+class AudioMixerImpl::FetchWorkers {
+ public:
+  using FetchState = SourceStatus::FetchState;
+
+  explicit FetchWorkers(size_t num_threads) {
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back(new Worker(this));
+      workers_.back()->thread.Start();
+    }
+  }
+
+  ~FetchWorkers() {
+    {
+      rtc::CritScope lock(&crit_);
+      stop_ = true;
+    }
+    for (auto& worker : workers_) {
+      worker->wake_up.Set();
+      worker->thread.Stop();
+    }
+  }
+
+  // Fetches a frame at |sample_rate_hz| from each of |sources| whose previous
+  // fetch is done, and waits until all of them are fetched or until
+  // |deadline_ms|. Sets |fetched_in_time| of each source. Must not be called
+  // concurrently.
+  void FetchFrames(const SourceStatusList& sources,
+                   int sample_rate_hz,
+                   int64_t deadline_ms) {
+    {
+      rtc::CritScope lock(&crit_);
+      RTC_DCHECK(jobs_.empty());
+      sample_rate_hz_ = sample_rate_hz;
+      for (const auto& source : sources) {
+        if (source->fetch_state != FetchState::kIdle)
+          continue;
+        source->fetch_state = FetchState::kQueued;
+        jobs_.push_back(source.get());
+      }
+      num_pending_ = jobs_.size();
+    }
+    // All workers are woken, since some may still be busy with late jobs.
+    for (auto& worker : workers_)
+      worker->wake_up.Set();
+
+    while (true) {
+      {
+        rtc::CritScope lock(&crit_);
+        if (num_pending_ == 0)
+          break;
+      }
+      const int64_t wait_ms = deadline_ms - rtc::TimeMillis();
+      if (wait_ms <= 0)
+        break;
+      all_done_.Wait(static_cast<int>(wait_ms));
+    }
+
+    // Jobs that haven't started are dropped. Jobs in progress finish in the
+    // background, and their frames are discarded.
+    rtc::CritScope lock(&crit_);
+    for (SourceStatus* source : jobs_) {
+      if (source->fetch_state == FetchState::kQueued)
+        source->fetch_state = FetchState::kIdle;
+      else if (source->fetch_state == FetchState::kFetching)
+        source->fetch_state = FetchState::kLate;
+    }
+    jobs_.clear();
+    next_job_ = 0;
+    for (const auto& source : sources) {
+      source->fetched_in_time = source->fetch_state == FetchState::kFetched;
+      if (source->fetched_in_time)
+        source->fetch_state = FetchState::kIdle;
+    }
+  }
+
+  // Waits until no frame is being fetched from |source|, so that it can be
+  // destroyed. |source| must no longer be in the list that is passed to
+  // FetchFrames().
+  void WaitForSource(SourceStatus* source) {
+    while (true) {
+      {
+        rtc::CritScope lock(&crit_);
+        if (source->fetch_state != FetchState::kFetching &&
+            source->fetch_state != FetchState::kLate) {
+          return;
+        }
+      }
+      source->late_fetch_done.Wait(rtc::Event::kForever);
+    }
+  }
+
+ private:
+  struct Worker {
+    explicit Worker(FetchWorkers* workers)
+        : workers(workers),
+          wake_up(false, false),
+          // The thread that mixes waits for the workers, so they run at the
+          // same priority as the audio device threads.
+          thread(&FetchWorkers::Run,
+                 this,
+                 "AudioMixerFetch",
+                 rtc::kRealtimePriority) {}
+
+    FetchWorkers* const workers;
+    rtc::Event wake_up;
+    rtc::PlatformThread thread;
+  };
+
+  static void Run(void* obj) {
+    Worker* worker = static_cast<Worker*>(obj);
+    while (true) {
+      worker->wake_up.Wait(rtc::Event::kForever);
+      {
+        rtc::CritScope lock(&worker->workers->crit_);
+        if (worker->workers->stop_)
+          return;
+      }
+      worker->workers->RunJobs();
+    }
+  }
+
+  // Runs jobs until there are no more to claim.
+  void RunJobs() {
+    while (true) {
+      SourceStatus* source;
+      int sample_rate_hz;
+      {
+        rtc::CritScope lock(&crit_);
+        if (next_job_ >= jobs_.size())
+          return;
+        source = jobs_[next_job_++];
+        RTC_DCHECK(source->fetch_state == FetchState::kQueued);
+        source->fetch_state = FetchState::kFetching;
+        sample_rate_hz = sample_rate_hz_;
+      }
+      const Source::AudioFrameInfo fetch_info =
+          source->audio_source->GetAudioFrameWithInfo(sample_rate_hz,
+                                                      source->fetch_frame);
+      {
+        rtc::CritScope lock(&crit_);
+        if (source->fetch_state == FetchState::kLate) {
+          source->fetch_state = FetchState::kIdle;
+          // Signaled under the lock, since WaitForSource() may destroy the
+          // source as soon as it sees the new state.
+          source->late_fetch_done.Set();
+        } else {
+          RTC_DCHECK(source->fetch_state == FetchState::kFetching);
+          source->fetch_state = FetchState::kFetched;
+          source->fetch_info = fetch_info;
+          if (--num_pending_ == 0)
+            all_done_.Set();
+        }
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  rtc::Event all_done_{false, false};
+  rtc::CriticalSection crit_;
+  bool stop_ RTC_GUARDED_BY(crit_) = false;
+  // The sources to fetch in the current call to FetchFrames(). The vector
+  // keeps its capacity between calls.
+  std::vector<SourceStatus*> jobs_ RTC_GUARDED_BY(crit_);
+  size_t next_job_ RTC_GUARDED_BY(crit_) = 0;
+  size_t num_pending_ RTC_GUARDED_BY(crit_) = 0;
+  int sample_rate_hz_ RTC_GUARDED_BY(crit_) = 0;
+};
+
 AudioMixerImpl::AudioMixerImpl(
     std::unique_ptr<OutputRateCalculator> output_rate_calculator,
     bool use_limiter)
+    : AudioMixerImpl(std::move(output_rate_calculator),
+                     use_limiter,
+                     ParallelFetchConfig()) {}
+
+AudioMixerImpl::AudioMixerImpl(
+    std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+    bool use_limiter,
+    const ParallelFetchConfig& parallel_fetch_config)
     : output_rate_calculator_(std::move(output_rate_calculator)),
       output_frequency_(0),
       sample_size_(0),
       audio_source_list_(),
-      frame_combiner_(ChooseLimiterType(use_limiter)) {}
+      frame_combiner_(ChooseLimiterType(use_limiter)),
+      parallel_fetch_config_(parallel_fetch_config) {
+  if (parallel_fetch_config_.num_threads > 0) {
+    fetch_workers_.reset(new FetchWorkers(parallel_fetch_config_.num_threads));
+  }
+}
 
 AudioMixerImpl::~AudioMixerImpl() {}
 
@@ -127,6 +330,16 @@ rtc::scoped_refptr<AudioMixerImpl> AudioMixerImpl::Create(
           std::move(output_rate_calculator), use_limiter));
 }
 
+rtc::scoped_refptr<AudioMixerImpl> AudioMixerImpl::Create(
+    std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+    bool use_limiter,
+    const ParallelFetchConfig& parallel_fetch_config) {
+  return rtc::scoped_refptr<AudioMixerImpl>(
+      new rtc::RefCountedObject<AudioMixerImpl>(
+          std::move(output_rate_calculator), use_limiter,
+          parallel_fetch_config));
+}
+
 void AudioMixerImpl::SetLimiterType(FrameCombiner::LimiterType limiter_type) {
   RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
   frame_combiner_.SetLimiterType(limiter_type);
@@ -142,14 +355,33 @@ void AudioMixerImpl::Mix(size_t number_of_channels,
   {
     rtc::CritScope lock(&crit_);
     const size_t number_of_streams = audio_source_list_.size();
-    frame_combiner_.Combine(GetAudioFromSources(), number_of_channels,
-                            OutputFrequency(), number_of_streams,
-                            audio_frame_for_mixing);
+    frame_combiner_.Combine(
+        GetAudioFromSources(kMaximumAmountOfMixedAudioSources, nullptr),
+        number_of_channels, OutputFrequency(), number_of_streams,
+        audio_frame_for_mixing);
   }
 
   return;
 }
 
+void AudioMixerImpl::MixSelectedSources(
+    size_t max_mixed_sources,
+    rtc::FunctionView<void(const AudioFrameList& mix_list,
+                           const std::vector<Source*>& mixed_sources,
+                           int sample_rate_hz,
+                           size_t number_of_streams)> mix) {
+  RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
+
+  CalculateOutputFrequency();
+
+  rtc::CritScope lock(&crit_);
+  const size_t number_of_streams = audio_source_list_.size();
+  std::vector<Source*> mixed_sources;
+  const AudioFrameList mix_list =
+      GetAudioFromSources(max_mixed_sources, &mixed_sources);
+  mix(mix_list, mixed_sources, OutputFrequency(), number_of_streams);
+}
+
 void AudioMixerImpl::CalculateOutputFrequency() {
   RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
   rtc::CritScope lock(&crit_);
@@ -183,30 +415,62 @@ bool AudioMixerImpl::AddSource(Source* audio_source) {
 
 void AudioMixerImpl::RemoveSource(Source* audio_source) {
   RTC_DCHECK(audio_source);
-  rtc::CritScope lock(&crit_);
-  const auto iter = FindSourceInList(audio_source, &audio_source_list_);
-  RTC_DCHECK(iter != audio_source_list_.end()) << "Source not present in mixer";
-  audio_source_list_.erase(iter);
+  std::unique_ptr<SourceStatus> source_status;
+  {
+    rtc::CritScope lock(&crit_);
+    const auto iter = FindSourceInList(audio_source, &audio_source_list_);
+    RTC_DCHECK(iter != audio_source_list_.end())
+        << "Source not present in mixer";
+    source_status =
+        std::move(audio_source_list_[iter - audio_source_list_.begin()]);
+    audio_source_list_.erase(iter);
+  }
+  // A late fetch may still be using the source. It is waited for without the
+  // lock, so that mixing isn't held up for as long as the fetch takes.
+  if (fetch_workers_)
+    fetch_workers_->WaitForSource(source_status.get());
 }
 
-AudioFrameList AudioMixerImpl::GetAudioFromSources() {
+AudioFrameList AudioMixerImpl::GetAudioFromSources(
+    size_t max_mixed_sources,
+    std::vector<Source*>* mixed_sources) {
   RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
   AudioFrameList result;
   std::vector<SourceFrame> audio_source_mixing_data_list;
   std::vector<SourceFrame> ramp_list;
 
+  if (fetch_workers_) {
+    fetch_workers_->FetchFrames(
+        audio_source_list_, OutputFrequency(),
+        rtc::TimeMillis() + parallel_fetch_config_.deadline_ms);
+  }
+
   // Get audio from the audio sources and put it in the SourceFrame vector.
   for (auto& source_and_status : audio_source_list_) {
-    const auto audio_frame_info =
-        source_and_status->audio_source->GetAudioFrameWithInfo(
-            OutputFrequency(), &source_and_status->audio_frame);
+    SourceStatus* const source_status = source_and_status.get();
+    AudioFrame* audio_frame;
+    Source::AudioFrameInfo audio_frame_info;
+    if (!fetch_workers_) {
+      audio_frame = &source_status->audio_frame;
+      audio_frame_info = source_status->audio_source->GetAudioFrameWithInfo(
+          OutputFrequency(), audio_frame);
+    } else if (source_status->fetched_in_time) {
+      std::swap(source_status->fetch_frame, source_status->last_frame);
+      audio_frame = source_status->last_frame;
+      audio_frame_info = source_status->fetch_info;
+      source_status->can_conceal =
+          audio_frame_info == Source::AudioFrameInfo::kNormal;
+    } else {
+      audio_frame = source_status->last_frame;
+      audio_frame_info = ConcealLateFrame(OutputFrequency(), source_status);
+    }
 
     if (audio_frame_info == Source::AudioFrameInfo::kError) {
       RTC_LOG_F(LS_WARNING) << "failed to GetAudioFrameWithInfo() from source";
       continue;
     }
     audio_source_mixing_data_list.emplace_back(
-        source_and_status.get(), &source_and_status->audio_frame,
+        source_status, audio_frame,
         audio_frame_info == Source::AudioFrameInfo::kMuted);
   }
 
@@ -214,7 +478,7 @@ AudioFrameList AudioMixerImpl::GetAudioFromSources() {
   std::sort(audio_source_mixing_data_list.begin(),
             audio_source_mixing_data_list.end(), ShouldMixBefore);
 
-  int max_audio_frame_counter = kMaximumAmountOfMixedAudioSources;
+  size_t max_audio_frame_counter = max_mixed_sources;
 
   // Go through list in order and put unmuted frames in result list.
   for (const auto& p : audio_source_mixing_data_list) {
@@ -229,6 +493,8 @@ AudioFrameList AudioMixerImpl::GetAudioFromSources() {
     if (max_audio_frame_counter > 0) {
       --max_audio_frame_counter;
       result.push_back(p.audio_frame);
+      if (mixed_sources)
+        mixed_sources->push_back(p.source_status->audio_source);
       ramp_list.emplace_back(p.source_status, p.audio_frame, false, -1);
       is_mixed = true;
     }
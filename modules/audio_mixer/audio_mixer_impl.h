@@ -18,6 +18,8 @@
 #include "modules/audio_mixer/frame_combiner.h"
 #include "modules/audio_mixer/output_rate_calculator.h"
 #include "modules/audio_processing/include/audio_processing.h"
+#include "rtc_base/event.h"
+#include "rtc_base/function_view.h"
 #include "rtc_base/race_checker.h"
 #include "rtc_base/scoped_ref_ptr.h"
 #include "rtc_base/thread_annotations.h"
@@ -38,6 +40,33 @@ class AudioMixerImpl : public AudioMixer {
 
     // A frame that will be passed to audio_source->GetAudioFrameWithInfo.
     AudioFrame audio_frame;
+
+    // The state of a source whose audio is fetched on the worker threads, see
+    // ParallelFetchConfig.
+    enum class FetchState {
+      kIdle,
+      kQueued,
+      kFetching,
+      kFetched,
+      // The fetch missed the deadline and its frame will be discarded.
+      kLate,
+    };
+
+    // The frame is fetched into |fetch_frame| on a worker thread, while
+    // |last_frame| holds the last frame that was fetched in time. They point
+    // to |audio_frame| and |spare_frame|, and are swapped when a frame is
+    // fetched in time. The fetch fields are guarded by the lock of the
+    // workers until the mixer has been handed the result.
+    AudioFrame spare_frame;
+    AudioFrame* fetch_frame = &audio_frame;
+    AudioFrame* last_frame = &spare_frame;
+    FetchState fetch_state = FetchState::kIdle;
+    Source::AudioFrameInfo fetch_info = Source::AudioFrameInfo::kError;
+    bool fetched_in_time = false;
+    // True if |last_frame| can be used to conceal a frame that is late.
+    bool can_conceal = false;
+    // Signaled when a late fetch is done.
+    rtc::Event late_fetch_done{false, false};
   };
 
   using SourceStatusList = std::vector<std::unique_ptr<SourceStatus>>;
@@ -46,12 +75,30 @@ class AudioMixerImpl : public AudioMixer {
   static const int kFrameDurationInMs = 10;
   static const int kMaximumAmountOfMixedAudioSources = 3;
 
+  // Settings for fetching the audio of the sources, which for a receive
+  // stream means decoding it, concurrently on worker threads instead of one
+  // after the other on the thread that calls Mix().
+  struct ParallelFetchConfig {
+    // Number of worker threads. If 0, the sources are fetched on the thread
+    // that calls Mix().
+    size_t num_threads = 0;
+    // How long Mix() waits for the sources. A source that misses the deadline
+    // is concealed by fading out its last frame, and isn't asked for audio
+    // again until the late fetch is done.
+    int deadline_ms = 5;
+  };
+
   static rtc::scoped_refptr<AudioMixerImpl> Create();
 
   static rtc::scoped_refptr<AudioMixerImpl> Create(
       std::unique_ptr<OutputRateCalculator> output_rate_calculator,
       bool use_limiter);
 
+  static rtc::scoped_refptr<AudioMixerImpl> Create(
+      std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+      bool use_limiter,
+      const ParallelFetchConfig& parallel_fetch_config);
+
   ~AudioMixerImpl() override;
 
   void SetLimiterType(FrameCombiner::LimiterType limiter_type);
@@ -72,17 +119,37 @@ class AudioMixerImpl : public AudioMixer {
  protected:
   AudioMixerImpl(std::unique_ptr<OutputRateCalculator> output_rate_calculator,
                  bool use_limiter);
+  AudioMixerImpl(std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+                 bool use_limiter,
+                 const ParallelFetchConfig& parallel_fetch_config);
+
+  // Fetches the audio of the sources and selects up to |max_mixed_sources| of
+  // them like Mix() does. Then calls |mix| with the selected frames in order
+  // of priority, their sources in the same order, the mixing rate and the
+  // number of sources. The sources can't be added or removed during the call,
+  // and the frames are only valid until it returns.
+  void MixSelectedSources(
+      size_t max_mixed_sources,
+      rtc::FunctionView<void(const AudioFrameList& mix_list,
+                             const std::vector<Source*>& mixed_sources,
+                             int sample_rate_hz,
+                             size_t number_of_streams)> mix)
+      RTC_LOCKS_EXCLUDED(crit_);
 
  private:
+  class FetchWorkers;
+
   // Set mixing frequency through OutputFrequencyCalculator.
   void CalculateOutputFrequency();
   // Get mixing frequency.
   int OutputFrequency() const;
 
   // Compute what audio sources to mix from audio_source_list_. Ramp
-  // in and out. Update mixed status. Mixes up to
-  // kMaximumAmountOfMixedAudioSources audio sources.
-  AudioFrameList GetAudioFromSources() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // in and out. Update mixed status. Mixes up to |max_mixed_sources| audio
+  // sources, and sets |mixed_sources| to their sources if not null.
+  AudioFrameList GetAudioFromSources(size_t max_mixed_sources,
+                                     std::vector<Source*>* mixed_sources)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Add/remove the MixerAudioSource to the specified
   // MixerAudioSource list.
@@ -108,6 +175,11 @@ class AudioMixerImpl : public AudioMixer {
   // Component that handles actual adding of audio frames.
   FrameCombiner frame_combiner_ RTC_GUARDED_BY(race_checker_);
 
+  const ParallelFetchConfig parallel_fetch_config_;
+  // Only set if |parallel_fetch_config_| has worker threads. Declared last, so
+  // that the workers are stopped before the sources are destroyed.
+  std::unique_ptr<FetchWorkers> fetch_workers_;
+
   RTC_DISALLOW_COPY_AND_ASSIGN(AudioMixerImpl);
 };
 }  // namespace webrtc
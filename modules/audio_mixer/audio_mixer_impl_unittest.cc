@@ -10,18 +10,29 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "api/audio/audio_mixer.h"
+#include "api/audio_codecs/opus/audio_decoder_opus.h"
+#include "api/audio_codecs/opus/audio_encoder_opus.h"
 #include "modules/audio_mixer/audio_mixer_impl.h"
 #include "modules/audio_mixer/default_output_rate_calculator.h"
+#include "modules/audio_mixer/sine_wave_generator.h"
 #include "rtc_base/bind.h"
+#include "rtc_base/buffer.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/task_queue_for_test.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/cpu_info.h"
+#include "system_wrappers/include/sleep.h"
 #include "test/gmock.h"
 
 using testing::_;
@@ -142,6 +153,79 @@ void MixAndCompare(
   }
 }
 
+rtc::scoped_refptr<AudioMixerImpl> CreateParallelFetchMixer(
+    size_t num_threads,
+    int deadline_ms) {
+  AudioMixerImpl::ParallelFetchConfig config;
+  config.num_threads = num_threads;
+  config.deadline_ms = deadline_ms;
+  return AudioMixerImpl::Create(
+      std::unique_ptr<OutputRateCalculator>(new DefaultOutputRateCalculator()),
+      true, config);
+}
+
+// A source that decodes a 10 ms Opus packet each time it is asked for audio,
+// like a receive stream does.
+class OpusSource : public AudioMixer::Source {
+ public:
+  OpusSource(const std::vector<rtc::Buffer>* packets, size_t first_packet)
+      : packets_(packets),
+        next_packet_(first_packet),
+        decoder_(AudioDecoderOpus::MakeAudioDecoder({1})) {}
+
+  AudioFrameInfo GetAudioFrameWithInfo(int sample_rate_hz,
+                                       AudioFrame* audio_frame) override {
+    const rtc::Buffer& packet = (*packets_)[next_packet_++ % packets_->size()];
+    AudioDecoder::SpeechType speech_type;
+    const int samples = decoder_->Decode(
+        packet.data(), packet.size(), sample_rate_hz,
+        AudioFrame::kMaxDataSizeBytes, audio_frame->mutable_data(),
+        &speech_type);
+    if (samples <= 0)
+      return AudioFrameInfo::kError;
+    audio_frame->sample_rate_hz_ = sample_rate_hz;
+    audio_frame->samples_per_channel_ = samples;
+    audio_frame->num_channels_ = 1;
+    audio_frame->vad_activity_ = AudioFrame::kVadActive;
+    audio_frame->speech_type_ = AudioFrame::kNormalSpeech;
+    return AudioFrameInfo::kNormal;
+  }
+
+  int Ssrc() const override { return 0; }
+  int PreferredSampleRate() const override { return kDefaultSampleRateHz; }
+
+ private:
+  const std::vector<rtc::Buffer>* const packets_;
+  size_t next_packet_;
+  const std::unique_ptr<AudioDecoder> decoder_;
+};
+
+// Encodes |num_packets| 10 ms Opus packets of a tone.
+std::vector<rtc::Buffer> EncodeOpusPackets(size_t num_packets) {
+  AudioEncoderOpusConfig config;
+  config.frame_size_ms = 10;
+  config.bitrate_bps = 32000;
+  std::unique_ptr<AudioEncoder> encoder =
+      AudioEncoderOpus::MakeAudioEncoder(config, 111);
+  SineWaveGenerator generator(440.f, 10000);
+  AudioFrame frame;
+  ResetFrame(&frame);
+  std::vector<rtc::Buffer> packets;
+  uint32_t rtp_timestamp = 0;
+  while (packets.size() < num_packets) {
+    generator.GenerateNextFrame(&frame);
+    rtc::Buffer packet;
+    encoder->Encode(rtp_timestamp,
+                    rtc::ArrayView<const int16_t>(frame.data(),
+                                                  frame.samples_per_channel_),
+                    &packet);
+    rtp_timestamp += frame.samples_per_channel_;
+    if (!packet.empty())
+      packets.push_back(std::move(packet));
+  }
+  return packets;
+}
+
 void MixMonoAtGivenNativeRate(int native_sample_rate,
                               AudioFrame* mix_frame,
                               rtc::scoped_refptr<AudioMixer> mixer,
@@ -531,4 +615,231 @@ TEST(AudioMixer, AnyRateIsPossibleWithNoLimiter) {
     }
   }
 }
+
+TEST(AudioMixer, ParallelFetchMixesLikeSequentialFetch) {
+  constexpr int kAudioSources =
+      AudioMixerImpl::kMaximumAmountOfMixedAudioSources + 3;
+
+  const auto sequential_mixer = AudioMixerImpl::Create();
+  const auto parallel_mixer = CreateParallelFetchMixer(2, 1000);
+  MockMixerAudioSource sequential_sources[kAudioSources];
+  MockMixerAudioSource parallel_sources[kAudioSources];
+  for (int i = 0; i < kAudioSources; ++i) {
+    for (MockMixerAudioSource* source :
+         {&sequential_sources[i], &parallel_sources[i]}) {
+      ResetFrame(source->fake_frame());
+      std::fill(source->fake_frame()->mutable_data(),
+                source->fake_frame()->mutable_data() +
+                    kDefaultSampleRateHz / 100,
+                100 * (i + 1));
+    }
+    EXPECT_TRUE(sequential_mixer->AddSource(&sequential_sources[i]));
+    EXPECT_TRUE(parallel_mixer->AddSource(&parallel_sources[i]));
+  }
+
+  for (int k = 0; k < 3; ++k) {
+    AudioFrame sequential_frame;
+    AudioFrame parallel_frame;
+    sequential_mixer->Mix(1, &sequential_frame);
+    parallel_mixer->Mix(1, &parallel_frame);
+
+    ASSERT_EQ(sequential_frame.samples_per_channel_,
+              parallel_frame.samples_per_channel_);
+    for (size_t j = 0; j < sequential_frame.samples_per_channel_; ++j)
+      ASSERT_EQ(sequential_frame.data()[j], parallel_frame.data()[j]);
+    for (int i = 0; i < kAudioSources; ++i) {
+      EXPECT_EQ(sequential_mixer->GetAudioSourceMixabilityStatusForTest(
+                    &sequential_sources[i]),
+                parallel_mixer->GetAudioSourceMixabilityStatusForTest(
+                    &parallel_sources[i]))
+          << "Mixed status of AudioSource #" << i << " differs.";
+    }
+  }
+}
+
+// A source that misses the deadline is concealed with its last frame once,
+// isn't asked for audio while it is still busy, and is muted after that.
+TEST(AudioMixer, LateSourceIsConcealedThenMuted) {
+  const auto mixer = CreateParallelFetchMixer(2, 10);
+  MockMixerAudioSource fast_source;
+  MockMixerAudioSource slow_source;
+  ResetFrame(fast_source.fake_frame());
+  ResetFrame(slow_source.fake_frame());
+  EXPECT_TRUE(mixer->AddSource(&fast_source));
+  EXPECT_TRUE(mixer->AddSource(&slow_source));
+
+  rtc::Event release(true, false);
+  auto fetch = [&slow_source](int sample_rate_hz, AudioFrame* audio_frame) {
+    audio_frame->CopyFrom(*slow_source.fake_frame());
+    return AudioMixer::Source::AudioFrameInfo::kNormal;
+  };
+  EXPECT_CALL(slow_source, GetAudioFrameWithInfo(_, _))
+      .WillOnce(Invoke(fetch))
+      .WillOnce(
+          Invoke([&](int sample_rate_hz, AudioFrame* audio_frame) {
+            release.Wait(rtc::Event::kForever);
+            return fetch(sample_rate_hz, audio_frame);
+          }));
+  EXPECT_CALL(fast_source, GetAudioFrameWithInfo(_, _)).Times(Exactly(3));
+
+  mixer->Mix(1, &frame_for_mixing);
+  EXPECT_TRUE(mixer->GetAudioSourceMixabilityStatusForTest(&slow_source));
+
+  // Late, and concealed with the last frame.
+  mixer->Mix(1, &frame_for_mixing);
+  EXPECT_TRUE(mixer->GetAudioSourceMixabilityStatusForTest(&fast_source));
+  EXPECT_TRUE(mixer->GetAudioSourceMixabilityStatusForTest(&slow_source));
+
+  // Still busy, so not asked for audio, and muted.
+  mixer->Mix(1, &frame_for_mixing);
+  EXPECT_TRUE(mixer->GetAudioSourceMixabilityStatusForTest(&fast_source));
+  EXPECT_FALSE(mixer->GetAudioSourceMixabilityStatusForTest(&slow_source));
+
+  // Removing the source waits for the late fetch.
+  release.Set();
+  mixer->RemoveSource(&slow_source);
+  mixer->RemoveSource(&fast_source);
+}
+
+// The last frame of a late source can't conceal it if the mixing rate has
+// changed since the frame was fetched.
+TEST(AudioMixer, LateSourceIsMutedWhenTheRateChanges) {
+  class SwitchableRateCalculator : public OutputRateCalculator {
+   public:
+    explicit SwitchableRateCalculator(const int* rate) : rate_(rate) {}
+    int CalculateOutputRate(const std::vector<int>& preferred_rates) override {
+      return *rate_;
+    }
+
+   private:
+    const int* const rate_;
+  };
+
+  int rate = kDefaultSampleRateHz;
+  AudioMixerImpl::ParallelFetchConfig config;
+  config.num_threads = 1;
+  config.deadline_ms = 10;
+  const auto mixer = AudioMixerImpl::Create(
+      std::unique_ptr<OutputRateCalculator>(
+          new SwitchableRateCalculator(&rate)),
+      true, config);
+  MockMixerAudioSource slow_source;
+  ResetFrame(slow_source.fake_frame());
+  EXPECT_TRUE(mixer->AddSource(&slow_source));
+
+  rtc::Event release(true, false);
+  EXPECT_CALL(slow_source, GetAudioFrameWithInfo(_, _))
+      .WillOnce(Invoke([&](int sample_rate_hz, AudioFrame* audio_frame) {
+        audio_frame->CopyFrom(*slow_source.fake_frame());
+        return AudioMixer::Source::AudioFrameInfo::kNormal;
+      }))
+      .WillOnce(Invoke([&](int sample_rate_hz, AudioFrame* audio_frame) {
+        release.Wait(rtc::Event::kForever);
+        return AudioMixer::Source::AudioFrameInfo::kMuted;
+      }));
+
+  mixer->Mix(1, &frame_for_mixing);
+  EXPECT_TRUE(mixer->GetAudioSourceMixabilityStatusForTest(&slow_source));
+
+  // Late, and the last frame has the old rate.
+  rate = 16000;
+  mixer->Mix(1, &frame_for_mixing);
+  EXPECT_FALSE(mixer->GetAudioSourceMixabilityStatusForTest(&slow_source));
+  EXPECT_EQ(16000, frame_for_mixing.sample_rate_hz_);
+
+  release.Set();
+  mixer->RemoveSource(&slow_source);
+}
+
+// Removing a source waits for its late fetch without holding up the mixing.
+TEST(AudioMixer, RemovingLateSourceDoesNotBlockMixing) {
+  const auto mixer = CreateParallelFetchMixer(2, 10);
+  MockMixerAudioSource fast_source;
+  MockMixerAudioSource slow_source;
+  ResetFrame(fast_source.fake_frame());
+  ResetFrame(slow_source.fake_frame());
+  EXPECT_TRUE(mixer->AddSource(&fast_source));
+  EXPECT_TRUE(mixer->AddSource(&slow_source));
+
+  rtc::Event release(true, false);
+  EXPECT_CALL(slow_source, GetAudioFrameWithInfo(_, _))
+      .WillOnce(Invoke([&](int sample_rate_hz, AudioFrame* audio_frame) {
+        release.Wait(rtc::Event::kForever);
+        return AudioMixer::Source::AudioFrameInfo::kMuted;
+      }));
+  // The mixer asks each of its sources for their preferred rate on each
+  // Mix().
+  int num_rate_queries = 0;
+  ON_CALL(slow_source, PreferredSampleRate())
+      .WillByDefault(Invoke([&num_rate_queries] {
+        ++num_rate_queries;
+        return kDefaultSampleRateHz;
+      }));
+  mixer->Mix(1, &frame_for_mixing);
+
+  rtc::Event removed(false, false);
+  rtc::test::TaskQueueForTest remove_queue("remove");
+  remove_queue.PostTask([&] {
+    mixer->RemoveSource(&slow_source);
+    removed.Set();
+  });
+
+  // Mix until the source is no longer in the mixer, while RemoveSource() is
+  // still waiting for the fetch.
+  bool unlinked = false;
+  for (int i = 0; i < 1000 && !unlinked; ++i) {
+    const int last_num_rate_queries = num_rate_queries;
+    mixer->Mix(1, &frame_for_mixing);
+    unlinked = num_rate_queries == last_num_rate_queries;
+    if (!unlinked)
+      SleepMs(1);
+  }
+  EXPECT_TRUE(unlinked);
+  EXPECT_FALSE(removed.Wait(0));
+
+  release.Set();
+  EXPECT_TRUE(removed.Wait(rtc::Event::kForever));
+  mixer->RemoveSource(&fast_source);
+}
+
+// Measures how long Mix() takes with 50 sources that decode Opus, when the
+// sources are fetched one after the other and in parallel.
+// Disabled because it only logs timings.
+TEST(AudioMixer, DISABLED_OpusSourcesBenchmark) {
+  constexpr size_t kNumSources = 50;
+  constexpr int kNumFrames = 500;
+  const std::vector<rtc::Buffer> packets = EncodeOpusPackets(100);
+  const size_t num_threads = CpuInfo::DetectNumberOfCores();
+
+  for (bool parallel : {false, true}) {
+    const auto mixer = parallel ? CreateParallelFetchMixer(num_threads, 8)
+                                : AudioMixerImpl::Create();
+    std::vector<std::unique_ptr<OpusSource>> sources;
+    for (size_t i = 0; i < kNumSources; ++i) {
+      sources.emplace_back(new OpusSource(&packets, i));
+      mixer->AddSource(sources.back().get());
+    }
+
+    int64_t total_us = 0;
+    int64_t max_us = 0;
+    int num_late_frames = 0;
+    for (int k = 0; k < kNumFrames; ++k) {
+      const int64_t start_us = rtc::TimeMicros();
+      mixer->Mix(1, &frame_for_mixing);
+      const int64_t elapsed_us = rtc::TimeMicros() - start_us;
+      total_us += elapsed_us;
+      max_us = std::max(max_us, elapsed_us);
+      if (elapsed_us > 10 * rtc::kNumMicrosecsPerMillisec)
+        ++num_late_frames;
+    }
+    RTC_LOG(LS_INFO) << (parallel ? "Parallel" : "Sequential") << " fetch of "
+                     << kNumSources << " Opus sources: "
+                     << total_us / kNumFrames << " us per frame on average, "
+                     << max_us << " us at most, " << num_late_frames
+                     << " frames over 10 ms.";
+
+    for (const auto& source : sources)
+      mixer->RemoveSource(source.get());
+  }
+}
 }  // namespace webrtc
@@ -250,13 +250,43 @@ void FrameCombiner::Combine(const std::vector<AudioFrame*>& mix_list,
   AudioFrameView<float> mixing_buffer_view(
       &channel_pointers[0], number_of_channels, samples_per_channel);
 
+  RunLimiter(mixing_buffer_view);
+
+  InterleaveToAudioFrame(mixing_buffer_view, audio_frame_for_mixing);
+}
+
+void FrameCombiner::CombineMixed(const std::vector<AudioFrame*>& mix_list,
+                                 AudioFrameView<float> mixing_buffer,
+                                 size_t number_of_streams,
+                                 AudioFrame* audio_frame_for_mixing) {
+  RTC_DCHECK(audio_frame_for_mixing);
+
+  const size_t number_of_channels = mixing_buffer.num_channels();
+  const int sample_rate =
+      static_cast<int>(mixing_buffer.samples_per_channel()) * 1000 /
+      AudioMixerImpl::kFrameDurationInMs;
+  SetAudioFrameFields(mix_list, number_of_channels, sample_rate,
+                      number_of_streams, audio_frame_for_mixing);
+
+  // As in Combine(), a single stream isn't limited.
+  if (number_of_streams <= 1) {
+    if (mix_list.empty()) {
+      audio_frame_for_mixing->Mute();
+      return;
+    }
+  } else {
+    RunLimiter(mixing_buffer);
+  }
+
+  InterleaveToAudioFrame(mixing_buffer, audio_frame_for_mixing);
+}
+
+void FrameCombiner::RunLimiter(AudioFrameView<float> mixing_buffer_view) {
   if (limiter_type_ == LimiterType::kApmAgcLimiter) {
     RunApmAgcLimiter(mixing_buffer_view, apm_agc_limiter_.get());
   } else if (limiter_type_ == LimiterType::kApmAgc2Limiter) {
     RunApmAgc2Limiter(mixing_buffer_view, &apm_agc2_limiter_);
   }
-
-  InterleaveToAudioFrame(mixing_buffer_view, audio_frame_for_mixing);
 }
 
 void FrameCombiner::LogMixingStats(const std::vector<AudioFrame*>& mix_list,
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "modules/audio_processing/agc2/fixed_gain_controller.h"
+#include "modules/audio_processing/include/audio_frame_view.h"
 #include "modules/audio_processing/include/audio_processing.h"
 
 namespace webrtc {
@@ -42,7 +43,17 @@ class FrameCombiner {
                size_t number_of_streams,
                AudioFrame* audio_frame_for_mixing);
 
+  // Like Combine(), for frames that have already been summed as FloatS16 in
+  // |mixing_buffer|, which is limited in place. The sample rate and the number
+  // of channels are those of |mixing_buffer|, and the frames in |mix_list|
+  // are only used to set the fields of |audio_frame_for_mixing|.
+  void CombineMixed(const std::vector<AudioFrame*>& mix_list,
+                    AudioFrameView<float> mixing_buffer,
+                    size_t number_of_streams,
+                    AudioFrame* audio_frame_for_mixing);
+
  private:
+  void RunLimiter(AudioFrameView<float> mixing_buffer_view);
   void LogMixingStats(const std::vector<AudioFrame*>& mix_list,
                       int sample_rate,
                       size_t number_of_streams) const;
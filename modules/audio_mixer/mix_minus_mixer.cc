@@ -0,0 +1,302 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_mixer/mix_minus_mixer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common_audio/resampler/include/push_resampler.h"
+#include "modules/audio_mixer/audio_frame_manipulator.h"
+#include "modules/audio_mixer/default_output_rate_calculator.h"
+#include "modules/audio_processing/include/audio_frame_view.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/refcountedobject.h"
+#include "typedefs.h"  // NOLINT(build/include)
+
+#if defined(WEBRTC_HAS_NEON)
+#include <arm_neon.h>
+#elif defined(WEBRTC_ARCH_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace webrtc {
+namespace {
+
+// Adds the |length| samples of |x| to |sum|.
+void AddToSum(const int16_t* x, size_t length, float* sum) {
+  size_t i = 0;
+#if defined(WEBRTC_HAS_NEON)
+  for (; i + 8 <= length; i += 8) {
+    const int16x8_t x16 = vld1q_s16(&x[i]);
+    const float32x4_t x_low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x16)));
+    const float32x4_t x_high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x16)));
+    vst1q_f32(&sum[i], vaddq_f32(vld1q_f32(&sum[i]), x_low));
+    vst1q_f32(&sum[i + 4], vaddq_f32(vld1q_f32(&sum[i + 4]), x_high));
+  }
+#elif defined(WEBRTC_ARCH_X86_FAMILY) && defined(__SSE2__)
+  for (; i + 8 <= length; i += 8) {
+    const __m128i x16 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]));
+    // Sign extends by unpacking each sample to the upper half of 32 bits.
+    const __m128 x_low =
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x16, x16), 16));
+    const __m128 x_high =
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x16, x16), 16));
+    _mm_storeu_ps(&sum[i], _mm_add_ps(_mm_loadu_ps(&sum[i]), x_low));
+    _mm_storeu_ps(&sum[i + 4], _mm_add_ps(_mm_loadu_ps(&sum[i + 4]), x_high));
+  }
+#endif
+  for (; i < length; ++i) {
+    sum[i] += x[i];
+  }
+}
+
+// Sets the |length| samples of |y| to |sum| - |x|.
+void SubtractFromSum(const float* sum,
+                     const int16_t* x,
+                     size_t length,
+                     float* y) {
+  size_t i = 0;
+#if defined(WEBRTC_HAS_NEON)
+  for (; i + 8 <= length; i += 8) {
+    const int16x8_t x16 = vld1q_s16(&x[i]);
+    const float32x4_t x_low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x16)));
+    const float32x4_t x_high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x16)));
+    vst1q_f32(&y[i], vsubq_f32(vld1q_f32(&sum[i]), x_low));
+    vst1q_f32(&y[i + 4], vsubq_f32(vld1q_f32(&sum[i + 4]), x_high));
+  }
+#elif defined(WEBRTC_ARCH_X86_FAMILY) && defined(__SSE2__)
+  for (; i + 8 <= length; i += 8) {
+    const __m128i x16 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]));
+    const __m128 x_low =
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x16, x16), 16));
+    const __m128 x_high =
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x16, x16), 16));
+    _mm_storeu_ps(&y[i], _mm_sub_ps(_mm_loadu_ps(&sum[i]), x_low));
+    _mm_storeu_ps(&y[i + 4], _mm_sub_ps(_mm_loadu_ps(&sum[i + 4]), x_high));
+  }
+#endif
+  for (; i < length; ++i) {
+    y[i] = sum[i] - x[i];
+  }
+}
+
+}  // namespace
+
+struct MixMinusMixer::Participant {
+  explicit Participant(FrameCombiner::LimiterType limiter_type)
+      : combiner(limiter_type) {}
+
+  FrameCombiner combiner;
+  // Resamples the mix of the participant while their own frame is subtracted
+  // from it.
+  PushResampler<float> resampler;
+};
+
+struct MixMinusMixer::SharedResampler {
+  PushResampler<float> resampler;
+  InterleavedBuffer everyone;
+};
+
+MixMinusMixer::MixMinusMixer(
+    std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+    FrameCombiner::LimiterType limiter_type)
+    : AudioMixerImpl(std::move(output_rate_calculator),
+                     limiter_type != FrameCombiner::LimiterType::kNoLimiter),
+      limiter_type_(limiter_type) {
+  SetLimiterType(limiter_type_);
+  participant_mix_list_.reserve(kMaximumAmountOfMixedAudioSources + 1);
+}
+
+MixMinusMixer::~MixMinusMixer() = default;
+
+rtc::scoped_refptr<MixMinusMixer> MixMinusMixer::Create(
+    FrameCombiner::LimiterType limiter_type) {
+  return Create(std::unique_ptr<DefaultOutputRateCalculator>(
+                    new DefaultOutputRateCalculator()),
+                limiter_type);
+}
+
+rtc::scoped_refptr<MixMinusMixer> MixMinusMixer::Create(
+    std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+    FrameCombiner::LimiterType limiter_type) {
+  return rtc::scoped_refptr<MixMinusMixer>(
+      new rtc::RefCountedObject<MixMinusMixer>(
+          std::move(output_rate_calculator), limiter_type));
+}
+
+bool MixMinusMixer::AddSource(Source* audio_source) {
+  RTC_DCHECK(audio_source);
+  if (!AudioMixerImpl::AddSource(audio_source))
+    return false;
+  rtc::CritScope lock(&participants_crit_);
+  // Never replaces the state of a participant that is already present.
+  participants_.emplace(audio_source,
+                        std::unique_ptr<Participant>(
+                            new Participant(limiter_type_)));
+  return true;
+}
+
+void MixMinusMixer::RemoveSource(Source* audio_source) {
+  RTC_DCHECK(audio_source);
+  AudioMixerImpl::RemoveSource(audio_source);
+  rtc::CritScope lock(&participants_crit_);
+  participants_.erase(audio_source);
+}
+
+void MixMinusMixer::MixMinus(size_t number_of_channels,
+                             rtc::ArrayView<const ParticipantMix> mixes) {
+  RTC_DCHECK(number_of_channels == 1 || number_of_channels == 2);
+  // One more source than AudioMixerImpl mixes is selected, so that a selected
+  // participant hears as many sources as everyone else.
+  MixSelectedSources(
+      kMaximumAmountOfMixedAudioSources + 1,
+      [&](const AudioFrameList& mix_list,
+          const std::vector<Source*>& mixed_sources, int sample_rate_hz,
+          size_t number_of_streams) {
+        MixForParticipants(mix_list, mixed_sources, sample_rate_hz,
+                           number_of_streams, number_of_channels, mixes);
+      });
+}
+
+void MixMinusMixer::MixForParticipants(
+    const AudioFrameList& mix_list,
+    const std::vector<Source*>& mixed_sources,
+    int sample_rate_hz,
+    size_t number_of_streams,
+    size_t number_of_channels,
+    rtc::ArrayView<const ParticipantMix> mixes) {
+  RTC_DCHECK_EQ(mix_list.size(), mixed_sources.size());
+  const size_t samples_per_channel =
+      static_cast<size_t>(sample_rate_hz * kFrameDurationInMs / 1000);
+  const size_t length = samples_per_channel * number_of_channels;
+
+  // The 'num_channels_' field of the frames could be different from
+  // 'number_of_channels'.
+  for (AudioFrame* frame : mix_list) {
+    RemixFrame(number_of_channels, frame);
+    RTC_DCHECK_EQ(samples_per_channel, frame->samples_per_channel_);
+  }
+
+  const size_t number_of_mixed = std::min<size_t>(
+      mix_list.size(), kMaximumAmountOfMixedAudioSources);
+  const AudioFrameList everyone_mix_list(mix_list.begin(),
+                                         mix_list.begin() + number_of_mixed);
+  std::fill(everyone_.begin(), everyone_.begin() + length, 0.f);
+  for (const AudioFrame* frame : everyone_mix_list) {
+    AddToSum(frame->data(), length, everyone_.data());
+  }
+  const float* const everyone_and_next =
+      mix_list.size() > number_of_mixed ? everyone_and_next_.data()
+                                        : everyone_.data();
+  if (mix_list.size() > number_of_mixed) {
+    std::copy(everyone_.begin(), everyone_.begin() + length,
+              everyone_and_next_.begin());
+    AddToSum(mix_list[number_of_mixed]->data(), length,
+             everyone_and_next_.data());
+  }
+
+  // Resamples |everyone_| once for each rate, including for the rates whose
+  // participants all have their own frame subtracted, so that the shared
+  // resamplers stay continuous.
+  for (const ParticipantMix& mix : mixes) {
+    if (mix.sample_rate_hz == sample_rate_hz ||
+        shared_resamplers_.count(mix.sample_rate_hz) > 0) {
+      continue;
+    }
+    shared_resamplers_[mix.sample_rate_hz].reset(new SharedResampler());
+  }
+  for (auto& rate_and_resampler : shared_resamplers_) {
+    SharedResampler* shared = rate_and_resampler.second.get();
+    shared->resampler.InitializeIfNeeded(
+        sample_rate_hz, rate_and_resampler.first, number_of_channels);
+    shared->resampler.Resample(everyone_.data(), length,
+                               shared->everyone.data(),
+                               shared->everyone.size());
+  }
+
+  rtc::CritScope lock(&participants_crit_);
+  for (const ParticipantMix& mix : mixes) {
+    RTC_DCHECK(mix.audio_frame);
+    const auto participant_iter = participants_.find(mix.participant);
+    RTC_DCHECK(participant_iter != participants_.end())
+        << "Participant not present in mixer";
+    if (participant_iter == participants_.end()) {
+      continue;
+    }
+    Participant* const participant = participant_iter->second.get();
+    // Everyone else is mixed for the participant.
+    const size_t number_of_other_streams =
+        number_of_streams > 0 ? number_of_streams - 1 : 0;
+
+    const auto own_source =
+        std::find(mixed_sources.begin(),
+                  mixed_sources.begin() + number_of_mixed, mix.participant);
+    if (own_source == mixed_sources.begin() + number_of_mixed) {
+      const float* const everyone =
+          mix.sample_rate_hz == sample_rate_hz
+              ? everyone_.data()
+              : shared_resamplers_[mix.sample_rate_hz]->everyone.data();
+      LimitAndWrite(everyone, number_of_channels, mix.sample_rate_hz,
+                    everyone_mix_list, number_of_other_streams, participant,
+                    mix.audio_frame);
+      continue;
+    }
+
+    const AudioFrame* const own_frame =
+        mix_list[own_source - mixed_sources.begin()];
+    participant_mix_list_.clear();
+    for (AudioFrame* frame : mix_list) {
+      if (frame != own_frame)
+        participant_mix_list_.push_back(frame);
+    }
+    SubtractFromSum(everyone_and_next, own_frame->data(), length,
+                    participant_buffer_.data());
+    const float* minus_own = participant_buffer_.data();
+    if (mix.sample_rate_hz != sample_rate_hz) {
+      participant->resampler.InitializeIfNeeded(
+          sample_rate_hz, mix.sample_rate_hz, number_of_channels);
+      participant->resampler.Resample(participant_buffer_.data(), length,
+                                      resampled_buffer_.data(),
+                                      resampled_buffer_.size());
+      minus_own = resampled_buffer_.data();
+    }
+    LimitAndWrite(minus_own, number_of_channels, mix.sample_rate_hz,
+                  participant_mix_list_, number_of_other_streams, participant,
+                  mix.audio_frame);
+  }
+}
+
+void MixMinusMixer::LimitAndWrite(const float* interleaved,
+                                  size_t number_of_channels,
+                                  int sample_rate_hz,
+                                  const std::vector<AudioFrame*>& mix_list,
+                                  size_t number_of_streams,
+                                  Participant* participant,
+                                  AudioFrame* audio_frame) {
+  const size_t samples_per_channel =
+      static_cast<size_t>(sample_rate_hz * kFrameDurationInMs / 1000);
+  std::array<float*, 2> channel_pointers{};
+  for (size_t i = 0; i < number_of_channels; ++i) {
+    channel_pointers[i] = channel_buffers_[i].data();
+    for (size_t j = 0; j < samples_per_channel; ++j) {
+      channel_buffers_[i][j] = interleaved[number_of_channels * j + i];
+    }
+  }
+  participant->combiner.CombineMixed(
+      mix_list,
+      AudioFrameView<float>(channel_pointers.data(), number_of_channels,
+                            samples_per_channel),
+      number_of_streams, audio_frame);
+}
+
+}  // namespace webrtc
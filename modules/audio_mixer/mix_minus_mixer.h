@@ -0,0 +1,132 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_MIXER_MIX_MINUS_MIXER_H_
+#define MODULES_AUDIO_MIXER_MIX_MINUS_MIXER_H_
+
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "api/array_view.h"
+#include "modules/audio_mixer/audio_mixer_impl.h"
+#include "modules/audio_mixer/frame_combiner.h"
+#include "modules/audio_mixer/output_rate_calculator.h"
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/scoped_ref_ptr.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Mixes a conference for each of its participants, e.g. on a server. Each
+// participant is a source of the mixer and gets the mix of everyone but
+// themselves, a "mix-minus". An AudioMixerImpl per participant would take
+// O(N^2) work for N participants. Instead, the sources are selected once like
+// AudioMixerImpl does and their frames are summed once. The mix of each
+// participant is then derived from the sum by subtracting their own frame if
+// it was selected. Each participant has their own limiter.
+//
+// A mix can have a different rate than the mixing rate. Then the shared sum is
+// resampled once for all the participants at that rate who don't have their
+// own frame subtracted.
+//
+// The mixes are the same as those of an AudioMixerImpl per participant that
+// mixes everyone else, except when the selection changes: a newly selected
+// source is ramped in for all of the participants at once, and a participant
+// who starts or stops being selected switches between their own resampler and
+// the shared one.
+class MixMinusMixer : public AudioMixerImpl {
+ public:
+  struct ParticipantMix {
+    // A source that has been added to the mixer.
+    Source* participant;
+    // The rate of the mix, which must be a native rate of AudioProcessing.
+    int sample_rate_hz;
+    AudioFrame* audio_frame;
+  };
+
+  static rtc::scoped_refptr<MixMinusMixer> Create(
+      FrameCombiner::LimiterType limiter_type);
+
+  static rtc::scoped_refptr<MixMinusMixer> Create(
+      std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+      FrameCombiner::LimiterType limiter_type);
+
+  ~MixMinusMixer() override;
+
+  // AudioMixer functions. Every source is a participant.
+  bool AddSource(Source* audio_source) override;
+  void RemoveSource(Source* audio_source) override;
+
+  // Mixes a frame with |number_of_channels| for each of |mixes|, with the
+  // audio of every participant except the one of the mix. Like Mix(), this
+  // fetches a new frame from every participant, so only one of MixMinus() and
+  // Mix() may be called every 10 ms. Calling both would drain the sources at
+  // twice real time and change which sources are ramped in on every call.
+  void MixMinus(size_t number_of_channels,
+                rtc::ArrayView<const ParticipantMix> mixes);
+
+ protected:
+  MixMinusMixer(std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+                FrameCombiner::LimiterType limiter_type);
+
+ private:
+  struct Participant;
+  struct SharedResampler;
+
+  using InterleavedBuffer = std::array<float, AudioFrame::kMaxDataSizeSamples>;
+
+  void MixForParticipants(const AudioFrameList& mix_list,
+                          const std::vector<Source*>& mixed_sources,
+                          int sample_rate_hz,
+                          size_t number_of_streams,
+                          size_t number_of_channels,
+                          rtc::ArrayView<const ParticipantMix> mixes);
+
+  // Limits |interleaved| with the limiter of |participant| and writes it to
+  // |audio_frame|.
+  void LimitAndWrite(const float* interleaved,
+                     size_t number_of_channels,
+                     int sample_rate_hz,
+                     const std::vector<AudioFrame*>& mix_list,
+                     size_t number_of_streams,
+                     Participant* participant,
+                     AudioFrame* audio_frame);
+
+  const FrameCombiner::LimiterType limiter_type_;
+
+  // Guards the participants separately from the sources of AudioMixerImpl,
+  // and is never held while adding or removing a source.
+  rtc::CriticalSection participants_crit_;
+  std::map<Source*, std::unique_ptr<Participant>> participants_
+      RTC_GUARDED_BY(participants_crit_);
+
+  // The buffers are only used by MixMinus(), and are kept between calls.
+  // The sum of the frames that a participant who isn't selected hears.
+  InterleavedBuffer everyone_;
+  // |everyone_| and the first frame that isn't in it, from which the frame of
+  // a selected participant is subtracted.
+  InterleavedBuffer everyone_and_next_;
+  InterleavedBuffer participant_buffer_;
+  InterleavedBuffer resampled_buffer_;
+  std::array<std::array<float, AudioFrame::kMaxDataSizeSamples / 2>, 2>
+      channel_buffers_;
+  std::vector<AudioFrame*> participant_mix_list_;
+  // |everyone_| resampled to each rate other than the mixing rate.
+  std::map<int, std::unique_ptr<SharedResampler>> shared_resamplers_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MixMinusMixer);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_MIXER_MIX_MINUS_MIXER_H_
@@ -0,0 +1,244 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_mixer/mix_minus_mixer.h"
+
+#include <memory>
+#include <vector>
+
+#include "api/audio/audio_mixer.h"
+#include "modules/audio_mixer/audio_mixer_impl.h"
+#include "modules/audio_mixer/default_output_rate_calculator.h"
+#include "modules/audio_mixer/sine_wave_generator.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/timeutils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kSampleRateHz = 48000;
+constexpr size_t kSamplesPerChannel = kSampleRateHz / 100;
+
+// A participant that says the same thing every 10 ms.
+class FakeParticipant : public AudioMixer::Source {
+ public:
+  FakeParticipant(float frequency, int16_t amplitude, bool active) {
+    frame_.sample_rate_hz_ = kSampleRateHz;
+    frame_.samples_per_channel_ = kSamplesPerChannel;
+    frame_.num_channels_ = 1;
+    frame_.vad_activity_ =
+        active ? AudioFrame::kVadActive : AudioFrame::kVadPassive;
+    frame_.speech_type_ = AudioFrame::kNormalSpeech;
+    SineWaveGenerator(frequency, amplitude).GenerateNextFrame(&frame_);
+  }
+
+  AudioFrameInfo GetAudioFrameWithInfo(int sample_rate_hz,
+                                       AudioFrame* audio_frame) override {
+    EXPECT_EQ(kSampleRateHz, sample_rate_hz);
+    audio_frame->CopyFrom(frame_);
+    return AudioFrameInfo::kNormal;
+  }
+
+  int Ssrc() const override { return 0; }
+  int PreferredSampleRate() const override { return kSampleRateHz; }
+
+ private:
+  AudioFrame frame_;
+};
+
+std::vector<std::unique_ptr<FakeParticipant>> CreateParticipants(
+    size_t number_of_participants) {
+  std::vector<std::unique_ptr<FakeParticipant>> participants;
+  for (size_t i = 0; i < number_of_participants; ++i) {
+    // Louder participants come first, and a few of them are talking.
+    participants.emplace_back(new FakeParticipant(
+        200.f + 50 * i, static_cast<int16_t>(8000 - 50 * i), i % 7 == 0));
+  }
+  return participants;
+}
+
+// Creates a mixer for each participant that mixes everyone else.
+std::vector<rtc::scoped_refptr<AudioMixerImpl>> CreateMixerPerParticipant(
+    const std::vector<std::unique_ptr<FakeParticipant>>& participants,
+    FrameCombiner::LimiterType limiter_type) {
+  std::vector<rtc::scoped_refptr<AudioMixerImpl>> mixers;
+  for (size_t i = 0; i < participants.size(); ++i) {
+    mixers.push_back(AudioMixerImpl::Create(
+        std::unique_ptr<OutputRateCalculator>(new DefaultOutputRateCalculator()),
+        false));
+    mixers.back()->SetLimiterType(limiter_type);
+    for (size_t j = 0; j < participants.size(); ++j) {
+      if (j != i)
+        mixers.back()->AddSource(participants[j].get());
+    }
+  }
+  return mixers;
+}
+
+rtc::scoped_refptr<MixMinusMixer> CreateMixMinusMixer(
+    const std::vector<std::unique_ptr<FakeParticipant>>& participants,
+    FrameCombiner::LimiterType limiter_type) {
+  rtc::scoped_refptr<MixMinusMixer> mixer =
+      MixMinusMixer::Create(limiter_type);
+  for (const auto& participant : participants)
+    mixer->AddSource(participant.get());
+  return mixer;
+}
+
+std::vector<MixMinusMixer::ParticipantMix> GetParticipantMixes(
+    const std::vector<std::unique_ptr<FakeParticipant>>& participants,
+    int sample_rate_hz,
+    std::vector<AudioFrame>* frames) {
+  RTC_DCHECK_EQ(participants.size(), frames->size());
+  std::vector<MixMinusMixer::ParticipantMix> mixes;
+  for (size_t i = 0; i < participants.size(); ++i) {
+    mixes.push_back({participants[i].get(), sample_rate_hz, &(*frames)[i]});
+  }
+  return mixes;
+}
+
+}  // namespace
+
+TEST(MixMinusMixerTest, MixesLikeAMixerPerParticipant) {
+  for (auto limiter_type : {FrameCombiner::LimiterType::kNoLimiter,
+                            FrameCombiner::LimiterType::kApmAgcLimiter,
+                            FrameCombiner::LimiterType::kApmAgc2Limiter}) {
+    const auto participants = CreateParticipants(9);
+    const auto mixers = CreateMixerPerParticipant(participants, limiter_type);
+    const auto mix_minus_mixer =
+        CreateMixMinusMixer(participants, limiter_type);
+
+    std::vector<AudioFrame> mix_minus_frames(participants.size());
+    const auto mixes =
+        GetParticipantMixes(participants, kSampleRateHz, &mix_minus_frames);
+    for (int k = 0; k < 10; ++k) {
+      mix_minus_mixer->MixMinus(1, mixes);
+      for (size_t i = 0; i < participants.size(); ++i) {
+        AudioFrame frame;
+        mixers[i]->Mix(1, &frame);
+        ASSERT_EQ(frame.samples_per_channel_,
+                  mix_minus_frames[i].samples_per_channel_);
+        for (size_t j = 0; j < frame.samples_per_channel_; ++j) {
+          ASSERT_EQ(frame.data()[j], mix_minus_frames[i].data()[j])
+              << "Participant " << i << ", frame " << k;
+        }
+      }
+    }
+  }
+}
+
+TEST(MixMinusMixerTest, ParticipantDoesNotHearThemselves) {
+  FakeParticipant talker(440.f, 5000, true);
+  FakeParticipant listener(440.f, 0, false);
+  FakeParticipant other_listener(440.f, 0, false);
+  const auto mixer =
+      MixMinusMixer::Create(FrameCombiner::LimiterType::kNoLimiter);
+  mixer->AddSource(&talker);
+  mixer->AddSource(&listener);
+  mixer->AddSource(&other_listener);
+
+  AudioFrame talker_frame;
+  AudioFrame listener_frame;
+  AudioFrame expected_frame;
+  talker.GetAudioFrameWithInfo(kSampleRateHz, &expected_frame);
+  const std::vector<MixMinusMixer::ParticipantMix> mixes = {
+      {&talker, kSampleRateHz, &talker_frame},
+      {&listener, kSampleRateHz, &listener_frame}};
+  // The talker is ramped in during the first frame.
+  for (int k = 0; k < 2; ++k)
+    mixer->MixMinus(1, mixes);
+
+  for (size_t j = 0; j < kSamplesPerChannel; ++j) {
+    EXPECT_EQ(0, talker_frame.data()[j]);
+    EXPECT_EQ(expected_frame.data()[j], listener_frame.data()[j]);
+  }
+}
+
+TEST(MixMinusMixerTest, MixesAtOtherRates) {
+  const auto participants = CreateParticipants(8);
+  const auto mixer = CreateMixMinusMixer(
+      participants, FrameCombiner::LimiterType::kNoLimiter);
+
+  std::vector<AudioFrame> frames(participants.size());
+  const auto mixes = GetParticipantMixes(participants, 16000, &frames);
+  for (int k = 0; k < 3; ++k)
+    mixer->MixMinus(2, mixes);
+
+  for (const AudioFrame& frame : frames) {
+    EXPECT_EQ(16000, frame.sample_rate_hz_);
+    EXPECT_EQ(160u, frame.samples_per_channel_);
+    EXPECT_EQ(2u, frame.num_channels_);
+  }
+  // The participants who aren't selected hear the same resampled mix.
+  std::vector<const AudioFrame*> not_mixed_frames;
+  for (size_t i = 0; i < participants.size(); ++i) {
+    if (!mixer->GetAudioSourceMixabilityStatusForTest(participants[i].get()))
+      not_mixed_frames.push_back(&frames[i]);
+  }
+  ASSERT_GE(not_mixed_frames.size(), 2u);
+  for (const AudioFrame* frame : not_mixed_frames) {
+    for (size_t j = 0; j < 2 * frame->samples_per_channel_; ++j)
+      ASSERT_EQ(not_mixed_frames[0]->data()[j], frame->data()[j]);
+  }
+}
+
+TEST(MixMinusMixerTest, RemovedParticipantIsNotMixed) {
+  const auto participants = CreateParticipants(2);
+  const auto mixer = CreateMixMinusMixer(
+      participants, FrameCombiner::LimiterType::kNoLimiter);
+  mixer->RemoveSource(participants[1].get());
+
+  AudioFrame frame;
+  const std::vector<MixMinusMixer::ParticipantMix> mixes = {
+      {participants[0].get(), kSampleRateHz, &frame}};
+  mixer->MixMinus(1, mixes);
+  EXPECT_TRUE(frame.muted());
+}
+
+// Measures how long it takes to mix a 100 participant conference, with a mixer
+// per participant and with a MixMinusMixer.
+// Disabled because it only logs timings.
+TEST(MixMinusMixerTest, DISABLED_ConferenceBenchmark) {
+  constexpr size_t kNumParticipants = 100;
+  constexpr int kNumFrames = 50;
+  const auto limiter_type = FrameCombiner::LimiterType::kApmAgc2Limiter;
+  const auto participants = CreateParticipants(kNumParticipants);
+  std::vector<AudioFrame> frames(participants.size());
+  const auto mixes =
+      GetParticipantMixes(participants, kSampleRateHz, &frames);
+
+  for (bool mix_minus : {false, true}) {
+    std::vector<rtc::scoped_refptr<AudioMixerImpl>> mixers;
+    rtc::scoped_refptr<MixMinusMixer> mix_minus_mixer;
+    if (mix_minus) {
+      mix_minus_mixer = CreateMixMinusMixer(participants, limiter_type);
+    } else {
+      mixers = CreateMixerPerParticipant(participants, limiter_type);
+    }
+
+    const int64_t start_us = rtc::TimeMicros();
+    for (int k = 0; k < kNumFrames; ++k) {
+      if (mix_minus) {
+        mix_minus_mixer->MixMinus(1, mixes);
+      } else {
+        for (size_t i = 0; i < kNumParticipants; ++i)
+          mixers[i]->Mix(1, &frames[i]);
+      }
+    }
+    const int64_t elapsed_us = rtc::TimeMicros() - start_us;
+    RTC_LOG(LS_INFO) << (mix_minus ? "MixMinusMixer" : "Mixer per participant")
+                     << ": " << elapsed_us / kNumFrames << " us per 10 ms for "
+                     << kNumParticipants << " participants.";
+  }
+}
+
+}  // namespace webrtc
@@ -21,6 +21,9 @@
 #include <functional>
 
 #include "modules/audio_processing/aec3/fft_data.h"
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include "modules/audio_processing/aec3/adaptive_fir_filter_avx2.h"
+#endif
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 
@@ -411,6 +414,29 @@ void ApplyFilter_SSE2(const RenderBuffer& render_buffer,
     X = &render_buffer_data[0];
   } while (j < lim2);
 }
+
+// Adapts the filter partitions. (AVX2 variant)
+void AdaptPartitions_AVX2(const RenderBuffer& render_buffer,
+                          const FftData& G,
+                          rtc::ArrayView<FftData> H) {
+  rtc::ArrayView<const FftData> render_buffer_data =
+      render_buffer.GetFftBuffer();
+  RTC_DCHECK_LT(render_buffer.Position(), render_buffer_data.size());
+  AdaptPartitionsKernel_AVX2(render_buffer_data.data(),
+                             render_buffer_data.size(),
+                             render_buffer.Position(), G, H.data(), H.size());
+}
+
+// Produces the filter output (AVX2 variant).
+void ApplyFilter_AVX2(const RenderBuffer& render_buffer,
+                      rtc::ArrayView<const FftData> H,
+                      FftData* S) {
+  rtc::ArrayView<const FftData> render_buffer_data =
+      render_buffer.GetFftBuffer();
+  RTC_DCHECK_LT(render_buffer.Position(), render_buffer_data.size());
+  ApplyFilterKernel_AVX2(render_buffer_data.data(), render_buffer_data.size(),
+                         render_buffer.Position(), H.data(), H.size(), S);
+}
 #endif
 
 }  // namespace aec3
@@ -537,6 +563,9 @@ void AdaptiveFirFilter::Filter(const RenderBuffer& render_buffer,
     case Aec3Optimization::kSse2:
       aec3::ApplyFilter_SSE2(render_buffer, H_, S);
       break;
+    case Aec3Optimization::kAvx2:
+      aec3::ApplyFilter_AVX2(render_buffer, H_, S);
+      break;
 #endif
 #if defined(WEBRTC_HAS_NEON)
     case Aec3Optimization::kNeon:
@@ -559,6 +588,9 @@ void AdaptiveFirFilter::Adapt(const RenderBuffer& render_buffer,
     case Aec3Optimization::kSse2:
       aec3::AdaptPartitions_SSE2(render_buffer, G, H_);
       break;
+    case Aec3Optimization::kAvx2:
+      aec3::AdaptPartitions_AVX2(render_buffer, G, H_);
+      break;
 #endif
 #if defined(WEBRTC_HAS_NEON)
     case Aec3Optimization::kNeon:
@@ -575,6 +607,7 @@ void AdaptiveFirFilter::Adapt(const RenderBuffer& render_buffer,
   // Update the frequency response and echo return loss for the filter.
   switch (optimization_) {
 #if defined(WEBRTC_ARCH_X86_FAMILY)
+    case Aec3Optimization::kAvx2:
     case Aec3Optimization::kSse2:
       aec3::UpdateFrequencyResponse_SSE2(H_, &H2_);
       aec3::UpdateErlEstimator_SSE2(H2_, &erl_);
@@ -69,6 +69,9 @@ void AdaptPartitions_NEON(const RenderBuffer& render_buffer,
 void AdaptPartitions_SSE2(const RenderBuffer& render_buffer,
                           const FftData& G,
                           rtc::ArrayView<FftData> H);
+void AdaptPartitions_AVX2(const RenderBuffer& render_buffer,
+                          const FftData& G,
+                          rtc::ArrayView<FftData> H);
 #endif
 
 // Produces the filter output.
@@ -84,6 +87,9 @@ void ApplyFilter_NEON(const RenderBuffer& render_buffer,
 void ApplyFilter_SSE2(const RenderBuffer& render_buffer,
                       rtc::ArrayView<const FftData> H,
                       FftData* S);
+void ApplyFilter_AVX2(const RenderBuffer& render_buffer,
+                      rtc::ArrayView<const FftData> H,
+                      FftData* S);
 #endif
 
 }  // namespace aec3
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/aec3/adaptive_fir_filter_avx2.h"
+
+#include <immintrin.h>
+
+namespace webrtc {
+
+namespace aec3 {
+
+// Adapts the filter partitions. (AVX2 variant)
+void AdaptPartitionsKernel_AVX2(const FftData* render_buffer_data,
+                                size_t render_buffer_size,
+                                size_t position,
+                                const FftData& G,
+                                FftData* H,
+                                size_t num_partitions) {
+  // Written out rather than with std::min(), whose instantiation would be
+  // compiled with AVX2 and shared with the rest of the binary.
+  const size_t num_to_end = render_buffer_size - position;
+  const int lim1 = static_cast<int>(
+      num_to_end < num_partitions ? num_to_end : num_partitions);
+  const int lim2 = static_cast<int>(num_partitions);
+  constexpr int kNumEightBinBands = kFftLengthBy2 / 8;
+  FftData* H_j;
+  const FftData* X;
+  int limit;
+  int j;
+  for (int k = 0, n = 0; n < kNumEightBinBands; ++n, k += 8) {
+    const __m256 G_re = _mm256_loadu_ps(&G.re[k]);
+    const __m256 G_im = _mm256_loadu_ps(&G.im[k]);
+
+    H_j = &H[0];
+    X = &render_buffer_data[position];
+    limit = lim1;
+    j = 0;
+    do {
+      for (; j < limit; ++j, ++H_j, ++X) {
+        const __m256 X_re = _mm256_loadu_ps(&X->re[k]);
+        const __m256 X_im = _mm256_loadu_ps(&X->im[k]);
+        const __m256 H_re = _mm256_loadu_ps(&H_j->re[k]);
+        const __m256 H_im = _mm256_loadu_ps(&H_j->im[k]);
+        // H_re += X_re * G_re + X_im * G_im.
+        const __m256 a = _mm256_fmadd_ps(X_re, G_re, H_re);
+        const __m256 g = _mm256_fmadd_ps(X_im, G_im, a);
+        // H_im += X_re * G_im - X_im * G_re.
+        const __m256 b = _mm256_fmadd_ps(X_re, G_im, H_im);
+        const __m256 h = _mm256_fnmadd_ps(X_im, G_re, b);
+        _mm256_storeu_ps(&H_j->re[k], g);
+        _mm256_storeu_ps(&H_j->im[k], h);
+      }
+
+      X = &render_buffer_data[0];
+      limit = lim2;
+    } while (j < lim2);
+  }
+
+  H_j = &H[0];
+  X = &render_buffer_data[position];
+  limit = lim1;
+  j = 0;
+  do {
+    for (; j < limit; ++j, ++H_j, ++X) {
+      H_j->re[kFftLengthBy2] += X->re[kFftLengthBy2] * G.re[kFftLengthBy2] +
+                                X->im[kFftLengthBy2] * G.im[kFftLengthBy2];
+      H_j->im[kFftLengthBy2] += X->re[kFftLengthBy2] * G.im[kFftLengthBy2] -
+                                X->im[kFftLengthBy2] * G.re[kFftLengthBy2];
+    }
+
+    X = &render_buffer_data[0];
+    limit = lim2;
+  } while (j < lim2);
+}
+
+// Produces the filter output (AVX2 variant).
+void ApplyFilterKernel_AVX2(const FftData* render_buffer_data,
+                            size_t render_buffer_size,
+                            size_t position,
+                            const FftData* H,
+                            size_t num_partitions,
+                            FftData* S) {
+  const size_t num_to_end = render_buffer_size - position;
+  const int lim1 = static_cast<int>(
+      num_to_end < num_partitions ? num_to_end : num_partitions);
+  const int lim2 = static_cast<int>(num_partitions);
+  constexpr int kNumEightBinBands = kFftLengthBy2 / 8;
+  const FftData* H_j;
+  const FftData* X;
+  int limit;
+  int j;
+  // The output of a band is accumulated in registers over all the partitions,
+  // and stored only once.
+  for (int k = 0, n = 0; n < kNumEightBinBands; ++n, k += 8) {
+    __m256 S_re = _mm256_setzero_ps();
+    __m256 S_im = _mm256_setzero_ps();
+
+    H_j = &H[0];
+    X = &render_buffer_data[position];
+    limit = lim1;
+    j = 0;
+    do {
+      for (; j < limit; ++j, ++H_j, ++X) {
+        const __m256 X_re = _mm256_loadu_ps(&X->re[k]);
+        const __m256 X_im = _mm256_loadu_ps(&X->im[k]);
+        const __m256 H_re = _mm256_loadu_ps(&H_j->re[k]);
+        const __m256 H_im = _mm256_loadu_ps(&H_j->im[k]);
+        // S_re += X_re * H_re - X_im * H_im.
+        S_re = _mm256_fmadd_ps(X_re, H_re, S_re);
+        S_re = _mm256_fnmadd_ps(X_im, H_im, S_re);
+        // S_im += X_re * H_im + X_im * H_re.
+        S_im = _mm256_fmadd_ps(X_re, H_im, S_im);
+        S_im = _mm256_fmadd_ps(X_im, H_re, S_im);
+      }
+
+      X = &render_buffer_data[0];
+      limit = lim2;
+    } while (j < lim2);
+
+    _mm256_storeu_ps(&S->re[k], S_re);
+    _mm256_storeu_ps(&S->im[k], S_im);
+  }
+
+  S->re[kFftLengthBy2] = 0.f;
+  S->im[kFftLengthBy2] = 0.f;
+  H_j = &H[0];
+  X = &render_buffer_data[position];
+  j = 0;
+  limit = lim1;
+  do {
+    for (; j < limit; ++j, ++H_j, ++X) {
+      S->re[kFftLengthBy2] += X->re[kFftLengthBy2] * H_j->re[kFftLengthBy2] -
+                              X->im[kFftLengthBy2] * H_j->im[kFftLengthBy2];
+      S->im[kFftLengthBy2] += X->re[kFftLengthBy2] * H_j->im[kFftLengthBy2] +
+                              X->im[kFftLengthBy2] * H_j->re[kFftLengthBy2];
+    }
+    limit = lim2;
+    X = &render_buffer_data[0];
+  } while (j < lim2);
+}
+
+}  // namespace aec3
+}  // namespace webrtc
@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_PROCESSING_AEC3_ADAPTIVE_FIR_FILTER_AVX2_H_
+#define MODULES_AUDIO_PROCESSING_AEC3_ADAPTIVE_FIR_FILTER_AVX2_H_
+
+#include <stddef.h>
+
+#include "modules/audio_processing/aec3/fft_data.h"
+
+namespace webrtc {
+namespace aec3 {
+
+// AVX2 and FMA kernels of AdaptPartitions_AVX2() and ApplyFilter_AVX2(). They
+// are compiled with AVX2 code generation, so they take plain arrays: an inline
+// function that they instantiated, e.g. of RenderBuffer or ArrayView, could be
+// picked by the linker for code that runs on CPUs without AVX2. The render
+// buffer is passed as its |render_buffer_size| FFTs and its current position.
+void AdaptPartitionsKernel_AVX2(const FftData* render_buffer_data,
+                                size_t render_buffer_size,
+                                size_t position,
+                                const FftData& G,
+                                FftData* H,
+                                size_t num_partitions);
+void ApplyFilterKernel_AVX2(const FftData* render_buffer_data,
+                            size_t render_buffer_size,
+                            size_t position,
+                            const FftData* H,
+                            size_t num_partitions,
+                            FftData* S);
+
+}  // namespace aec3
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_PROCESSING_AEC3_ADAPTIVE_FIR_FILTER_AVX2_H_
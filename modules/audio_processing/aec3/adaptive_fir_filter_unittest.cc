@@ -27,8 +27,10 @@
 #include "modules/audio_processing/logging/apm_data_dumper.h"
 #include "modules/audio_processing/test/echo_canceller_test_tools.h"
 #include "rtc_base/arraysize.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/numerics/safe_minmax.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"
 #include "test/gtest.h"
 
@@ -210,6 +212,130 @@ TEST(AdaptiveFirFilter, FilterAdaptationSse2Optimizations) {
   }
 }
 
+// Verifies that the AVX2 methods for filter adaptation are similar to their
+// reference counterparts. FMA rounds differently, so they are not bitexact and
+// are compared with a tolerance relative to the largest value of the output.
+TEST(AdaptiveFirFilter, FilterAdaptationAvx2Optimizations) {
+  if (WebRtc_GetCPUInfo(kAVX2) == 0 || WebRtc_GetCPUInfo(kFMA3) == 0) {
+    return;
+  }
+  auto tolerance = [](const FftData& X) {
+    float max_abs = 0.f;
+    for (size_t j = 0; j < X.re.size(); ++j) {
+      max_abs = std::max(max_abs, std::max(fabs(X.re[j]), fabs(X.im[j])));
+    }
+    return max_abs * 0.00001f;
+  };
+
+  std::unique_ptr<RenderDelayBuffer> render_delay_buffer(
+      RenderDelayBuffer::Create(EchoCanceller3Config(), 3));
+  Random random_generator(42U);
+  std::vector<std::vector<float>> x(3, std::vector<float>(kBlockSize, 0.f));
+  FftData S_C;
+  FftData S_AVX2;
+  FftData G;
+  std::vector<FftData> H_C(10);
+  std::vector<FftData> H_AVX2(10);
+  for (auto& H_j : H_C) {
+    H_j.Clear();
+  }
+  for (auto& H_j : H_AVX2) {
+    H_j.Clear();
+  }
+
+  for (size_t k = 0; k < 500; ++k) {
+    RandomizeSampleVector(&random_generator, x[0]);
+    render_delay_buffer->Insert(x);
+    if (k == 0) {
+      render_delay_buffer->Reset();
+    }
+    render_delay_buffer->PrepareCaptureProcessing();
+    const auto& render_buffer = render_delay_buffer->GetRenderBuffer();
+
+    ApplyFilter_AVX2(*render_buffer, H_AVX2, &S_AVX2);
+    ApplyFilter(*render_buffer, H_C, &S_C);
+    const float S_tolerance = tolerance(S_C);
+    for (size_t j = 0; j < S_C.re.size(); ++j) {
+      EXPECT_NEAR(S_C.re[j], S_AVX2.re[j], S_tolerance);
+      EXPECT_NEAR(S_C.im[j], S_AVX2.im[j], S_tolerance);
+    }
+
+    std::for_each(G.re.begin(), G.re.end(),
+                  [&](float& a) { a = random_generator.Rand<float>(); });
+    std::for_each(G.im.begin(), G.im.end(),
+                  [&](float& a) { a = random_generator.Rand<float>(); });
+
+    AdaptPartitions_AVX2(*render_buffer, G, H_AVX2);
+    AdaptPartitions(*render_buffer, G, H_C);
+
+    for (size_t k = 0; k < H_C.size(); ++k) {
+      const float H_tolerance = tolerance(H_C[k]);
+      for (size_t j = 0; j < H_C[k].re.size(); ++j) {
+        EXPECT_NEAR(H_C[k].re[j], H_AVX2[k].re[j], H_tolerance);
+        EXPECT_NEAR(H_C[k].im[j], H_AVX2[k].im[j], H_tolerance);
+      }
+    }
+  }
+}
+
+// Measures the time per call of the filter adaptation and filter output
+// methods.
+// Disabled because it only logs timings.
+TEST(AdaptiveFirFilter, DISABLED_FilterAdaptationBenchmark) {
+  constexpr int kNumCalls = 20000;
+  constexpr size_t kNumPartitions = 12;
+  std::unique_ptr<RenderDelayBuffer> render_delay_buffer(
+      RenderDelayBuffer::Create(EchoCanceller3Config(), 3));
+  Random random_generator(42U);
+  std::vector<std::vector<float>> x(3, std::vector<float>(kBlockSize, 0.f));
+  for (size_t k = 0; k < 30; ++k) {
+    RandomizeSampleVector(&random_generator, x[0]);
+    render_delay_buffer->Insert(x);
+    if (k == 0) {
+      render_delay_buffer->Reset();
+    }
+    render_delay_buffer->PrepareCaptureProcessing();
+  }
+  const auto& render_buffer = render_delay_buffer->GetRenderBuffer();
+  FftData G;
+  std::for_each(G.re.begin(), G.re.end(),
+                [&](float& a) { a = random_generator.Rand<float>() * 1e-6f; });
+  std::for_each(G.im.begin(), G.im.end(),
+                [&](float& a) { a = random_generator.Rand<float>() * 1e-6f; });
+
+  struct Kernels {
+    std::string name;
+    void (*adapt)(const RenderBuffer&, const FftData&, rtc::ArrayView<FftData>);
+    void (*apply)(const RenderBuffer&, rtc::ArrayView<const FftData>, FftData*);
+  };
+  std::vector<Kernels> kernels = {{"C", AdaptPartitions, ApplyFilter}};
+  if (WebRtc_GetCPUInfo(kSSE2) != 0)
+    kernels.push_back({"SSE2", AdaptPartitions_SSE2, ApplyFilter_SSE2});
+  if (WebRtc_GetCPUInfo(kAVX2) != 0 && WebRtc_GetCPUInfo(kFMA3) != 0)
+    kernels.push_back({"AVX2", AdaptPartitions_AVX2, ApplyFilter_AVX2});
+
+  for (const auto& kernel : kernels) {
+    std::vector<FftData> H(kNumPartitions);
+    for (auto& H_j : H) {
+      H_j.Clear();
+    }
+    FftData S;
+    int64_t start_us = rtc::TimeMicros();
+    for (int k = 0; k < kNumCalls; ++k) {
+      kernel.adapt(*render_buffer, G, H);
+    }
+    const int64_t adapt_us = rtc::TimeMicros() - start_us;
+    start_us = rtc::TimeMicros();
+    for (int k = 0; k < kNumCalls; ++k) {
+      kernel.apply(*render_buffer, H, &S);
+    }
+    const int64_t apply_us = rtc::TimeMicros() - start_us;
+    RTC_LOG(LS_INFO) << kernel.name << ": AdaptPartitions "
+                     << adapt_us * 1000 / kNumCalls << " ns, ApplyFilter "
+                     << apply_us * 1000 / kNumCalls << " ns per call.";
+  }
+}
+
 // Verifies that the optimized method for frequency response computation is
 // bitexact to the reference counterpart.
 TEST(AdaptiveFirFilter, UpdateFrequencyResponseSse2Optimization) {
@@ -17,6 +17,9 @@ namespace webrtc {
 
 Aec3Optimization DetectOptimization() {
 #if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kAVX2) != 0 && WebRtc_GetCPUInfo(kFMA3) != 0) {
+    return Aec3Optimization::kAvx2;
+  }
   if (WebRtc_GetCPUInfo(kSSE2) != 0) {
     return Aec3Optimization::kSse2;
   }
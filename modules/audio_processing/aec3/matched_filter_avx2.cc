@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#include "modules/audio_processing/aec3/matched_filter_avx2.h"
+
+#include <immintrin.h>
+
+#include <initializer_list>
+
+namespace webrtc {
+namespace aec3 {
+
+namespace {
+
+// Sums the elements of |v|.
+float HorizontalSum(__m256 v) {
+  const __m128 sum4 =
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  const __m128 sum1 = _mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 0x1));
+  return _mm_cvtss_f32(sum1);
+}
+
+// Used instead of std::min() and std::max(), whose instantiations for float
+// would be compiled with AVX2 and shared with the rest of the binary.
+float ClampToInt16Range(float v) {
+  return v > 32767.f ? 32767.f : (v < -32768.f ? -32768.f : v);
+}
+
+}  // namespace
+
+void MatchedFilterKernel_AVX2(size_t x_start_index,
+                              float x2_sum_threshold,
+                              const float* x,
+                              size_t x_size,
+                              const float* y,
+                              size_t y_size,
+                              float* h,
+                              size_t h_size,
+                              bool* filters_updated,
+                              float* error_sum) {
+  // Process for all samples in the sub-block.
+  for (size_t i = 0; i < y_size; ++i) {
+    // Apply the matched filter as filter * x, and compute x * x.
+
+    const float* x_p = &x[x_start_index];
+    const float* h_p = &h[0];
+
+    // Initialize values for the accumulation.
+    __m256 s_256 = _mm256_setzero_ps();
+    __m256 x2_sum_256 = _mm256_setzero_ps();
+    float x2_sum = 0.f;
+    float s = 0;
+
+    // Compute loop chunk sizes until, and after, the wraparound of the circular
+    // buffer for x.
+    const size_t num_to_end = x_size - x_start_index;
+    const int chunk1 =
+        static_cast<int>(h_size < num_to_end ? h_size : num_to_end);
+
+    // Perform the loop in two chunks.
+    const int chunk2 = static_cast<int>(h_size) - chunk1;
+    for (int limit : {chunk1, chunk2}) {
+      // Perform 256 bit vector operations.
+      const int limit_by_8 = limit >> 3;
+      for (int k = limit_by_8; k > 0; --k, h_p += 8, x_p += 8) {
+        // Load the data into 256 bit vectors.
+        const __m256 x_k = _mm256_loadu_ps(x_p);
+        const __m256 h_k = _mm256_loadu_ps(h_p);
+        // Compute and accumulate x * x and h * x.
+        x2_sum_256 = _mm256_fmadd_ps(x_k, x_k, x2_sum_256);
+        s_256 = _mm256_fmadd_ps(h_k, x_k, s_256);
+      }
+
+      // Perform non-vector operations for any remaining items.
+      for (int k = limit - limit_by_8 * 8; k > 0; --k, ++h_p, ++x_p) {
+        const float x_k = *x_p;
+        x2_sum += x_k * x_k;
+        s += *h_p * x_k;
+      }
+
+      x_p = &x[0];
+    }
+
+    // Combine the accumulated vector and scalar values.
+    x2_sum += HorizontalSum(x2_sum_256);
+    s += HorizontalSum(s_256);
+
+    // Compute the matched filter error.
+    float e = y[i] - s;
+    const bool saturation = y[i] >= 32000.f || y[i] <= -32000.f ||
+                            s >= 32000.f || s <= -32000.f || e >= 32000.f ||
+                            e <= -32000.f;
+
+    e = ClampToInt16Range(e);
+    (*error_sum) += e * e;
+
+    // Update the matched filter estimate in an NLMS manner.
+    if (x2_sum > x2_sum_threshold && !saturation) {
+      const float alpha = 0.7f * e / x2_sum;
+      const __m256 alpha_256 = _mm256_set1_ps(alpha);
+
+      // filter = filter + 0.7 * (y - filter * x) / x * x.
+      float* h_p = &h[0];
+      x_p = &x[x_start_index];
+
+      // Perform the loop in two chunks.
+      for (int limit : {chunk1, chunk2}) {
+        // Perform 256 bit vector operations.
+        const int limit_by_8 = limit >> 3;
+        for (int k = limit_by_8; k > 0; --k, h_p += 8, x_p += 8) {
+          // Load the data into 256 bit vectors.
+          const __m256 h_k = _mm256_loadu_ps(h_p);
+          const __m256 x_k = _mm256_loadu_ps(x_p);
+
+          // Compute h = h + alpha * x and store the result.
+          _mm256_storeu_ps(h_p, _mm256_fmadd_ps(alpha_256, x_k, h_k));
+        }
+
+        // Perform non-vector operations for any remaining items.
+        for (int k = limit - limit_by_8 * 8; k > 0; --k, ++h_p, ++x_p) {
+          *h_p += alpha * *x_p;
+        }
+
+        x_p = &x[0];
+      }
+
+      *filters_updated = true;
+    }
+
+    x_start_index = x_start_index > 0 ? x_start_index - 1 : x_size - 1;
+  }
+}
+
+}  // namespace aec3
+}  // namespace webrtc
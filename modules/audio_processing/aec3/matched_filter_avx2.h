@@ -0,0 +1,38 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_PROCESSING_AEC3_MATCHED_FILTER_AVX2_H_
+#define MODULES_AUDIO_PROCESSING_AEC3_MATCHED_FILTER_AVX2_H_
+
+#include <stddef.h>
+
+namespace webrtc {
+namespace aec3 {
+
+// AVX2 and FMA kernel of MatchedFilterCore_AVX2(). It is compiled with AVX2
+// code generation, so it takes plain arrays rather than ArrayViews: an inline
+// function that it instantiated could be picked by the linker for code that
+// runs on CPUs without AVX2. |h_size| must be a multiple of 4, and
+// |x_start_index| less than |x_size|.
+void MatchedFilterKernel_AVX2(size_t x_start_index,
+                              float x2_sum_threshold,
+                              const float* x,
+                              size_t x_size,
+                              const float* y,
+                              size_t y_size,
+                              float* h,
+                              size_t h_size,
+                              bool* filters_updated,
+                              float* error_sum);
+
+}  // namespace aec3
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_PROCESSING_AEC3_MATCHED_FILTER_AVX2_H_
@@ -17,13 +17,17 @@
 #include <algorithm>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "modules/audio_processing/aec3/aec3_common.h"
 #include "modules/audio_processing/aec3/decimator.h"
 #include "modules/audio_processing/aec3/render_delay_buffer.h"
 #include "modules/audio_processing/logging/apm_data_dumper.h"
 #include "modules/audio_processing/test/echo_canceller_test_tools.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"
 #include "test/gtest.h"
 
@@ -128,6 +132,85 @@ TEST(MatchedFilter, TestSse2Optimizations) {
   }
 }
 
+// Verifies that the optimized methods for AVX2 are similar to their reference
+// counterparts. FMA rounds differently, so they are not bitexact.
+TEST(MatchedFilter, TestAvx2Optimizations) {
+  if (WebRtc_GetCPUInfo(kAVX2) == 0 || WebRtc_GetCPUInfo(kFMA3) == 0) {
+    return;
+  }
+  Random random_generator(42U);
+  for (auto down_sampling_factor : kDownSamplingFactors) {
+    const size_t sub_block_size = kBlockSize / down_sampling_factor;
+    std::vector<float> x(2000);
+    RandomizeSampleVector(&random_generator, x);
+    std::vector<float> y(sub_block_size);
+    std::vector<float> h_AVX2(512);
+    std::vector<float> h(512);
+    int x_index = 0;
+    for (int k = 0; k < 1000; ++k) {
+      RandomizeSampleVector(&random_generator, y);
+
+      bool filters_updated = false;
+      float error_sum = 0.f;
+      bool filters_updated_AVX2 = false;
+      float error_sum_AVX2 = 0.f;
+
+      MatchedFilterCore_AVX2(x_index, h.size() * 150.f * 150.f, x, y, h_AVX2,
+                             &filters_updated_AVX2, &error_sum_AVX2);
+
+      MatchedFilterCore(x_index, h.size() * 150.f * 150.f, x, y, h,
+                        &filters_updated, &error_sum);
+
+      EXPECT_EQ(filters_updated, filters_updated_AVX2);
+      EXPECT_NEAR(error_sum, error_sum_AVX2, error_sum / 100000.f);
+
+      for (size_t j = 0; j < h.size(); ++j) {
+        EXPECT_NEAR(h[j], h_AVX2[j], 0.00001f);
+      }
+
+      x_index = (x_index + sub_block_size) % x.size();
+    }
+  }
+}
+
+// Measures the time per call of the matched filter cores.
+// Disabled because it only logs timings.
+TEST(MatchedFilter, DISABLED_CoreBenchmark) {
+  constexpr int kNumCalls = 20000;
+  const size_t sub_block_size = kBlockSize / 4;
+  Random random_generator(42U);
+  std::vector<float> x(2000);
+  RandomizeSampleVector(&random_generator, x);
+  std::vector<float> y(sub_block_size);
+  RandomizeSampleVector(&random_generator, y);
+  std::vector<float> h(512);
+
+  using Core = void (*)(size_t, float, rtc::ArrayView<const float>,
+                        rtc::ArrayView<const float>, rtc::ArrayView<float>,
+                        bool*, float*);
+  std::vector<std::pair<std::string, Core>> cores = {{"C", MatchedFilterCore}};
+  if (WebRtc_GetCPUInfo(kSSE2) != 0)
+    cores.emplace_back("SSE2", MatchedFilterCore_SSE2);
+  if (WebRtc_GetCPUInfo(kAVX2) != 0 && WebRtc_GetCPUInfo(kFMA3) != 0)
+    cores.emplace_back("AVX2", MatchedFilterCore_AVX2);
+
+  for (const auto& core : cores) {
+    std::fill(h.begin(), h.end(), 0.f);
+    size_t x_index = 0;
+    const int64_t start_us = rtc::TimeMicros();
+    for (int k = 0; k < kNumCalls; ++k) {
+      bool filters_updated = false;
+      float error_sum = 0.f;
+      core.second(x_index, h.size() * 150.f * 150.f, x, y, h, &filters_updated,
+                  &error_sum);
+      x_index = (x_index + sub_block_size) % x.size();
+    }
+    const int64_t elapsed_us = rtc::TimeMicros() - start_us;
+    RTC_LOG(LS_INFO) << "MatchedFilterCore " << core.first << ": "
+                     << elapsed_us * 1000 / kNumCalls << " ns per call.";
+  }
+}
+
 #endif
 
 // Verifies that the matched filter produces proper lag estimates for
@@ -370,6 +370,9 @@ AudioProcessingImpl::AudioProcessingImpl(const webrtc::Config& config)
 
 int AudioProcessingImpl::instance_count_ = 0;
 
+constexpr AudioProcessingImpl::CaptureStage
+    AudioProcessingImpl::kCaptureStages[];
+
 AudioProcessingImpl::AudioProcessingImpl(
     const webrtc::Config& config,
     std::unique_ptr<CustomProcessing> capture_post_processor,
@@ -1061,6 +1064,15 @@ void AudioProcessingImpl::EmptyQueuedRenderAudio() {
 
 int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
   TRACE_EVENT0("webrtc", "AudioProcessing::ProcessStream_AudioFrame");
+  RETURN_ON_ERR(PrepareCaptureFrame(frame));
+  rtc::CritScope cs_capture(&crit_capture_);
+  RETURN_ON_ERR(DeinterleaveCaptureFrameLocked(frame));
+  RETURN_ON_ERR(ProcessCaptureStreamLocked());
+  InterleaveCaptureFrameLocked(frame);
+  return kNoError;
+}
+
+int AudioProcessingImpl::PrepareCaptureFrame(const AudioFrame* frame) {
   {
     // Acquire the capture lock in order to safely call the function
     // that retrieves the render side data. This function accesses apm
@@ -1101,13 +1113,12 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
   processing_config.output_stream().set_sample_rate_hz(frame->sample_rate_hz_);
   processing_config.output_stream().set_num_channels(frame->num_channels_);
 
-  {
-    // Do conditional reinitialization.
-    rtc::CritScope cs_render(&crit_render_);
-    RETURN_ON_ERR(
-        MaybeInitializeCapture(processing_config, reinitialization_required));
-  }
-  rtc::CritScope cs_capture(&crit_capture_);
+  // Do conditional reinitialization.
+  rtc::CritScope cs_render(&crit_render_);
+  return MaybeInitializeCapture(processing_config, reinitialization_required);
+}
+
+int AudioProcessingImpl::DeinterleaveCaptureFrameLocked(AudioFrame* frame) {
   if (frame->samples_per_channel_ !=
       formats_.api_format.input_stream().num_frames()) {
     return kBadDataLengthError;
@@ -1118,7 +1129,10 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
   }
 
   capture_.capture_audio->DeinterleaveFrom(frame);
-  RETURN_ON_ERR(ProcessCaptureStreamLocked());
+  return kNoError;
+}
+
+void AudioProcessingImpl::InterleaveCaptureFrameLocked(AudioFrame* frame) {
   capture_.capture_audio->InterleaveTo(
       frame, submodule_states_.CaptureMultiBandProcessingActive() ||
                  submodule_states_.CaptureFullBandProcessingActive());
@@ -1126,11 +1140,37 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
   if (aec_dump_) {
     RecordProcessedCaptureStream(*frame);
   }
+}
 
+int AudioProcessingImpl::ProcessCaptureStreamLocked() {
+  for (CaptureStage stage : kCaptureStages) {
+    RETURN_ON_ERR(ProcessCaptureStageLocked(stage));
+  }
   return kNoError;
 }
 
-int AudioProcessingImpl::ProcessCaptureStreamLocked() {
+int AudioProcessingImpl::ProcessCaptureStageLocked(CaptureStage stage) {
+  switch (stage) {
+    case CaptureStage::kAnalysis:
+      AnalyzeCaptureLocked();
+      return kNoError;
+    case CaptureStage::kPreProcessing:
+      return PreProcessCaptureLocked();
+    case CaptureStage::kEchoCancellation:
+      return CancelCaptureEchoLocked();
+    case CaptureStage::kNoiseSuppression:
+      return SuppressCaptureNoiseLocked();
+    case CaptureStage::kGainControl:
+      return ControlCaptureGainLocked();
+    case CaptureStage::kPostProcessing:
+      PostProcessCaptureLocked();
+      return kNoError;
+  }
+  RTC_NOTREACHED();
+  return kUnspecifiedError;
+}
+
+void AudioProcessingImpl::AnalyzeCaptureLocked() {
   // Ensure that not both the AEC and AECM are active at the same time.
   // TODO(peah): Simplify once the public API Enable functions for these
   // are moved to APM.
@@ -1144,8 +1184,9 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
   capture_input_rms_.Analyze(rtc::ArrayView<const int16_t>(
       capture_buffer->channels_const()[0],
       capture_nonlocked_.capture_processing_format.num_frames()));
-  const bool log_rms = ++capture_rms_interval_counter_ >= 1000;
-  if (log_rms) {
+  if (++capture_rms_interval_counter_ >= 1000) {
+    // The output levels are logged by PostProcessCaptureLocked() when the
+    // counter has been reset.
     capture_rms_interval_counter_ = 0;
     RmsLevel::Levels levels = capture_input_rms_.AverageAndPeak();
     RTC_HISTOGRAM_COUNTS_LINEAR("WebRTC.Audio.ApmCaptureInputLevelAverageRms",
@@ -1188,6 +1229,10 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
     // Discards all channels by the leftmost one.
     capture_buffer->set_num_channels(1);
   }
+}
+
+int AudioProcessingImpl::PreProcessCaptureLocked() {
+  AudioBuffer* capture_buffer = capture_.capture_audio.get();  // For brevity.
 
   // TODO(peah): Move the AEC3 low-cut filter to this place.
   if (private_submodules_->low_cut_filter &&
@@ -1197,6 +1242,11 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
   RETURN_ON_ERR(
       public_submodules_->gain_control->AnalyzeCaptureAudio(capture_buffer));
   public_submodules_->noise_suppression->AnalyzeCaptureAudio(capture_buffer);
+  return kNoError;
+}
+
+int AudioProcessingImpl::CancelCaptureEchoLocked() {
+  AudioBuffer* capture_buffer = capture_.capture_audio.get();  // For brevity.
 
   // Ensure that the stream delay was set before the call to the
   // AEC ProcessCaptureAudio function.
@@ -1214,6 +1264,11 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
     RETURN_ON_ERR(public_submodules_->echo_cancellation->ProcessCaptureAudio(
         capture_buffer, stream_delay_ms()));
   }
+  return kNoError;
+}
+
+int AudioProcessingImpl::SuppressCaptureNoiseLocked() {
+  AudioBuffer* capture_buffer = capture_.capture_audio.get();  // For brevity.
 
   if (public_submodules_->echo_control_mobile->is_enabled() &&
       public_submodules_->noise_suppression->is_enabled()) {
@@ -1251,6 +1306,11 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
   }
 
   public_submodules_->voice_detection->ProcessCaptureAudio(capture_buffer);
+  return kNoError;
+}
+
+int AudioProcessingImpl::ControlCaptureGainLocked() {
+  AudioBuffer* capture_buffer = capture_.capture_audio.get();  // For brevity.
 
   if (constants_.use_experimental_agc &&
       public_submodules_->gain_control->is_enabled() &&
@@ -1268,6 +1328,11 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
           capture_nonlocked_.capture_processing_format.sample_rate_hz())) {
     capture_buffer->MergeFrequencyBands();
   }
+  return kNoError;
+}
+
+void AudioProcessingImpl::PostProcessCaptureLocked() {
+  AudioBuffer* capture_buffer = capture_.capture_audio.get();  // For brevity.
 
   if (config_.residual_echo_detector.enabled) {
     RTC_DCHECK(private_submodules_->echo_detector);
@@ -1307,7 +1372,7 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
   capture_output_rms_.Analyze(rtc::ArrayView<const int16_t>(
       capture_buffer->channels_const()[0],
       capture_nonlocked_.capture_processing_format.num_frames()));
-  if (log_rms) {
+  if (capture_rms_interval_counter_ == 0) {
     RmsLevel::Levels levels = capture_output_rms_.AverageAndPeak();
     RTC_HISTOGRAM_COUNTS_LINEAR("WebRTC.Audio.ApmCaptureOutputLevelAverageRms",
                                 levels.average, 1, RmsLevel::kMinLevelDb, 64);
@@ -1316,7 +1381,6 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
   }
 
   capture_.was_stream_delay_set = false;
-  return kNoError;
 }
 
 int AudioProcessingImpl::AnalyzeReverseStream(const float* const* data,
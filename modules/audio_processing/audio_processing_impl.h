@@ -143,6 +143,7 @@ class AudioProcessingImpl : public AudioProcessing {
   FRIEND_TEST_ALL_PREFIXES(ApmConfiguration, DefaultBehavior);
   FRIEND_TEST_ALL_PREFIXES(ApmConfiguration, ValidConfigBehavior);
   FRIEND_TEST_ALL_PREFIXES(ApmConfiguration, InValidConfigBehavior);
+  friend class BatchedAudioProcessing;
   struct ApmPublicSubmodules;
   struct ApmPrivateSubmodules;
 
@@ -247,9 +248,42 @@ class AudioProcessingImpl : public AudioProcessing {
   void QueueNonbandedRenderAudio(AudioBuffer* audio)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_render_);
 
+  // The stages of the capture processing, in the order they are run. They are
+  // run one at a time so that BatchedAudioProcessing can run a stage for all
+  // of its instances before moving on to the next.
+  enum class CaptureStage {
+    kAnalysis,
+    kPreProcessing,
+    kEchoCancellation,
+    kNoiseSuppression,
+    kGainControl,
+    kPostProcessing
+  };
+  static constexpr CaptureStage kCaptureStages[] = {
+      CaptureStage::kAnalysis,         CaptureStage::kPreProcessing,
+      CaptureStage::kEchoCancellation, CaptureStage::kNoiseSuppression,
+      CaptureStage::kGainControl,      CaptureStage::kPostProcessing};
+
+  // Steps of ProcessStream(AudioFrame*). PrepareCaptureFrame() validates the
+  // frame and reinitializes APM for its format if needed, and is called
+  // without any lock held.
+  int PrepareCaptureFrame(const AudioFrame* frame);
+  int DeinterleaveCaptureFrameLocked(AudioFrame* frame)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  void InterleaveCaptureFrameLocked(AudioFrame* frame)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+
   // Capture-side exclusive methods possibly running APM in a multi-threaded
   // manner that are called with the render lock already acquired.
   int ProcessCaptureStreamLocked() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  int ProcessCaptureStageLocked(CaptureStage stage)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  void AnalyzeCaptureLocked() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  int PreProcessCaptureLocked() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  int CancelCaptureEchoLocked() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  int SuppressCaptureNoiseLocked() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  int ControlCaptureGainLocked() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  void PostProcessCaptureLocked() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
   void MaybeUpdateHistograms() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
 
   // Render-side exclusive methods possibly running APM in a multi-threaded
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/batched_audio_processing.h"
+
+#include <utility>
+
+#include "api/audio/audio_frame.h"
+#include "modules/audio_processing/audio_processing_impl.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/ptr_util.h"
+#include "rtc_base/trace_event.h"
+
+namespace webrtc {
+
+// Lets each instance create its echo controllers with the factory owned by
+// the batch.
+class BatchedAudioProcessing::SharedEchoControlFactory
+    : public EchoControlFactory {
+ public:
+  explicit SharedEchoControlFactory(EchoControlFactory* factory)
+      : factory_(factory) {}
+
+  std::unique_ptr<EchoControl> Create(int sample_rate_hz) override {
+    return factory_->Create(sample_rate_hz);
+  }
+
+ private:
+  EchoControlFactory* const factory_;
+};
+
+// Holds the capture locks of all of the instances for its lifetime.
+class BatchedAudioProcessing::ScopedCaptureLocks {
+ public:
+  explicit ScopedCaptureLocks(
+      const std::vector<rtc::scoped_refptr<AudioProcessingImpl>>& instances)
+      RTC_NO_THREAD_SAFETY_ANALYSIS : instances_(instances) {
+    for (const auto& instance : instances_)
+      instance->crit_capture_.Enter();
+  }
+  ~ScopedCaptureLocks() RTC_NO_THREAD_SAFETY_ANALYSIS {
+    for (const auto& instance : instances_)
+      instance->crit_capture_.Leave();
+  }
+
+ private:
+  const std::vector<rtc::scoped_refptr<AudioProcessingImpl>>& instances_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ScopedCaptureLocks);
+};
+
+BatchedAudioProcessing::BatchedAudioProcessing(
+    size_t num_instances,
+    const webrtc::Config& config,
+    std::unique_ptr<EchoControlFactory> echo_control_factory)
+    : echo_control_factory_(std::move(echo_control_factory)),
+      errors_(num_instances, AudioProcessing::kNoError) {
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    AudioProcessingBuilder builder;
+    if (echo_control_factory_) {
+      builder.SetEchoControlFactory(rtc::MakeUnique<SharedEchoControlFactory>(
+          echo_control_factory_.get()));
+    }
+    // The builder always creates an AudioProcessingImpl.
+    AudioProcessing* apm = builder.Create(config);
+    RTC_CHECK(apm);
+    instances_.emplace_back(static_cast<AudioProcessingImpl*>(apm));
+  }
+}
+
+BatchedAudioProcessing::~BatchedAudioProcessing() = default;
+
+AudioProcessing* BatchedAudioProcessing::instance(size_t index) {
+  RTC_DCHECK_LT(index, instances_.size());
+  return instances_[index].get();
+}
+
+int BatchedAudioProcessing::ProcessStreams(
+    rtc::ArrayView<AudioFrame* const> frames) {
+  TRACE_EVENT0("webrtc", "BatchedAudioProcessing::ProcessStreams");
+  if (frames.size() != instances_.size())
+    return AudioProcessing::kBadParameterError;
+
+  // Reinitializing takes both of the locks of an instance, so it is done
+  // before any capture lock is held.
+  for (size_t i = 0; i < instances_.size(); ++i)
+    errors_[i] = instances_[i]->PrepareCaptureFrame(frames[i]);
+
+  // The capture locks are held for the whole pass, so that the configuration
+  // of an instance doesn't change between the stages.
+  ScopedCaptureLocks locks(instances_);
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    if (errors_[i] == AudioProcessing::kNoError)
+      errors_[i] = instances_[i]->DeinterleaveCaptureFrameLocked(frames[i]);
+  }
+
+  for (AudioProcessingImpl::CaptureStage stage :
+       AudioProcessingImpl::kCaptureStages) {
+    for (size_t i = 0; i < instances_.size(); ++i) {
+      if (errors_[i] == AudioProcessing::kNoError)
+        errors_[i] = instances_[i]->ProcessCaptureStageLocked(stage);
+    }
+  }
+
+  int error = AudioProcessing::kNoError;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    if (errors_[i] == AudioProcessing::kNoError)
+      instances_[i]->InterleaveCaptureFrameLocked(frames[i]);
+    else if (error == AudioProcessing::kNoError)
+      error = errors_[i];
+  }
+  return error;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_PROCESSING_BATCHED_AUDIO_PROCESSING_H_
+#define MODULES_AUDIO_PROCESSING_BATCHED_AUDIO_PROCESSING_H_
+
+#include <memory>
+#include <vector>
+
+#include "api/array_view.h"
+#include "api/audio/echo_control.h"
+#include "modules/audio_processing/include/audio_processing.h"
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/scoped_ref_ptr.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+class AudioFrame;
+class AudioProcessingImpl;
+
+// Processes the capture streams of many independent AudioProcessing instances,
+// e.g. one per participant on a server, with one call. Each stage of the
+// capture processing (the analysis, the low-cut filter, the echo canceller,
+// the noise suppressor, the gain control and the post-processing) is run for
+// all of the instances before the next stage. The instances keep their own
+// state and are processed one channel at a time, as by
+// AudioProcessing::ProcessStream().
+class BatchedAudioProcessing {
+ public:
+  // Creates |num_instances| instances with |config|. If |echo_control_factory|
+  // is set, it creates an echo controller for each of the instances.
+  BatchedAudioProcessing(
+      size_t num_instances,
+      const webrtc::Config& config,
+      std::unique_ptr<EchoControlFactory> echo_control_factory);
+  ~BatchedAudioProcessing();
+
+  size_t num_instances() const { return instances_.size(); }
+
+  // The instance that processes the frames at |index|. It is used like any
+  // AudioProcessing, e.g. to configure it, to set its stream delay and to
+  // process its render stream, except that its capture stream must only be
+  // processed by ProcessStreams().
+  AudioProcessing* instance(size_t index);
+
+  // Processes |frames|, one for each instance in order, like
+  // AudioProcessing::ProcessStream(AudioFrame*). An instance that fails leaves
+  // its frame unprocessed, without affecting the other instances. Returns
+  // AudioProcessing::kNoError if all of the instances succeeded and otherwise
+  // the error of the first one that failed. Returns kBadParameterError without
+  // processing anything if there isn't exactly one frame per instance. The
+  // capture locks of the instances are held by a ScopedCaptureLocks, which the
+  // thread safety analysis can't follow.
+  int ProcessStreams(rtc::ArrayView<AudioFrame* const> frames)
+      RTC_NO_THREAD_SAFETY_ANALYSIS;
+
+ private:
+  class ScopedCaptureLocks;
+  class SharedEchoControlFactory;
+
+  const std::unique_ptr<EchoControlFactory> echo_control_factory_;
+  std::vector<rtc::scoped_refptr<AudioProcessingImpl>> instances_;
+  // The result of the processing so far for each instance, reused between
+  // calls to ProcessStreams().
+  std::vector<int> errors_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(BatchedAudioProcessing);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_PROCESSING_BATCHED_AUDIO_PROCESSING_H_
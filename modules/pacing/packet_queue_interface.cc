@@ -32,6 +32,9 @@ PacketQueueInterface::Packet::Packet(RtpPacketSender::Priority priority,
 
 PacketQueueInterface::Packet::Packet(const Packet& other) = default;
 
+PacketQueueInterface::Packet& PacketQueueInterface::Packet::operator=(
+    const Packet& other) = default;
+
 PacketQueueInterface::Packet::~Packet() {}
 
 bool PacketQueueInterface::Packet::operator<(
@@ -36,6 +36,7 @@ class PacketQueueInterface {
            bool retransmission,
            uint64_t enqueue_order);
     Packet(const Packet& other);
+    Packet& operator=(const Packet& other);
     virtual ~Packet();
     bool operator<(const Packet& other) const;
 
@@ -0,0 +1,334 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/pacing/pooled_packet_queue.h"
+
+#include "rtc_base/checks.h"
+#include "system_wrappers/include/clock.h"
+
+namespace webrtc {
+namespace {
+// Number of nodes allocated at a time when the pool runs dry.
+constexpr size_t kNodesPerChunk = 64;
+}  // namespace
+
+constexpr int64_t PooledPacketQueue::kQuantumBytes;
+constexpr int PooledPacketQueue::kNumPriorities;
+
+PooledPacketQueue::Node::Node()
+    : packet(RtpPacketSender::kNormalPriority, 0, 0, 0, 0, 0, false, 0),
+      enqueue_time_ms(0),
+      next(nullptr),
+      age_prev(nullptr),
+      age_next(nullptr) {}
+
+void PooledPacketQueue::NodeList::PushBack(Node* node) {
+  node->next = nullptr;
+  if (tail) {
+    tail->next = node;
+  } else {
+    head = node;
+  }
+  tail = node;
+}
+
+void PooledPacketQueue::NodeList::PushFront(Node* node) {
+  node->next = head;
+  head = node;
+  if (!tail)
+    tail = node;
+}
+
+PooledPacketQueue::Node* PooledPacketQueue::NodeList::PopFront() {
+  RTC_DCHECK(head);
+  Node* node = head;
+  head = node->next;
+  if (!head)
+    tail = nullptr;
+  node->next = nullptr;
+  return node;
+}
+
+PooledPacketQueue::Stream::Stream() : ssrc(0) {
+  for (int i = 0; i < kNumPriorities; ++i) {
+    ring_prev[i] = nullptr;
+    ring_next[i] = nullptr;
+    in_ring[i] = false;
+    deficit_bytes[i] = 0;
+  }
+}
+
+PooledPacketQueue::PooledPacketQueue(const Clock* clock)
+    : clock_(clock), time_last_updated_(clock_->TimeInMilliseconds()) {
+  for (int i = 0; i < kNumPriorities; ++i)
+    rings_[i] = nullptr;
+}
+
+PooledPacketQueue::~PooledPacketQueue() {}
+
+void PooledPacketQueue::Push(const Packet& packet) {
+  RTC_CHECK_GE(packet.priority, 0);
+  RTC_CHECK_LT(packet.priority, kNumPriorities);
+
+  auto stream_it = streams_.find(packet.ssrc);
+  if (stream_it == streams_.end()) {
+    stream_it = streams_.emplace(packet.ssrc, Stream()).first;
+    stream_it->second.ssrc = packet.ssrc;
+  }
+  Stream* stream = &stream_it->second;
+
+  Node* node = AllocateNode();
+  node->packet = packet;
+  node->enqueue_time_ms = packet.enqueue_time_ms;
+  InsertInAgeList(node);
+
+  // See RoundRobinPacketQueue::Push() for how the time spent in a paused state
+  // is excluded from the queue time.
+  UpdateQueueTime(packet.enqueue_time_ms);
+  node->packet.enqueue_time_ms -= pause_time_sum_ms_;
+
+  // PacedSender assigns increasing |enqueue_order| values, so appending keeps
+  // each list sorted the same way as Packet::operator<.
+  const int priority = packet.priority;
+  stream->packets[priority][packet.retransmission ? 0 : 1].PushBack(node);
+  if (!stream->in_ring[priority])
+    AddToRing(stream, priority);
+
+  size_packets_ += 1;
+  size_bytes_ += packet.bytes;
+}
+
+const PacketQueueInterface::Packet& PooledPacketQueue::BeginPop() {
+  RTC_CHECK(!pop_node_ && !pop_stream_);
+
+  const int priority = HighestScheduledPriority();
+  RTC_CHECK_GE(priority, 0);
+  Stream* stream = rings_[priority];
+  NodeList* list = stream->packets[priority][0].empty()
+                       ? &stream->packets[priority][1]
+                       : &stream->packets[priority][0];
+  RTC_CHECK(!list->empty());
+
+  // The packet is unlinked from its stream but the stream stays scheduled
+  // until FinalizePop(), so that packets pushed while the packet is being sent
+  // don't change the round robin order.
+  pop_node_ = list->PopFront();
+  pop_stream_ = stream;
+  return pop_node_->packet;
+}
+
+void PooledPacketQueue::CancelPop(const Packet& packet) {
+  RTC_CHECK(pop_node_ && pop_stream_);
+  const Packet& popped = pop_node_->packet;
+  pop_stream_->packets[popped.priority][popped.retransmission ? 0 : 1]
+      .PushFront(pop_node_);
+  pop_node_ = nullptr;
+  pop_stream_ = nullptr;
+}
+
+void PooledPacketQueue::FinalizePop(const Packet& packet) {
+  RTC_CHECK(!paused_);
+  if (!Empty()) {
+    RTC_CHECK(pop_node_ && pop_stream_);
+    Node* node = pop_node_;
+    Stream* stream = pop_stream_;
+    const Packet& popped = node->packet;
+
+    int64_t time_in_non_paused_state_ms =
+        time_last_updated_ - popped.enqueue_time_ms - pause_time_sum_ms_;
+    queue_time_sum_ms_ -= time_in_non_paused_state_ms;
+
+    RemoveFromAgeList(node);
+
+    // Deficit round robin: a stream keeps its turn until it has used up its
+    // quantum, and the overshoot is carried over to its next turn so that
+    // streams with large packets don't get more than their share of bytes.
+    const int priority = popped.priority;
+    if (!HasPackets(*stream, priority)) {
+      RemoveFromRing(stream, priority);
+    } else {
+      stream->deficit_bytes[priority] -= popped.bytes;
+      if (stream->deficit_bytes[priority] <= 0) {
+        stream->deficit_bytes[priority] += kQuantumBytes;
+        if (rings_[priority] == stream)
+          rings_[priority] = stream->ring_next[priority];
+      }
+    }
+
+    size_bytes_ -= popped.bytes;
+    size_packets_ -= 1;
+    RTC_CHECK(size_packets_ > 0 || queue_time_sum_ms_ == 0);
+
+    FreeNode(node);
+    pop_node_ = nullptr;
+    pop_stream_ = nullptr;
+  }
+}
+
+bool PooledPacketQueue::Empty() const {
+  RTC_CHECK((age_head_ && size_packets_ > 0) ||
+            (!age_head_ && size_packets_ == 0));
+  return size_packets_ == 0;
+}
+
+size_t PooledPacketQueue::SizeInPackets() const {
+  return size_packets_;
+}
+
+uint64_t PooledPacketQueue::SizeInBytes() const {
+  return size_bytes_;
+}
+
+int64_t PooledPacketQueue::OldestEnqueueTimeMs() const {
+  if (Empty())
+    return 0;
+  return age_head_->enqueue_time_ms;
+}
+
+void PooledPacketQueue::UpdateQueueTime(int64_t timestamp_ms) {
+  RTC_CHECK_GE(timestamp_ms, time_last_updated_);
+  if (timestamp_ms == time_last_updated_)
+    return;
+
+  int64_t delta_ms = timestamp_ms - time_last_updated_;
+
+  if (paused_) {
+    pause_time_sum_ms_ += delta_ms;
+  } else {
+    queue_time_sum_ms_ += delta_ms * size_packets_;
+  }
+
+  time_last_updated_ = timestamp_ms;
+}
+
+void PooledPacketQueue::SetPauseState(bool paused, int64_t timestamp_ms) {
+  if (paused_ == paused)
+    return;
+  UpdateQueueTime(timestamp_ms);
+  paused_ = paused;
+}
+
+int64_t PooledPacketQueue::AverageQueueTimeMs() const {
+  if (Empty())
+    return 0;
+  return queue_time_sum_ms_ / size_packets_;
+}
+
+PooledPacketQueue::Node* PooledPacketQueue::AllocateNode() {
+  if (!free_nodes_) {
+    std::unique_ptr<Node[]> chunk(new Node[kNodesPerChunk]);
+    for (size_t i = 0; i < kNodesPerChunk; ++i)
+      FreeNode(&chunk[i]);
+    node_chunks_.push_back(std::move(chunk));
+  }
+  Node* node = free_nodes_;
+  free_nodes_ = node->next;
+  node->next = nullptr;
+  return node;
+}
+
+void PooledPacketQueue::FreeNode(Node* node) {
+  node->age_prev = nullptr;
+  node->age_next = nullptr;
+  node->next = free_nodes_;
+  free_nodes_ = node;
+}
+
+void PooledPacketQueue::InsertInAgeList(Node* node) {
+  // Packets are normally pushed in enqueue time order, in which case this
+  // appends to the list without iterating.
+  Node* prev = age_tail_;
+  while (prev && prev->enqueue_time_ms > node->enqueue_time_ms)
+    prev = prev->age_prev;
+
+  Node* next = prev ? prev->age_next : age_head_;
+  node->age_prev = prev;
+  node->age_next = next;
+  if (prev) {
+    prev->age_next = node;
+  } else {
+    age_head_ = node;
+  }
+  if (next) {
+    next->age_prev = node;
+  } else {
+    age_tail_ = node;
+  }
+}
+
+void PooledPacketQueue::RemoveFromAgeList(Node* node) {
+  if (node->age_prev) {
+    node->age_prev->age_next = node->age_next;
+  } else {
+    RTC_DCHECK_EQ(age_head_, node);
+    age_head_ = node->age_next;
+  }
+  if (node->age_next) {
+    node->age_next->age_prev = node->age_prev;
+  } else {
+    RTC_DCHECK_EQ(age_tail_, node);
+    age_tail_ = node->age_prev;
+  }
+  node->age_prev = nullptr;
+  node->age_next = nullptr;
+}
+
+void PooledPacketQueue::AddToRing(Stream* stream, int priority) {
+  RTC_DCHECK(!stream->in_ring[priority]);
+  Stream* head = rings_[priority];
+  if (!head) {
+    stream->ring_prev[priority] = stream;
+    stream->ring_next[priority] = stream;
+    rings_[priority] = stream;
+  } else {
+    // Insert last, i.e. just before the stream whose turn it is.
+    Stream* tail = head->ring_prev[priority];
+    tail->ring_next[priority] = stream;
+    stream->ring_prev[priority] = tail;
+    stream->ring_next[priority] = head;
+    head->ring_prev[priority] = stream;
+  }
+  stream->in_ring[priority] = true;
+  stream->deficit_bytes[priority] = kQuantumBytes;
+}
+
+void PooledPacketQueue::RemoveFromRing(Stream* stream, int priority) {
+  RTC_DCHECK(stream->in_ring[priority]);
+  Stream* next = stream->ring_next[priority];
+  if (next == stream) {
+    rings_[priority] = nullptr;
+  } else {
+    Stream* prev = stream->ring_prev[priority];
+    prev->ring_next[priority] = next;
+    next->ring_prev[priority] = prev;
+    if (rings_[priority] == stream)
+      rings_[priority] = next;
+  }
+  stream->ring_prev[priority] = nullptr;
+  stream->ring_next[priority] = nullptr;
+  stream->in_ring[priority] = false;
+  stream->deficit_bytes[priority] = 0;
+}
+
+bool PooledPacketQueue::HasPackets(const Stream& stream, int priority) const {
+  return !stream.packets[priority][0].empty() ||
+         !stream.packets[priority][1].empty();
+}
+
+int PooledPacketQueue::HighestScheduledPriority() const {
+  // RtpPacketSender::Priority uses lower ordinal for higher priority.
+  for (int priority = 0; priority < kNumPriorities; ++priority) {
+    if (rings_[priority])
+      return priority;
+  }
+  return -1;
+}
+
+}  // namespace webrtc
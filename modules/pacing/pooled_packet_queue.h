@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_PACING_POOLED_PACKET_QUEUE_H_
+#define MODULES_PACING_POOLED_PACKET_QUEUE_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "modules/pacing/packet_queue_interface.h"
+#include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+
+namespace webrtc {
+
+// Packet queue with the same external behavior as RoundRobinPacketQueue that
+// does not allocate in steady state. Packets are stored in pooled nodes that
+// are linked into intrusive per-stream FIFOs, one per priority and
+// retransmission flag, and streams that have packets of a given priority are
+// served in deficit round robin order from an intrusive ring. Pushing and
+// popping a packet are O(1); the only allocations happen when the pool has to
+// grow or a previously unseen SSRC is pushed.
+class PooledPacketQueue : public PacketQueueInterface {
+ public:
+  explicit PooledPacketQueue(const Clock* clock);
+  ~PooledPacketQueue() override;
+
+  using Packet = PacketQueueInterface::Packet;
+
+  void Push(const Packet& packet) override;
+  const Packet& BeginPop() override;
+  void CancelPop(const Packet& packet) override;
+  void FinalizePop(const Packet& packet) override;
+
+  bool Empty() const override;
+  size_t SizeInPackets() const override;
+  uint64_t SizeInBytes() const override;
+
+  int64_t OldestEnqueueTimeMs() const override;
+  int64_t AverageQueueTimeMs() const override;
+  void UpdateQueueTime(int64_t timestamp_ms) override;
+  void SetPauseState(bool paused, int64_t timestamp_ms) override;
+
+  // Number of bytes a stream may send before the next stream of the same
+  // priority gets its turn.
+  static constexpr int64_t kQuantumBytes = 1400;
+
+ private:
+  // RtpPacketSender::Priority values are used directly as indices, so this
+  // needs to be larger than the largest enum value.
+  static constexpr int kNumPriorities = RtpPacketSender::kLowPriority + 1;
+
+  struct Node {
+    Node();
+
+    Packet packet;
+    // Enqueue time as given to Push(), before compensating for pause time.
+    int64_t enqueue_time_ms;
+    // Next packet in the per-stream FIFO.
+    Node* next;
+    // Neighbours in |age_list_|, ordered by |enqueue_time_ms|.
+    Node* age_prev;
+    Node* age_next;
+  };
+
+  // Singly linked FIFO of nodes that supports pushing to the front, which is
+  // needed to put back a packet on CancelPop().
+  struct NodeList {
+    bool empty() const { return head == nullptr; }
+    void PushBack(Node* node);
+    void PushFront(Node* node);
+    Node* PopFront();
+
+    Node* head = nullptr;
+    Node* tail = nullptr;
+  };
+
+  struct Stream {
+    Stream();
+
+    uint32_t ssrc;
+    // Index 0 holds retransmissions, which are sent before other packets of
+    // the same priority.
+    NodeList packets[kNumPriorities][2];
+    // Links in |rings_[priority]|, only valid while |in_ring[priority]|.
+    Stream* ring_prev[kNumPriorities];
+    Stream* ring_next[kNumPriorities];
+    bool in_ring[kNumPriorities];
+    int64_t deficit_bytes[kNumPriorities];
+  };
+
+  Node* AllocateNode();
+  void FreeNode(Node* node);
+
+  void InsertInAgeList(Node* node);
+  void RemoveFromAgeList(Node* node);
+
+  void AddToRing(Stream* stream, int priority);
+  void RemoveFromRing(Stream* stream, int priority);
+  bool HasPackets(const Stream& stream, int priority) const;
+  int HighestScheduledPriority() const;
+
+  const Clock* const clock_;
+  int64_t time_last_updated_;
+
+  Node* pop_node_ = nullptr;
+  Stream* pop_stream_ = nullptr;
+
+  bool paused_ = false;
+  size_t size_packets_ = 0;
+  uint64_t size_bytes_ = 0;
+  int64_t queue_time_sum_ms_ = 0;
+  int64_t pause_time_sum_ms_ = 0;
+
+  // Node storage. Chunks are never released until the queue is destroyed, and
+  // unused nodes are kept in |free_nodes_|.
+  std::vector<std::unique_ptr<Node[]>> node_chunks_;
+  Node* free_nodes_ = nullptr;
+
+  // Every packet currently in the queue, including one that has been handed
+  // out by BeginPop(), ordered by enqueue time.
+  Node* age_head_ = nullptr;
+  Node* age_tail_ = nullptr;
+
+  // For each priority, the stream at the front of a circular list of streams
+  // that have packets of that priority, or null if there are none.
+  Stream* rings_[kNumPriorities];
+
+  std::unordered_map<uint32_t, Stream> streams_;
+};
+}  // namespace webrtc
+
+#endif  // MODULES_PACING_POOLED_PACKET_QUEUE_H_
@@ -0,0 +1,248 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#include "modules/pacing/pooled_packet_queue.h"
+#include "modules/pacing/round_robin_packet_queue.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/clock.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t kPacketSize = 1200;
+
+class PooledPacketQueueTest : public ::testing::Test {
+ protected:
+  PooledPacketQueueTest() : clock_(123456), queue_(&clock_) {}
+
+  void Push(RtpPacketSender::Priority priority,
+            uint32_t ssrc,
+            uint16_t sequence_number,
+            size_t bytes = kPacketSize,
+            bool retransmission = false) {
+    queue_.Push(PacketQueueInterface::Packet(
+        priority, ssrc, sequence_number, clock_.TimeInMilliseconds(),
+        clock_.TimeInMilliseconds(), bytes, retransmission, enqueue_order_++));
+  }
+
+  PacketQueueInterface::Packet Pop() {
+    const PacketQueueInterface::Packet& packet = queue_.BeginPop();
+    PacketQueueInterface::Packet copy(packet);
+    queue_.FinalizePop(packet);
+    return copy;
+  }
+
+  SimulatedClock clock_;
+  PooledPacketQueue queue_;
+  uint64_t enqueue_order_ = 0;
+};
+
+TEST_F(PooledPacketQueueTest, StartsEmpty) {
+  EXPECT_TRUE(queue_.Empty());
+  EXPECT_EQ(0u, queue_.SizeInPackets());
+  EXPECT_EQ(0u, queue_.SizeInBytes());
+  EXPECT_EQ(0, queue_.OldestEnqueueTimeMs());
+  EXPECT_EQ(0, queue_.AverageQueueTimeMs());
+}
+
+TEST_F(PooledPacketQueueTest, PopsPacketsOfOneStreamInOrder) {
+  for (uint16_t i = 0; i < 200; ++i)
+    Push(RtpPacketSender::kNormalPriority, 1, i);
+  EXPECT_EQ(200u, queue_.SizeInPackets());
+  EXPECT_EQ(200 * kPacketSize, queue_.SizeInBytes());
+
+  for (uint16_t i = 0; i < 200; ++i)
+    EXPECT_EQ(i, Pop().sequence_number);
+  EXPECT_TRUE(queue_.Empty());
+  EXPECT_EQ(0u, queue_.SizeInBytes());
+}
+
+TEST_F(PooledPacketQueueTest, HigherPriorityAndRetransmissionsGoFirst) {
+  Push(RtpPacketSender::kLowPriority, 1, 1);
+  Push(RtpPacketSender::kNormalPriority, 2, 2);
+  Push(RtpPacketSender::kNormalPriority, 2, 3, kPacketSize, true);
+  Push(RtpPacketSender::kHighPriority, 3, 4);
+
+  EXPECT_EQ(4, Pop().sequence_number);
+  EXPECT_EQ(3, Pop().sequence_number);
+  EXPECT_EQ(2, Pop().sequence_number);
+  EXPECT_EQ(1, Pop().sequence_number);
+  EXPECT_TRUE(queue_.Empty());
+}
+
+TEST_F(PooledPacketQueueTest, SharesBytesEvenlyBetweenStreams) {
+  // Stream 1 sends small packets and stream 2 large ones, but both should get
+  // roughly the same number of bytes through.
+  const size_t kSmallPacketSize = 200;
+  for (uint16_t i = 0; i < 100; ++i) {
+    Push(RtpPacketSender::kNormalPriority, 1, i, kSmallPacketSize);
+    Push(RtpPacketSender::kNormalPriority, 2, i, kPacketSize);
+  }
+
+  std::map<uint32_t, size_t> bytes_sent;
+  for (int i = 0; i < 60; ++i) {
+    PacketQueueInterface::Packet packet = Pop();
+    bytes_sent[packet.ssrc] += packet.bytes;
+  }
+  EXPECT_NEAR(bytes_sent[1], bytes_sent[2],
+              2 * PooledPacketQueue::kQuantumBytes);
+}
+
+TEST_F(PooledPacketQueueTest, CancelPopKeepsOrder) {
+  Push(RtpPacketSender::kNormalPriority, 1, 1);
+  Push(RtpPacketSender::kNormalPriority, 1, 2);
+
+  const PacketQueueInterface::Packet& packet = queue_.BeginPop();
+  EXPECT_EQ(1, packet.sequence_number);
+  // Packets may be pushed while the popped packet is being sent.
+  Push(RtpPacketSender::kHighPriority, 2, 3);
+  queue_.CancelPop(packet);
+  EXPECT_EQ(3u, queue_.SizeInPackets());
+
+  EXPECT_EQ(3, Pop().sequence_number);
+  EXPECT_EQ(1, Pop().sequence_number);
+  EXPECT_EQ(2, Pop().sequence_number);
+  EXPECT_TRUE(queue_.Empty());
+}
+
+TEST_F(PooledPacketQueueTest, TracksOldestEnqueueTime) {
+  const int64_t first_time_ms = clock_.TimeInMilliseconds();
+  Push(RtpPacketSender::kLowPriority, 1, 1);
+  clock_.AdvanceTimeMilliseconds(10);
+  Push(RtpPacketSender::kHighPriority, 2, 2);
+  EXPECT_EQ(first_time_ms, queue_.OldestEnqueueTimeMs());
+
+  // The high priority packet is popped first, which doesn't affect the oldest
+  // enqueue time.
+  EXPECT_EQ(2, Pop().sequence_number);
+  EXPECT_EQ(first_time_ms, queue_.OldestEnqueueTimeMs());
+  EXPECT_EQ(1, Pop().sequence_number);
+  EXPECT_EQ(0, queue_.OldestEnqueueTimeMs());
+}
+
+TEST_F(PooledPacketQueueTest, AverageQueueTimeExcludesPausedTime) {
+  Push(RtpPacketSender::kNormalPriority, 1, 1);
+  clock_.AdvanceTimeMilliseconds(100);
+  queue_.SetPauseState(true, clock_.TimeInMilliseconds());
+  clock_.AdvanceTimeMilliseconds(100);
+  queue_.UpdateQueueTime(clock_.TimeInMilliseconds());
+  EXPECT_EQ(100, queue_.AverageQueueTimeMs());
+
+  // A packet pushed while paused starts out with zero queue time.
+  Push(RtpPacketSender::kNormalPriority, 1, 2);
+  EXPECT_EQ(50, queue_.AverageQueueTimeMs());
+
+  queue_.SetPauseState(false, clock_.TimeInMilliseconds());
+  clock_.AdvanceTimeMilliseconds(100);
+  queue_.UpdateQueueTime(clock_.TimeInMilliseconds());
+  EXPECT_EQ(150, queue_.AverageQueueTimeMs());
+
+  Pop();
+  EXPECT_EQ(100, queue_.AverageQueueTimeMs());
+  Pop();
+  EXPECT_EQ(0, queue_.AverageQueueTimeMs());
+}
+
+TEST_F(PooledPacketQueueTest, MatchesRoundRobinQueueForSingleStream) {
+  RoundRobinPacketQueue reference(&clock_);
+  const RtpPacketSender::Priority kPriorities[] = {
+      RtpPacketSender::kHighPriority, RtpPacketSender::kNormalPriority,
+      RtpPacketSender::kLowPriority};
+  for (uint16_t i = 0; i < 300; ++i) {
+    PacketQueueInterface::Packet packet(kPriorities[i % 3], 1, i,
+                                        clock_.TimeInMilliseconds(),
+                                        clock_.TimeInMilliseconds(),
+                                        kPacketSize, i % 7 == 0, i);
+    queue_.Push(packet);
+    reference.Push(packet);
+    clock_.AdvanceTimeMilliseconds(1);
+  }
+
+  while (!reference.Empty()) {
+    ASSERT_FALSE(queue_.Empty());
+    const PacketQueueInterface::Packet& expected = reference.BeginPop();
+    const PacketQueueInterface::Packet& actual = queue_.BeginPop();
+    EXPECT_EQ(expected.sequence_number, actual.sequence_number);
+    reference.FinalizePop(expected);
+    queue_.FinalizePop(actual);
+  }
+  EXPECT_TRUE(queue_.Empty());
+}
+
+// Measures the cost of pushing and popping packets, compared to the
+// RoundRobinPacketQueue, for a varying number of streams.
+class PacketQueueThroughputTest : public ::testing::TestWithParam<int> {
+ protected:
+  PacketQueueThroughputTest() : clock_(123456) {}
+
+  int64_t RunPushPop(PacketQueueInterface* queue) {
+    const int num_ssrcs = GetParam();
+    const int kQueueDepth = 200;
+    const int kNumPackets = 200000;
+    uint64_t enqueue_order = 0;
+
+    int64_t start_us = rtc::TimeMicros();
+    for (int i = 0; i < kQueueDepth; ++i) {
+      queue->Push(PacketQueueInterface::Packet(
+          RtpPacketSender::kNormalPriority, i % num_ssrcs,
+          static_cast<uint16_t>(i), clock_.TimeInMilliseconds(),
+          clock_.TimeInMilliseconds(), kPacketSize, false, enqueue_order++));
+    }
+    for (int i = kQueueDepth; i < kNumPackets; ++i) {
+      // Retransmissions and audio every now and then, to exercise the
+      // priority handling.
+      RtpPacketSender::Priority priority =
+          i % 50 == 0 ? RtpPacketSender::kHighPriority
+                      : RtpPacketSender::kNormalPriority;
+      queue->Push(PacketQueueInterface::Packet(
+          priority, i % num_ssrcs, static_cast<uint16_t>(i),
+          clock_.TimeInMilliseconds(), clock_.TimeInMilliseconds(),
+          kPacketSize, i % 20 == 0, enqueue_order++));
+      const PacketQueueInterface::Packet& packet = queue->BeginPop();
+      queue->FinalizePop(packet);
+    }
+    while (!queue->Empty()) {
+      const PacketQueueInterface::Packet& packet = queue->BeginPop();
+      queue->FinalizePop(packet);
+    }
+    int64_t elapsed_us = rtc::TimeMicros() - start_us;
+    return kNumPackets * rtc::kNumMicrosecsPerSec /
+           std::max<int64_t>(elapsed_us, 1);
+  }
+
+  SimulatedClock clock_;
+};
+
+// Disabled because it only logs timings.
+TEST_P(PacketQueueThroughputTest, DISABLED_PushPop) {
+  PooledPacketQueue pooled(&clock_);
+  RoundRobinPacketQueue round_robin(&clock_);
+  int64_t pooled_packets_per_second = RunPushPop(&pooled);
+  int64_t round_robin_packets_per_second = RunPushPop(&round_robin);
+  EXPECT_TRUE(pooled.Empty());
+  EXPECT_TRUE(round_robin.Empty());
+  RTC_LOG(LS_INFO) << GetParam() << " SSRCs: PooledPacketQueue "
+                   << pooled_packets_per_second
+                   << " packets/s, RoundRobinPacketQueue "
+                   << round_robin_packets_per_second << " packets/s.";
+}
+
+INSTANTIATE_TEST_CASE_P(NumSsrcs,
+                        PacketQueueThroughputTest,
+                        ::testing::Values(1, 10, 100));
+
+}  // namespace
+}  // namespace webrtc
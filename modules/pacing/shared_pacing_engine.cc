@@ -0,0 +1,414 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/pacing/shared_pacing_engine.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "modules/include/module.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/task_queue.h"
+#include "rtc_base/timeutils.h"
+#include "rtc_base/trace_event.h"
+
+namespace webrtc {
+namespace {
+
+int64_t GetNextCallbackTime(Module* module, int64_t time_now) {
+  int64_t interval = module->TimeUntilNextProcess();
+  if (interval < 0) {
+    // Falling behind, we should call the callback now.
+    return time_now;
+  }
+  return time_now + interval;
+}
+
+}  // namespace
+
+constexpr int64_t SharedPacingEngine::kDefaultCoalescingWindowMs;
+constexpr int SharedPacingEngine::kWheelBits;
+constexpr int SharedPacingEngine::kWheelSize;
+constexpr int64_t SharedPacingEngine::kWheelMask;
+constexpr int64_t SharedPacingEngine::kWheelSpanMs;
+
+void SharedPacingEngine::EntryList::PushBack(Entry* entry) {
+  RTC_DCHECK(!entry->list);
+  entry->list = this;
+  entry->prev = tail;
+  entry->next = nullptr;
+  if (tail) {
+    tail->next = entry;
+  } else {
+    head = entry;
+  }
+  tail = entry;
+}
+
+void SharedPacingEngine::EntryList::Remove(Entry* entry) {
+  RTC_DCHECK_EQ(entry->list, this);
+  if (entry->prev) {
+    entry->prev->next = entry->next;
+  } else {
+    head = entry->next;
+  }
+  if (entry->next) {
+    entry->next->prev = entry->prev;
+  } else {
+    tail = entry->prev;
+  }
+  entry->list = nullptr;
+  entry->prev = nullptr;
+  entry->next = nullptr;
+}
+
+SharedPacingEngine::Entry* SharedPacingEngine::EntryList::PopFront() {
+  Entry* entry = head;
+  if (entry)
+    Remove(entry);
+  return entry;
+}
+
+SharedPacingEngine::SharedPacingEngine(const char* thread_name)
+    : SharedPacingEngine(thread_name, kDefaultCoalescingWindowMs) {}
+
+SharedPacingEngine::SharedPacingEngine(const char* thread_name,
+                                       int64_t coalescing_window_ms)
+    : coalescing_window_ms_(coalescing_window_ms),
+      thread_name_(thread_name),
+      wake_up_(EventWrapper::Create()),
+      current_ms_(rtc::TimeMillis()) {
+  RTC_DCHECK_GE(coalescing_window_ms_, 0);
+}
+
+SharedPacingEngine::~SharedPacingEngine() {
+  RTC_DCHECK(!thread_.get());
+  RTC_DCHECK(!stop_);
+
+  while (!queue_.empty()) {
+    delete queue_.front();
+    queue_.pop();
+  }
+}
+
+// static
+SharedPacingEngine* SharedPacingEngine::GetDefault() {
+  static SharedPacingEngine* const engine = [] {
+    SharedPacingEngine* engine = new SharedPacingEngine("SharedPacerThread");
+    engine->Start();
+    return engine;
+  }();
+  return engine;
+}
+
+void SharedPacingEngine::Start() {
+  RTC_DCHECK(!thread_.get());
+  if (thread_.get())
+    return;
+
+  std::vector<Module*> modules;
+  {
+    rtc::CritScope lock(&lock_);
+    RTC_DCHECK(!stop_);
+    started_ = true;
+    for (const auto& it : entries_)
+      modules.push_back(it.second->module);
+  }
+  for (Module* module : modules)
+    module->ProcessThreadAttached(this);
+
+  thread_.reset(
+      new rtc::PlatformThread(&SharedPacingEngine::Run, this, thread_name_));
+  thread_->Start();
+}
+
+void SharedPacingEngine::Stop() {
+  if (!thread_.get())
+    return;
+
+  {
+    rtc::CritScope lock(&lock_);
+    stop_ = true;
+  }
+
+  wake_up_->Set();
+
+  thread_->Stop();
+  thread_.reset();
+
+  std::vector<Module*> modules;
+  {
+    rtc::CritScope lock(&lock_);
+    stop_ = false;
+    started_ = false;
+    for (const auto& it : entries_)
+      modules.push_back(it.second->module);
+  }
+  for (Module* module : modules)
+    module->ProcessThreadAttached(nullptr);
+}
+
+void SharedPacingEngine::WakeUp(Module* module) {
+  // Allowed to be called on any thread.
+  {
+    rtc::CritScope lock(&lock_);
+    auto it = entries_.find(module);
+    if (it == entries_.end())
+      return;
+    Entry* entry = it->second.get();
+    if (entry == processing_) {
+      processing_woken_ = true;
+    } else {
+      entry->queried = true;
+      Unschedule(entry);
+      Schedule(entry, rtc::TimeMillis());
+    }
+  }
+  wake_up_->Set();
+}
+
+void SharedPacingEngine::PostTask(std::unique_ptr<rtc::QueuedTask> task) {
+  // Allowed to be called on any thread.
+  {
+    rtc::CritScope lock(&lock_);
+    queue_.push(task.release());
+  }
+  wake_up_->Set();
+}
+
+void SharedPacingEngine::RegisterModule(Module* module,
+                                        const rtc::Location& from) {
+  RTC_DCHECK(module) << from.ToString();
+
+  bool started;
+  {
+    rtc::CritScope lock(&lock_);
+    RTC_DCHECK(entries_.find(module) == entries_.end())
+        << "Already registered, now attempting from here: "
+        << from.ToString();
+    started = started_;
+  }
+
+  // As for ProcessThreadImpl, notify the module without holding the lock.
+  if (started)
+    module->ProcessThreadAttached(this);
+
+  {
+    rtc::CritScope lock(&lock_);
+    Entry* entry = new Entry(module, from);
+    entries_[module].reset(entry);
+    // The engine thread queries the module for when it wants to be processed.
+    Schedule(entry, current_ms_);
+  }
+
+  wake_up_->Set();
+}
+
+void SharedPacingEngine::DeRegisterModule(Module* module) {
+  RTC_DCHECK(module);
+
+  {
+    rtc::CritScope lock(&lock_);
+    auto it = entries_.find(module);
+    if (it != entries_.end()) {
+      Entry* entry = it->second.get();
+      if (entry == processing_) {
+        // Deregistered from within its own Process() call. The entry is
+        // removed once that returns.
+        processing_removed_ = true;
+      } else {
+        Unschedule(entry);
+        entries_.erase(it);
+      }
+    }
+  }
+
+  // Notify the module that it's been detached.
+  module->ProcessThreadAttached(nullptr);
+}
+
+rtc::Optional<SharedPacingEngine::SchedulingStats>
+SharedPacingEngine::GetSchedulingStats(const Module* module) const {
+  rtc::CritScope lock(&lock_);
+  auto it = entries_.find(module);
+  if (it == entries_.end())
+    return rtc::nullopt;
+  return it->second->stats;
+}
+
+int64_t SharedPacingEngine::num_wakeups() const {
+  rtc::CritScope lock(&lock_);
+  return num_wakeups_;
+}
+
+// static
+bool SharedPacingEngine::Run(void* obj) {
+  return static_cast<SharedPacingEngine*>(obj)->Process();
+}
+
+bool SharedPacingEngine::Process() {
+  {
+    rtc::CritScope lock(&lock_);
+    if (stop_)
+      return false;
+  }
+
+  int64_t time_to_wait = ProcessDueModules();
+  if (time_to_wait > 0)
+    wake_up_->Wait(static_cast<unsigned long>(time_to_wait));
+
+  return true;
+}
+
+int64_t SharedPacingEngine::ProcessDueModules() {
+  TRACE_EVENT1("webrtc", "SharedPacingEngine", "name", thread_name_);
+  int64_t now = rtc::TimeMillis();
+
+  rtc::CritScope lock(&lock_);
+  // Anything that is due within the coalescing window is processed now,
+  // rather than in a separate wakeup.
+  AdvanceTo(now + coalescing_window_ms_);
+
+  // Modules that become due again while processing the batch are left for
+  // the next wakeup, so that one module can't starve the others.
+  if (!ready_.empty())
+    ++num_wakeups_;
+  while (Entry* entry = ready_.PopFront())
+    batch_.PushBack(entry);
+  while (Entry* entry = batch_.PopFront())
+    ProcessEntry(entry, now);
+
+  while (!queue_.empty()) {
+    rtc::QueuedTask* task = queue_.front();
+    queue_.pop();
+    lock_.Leave();
+    task->Run();
+    delete task;
+    lock_.Enter();
+  }
+
+  if (!ready_.empty())
+    return 0;
+  return NextDueTime() - rtc::TimeMillis();
+}
+
+void SharedPacingEngine::ProcessEntry(Entry* entry, int64_t now_ms) {
+  if (!entry->queried) {
+    entry->queried = true;
+    Schedule(entry, GetNextCallbackTime(entry->module, now_ms));
+    return;
+  }
+
+  SchedulingStats& stats = entry->stats;
+  stats.last_lag_ms = std::max<int64_t>(0, now_ms - entry->due_ms);
+  stats.max_lag_ms = std::max(stats.max_lag_ms, stats.last_lag_ms);
+  stats.sum_lag_ms += stats.last_lag_ms;
+  ++stats.num_process_calls;
+
+  processing_ = entry;
+  processing_removed_ = false;
+  processing_woken_ = false;
+  {
+    TRACE_EVENT2("webrtc", "ModuleProcess", "function",
+                 entry->location.function_name(), "file",
+                 entry->location.file_and_line());
+    entry->module->Process();
+  }
+  processing_ = nullptr;
+
+  if (processing_removed_) {
+    entries_.erase(entry->module);
+    return;
+  }
+  int64_t new_now = rtc::TimeMillis();
+  Schedule(entry, processing_woken_
+                      ? new_now
+                      : GetNextCallbackTime(entry->module, new_now));
+}
+
+void SharedPacingEngine::Schedule(Entry* entry, int64_t due_ms) {
+  entry->due_ms = due_ms;
+  if (due_ms <= current_ms_) {
+    ready_.PushBack(entry);
+    return;
+  }
+
+  int64_t delta_ms = due_ms - current_ms_;
+  if (delta_ms < kWheelSize) {
+    inner_wheel_[due_ms & kWheelMask].PushBack(entry);
+  } else if (delta_ms < kWheelSpanMs) {
+    outer_wheel_[(due_ms >> kWheelBits) & kWheelMask].PushBack(entry);
+  } else {
+    // Too far ahead for the outer wheel; park it in the last outer slot and
+    // re-insert it from there.
+    outer_wheel_[((current_ms_ >> kWheelBits) + kWheelSize - 1) & kWheelMask]
+        .PushBack(entry);
+  }
+}
+
+void SharedPacingEngine::Unschedule(Entry* entry) {
+  if (entry->list)
+    entry->list->Remove(entry);
+}
+
+void SharedPacingEngine::AdvanceTo(int64_t time_ms) {
+  if (time_ms <= current_ms_)
+    return;
+
+  if (time_ms - current_ms_ >= kWheelSpanMs) {
+    // The whole wheel has been passed, e.g. after a long time without any
+    // modules. Re-insert everything relative to the new time.
+    EntryList all;
+    for (int i = 0; i < kWheelSize; ++i) {
+      while (Entry* entry = inner_wheel_[i].PopFront())
+        all.PushBack(entry);
+      while (Entry* entry = outer_wheel_[i].PopFront())
+        all.PushBack(entry);
+    }
+    current_ms_ = time_ms;
+    while (Entry* entry = all.PopFront())
+      Schedule(entry, entry->due_ms);
+    return;
+  }
+
+  while (current_ms_ < time_ms) {
+    ++current_ms_;
+    if ((current_ms_ & kWheelMask) == 0)
+      CascadeOuterSlot((current_ms_ >> kWheelBits) & kWheelMask);
+    EntryList& slot = inner_wheel_[current_ms_ & kWheelMask];
+    while (Entry* entry = slot.PopFront())
+      ready_.PushBack(entry);
+  }
+}
+
+void SharedPacingEngine::CascadeOuterSlot(int index) {
+  EntryList entries;
+  while (Entry* entry = outer_wheel_[index].PopFront())
+    entries.PushBack(entry);
+  while (Entry* entry = entries.PopFront())
+    Schedule(entry, entry->due_ms);
+}
+
+int64_t SharedPacingEngine::NextDueTime() const {
+  for (int64_t i = 1; i < kWheelSize; ++i) {
+    if (!inner_wheel_[(current_ms_ + i) & kWheelMask].empty())
+      return current_ms_ + i;
+  }
+  // Wake up at the start of the first non-empty outer slot, where its entries
+  // are moved to the inner wheel.
+  const int64_t current_slot = current_ms_ >> kWheelBits;
+  for (int64_t i = 1; i <= kWheelSize; ++i) {
+    if (!outer_wheel_[(current_slot + i) & kWheelMask].empty())
+      return (current_slot + i) << kWheelBits;
+  }
+  return current_ms_ + kWheelSpanMs;
+}
+
+}  // namespace webrtc
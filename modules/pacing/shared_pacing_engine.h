@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_PACING_SHARED_PACING_ENGINE_H_
+#define MODULES_PACING_SHARED_PACING_ENGINE_H_
+
+#include <memory>
+#include <queue>
+#include <unordered_map>
+
+#include "api/optional.h"
+#include "modules/utility/include/process_thread.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/location.h"
+#include "rtc_base/platform_thread.h"
+#include "system_wrappers/include/event_wrapper.h"
+
+namespace webrtc {
+
+// A ProcessThread that drives the pacers of many calls from a single thread.
+// Instead of querying every registered module on each wakeup, modules are
+// kept in a two level timer wheel with millisecond resolution, so the cost of
+// a wakeup only depends on the number of modules that are due. Modules that
+// are due within |coalescing_window_ms| of each other are processed in the
+// same wakeup. Each module keeps its own state (e.g. the IntervalBudget and
+// BitrateProber of a PacedSender); the engine only decides when to call it.
+//
+// Unlike ProcessThreadImpl, modules may be registered and deregistered from
+// any thread, so that one engine can be shared by all calls in a process.
+class SharedPacingEngine : public ProcessThread {
+ public:
+  static constexpr int64_t kDefaultCoalescingWindowMs = 1;
+
+  // How late a module has been processed, compared to the time it asked to be
+  // processed at.
+  struct SchedulingStats {
+    int64_t num_process_calls = 0;
+    int64_t last_lag_ms = 0;
+    int64_t max_lag_ms = 0;
+    int64_t sum_lag_ms = 0;
+  };
+
+  explicit SharedPacingEngine(const char* thread_name);
+  SharedPacingEngine(const char* thread_name, int64_t coalescing_window_ms);
+  ~SharedPacingEngine() override;
+
+  // Returns an engine that is shared by everyone in the process. It is
+  // started on first use and never stopped.
+  static SharedPacingEngine* GetDefault();
+
+  void Start() override;
+  void Stop() override;
+
+  void WakeUp(Module* module) override;
+  void PostTask(std::unique_ptr<rtc::QueuedTask> task) override;
+
+  void RegisterModule(Module* module, const rtc::Location& from) override;
+  void DeRegisterModule(Module* module) override;
+
+  rtc::Optional<SchedulingStats> GetSchedulingStats(
+      const Module* module) const;
+
+  // Number of times the engine has processed modules, for testing the effect
+  // of coalescing.
+  int64_t num_wakeups() const;
+
+ protected:
+  static bool Run(void* obj);
+  bool Process();
+
+  // Processes all modules that are due, and runs posted tasks. Returns the
+  // number of milliseconds until the next module is due.
+  int64_t ProcessDueModules();
+
+ private:
+  static constexpr int kWheelBits = 6;
+  static constexpr int kWheelSize = 1 << kWheelBits;
+  static constexpr int64_t kWheelMask = kWheelSize - 1;
+  // Time spanned by the outer wheel. Modules that are due later than this are
+  // put in the last outer slot and re-inserted when it is reached.
+  static constexpr int64_t kWheelSpanMs = kWheelSize * kWheelSize;
+
+  struct Entry;
+
+  // Intrusive doubly linked list of entries.
+  struct EntryList {
+    bool empty() const { return head == nullptr; }
+    void PushBack(Entry* entry);
+    void Remove(Entry* entry);
+    Entry* PopFront();
+
+    Entry* head = nullptr;
+    Entry* tail = nullptr;
+  };
+
+  struct Entry {
+    Entry(Module* module, const rtc::Location& location)
+        : module(module), location(location) {}
+
+    Module* const module;
+    const rtc::Location location;
+    // Absolute time at which the module wants to be processed.
+    int64_t due_ms = 0;
+    // False until TimeUntilNextProcess() has been called on the engine thread.
+    bool queried = false;
+    SchedulingStats stats;
+
+    // The list this entry is currently linked into, if any.
+    EntryList* list = nullptr;
+    Entry* prev = nullptr;
+    Entry* next = nullptr;
+  };
+
+  void Schedule(Entry* entry, int64_t due_ms)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void Unschedule(Entry* entry) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Moves all entries that are due at or before |time_ms| to |ready_|.
+  void AdvanceTo(int64_t time_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void CascadeOuterSlot(int index) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  int64_t NextDueTime() const RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void ProcessEntry(Entry* entry, int64_t now_ms)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const int64_t coalescing_window_ms_;
+  const char* const thread_name_;
+  const std::unique_ptr<EventWrapper> wake_up_;
+  std::unique_ptr<rtc::PlatformThread> thread_;
+
+  // Held while modules are processed, which means that DeRegisterModule()
+  // blocks until the module is no longer in use.
+  rtc::CriticalSection lock_;
+  bool stop_ RTC_GUARDED_BY(lock_) = false;
+  bool started_ RTC_GUARDED_BY(lock_) = false;
+  int64_t num_wakeups_ RTC_GUARDED_BY(lock_) = 0;
+
+  std::unordered_map<const Module*, std::unique_ptr<Entry>> entries_
+      RTC_GUARDED_BY(lock_);
+  // Entries in the wheels are due after |current_ms_|. The inner wheel has one
+  // slot per millisecond and the outer wheel one slot per kWheelSize ms.
+  int64_t current_ms_ RTC_GUARDED_BY(lock_);
+  EntryList inner_wheel_[kWheelSize] RTC_GUARDED_BY(lock_);
+  EntryList outer_wheel_[kWheelSize] RTC_GUARDED_BY(lock_);
+  // Entries that are due, and entries that are being processed in the current
+  // wakeup.
+  EntryList ready_ RTC_GUARDED_BY(lock_);
+  EntryList batch_ RTC_GUARDED_BY(lock_);
+  // Entry currently being processed, and whether it was deregistered or woken
+  // up from within its own Process() call.
+  Entry* processing_ RTC_GUARDED_BY(lock_) = nullptr;
+  bool processing_removed_ RTC_GUARDED_BY(lock_) = false;
+  bool processing_woken_ RTC_GUARDED_BY(lock_) = false;
+
+  std::queue<rtc::QueuedTask*> queue_ RTC_GUARDED_BY(lock_);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_PACING_SHARED_PACING_ENGINE_H_
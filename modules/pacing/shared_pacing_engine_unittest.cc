@@ -0,0 +1,236 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "modules/include/module.h"
+#include "modules/pacing/shared_pacing_engine.h"
+#include "rtc_base/event.h"
+#include "rtc_base/fakeclock.h"
+#include "rtc_base/location.h"
+#include "rtc_base/ptr_util.h"
+#include "rtc_base/timeutils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+// Module that wants to be processed every |interval_ms|, starting
+// |first_delay_ms| after it's first queried.
+class PeriodicModule : public Module {
+ public:
+  PeriodicModule(int64_t interval_ms, int64_t first_delay_ms)
+      : interval_ms_(interval_ms), first_delay_ms_(first_delay_ms) {}
+
+  int64_t TimeUntilNextProcess() override {
+    if (next_process_ms_ < 0)
+      next_process_ms_ = rtc::TimeMillis() + first_delay_ms_;
+    return next_process_ms_ - rtc::TimeMillis();
+  }
+
+  void Process() override {
+    ++num_process_calls_;
+    process_times_ms_.push_back(rtc::TimeMillis());
+    next_process_ms_ = rtc::TimeMillis() + interval_ms_;
+  }
+
+  int num_process_calls() const { return num_process_calls_; }
+  const std::vector<int64_t>& process_times_ms() const {
+    return process_times_ms_;
+  }
+
+ private:
+  const int64_t interval_ms_;
+  const int64_t first_delay_ms_;
+  int64_t next_process_ms_ = -1;
+  int num_process_calls_ = 0;
+  std::vector<int64_t> process_times_ms_;
+};
+
+// Drives the engine from the test instead of from its own thread.
+class ManualSharedPacingEngine : public SharedPacingEngine {
+ public:
+  explicit ManualSharedPacingEngine(int64_t coalescing_window_ms)
+      : SharedPacingEngine("ManualSharedPacingEngine", coalescing_window_ms) {}
+
+  using SharedPacingEngine::ProcessDueModules;
+};
+
+class SharedPacingEngineTest : public ::testing::Test {
+ protected:
+  SharedPacingEngineTest() {
+    clock_.SetTimeMicros(123456 * rtc::kNumMicrosecsPerMillisec);
+  }
+
+  // Runs the engine the way its thread would, until |duration_ms| has passed.
+  void RunFor(SharedPacingEngine* engine, int64_t duration_ms) {
+    ManualSharedPacingEngine* manual =
+        static_cast<ManualSharedPacingEngine*>(engine);
+    const int64_t end_ms = rtc::TimeMillis() + duration_ms;
+    while (true) {
+      int64_t time_to_wait_ms = manual->ProcessDueModules();
+      int64_t step_ms =
+          std::min(std::max<int64_t>(time_to_wait_ms, 0),
+                   end_ms - rtc::TimeMillis());
+      if (step_ms <= 0 && rtc::TimeMillis() >= end_ms)
+        break;
+      clock_.AdvanceTime(rtc::TimeDelta::FromMilliseconds(step_ms));
+    }
+  }
+
+  rtc::ScopedFakeClock clock_;
+};
+
+TEST_F(SharedPacingEngineTest, ProcessesModuleAtRequestedInterval) {
+  ManualSharedPacingEngine engine(0);
+  PeriodicModule module(5, 5);
+  engine.RegisterModule(&module, RTC_FROM_HERE);
+
+  const int64_t start_ms = rtc::TimeMillis();
+  RunFor(&engine, 100);
+  EXPECT_EQ(20, module.num_process_calls());
+  for (size_t i = 0; i < module.process_times_ms().size(); ++i)
+    EXPECT_EQ(start_ms + 5 * static_cast<int64_t>(i + 1),
+              module.process_times_ms()[i]);
+
+  rtc::Optional<SharedPacingEngine::SchedulingStats> stats =
+      engine.GetSchedulingStats(&module);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(20, stats->num_process_calls);
+  EXPECT_EQ(0, stats->max_lag_ms);
+  engine.DeRegisterModule(&module);
+  EXPECT_FALSE(engine.GetSchedulingStats(&module));
+}
+
+TEST_F(SharedPacingEngineTest, CoalescesWakeupsOfManyModules) {
+  const int kNumModules = 300;
+  const int64_t kCoalescingWindowMs = 2;
+  ManualSharedPacingEngine engine(kCoalescingWindowMs);
+  std::vector<std::unique_ptr<PeriodicModule>> modules;
+  for (int i = 0; i < kNumModules; ++i) {
+    // Spread the modules out over the 5 ms pacer interval.
+    modules.push_back(rtc::MakeUnique<PeriodicModule>(5, i % 5));
+    engine.RegisterModule(modules.back().get(), RTC_FROM_HERE);
+  }
+
+  RunFor(&engine, 1000);
+  // Without coalescing there would be one wakeup per millisecond.
+  EXPECT_LT(engine.num_wakeups(), 1000 / kCoalescingWindowMs);
+  for (const auto& module : modules) {
+    EXPECT_GE(module->num_process_calls(), 1000 / 5 - 1);
+    rtc::Optional<SharedPacingEngine::SchedulingStats> stats =
+        engine.GetSchedulingStats(module.get());
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(0, stats->max_lag_ms);
+    engine.DeRegisterModule(module.get());
+  }
+}
+
+TEST_F(SharedPacingEngineTest, ReportsSchedulingLag) {
+  ManualSharedPacingEngine engine(0);
+  PeriodicModule module(5, 5);
+  engine.RegisterModule(&module, RTC_FROM_HERE);
+  engine.ProcessDueModules();
+
+  // The engine thread is late, e.g. because the machine is overloaded.
+  clock_.AdvanceTime(rtc::TimeDelta::FromMilliseconds(12));
+  engine.ProcessDueModules();
+  rtc::Optional<SharedPacingEngine::SchedulingStats> stats =
+      engine.GetSchedulingStats(&module);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(1, stats->num_process_calls);
+  EXPECT_EQ(7, stats->last_lag_ms);
+  EXPECT_EQ(7, stats->max_lag_ms);
+
+  clock_.AdvanceTime(rtc::TimeDelta::FromMilliseconds(5));
+  engine.ProcessDueModules();
+  stats = engine.GetSchedulingStats(&module);
+  EXPECT_EQ(2, stats->num_process_calls);
+  EXPECT_EQ(0, stats->last_lag_ms);
+  EXPECT_EQ(7, stats->max_lag_ms);
+  engine.DeRegisterModule(&module);
+}
+
+TEST_F(SharedPacingEngineTest, HandlesModulesBeyondTheWheel) {
+  ManualSharedPacingEngine engine(0);
+  // Further ahead than the outer wheel covers.
+  PeriodicModule slow_module(10000, 10000);
+  PeriodicModule paused_module(500, 500);
+  engine.RegisterModule(&slow_module, RTC_FROM_HERE);
+  engine.RegisterModule(&paused_module, RTC_FROM_HERE);
+
+  const int64_t start_ms = rtc::TimeMillis();
+  RunFor(&engine, 20001);
+  ASSERT_EQ(2, slow_module.num_process_calls());
+  EXPECT_EQ(start_ms + 10000, slow_module.process_times_ms()[0]);
+  EXPECT_EQ(start_ms + 20000, slow_module.process_times_ms()[1]);
+  EXPECT_EQ(40, paused_module.num_process_calls());
+  engine.DeRegisterModule(&slow_module);
+  engine.DeRegisterModule(&paused_module);
+}
+
+TEST_F(SharedPacingEngineTest, WakeUpProcessesModuleRightAway) {
+  ManualSharedPacingEngine engine(0);
+  PeriodicModule module(500, 500);
+  engine.RegisterModule(&module, RTC_FROM_HERE);
+  engine.ProcessDueModules();
+  clock_.AdvanceTime(rtc::TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(0, module.num_process_calls());
+
+  engine.WakeUp(&module);
+  engine.ProcessDueModules();
+  EXPECT_EQ(1, module.num_process_calls());
+  engine.DeRegisterModule(&module);
+}
+
+class DeregisteringModule : public PeriodicModule {
+ public:
+  explicit DeregisteringModule(SharedPacingEngine* engine)
+      : PeriodicModule(5, 5), engine_(engine) {}
+
+  void Process() override {
+    PeriodicModule::Process();
+    engine_->DeRegisterModule(this);
+  }
+
+ private:
+  SharedPacingEngine* const engine_;
+};
+
+TEST_F(SharedPacingEngineTest, ModuleCanDeregisterItselfWhileProcessed) {
+  ManualSharedPacingEngine engine(0);
+  DeregisteringModule module(&engine);
+  engine.RegisterModule(&module, RTC_FROM_HERE);
+  RunFor(&engine, 100);
+  EXPECT_EQ(1, module.num_process_calls());
+  EXPECT_FALSE(engine.GetSchedulingStats(&module));
+}
+
+TEST(SharedPacingEngineThreadTest, ProcessesModulesOnItsThread) {
+  class SignalingModule : public Module {
+   public:
+    int64_t TimeUntilNextProcess() override { return 5; }
+    void Process() override { processed_.Set(); }
+    rtc::Event processed_{false, false};
+  };
+
+  SharedPacingEngine engine("SharedPacingEngineTest");
+  SignalingModule module;
+  engine.RegisterModule(&module, RTC_FROM_HERE);
+  engine.Start();
+  EXPECT_TRUE(module.processed_.Wait(1000));
+  engine.Stop();
+  engine.DeRegisterModule(&module);
+}
+
+}  // namespace
+}  // namespace webrtc
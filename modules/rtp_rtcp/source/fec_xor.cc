@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/rtp_rtcp/source/fec_xor.h"
+
+#if defined(WEBRTC_HAS_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+#include <string.h>
+
+#include "system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace internal {
+namespace {
+
+using SimdXorFunction = size_t (*)(const uint8_t* src,
+                                   size_t length,
+                                   uint8_t* const* dsts,
+                                   size_t num_dsts);
+
+// XORs bytes [|begin|, |length|) of |src| into |dsts|, a word at a time.
+void XorTail(const uint8_t* src,
+             size_t begin,
+             size_t length,
+             uint8_t* const* dsts,
+             size_t num_dsts) {
+  size_t i = begin;
+  for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+    uint64_t s;
+    memcpy(&s, src + i, sizeof(s));
+    for (size_t k = 0; k < num_dsts; ++k) {
+      uint64_t d;
+      memcpy(&d, dsts[k] + i, sizeof(d));
+      d ^= s;
+      memcpy(dsts[k] + i, &d, sizeof(d));
+    }
+  }
+  for (; i < length; ++i) {
+    for (size_t k = 0; k < num_dsts; ++k)
+      dsts[k][i] ^= src[i];
+  }
+}
+
+SimdXorFunction SelectSimdXorFunction() {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kAVX2))
+    return XorToMultipleAvx2;
+  if (WebRtc_GetCPUInfo(kSSE2))
+    return XorToMultipleSse2;
+#elif defined(WEBRTC_HAS_NEON)
+  return XorToMultipleNeon;
+#endif
+  return nullptr;
+}
+
+}  // namespace
+
+void XorToMultiple(const uint8_t* src,
+                   size_t length,
+                   uint8_t* const* dsts,
+                   size_t num_dsts) {
+  static const SimdXorFunction simd_xor = SelectSimdXorFunction();
+  const size_t processed = simd_xor ? simd_xor(src, length, dsts, num_dsts) : 0;
+  XorTail(src, processed, length, dsts, num_dsts);
+}
+
+void XorToMultipleC(const uint8_t* src,
+                    size_t length,
+                    uint8_t* const* dsts,
+                    size_t num_dsts) {
+  XorTail(src, 0, length, dsts, num_dsts);
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+size_t XorToMultipleSse2(const uint8_t* src,
+                         size_t length,
+                         uint8_t* const* dsts,
+                         size_t num_dsts) {
+  const size_t simd_length = length & ~static_cast<size_t>(15);
+  for (size_t i = 0; i < simd_length; i += 16) {
+    const __m128i s =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    for (size_t k = 0; k < num_dsts; ++k) {
+      __m128i* d = reinterpret_cast<__m128i*>(dsts[k] + i);
+      _mm_storeu_si128(d, _mm_xor_si128(_mm_loadu_si128(d), s));
+    }
+  }
+  return simd_length;
+}
+#endif
+
+#if defined(WEBRTC_HAS_NEON)
+size_t XorToMultipleNeon(const uint8_t* src,
+                         size_t length,
+                         uint8_t* const* dsts,
+                         size_t num_dsts) {
+  const size_t simd_length = length & ~static_cast<size_t>(15);
+  for (size_t i = 0; i < simd_length; i += 16) {
+    const uint8x16_t s = vld1q_u8(src + i);
+    for (size_t k = 0; k < num_dsts; ++k) {
+      uint8_t* d = dsts[k] + i;
+      vst1q_u8(d, veorq_u8(vld1q_u8(d), s));
+    }
+  }
+  return simd_length;
+}
+#endif
+
+}  // namespace internal
+}  // namespace webrtc
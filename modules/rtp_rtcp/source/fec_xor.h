@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_RTP_RTCP_SOURCE_FEC_XOR_H_
+#define MODULES_RTP_RTCP_SOURCE_FEC_XOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "typedefs.h"  // NOLINT(build/include)
+
+namespace webrtc {
+namespace internal {
+
+// XORs |length| bytes of |src| into each of the |num_dsts| buffers pointed to
+// by |dsts|. |src| is read only once, so a media packet protected by several
+// FEC packets is XORed into all of them in a single pass over its payload.
+// Uses the widest SIMD kernel supported by the CPU, detected at runtime.
+void XorToMultiple(const uint8_t* src,
+                   size_t length,
+                   uint8_t* const* dsts,
+                   size_t num_dsts);
+
+// Portable implementation of XorToMultiple(), exposed for testing.
+void XorToMultipleC(const uint8_t* src,
+                    size_t length,
+                    uint8_t* const* dsts,
+                    size_t num_dsts);
+
+// The SIMD kernels below XOR the largest prefix of |length| that is a multiple
+// of their vector width, and return the number of bytes processed.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+size_t XorToMultipleSse2(const uint8_t* src,
+                         size_t length,
+                         uint8_t* const* dsts,
+                         size_t num_dsts);
+// Defined in fec_xor_avx2.cc, which is built with AVX2 enabled.
+size_t XorToMultipleAvx2(const uint8_t* src,
+                         size_t length,
+                         uint8_t* const* dsts,
+                         size_t num_dsts);
+#endif
+#if defined(WEBRTC_HAS_NEON)
+size_t XorToMultipleNeon(const uint8_t* src,
+                         size_t length,
+                         uint8_t* const* dsts,
+                         size_t num_dsts);
+#endif
+
+}  // namespace internal
+}  // namespace webrtc
+
+#endif  // MODULES_RTP_RTCP_SOURCE_FEC_XOR_H_
@@ -0,0 +1,35 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/rtp_rtcp/source/fec_xor.h"
+
+#include <immintrin.h>
+
+namespace webrtc {
+namespace internal {
+
+size_t XorToMultipleAvx2(const uint8_t* src,
+                         size_t length,
+                         uint8_t* const* dsts,
+                         size_t num_dsts) {
+  const size_t simd_length = length & ~static_cast<size_t>(31);
+  for (size_t i = 0; i < simd_length; i += 32) {
+    const __m256i s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    for (size_t k = 0; k < num_dsts; ++k) {
+      __m256i* d = reinterpret_cast<__m256i*>(dsts[k] + i);
+      _mm256_storeu_si256(d, _mm256_xor_si256(_mm256_loadu_si256(d), s));
+    }
+  }
+  return simd_length;
+}
+
+}  // namespace internal
+}  // namespace webrtc
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/rtp_rtcp/source/fec_xor.h"
+
+#include <vector>
+
+#include "rtc_base/random.h"
+#include "system_wrappers/include/cpu_features_wrapper.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace internal {
+namespace {
+
+constexpr size_t kMaxLength = 150;
+constexpr size_t kMaxDsts = 5;
+
+using XorFunction = void (*)(const uint8_t* src,
+                             size_t length,
+                             uint8_t* const* dsts,
+                             size_t num_dsts);
+
+// Checks |xor_function| against a byte-wise XOR, for all lengths up to
+// |kMaxLength| and unaligned source and destination buffers.
+void VerifyXorFunction(XorFunction xor_function) {
+  Random random(0x1234);
+  std::vector<uint8_t> src(kMaxLength + 1);
+  std::vector<std::vector<uint8_t>> dsts(kMaxDsts,
+                                         std::vector<uint8_t>(kMaxLength + 1));
+  for (size_t num_dsts = 1; num_dsts <= kMaxDsts; ++num_dsts) {
+    for (size_t length = 0; length <= kMaxLength; ++length) {
+      const size_t offset = length % 2;
+      for (uint8_t& byte : src)
+        byte = random.Rand<uint8_t>();
+      std::vector<std::vector<uint8_t>> expected;
+      std::vector<uint8_t*> dst_ptrs;
+      for (size_t k = 0; k < num_dsts; ++k) {
+        for (uint8_t& byte : dsts[k])
+          byte = random.Rand<uint8_t>();
+        expected.push_back(dsts[k]);
+        for (size_t i = 0; i < length; ++i)
+          expected[k][offset + i] ^= src[offset + i];
+        dst_ptrs.push_back(dsts[k].data() + offset);
+      }
+      xor_function(src.data() + offset, length, dst_ptrs.data(), num_dsts);
+      for (size_t k = 0; k < num_dsts; ++k) {
+        ASSERT_EQ(expected[k], dsts[k])
+            << "length " << length << ", num_dsts " << num_dsts;
+      }
+    }
+  }
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void XorToMultipleSse2AndC(const uint8_t* src,
+                           size_t length,
+                           uint8_t* const* dsts,
+                           size_t num_dsts) {
+  const size_t processed = XorToMultipleSse2(src, length, dsts, num_dsts);
+  std::vector<uint8_t*> tail_dsts;
+  for (size_t k = 0; k < num_dsts; ++k)
+    tail_dsts.push_back(dsts[k] + processed);
+  XorToMultipleC(src + processed, length - processed, tail_dsts.data(),
+                 num_dsts);
+}
+
+void XorToMultipleAvx2AndC(const uint8_t* src,
+                           size_t length,
+                           uint8_t* const* dsts,
+                           size_t num_dsts) {
+  const size_t processed = XorToMultipleAvx2(src, length, dsts, num_dsts);
+  std::vector<uint8_t*> tail_dsts;
+  for (size_t k = 0; k < num_dsts; ++k)
+    tail_dsts.push_back(dsts[k] + processed);
+  XorToMultipleC(src + processed, length - processed, tail_dsts.data(),
+                 num_dsts);
+}
+#endif
+
+}  // namespace
+
+TEST(FecXorTest, C) {
+  VerifyXorFunction(XorToMultipleC);
+}
+
+TEST(FecXorTest, RuntimeDispatch) {
+  VerifyXorFunction(XorToMultiple);
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+TEST(FecXorTest, Sse2) {
+  if (!WebRtc_GetCPUInfo(kSSE2))
+    return;
+  VerifyXorFunction(XorToMultipleSse2AndC);
+}
+
+TEST(FecXorTest, Avx2) {
+  if (!WebRtc_GetCPUInfo(kAVX2))
+    return;
+  VerifyXorFunction(XorToMultipleAvx2AndC);
+}
+#endif
+
+}  // namespace internal
+}  // namespace webrtc
@@ -18,6 +18,7 @@
 
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "modules/rtp_rtcp/source/byte_io.h"
+#include "modules/rtp_rtcp/source/fec_xor.h"
 #include "modules/rtp_rtcp/source/flexfec_header_reader_writer.h"
 #include "modules/rtp_rtcp/source/forward_error_correction_internal.h"
 #include "modules/rtp_rtcp/source/ulpfec_header_reader_writer.h"
@@ -200,60 +201,69 @@ void ForwardErrorCorrection::GenerateFecPayloads(
     const PacketList& media_packets,
     size_t num_fec_packets) {
   RTC_DCHECK(!media_packets.empty());
+  RTC_DCHECK_LE(num_fec_packets, kUlpfecMaxMediaPackets);
+  size_t fec_header_sizes[kUlpfecMaxMediaPackets];
   for (size_t i = 0; i < num_fec_packets; ++i) {
-    Packet* const fec_packet = &generated_fec_packets_[i];
-    size_t pkt_mask_idx = i * packet_mask_size_;
     const size_t min_packet_mask_size = fec_header_writer_->MinPacketMaskSize(
-        &packet_masks_[pkt_mask_idx], packet_mask_size_);
-    const size_t fec_header_size =
+        &packet_masks_[i * packet_mask_size_], packet_mask_size_);
+    fec_header_sizes[i] =
         fec_header_writer_->FecHeaderSize(min_packet_mask_size);
+  }
 
-    size_t media_pkt_idx = 0;
-    auto media_packets_it = media_packets.cbegin();
-    uint16_t prev_seq_num = ParseSequenceNumber((*media_packets_it)->data);
-    while (media_packets_it != media_packets.end()) {
-      Packet* const media_packet = media_packets_it->get();
+  // Each media packet is XORed into all FEC packets protecting it at once,
+  // so that its payload is only traversed a single time.
+  uint8_t* fec_payloads[kUlpfecMaxMediaPackets];
+  const uint16_t first_seq_num =
+      ParseSequenceNumber(media_packets.front()->data);
+  for (const auto& media_packet_ptr : media_packets) {
+    Packet* const media_packet = media_packet_ptr.get();
+    // Column of |media_packet| in the packet masks. Sequence number gaps have
+    // been accounted for by InsertZerosInPacketMasks().
+    const size_t media_pkt_idx = static_cast<uint16_t>(
+        ParseSequenceNumber(media_packet->data) - first_seq_num);
+    const size_t mask_byte_idx = media_pkt_idx / 8;
+    const uint8_t mask_bit = 1 << (7 - media_pkt_idx % 8);
+    const size_t media_payload_length = media_packet->length - kRtpHeaderSize;
+
+    size_t num_fec_payloads = 0;
+    for (size_t i = 0; i < num_fec_packets; ++i) {
       // Should |media_packet| be protected by |fec_packet|?
-      if (packet_masks_[pkt_mask_idx] & (1 << (7 - media_pkt_idx))) {
-        size_t media_payload_length = media_packet->length - kRtpHeaderSize;
-
-        bool first_protected_packet = (fec_packet->length == 0);
-        size_t fec_packet_length = fec_header_size + media_payload_length;
-        if (fec_packet_length > fec_packet->length) {
-          // Recall that XORing with zero (which the FEC packets are prefilled
-          // with) is the identity operator, thus all prior XORs are
-          // still correct even though we expand the packet length here.
-          fec_packet->length = fec_packet_length;
-        }
-        if (first_protected_packet) {
-          // Write P, X, CC, M, and PT recovery fields.
-          // Note that bits 0, 1, and 16 are overwritten in FinalizeFecHeaders.
-          memcpy(&fec_packet->data[0], &media_packet->data[0], 2);
-          // Write length recovery field. (This is a temporary location for
-          // ULPFEC.)
-          ByteWriter<uint16_t>::WriteBigEndian(&fec_packet->data[2],
-                                               media_payload_length);
-          // Write timestamp recovery field.
-          memcpy(&fec_packet->data[4], &media_packet->data[4], 4);
-          // Write payload.
-          memcpy(&fec_packet->data[fec_header_size],
-                 &media_packet->data[kRtpHeaderSize], media_payload_length);
-        } else {
-          XorHeaders(*media_packet, fec_packet);
-          XorPayloads(*media_packet, media_payload_length, fec_header_size,
-                      fec_packet);
-        }
+      if (!(packet_masks_[i * packet_mask_size_ + mask_byte_idx] & mask_bit))
+        continue;
+      Packet* const fec_packet = &generated_fec_packets_[i];
+      const size_t fec_header_size = fec_header_sizes[i];
+      bool first_protected_packet = (fec_packet->length == 0);
+      size_t fec_packet_length = fec_header_size + media_payload_length;
+      if (fec_packet_length > fec_packet->length) {
+        // Recall that XORing with zero (which the FEC packets are prefilled
+        // with) is the identity operator, thus all prior XORs are
+        // still correct even though we expand the packet length here.
+        fec_packet->length = fec_packet_length;
       }
-      media_packets_it++;
-      if (media_packets_it != media_packets.end()) {
-        uint16_t seq_num = ParseSequenceNumber((*media_packets_it)->data);
-        media_pkt_idx += static_cast<uint16_t>(seq_num - prev_seq_num);
-        prev_seq_num = seq_num;
+      if (first_protected_packet) {
+        // Write P, X, CC, M, and PT recovery fields.
+        // Note that bits 0, 1, and 16 are overwritten in FinalizeFecHeaders.
+        memcpy(&fec_packet->data[0], &media_packet->data[0], 2);
+        // Write length recovery field. (This is a temporary location for
+        // ULPFEC.)
+        ByteWriter<uint16_t>::WriteBigEndian(&fec_packet->data[2],
+                                             media_payload_length);
+        // Write timestamp recovery field.
+        memcpy(&fec_packet->data[4], &media_packet->data[4], 4);
+        // Write payload.
+        memcpy(&fec_packet->data[fec_header_size],
+               &media_packet->data[kRtpHeaderSize], media_payload_length);
+      } else {
+        XorHeaders(*media_packet, fec_packet);
+        fec_payloads[num_fec_payloads++] = &fec_packet->data[fec_header_size];
       }
-      pkt_mask_idx += media_pkt_idx / 8;
-      media_pkt_idx %= 8;
     }
-    RTC_DCHECK_GT(fec_packet->length, 0)
+    internal::XorToMultiple(&media_packet->data[kRtpHeaderSize],
+                            media_payload_length, fec_payloads,
+                            num_fec_payloads);
+  }
+  for (size_t i = 0; i < num_fec_packets; ++i) {
+    RTC_DCHECK_GT(generated_fec_packets_[i].length, 0)
         << "Packet mask is wrong or poorly designed.";
   }
 }
@@ -611,9 +621,9 @@ void ForwardErrorCorrection::XorPayloads(const Packet& src,
   // XOR the payload.
   RTC_DCHECK_LE(kRtpHeaderSize + payload_length, sizeof(src.data));
   RTC_DCHECK_LE(dst_offset + payload_length, sizeof(dst->data));
-  for (size_t i = 0; i < payload_length; ++i) {
-    dst->data[dst_offset + i] ^= src.data[kRtpHeaderSize + i];
-  }
+  uint8_t* dst_payload = &dst->data[dst_offset];
+  internal::XorToMultiple(&src.data[kRtpHeaderSize], payload_length,
+                          &dst_payload, 1);
 }
 
 bool ForwardErrorCorrection::RecoverPacket(const ReceivedFecPacket& fec_packet,
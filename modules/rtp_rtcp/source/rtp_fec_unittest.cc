@@ -18,7 +18,9 @@
 #include "modules/rtp_rtcp/source/forward_error_correction.h"
 #include "modules/rtp_rtcp/source/ulpfec_header_reader_writer.h"
 #include "rtc_base/basictypes.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gtest.h"
 
 namespace webrtc {
@@ -1160,4 +1162,63 @@ TYPED_TEST(RtpFecTest, FecRecoveryNonConsecutivePacketsWrap) {
   EXPECT_FALSE(this->IsRecoveryComplete());
 }
 
+// Measures FEC encode and decode throughput, in MB/s of media payload, for
+// the random and bursty mask tables at low and full protection.
+// Disabled because it only logs timings.
+TYPED_TEST(RtpFecTest, DISABLED_EncodeDecodeThroughput) {
+  constexpr int kNumImportantPackets = 0;
+  constexpr bool kUseUnequalProtection = false;
+  constexpr int kNumMediaPackets = 24;
+  constexpr int kNumIterations = 200;
+
+  this->media_packets_ =
+      this->media_packet_generator_.ConstructMediaPackets(kNumMediaPackets);
+  size_t media_payload_bytes = 0;
+  for (const auto& media_packet : this->media_packets_)
+    media_payload_bytes += media_packet->length - kRtpHeaderSize;
+
+  for (FecMaskType mask_type : {kFecMaskRandom, kFecMaskBursty}) {
+    for (uint8_t protection_factor : {64, 255}) {
+      int64_t start_us = rtc::TimeMicros();
+      for (int i = 0; i < kNumIterations; ++i) {
+        this->generated_fec_packets_.clear();
+        ASSERT_EQ(0, this->fec_.EncodeFec(
+                         this->media_packets_, protection_factor,
+                         kNumImportantPackets, kUseUnequalProtection,
+                         mask_type, &this->generated_fec_packets_));
+      }
+      const int64_t encode_us = std::max<int64_t>(
+          rtc::TimeMicros() - start_us, 1);
+
+      // Lose the first media packet, which all masks protect. The received
+      // packets are modified by decoding, so they are recreated (untimed)
+      // for every iteration.
+      memset(this->media_loss_mask_, 0, sizeof(this->media_loss_mask_));
+      memset(this->fec_loss_mask_, 0, sizeof(this->fec_loss_mask_));
+      this->media_loss_mask_[0] = 1;
+      int64_t decode_us = 1;
+      for (int i = 0; i < kNumIterations; ++i) {
+        this->fec_.ResetState(&this->recovered_packets_);
+        this->NetworkReceivedPackets(this->media_loss_mask_,
+                                     this->fec_loss_mask_);
+        start_us = rtc::TimeMicros();
+        for (const auto& received_packet : this->received_packets_)
+          this->fec_.DecodeFec(*received_packet, &this->recovered_packets_);
+        decode_us += rtc::TimeMicros() - start_us;
+      }
+      EXPECT_TRUE(this->IsRecoveryComplete());
+
+      // Bytes per microsecond is the same as MB/s.
+      const size_t total_bytes = media_payload_bytes * kNumIterations;
+      RTC_LOG(LS_INFO) << (mask_type == kFecMaskRandom ? "Random" : "Bursty")
+                       << " mask, protection factor "
+                       << static_cast<int>(protection_factor) << ", "
+                       << this->generated_fec_packets_.size()
+                       << " FEC packets: encode "
+                       << total_bytes / encode_us << " MB/s, decode "
+                       << total_bytes / decode_us << " MB/s.";
+    }
+  }
+}
+
 }  // namespace webrtc
@@ -14,6 +14,7 @@
 #include <limits>
 #include <utility>
 
+#include "modules/include/module_common_types_public.h"
 #include "modules/rtp_rtcp/source/rtp_packet_to_send.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
@@ -25,6 +26,15 @@ namespace {
 // Min packet size for BestFittingPacket() to honor.
 constexpr size_t kMinPacketRequestBytes = 50;
 
+// Number of slots in the packet ring. A power of two, so that a sequence
+// number maps to its slot with a mask, and enough to hold kMaxCapacity
+// consecutive packets.
+constexpr size_t kRingSize = 1 << 14;
+static_assert(kRingSize >= RtpPacketHistory::kMaxCapacity,
+              "The packet ring must hold kMaxCapacity packets.");
+static_assert((kRingSize & (kRingSize - 1)) == 0,
+              "The packet ring size must be a power of two.");
+
 // Utility function to get the absolute difference in size between the provided
 // target size and the size of packet.
 size_t SizeDiff(const std::unique_ptr<RtpPacketToSend>& packet, size_t size) {
@@ -55,7 +65,10 @@ RtpPacketHistory::RtpPacketHistory(Clock* clock)
     : clock_(clock),
       number_to_store_(0),
       mode_(StorageMode::kDisabled),
-      rtt_ms_(-1) {}
+      rtt_ms_(-1),
+      num_stored_packets_(0),
+      start_seqno_(0),
+      end_seqno_(0) {}
 
 RtpPacketHistory::~RtpPacketHistory() {}
 
@@ -69,6 +82,12 @@ void RtpPacketHistory::SetStorePacketsStatus(StorageMode mode,
   Reset();
   mode_ = mode;
   number_to_store_ = std::min(kMaxCapacity, number_to_store);
+  // The ring is allocated once, so that storing packets never allocates.
+  if (mode_ == StorageMode::kDisabled) {
+    std::vector<StoredPacket>().swap(packet_history_);
+  } else if (packet_history_.empty()) {
+    packet_history_.resize(kRingSize);
+  }
 }
 
 RtpPacketHistory::StorageMode RtpPacketHistory::GetStorageMode() const {
@@ -94,10 +113,35 @@ void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
 
   CullOldPackets(now_ms);
 
-  // Store packet.
+  // Store packet. The packets from |start_seqno_| to |end_seqno_| must map to
+  // distinct slots, so the oldest packets are evicted when a new packet is too
+  // far ahead of them, even if they haven't been sent.
   const uint16_t rtp_seq_no = packet->SequenceNumber();
-  StoredPacket& stored_packet = packet_history_[rtp_seq_no];
+  if (num_stored_packets_ > 0 &&
+      IsNewerSequenceNumber(rtp_seq_no, end_seqno_)) {
+    while (num_stored_packets_ > 0 &&
+           static_cast<uint16_t>(rtp_seq_no - start_seqno_) >= kRingSize) {
+      RemovePacket(start_seqno_);
+    }
+  }
+  if (num_stored_packets_ == 0) {
+    start_seqno_ = rtp_seq_no;
+    end_seqno_ = rtp_seq_no;
+  } else if (IsNewerSequenceNumber(rtp_seq_no, end_seqno_)) {
+    end_seqno_ = rtp_seq_no;
+  } else if (IsNewerSequenceNumber(start_seqno_, rtp_seq_no)) {
+    if (static_cast<uint16_t>(end_seqno_ - rtp_seq_no) >= kRingSize) {
+      RTC_LOG(LS_WARNING) << "Not storing packet " << rtp_seq_no
+                          << ", which is too old.";
+      return;
+    }
+    start_seqno_ = rtp_seq_no;
+  }
+
+  StoredPacket& stored_packet = packet_history_[rtp_seq_no & (kRingSize - 1)];
   RTC_DCHECK(stored_packet.packet == nullptr);
+  if (!stored_packet.packet)
+    ++num_stored_packets_;
   stored_packet.packet = std::move(packet);
 
   if (stored_packet.packet->capture_time_ms() <= 0) {
@@ -106,10 +150,6 @@ void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
   stored_packet.send_time_ms = send_time_ms;
   stored_packet.storage_type = type;
   stored_packet.times_retransmitted = 0;
-
-  if (!start_seqno_) {
-    start_seqno_ = rtp_seq_no;
-  }
 }
 
 std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetPacketAndSetSendTime(
@@ -119,31 +159,54 @@ std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetPacketAndSetSendTime(
   if (mode_ == StorageMode::kDisabled) {
     return nullptr;
   }
+  return GetPacketAndSetSendTimeLocked(sequence_number, verify_rtt,
+                                       clock_->TimeInMilliseconds());
+}
 
-  int64_t now_ms = clock_->TimeInMilliseconds();
-  StoredPacketIterator rtp_it = packet_history_.find(sequence_number);
-  if (rtp_it == packet_history_.end()) {
+std::vector<std::unique_ptr<RtpPacketToSend>>
+RtpPacketHistory::GetPacketsAndSetSendTime(
+    rtc::ArrayView<const uint16_t> sequence_numbers,
+    bool verify_rtt) {
+  std::vector<std::unique_ptr<RtpPacketToSend>> packets(
+      sequence_numbers.size());
+  rtc::CritScope cs(&lock_);
+  if (mode_ == StorageMode::kDisabled) {
+    return packets;
+  }
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  for (size_t i = 0; i < sequence_numbers.size(); ++i) {
+    packets[i] =
+        GetPacketAndSetSendTimeLocked(sequence_numbers[i], verify_rtt, now_ms);
+  }
+  return packets;
+}
+
+std::unique_ptr<RtpPacketToSend>
+RtpPacketHistory::GetPacketAndSetSendTimeLocked(uint16_t sequence_number,
+                                                bool verify_rtt,
+                                                int64_t now_ms) {
+  StoredPacket* packet = FindPacket(sequence_number);
+  if (!packet) {
     return nullptr;
   }
 
-  StoredPacket& packet = rtp_it->second;
-  if (verify_rtt && !VerifyRtt(rtp_it->second, now_ms)) {
+  if (verify_rtt && !VerifyRtt(*packet, now_ms)) {
     return nullptr;
   }
 
-  if (packet.send_time_ms) {
-    ++packet.times_retransmitted;
+  if (packet->send_time_ms) {
+    ++packet->times_retransmitted;
   }
 
   // Update send-time and return copy of packet instance.
-  packet.send_time_ms = now_ms;
+  packet->send_time_ms = now_ms;
 
-  if (packet.storage_type == StorageType::kDontRetransmit) {
+  if (packet->storage_type == StorageType::kDontRetransmit) {
     // Non retransmittable packet, so call must come from paced sender.
     // Remove from history and return actual packet instance.
-    return RemovePacket(rtp_it);
+    return RemovePacket(sequence_number);
   }
-  return rtc::MakeUnique<RtpPacketToSend>(*packet.packet);
+  return rtc::MakeUnique<RtpPacketToSend>(*packet->packet);
 }
 
 rtc::Optional<RtpPacketHistory::PacketState> RtpPacketHistory::GetPacketState(
@@ -154,16 +217,16 @@ rtc::Optional<RtpPacketHistory::PacketState> RtpPacketHistory::GetPacketState(
     return rtc::nullopt;
   }
 
-  auto rtp_it = packet_history_.find(sequence_number);
-  if (rtp_it == packet_history_.end()) {
+  const StoredPacket* packet = FindPacket(sequence_number);
+  if (!packet) {
     return rtc::nullopt;
   }
 
-  if (verify_rtt && !VerifyRtt(rtp_it->second, clock_->TimeInMilliseconds())) {
+  if (verify_rtt && !VerifyRtt(*packet, clock_->TimeInMilliseconds())) {
     return rtc::nullopt;
   }
 
-  return StoredPacketToPacketState(rtp_it->second);
+  return StoredPacketToPacketState(*packet);
 }
 
 bool RtpPacketHistory::VerifyRtt(const RtpPacketHistory::StoredPacket& packet,
@@ -186,64 +249,72 @@ std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetBestFittingPacket(
     size_t packet_length) const {
   // TODO(sprang): Make this smarter, taking retransmit count etc into account.
   rtc::CritScope cs(&lock_);
-  if (packet_length < kMinPacketRequestBytes || packet_history_.empty()) {
+  if (packet_length < kMinPacketRequestBytes || num_stored_packets_ == 0) {
     return nullptr;
   }
 
   size_t min_diff = std::numeric_limits<size_t>::max();
   RtpPacketToSend* best_packet = nullptr;
-  for (auto& it : packet_history_) {
-    size_t diff = SizeDiff(it.second.packet, packet_length);
-    if (!min_diff || diff < min_diff) {
-      min_diff = diff;
-      best_packet = it.second.packet.get();
-      if (diff == 0) {
-        break;
+  for (uint16_t seq_no = start_seqno_;; ++seq_no) {
+    const StoredPacket& stored_packet =
+        packet_history_[seq_no & (kRingSize - 1)];
+    if (stored_packet.packet) {
+      size_t diff = SizeDiff(stored_packet.packet, packet_length);
+      if (!min_diff || diff < min_diff) {
+        min_diff = diff;
+        best_packet = stored_packet.packet.get();
+        if (diff == 0) {
+          break;
+        }
       }
     }
+    if (seq_no == end_seqno_) {
+      break;
+    }
   }
 
   return rtc::MakeUnique<RtpPacketToSend>(*best_packet);
 }
 
 void RtpPacketHistory::Reset() {
-  packet_history_.clear();
-  start_seqno_.reset();
+  for (StoredPacket& stored_packet : packet_history_) {
+    stored_packet = StoredPacket();
+  }
+  num_stored_packets_ = 0;
 }
 
 void RtpPacketHistory::CullOldPackets(int64_t now_ms) {
   int64_t packet_duration_ms =
       std::max(kMinPacketDurationRtt * rtt_ms_, kMinPacketDurationMs);
-  while (!packet_history_.empty()) {
-    auto stored_packet_it = packet_history_.find(*start_seqno_);
-    RTC_DCHECK(stored_packet_it != packet_history_.end());
+  while (num_stored_packets_ > 0) {
+    const StoredPacket* stored_packet = FindPacket(start_seqno_);
+    RTC_DCHECK(stored_packet);
 
-    if (packet_history_.size() >= kMaxCapacity) {
+    if (num_stored_packets_ >= kMaxCapacity) {
       // We have reached the absolute max capacity, remove one packet
       // unconditionally.
-      RemovePacket(stored_packet_it);
+      RemovePacket(start_seqno_);
       continue;
     }
 
-    const StoredPacket& stored_packet = stored_packet_it->second;
-    if (!stored_packet.send_time_ms) {
+    if (!stored_packet->send_time_ms) {
       // Don't remove packets that have not been sent.
       return;
     }
 
-    if (*stored_packet.send_time_ms + packet_duration_ms > now_ms) {
+    if (*stored_packet->send_time_ms + packet_duration_ms > now_ms) {
       // Don't cull packets too early to avoid failed retransmission requests.
       return;
     }
 
-    if (packet_history_.size() >= number_to_store_ ||
+    if (num_stored_packets_ >= number_to_store_ ||
         (mode_ == StorageMode::kStoreAndCull &&
-         *stored_packet.send_time_ms +
+         *stored_packet->send_time_ms +
                  (packet_duration_ms * kPacketCullingDelayFactor) <=
              now_ms)) {
       // Too many packets in history, or this packet has timed out. Remove it
       // and continue.
-      RemovePacket(stored_packet_it);
+      RemovePacket(start_seqno_);
     } else {
       // No more packets can be removed right now.
       return;
@@ -251,25 +322,55 @@ void RtpPacketHistory::CullOldPackets(int64_t now_ms) {
   }
 }
 
+RtpPacketHistory::StoredPacket* RtpPacketHistory::FindPacket(
+    uint16_t sequence_number) {
+  if (num_stored_packets_ == 0) {
+    return nullptr;
+  }
+  StoredPacket& stored_packet =
+      packet_history_[sequence_number & (kRingSize - 1)];
+  if (!stored_packet.packet ||
+      stored_packet.packet->SequenceNumber() != sequence_number) {
+    return nullptr;
+  }
+  return &stored_packet;
+}
+
+const RtpPacketHistory::StoredPacket* RtpPacketHistory::FindPacket(
+    uint16_t sequence_number) const {
+  if (num_stored_packets_ == 0) {
+    return nullptr;
+  }
+  const StoredPacket& stored_packet =
+      packet_history_[sequence_number & (kRingSize - 1)];
+  if (!stored_packet.packet ||
+      stored_packet.packet->SequenceNumber() != sequence_number) {
+    return nullptr;
+  }
+  return &stored_packet;
+}
+
 std::unique_ptr<RtpPacketToSend> RtpPacketHistory::RemovePacket(
-    StoredPacketIterator packet_it) {
+    uint16_t sequence_number) {
+  const size_t mask = kRingSize - 1;
+  StoredPacket& stored_packet = packet_history_[sequence_number & mask];
   // Move the packet out from the StoredPacket container.
-  std::unique_ptr<RtpPacketToSend> rtp_packet =
-      std::move(packet_it->second.packet);
-  // Erase the packet from the map, and capture iterator to the next one.
-  StoredPacketIterator next_it = packet_history_.erase(packet_it);
-
-  // |next_it| now points to the next element, or to the end. If the end,
-  // check if we can wrap around.
-  if (next_it == packet_history_.end()) {
-    next_it = packet_history_.begin();
+  std::unique_ptr<RtpPacketToSend> rtp_packet = std::move(stored_packet.packet);
+  stored_packet = StoredPacket();
+  if (--num_stored_packets_ == 0) {
+    return rtp_packet;
   }
 
-  // Update |start_seq_no| to the new oldest item.
-  if (next_it != packet_history_.end()) {
-    start_seqno_ = next_it->first;
-  } else {
-    start_seqno_.reset();
+  // Update |start_seqno_| and |end_seqno_| to the oldest and newest
+  // remaining items.
+  if (sequence_number == start_seqno_) {
+    do {
+      ++start_seqno_;
+    } while (!packet_history_[start_seqno_ & mask].packet);
+  } else if (sequence_number == end_seqno_) {
+    do {
+      --end_seqno_;
+    } while (!packet_history_[end_seqno_ & mask].packet);
   }
 
   return rtp_packet;
@@ -11,10 +11,10 @@
 #ifndef MODULES_RTP_RTCP_SOURCE_RTP_PACKET_HISTORY_H_
 #define MODULES_RTP_RTCP_SOURCE_RTP_PACKET_HISTORY_H_
 
-#include <map>
 #include <memory>
 #include <vector>
 
+#include "api/array_view.h"
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "rtc_base/constructormagic.h"
 #include "rtc_base/criticalsection.h"
@@ -83,6 +83,13 @@ class RtpPacketHistory {
       uint16_t sequence_number,
       bool verify_rtt);
 
+  // Batched version of GetPacketAndSetSendTime(), e.g. for a NACK listing
+  // several sequence numbers. Returns one entry per sequence number, in the
+  // same order, which is nullptr if the packet isn't returned.
+  std::vector<std::unique_ptr<RtpPacketToSend>> GetPacketsAndSetSendTime(
+      rtc::ArrayView<const uint16_t> sequence_numbers,
+      bool verify_rtt);
+
   // Similar to GetPacketAndSetSendTime(), but only returns a snapshot of the
   // current state for packet, and never updates internal state.
   rtc::Optional<PacketState> GetPacketState(uint16_t sequence_number,
@@ -114,17 +121,24 @@ class RtpPacketHistory {
     std::unique_ptr<RtpPacketToSend> packet;
   };
 
-  using StoredPacketIterator = std::map<uint16_t, StoredPacket>::iterator;
-
   // Helper method used by GetPacketAndSetSendTime() and GetPacketState() to
   // check if packet has too recently been sent.
   bool VerifyRtt(const StoredPacket& packet, int64_t now_ms) const
       RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  std::unique_ptr<RtpPacketToSend> GetPacketAndSetSendTimeLocked(
+      uint16_t sequence_number,
+      bool verify_rtt,
+      int64_t now_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void Reset() RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void CullOldPackets(int64_t now_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the slot holding |sequence_number|, or nullptr if not stored.
+  StoredPacket* FindPacket(uint16_t sequence_number)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  const StoredPacket* FindPacket(uint16_t sequence_number) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   // Removes the packet from the history, and context/mapping that has been
   // stored. Returns the RTP packet instance contained within the StoredPacket.
-  std::unique_ptr<RtpPacketToSend> RemovePacket(StoredPacketIterator packet)
+  std::unique_ptr<RtpPacketToSend> RemovePacket(uint16_t sequence_number)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   static PacketState StoredPacketToPacketState(
       const StoredPacket& stored_packet);
@@ -135,12 +149,18 @@ class RtpPacketHistory {
   StorageMode mode_ RTC_GUARDED_BY(lock_);
   int64_t rtt_ms_ RTC_GUARDED_BY(lock_);
 
-  // Map from rtp sequence numbers to stored packet.
-  std::map<uint16_t, StoredPacket> packet_history_ RTC_GUARDED_BY(lock_);
-
-  // The earliest packet in the history. This might not be the lowest sequence
-  // number, in case there is a wraparound.
-  rtc::Optional<uint16_t> start_seqno_ RTC_GUARDED_BY(lock_);
+  // Ring of stored packets, indexed by rtp sequence number modulo its fixed
+  // size, which is allocated while storage is enabled. The span between the
+  // oldest and newest stored sequence numbers is kept within the size, so
+  // slots never collide and walking from |start_seqno_| to |end_seqno_|
+  // visits the packets in sequence order.
+  std::vector<StoredPacket> packet_history_ RTC_GUARDED_BY(lock_);
+  size_t num_stored_packets_ RTC_GUARDED_BY(lock_);
+
+  // The oldest and newest packets in the history. Only valid if
+  // |num_stored_packets_| > 0. Both slots are always occupied.
+  uint16_t start_seqno_ RTC_GUARDED_BY(lock_);
+  uint16_t end_seqno_ RTC_GUARDED_BY(lock_);
 
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(RtpPacketHistory);
 };
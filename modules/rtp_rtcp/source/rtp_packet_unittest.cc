@@ -9,10 +9,13 @@
  */
 #include "modules/rtp_rtcp/source/rtp_packet_received.h"
 #include "modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "modules/rtp_rtcp/source/rtp_packet_view.h"
 
 #include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
 #include "modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
 
@@ -563,4 +566,181 @@ TEST(RtpPacketTest, ParseLegacyTimingFrameExtension) {
   EXPECT_EQ(receivied_timing.flags, 0);
 }
 
+TEST(RtpPacketViewTest, ParseMinimum) {
+  RtpPacketView packet(kMinimumPacket);
+  ASSERT_TRUE(packet.IsValid());
+  EXPECT_FALSE(packet.Marker());
+  EXPECT_EQ(kPayloadType, packet.PayloadType());
+  EXPECT_EQ(kSeqNum, packet.SequenceNumber());
+  EXPECT_EQ(kTimestamp, packet.Timestamp());
+  EXPECT_EQ(kSsrc, packet.Ssrc());
+  EXPECT_EQ(0u, packet.NumCsrcs());
+  EXPECT_TRUE(packet.GetRawExtension(kTransmissionOffsetExtensionId).empty());
+}
+
+TEST(RtpPacketViewTest, RejectsInvalidHeaders) {
+  EXPECT_FALSE(RtpPacketView(rtc::MakeArrayView(kMinimumPacket,
+                                                sizeof(kMinimumPacket) - 1))
+                   .IsValid());
+  // Csrc count larger than the packet.
+  EXPECT_FALSE(RtpPacketView(rtc::MakeArrayView(kPacket, 16)).IsValid());
+
+  uint8_t bad_version[sizeof(kMinimumPacket)];
+  memcpy(bad_version, kMinimumPacket, sizeof(kMinimumPacket));
+  bad_version[0] = 0x40;
+  EXPECT_FALSE(RtpPacketView(bad_version).IsValid());
+}
+
+TEST(RtpPacketViewTest, ParseWithAllFeatures) {
+  RtpHeaderExtensionMap extensions;
+  extensions.Register<TransmissionOffset>(kTransmissionOffsetExtensionId);
+  RtpPacketView packet(kPacket, &extensions);
+  ASSERT_TRUE(packet.IsValid());
+  EXPECT_EQ(kSsrc, packet.Ssrc());
+  ASSERT_EQ(2u, packet.NumCsrcs());
+  EXPECT_EQ(kCsrcs[0], packet.Csrc(0));
+  EXPECT_EQ(kCsrcs[1], packet.Csrc(1));
+  int32_t time_offset;
+  EXPECT_TRUE(packet.GetExtension<TransmissionOffset>(&time_offset));
+  EXPECT_EQ(kTimeOffset, time_offset);
+}
+
+TEST(RtpPacketViewTest, ParseWith2Extensions) {
+  RtpHeaderExtensionMap extensions;
+  extensions.Register<TransmissionOffset>(kTransmissionOffsetExtensionId);
+  extensions.Register<AudioLevel>(kAudioLevelExtensionId);
+  RtpPacketView packet(kPacketWithTOAndAL, &extensions);
+  ASSERT_TRUE(packet.IsValid());
+  int32_t time_offset;
+  EXPECT_TRUE(packet.GetExtension<TransmissionOffset>(&time_offset));
+  EXPECT_EQ(kTimeOffset, time_offset);
+  bool voice_active;
+  uint8_t audio_level;
+  EXPECT_TRUE(packet.GetExtension<AudioLevel>(&voice_active, &audio_level));
+  EXPECT_EQ(kVoiceActive, voice_active);
+  EXPECT_EQ(kAudioLevel, audio_level);
+  EXPECT_FALSE(packet.HasExtension<TransportSequenceNumber>());
+}
+
+TEST(RtpPacketViewTest, ParseWithoutExtensionManager) {
+  RtpPacketView packet(kPacketWithTO);
+  ASSERT_TRUE(packet.IsValid());
+  EXPECT_FALSE(packet.HasExtension<TransmissionOffset>());
+  EXPECT_EQ(3u, packet.GetRawExtension(kTransmissionOffsetExtensionId).size());
+  EXPECT_TRUE(packet.GetRawExtension(kAudioLevelExtensionId).empty());
+  EXPECT_TRUE(packet.GetRawExtension(0).empty());
+}
+
+TEST(RtpPacketViewTest, ParseWithInvalidSizedExtension) {
+  RtpHeaderExtensionMap extensions;
+  extensions.Register<TransmissionOffset>(kTransmissionOffsetExtensionId);
+  RtpPacketView packet(kPacketWithInvalidExtension, &extensions);
+  ASSERT_TRUE(packet.IsValid());
+  // The extension is there, but can't be parsed as a transmission offset.
+  EXPECT_TRUE(packet.HasExtension<TransmissionOffset>());
+  int32_t time_offset;
+  EXPECT_FALSE(packet.GetExtension<TransmissionOffset>(&time_offset));
+}
+
+TEST(RtpPacketViewTest, IgnoresTruncatedExtensionBlock) {
+  // The extension header says there is one word of extensions, but the packet
+  // ends right after the header.
+  RtpPacketView packet(rtc::MakeArrayView(kPacketWithTO, 16));
+  ASSERT_TRUE(packet.IsValid());
+  EXPECT_EQ(kSsrc, packet.Ssrc());
+  EXPECT_TRUE(packet.GetRawExtension(kTransmissionOffsetExtensionId).empty());
+}
+
+TEST(RtpPacketViewTest, MatchesRtpPacket) {
+  RtpPacketToSend::ExtensionManager extensions;
+  extensions.Register<TransportSequenceNumber>(1);
+  extensions.Register<AbsoluteSendTime>(2);
+  extensions.Register<RtpMid>(3);
+  extensions.Register<AudioLevel>(4);
+  RtpPacketToSend send_packet(&extensions);
+  send_packet.SetMarker(true);
+  send_packet.SetPayloadType(kPayloadType);
+  send_packet.SetSequenceNumber(kSeqNum);
+  send_packet.SetTimestamp(kTimestamp);
+  send_packet.SetSsrc(kSsrc);
+  send_packet.SetExtension<AudioLevel>(kVoiceActive, kAudioLevel);
+  send_packet.SetExtension<RtpMid>(kMid);
+  send_packet.SetExtension<AbsoluteSendTime>(0x123456);
+  send_packet.SetExtension<TransportSequenceNumber>(0x4321);
+  send_packet.SetPayloadSize(sizeof(kPayload));
+
+  RtpPacketReceived parsed(&extensions);
+  ASSERT_TRUE(parsed.Parse(send_packet.Buffer()));
+  RtpPacketView view(rtc::MakeArrayView(send_packet.data(), send_packet.size()),
+                     &extensions);
+  ASSERT_TRUE(view.IsValid());
+  EXPECT_EQ(parsed.Marker(), view.Marker());
+  EXPECT_EQ(parsed.PayloadType(), view.PayloadType());
+  EXPECT_EQ(parsed.SequenceNumber(), view.SequenceNumber());
+  EXPECT_EQ(parsed.Timestamp(), view.Timestamp());
+  EXPECT_EQ(parsed.Ssrc(), view.Ssrc());
+  for (int id = RtpPacket::kMinExtensionId; id <= RtpPacket::kMaxExtensionId;
+       ++id) {
+    EXPECT_THAT(view.GetRawExtension(id),
+                ElementsAreArray(parsed.GetRawExtension(id)));
+  }
+  uint16_t transport_sequence_number;
+  EXPECT_TRUE(
+      view.GetExtension<TransportSequenceNumber>(&transport_sequence_number));
+  EXPECT_EQ(0x4321, transport_sequence_number);
+  std::string mid;
+  EXPECT_TRUE(view.GetExtension<RtpMid>(&mid));
+  EXPECT_EQ(kMid, mid);
+}
+
+// Compares the cost of reading the ssrc, sequence number and transport
+// sequence number of a packet with a full parse and with a view.
+// Disabled because it only logs timings.
+TEST(RtpPacketViewTest, DISABLED_ForwardingThroughput) {
+  RtpPacketToSend::ExtensionManager extensions;
+  extensions.Register<TransmissionOffset>(1);
+  extensions.Register<AbsoluteSendTime>(2);
+  extensions.Register<AudioLevel>(3);
+  extensions.Register<VideoOrientation>(4);
+  extensions.Register<TransportSequenceNumber>(5);
+  RtpPacketToSend send_packet(&extensions);
+  send_packet.SetSsrc(kSsrc);
+  send_packet.SetSequenceNumber(kSeqNum);
+  send_packet.SetExtension<TransmissionOffset>(kTimeOffset);
+  send_packet.SetExtension<AbsoluteSendTime>(0x123456);
+  send_packet.SetExtension<AudioLevel>(kVoiceActive, kAudioLevel);
+  send_packet.SetExtension<VideoOrientation>(kVideoRotation_90);
+  send_packet.SetExtension<TransportSequenceNumber>(0x4321);
+  memset(send_packet.SetPayloadSize(1000), 0x5a, 1000);
+  const rtc::CopyOnWriteBuffer buffer = send_packet.Buffer();
+
+  const int kNumPackets = 1000000;
+  uint32_t checksum = 0;
+  int64_t start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumPackets; ++i) {
+    RtpPacketReceived packet(&extensions);
+    packet.Parse(buffer.cdata(), buffer.size());
+    uint16_t transport_sequence_number = 0;
+    packet.GetExtension<TransportSequenceNumber>(&transport_sequence_number);
+    checksum += packet.Ssrc() + packet.SequenceNumber() +
+                transport_sequence_number;
+  }
+  int64_t parse_us = rtc::TimeMicros() - start_us;
+
+  start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumPackets; ++i) {
+    RtpPacketView packet(rtc::MakeArrayView(buffer.cdata(), buffer.size()),
+                         &extensions);
+    uint16_t transport_sequence_number = 0;
+    packet.GetExtension<TransportSequenceNumber>(&transport_sequence_number);
+    checksum -= packet.Ssrc() + packet.SequenceNumber() +
+                transport_sequence_number;
+  }
+  int64_t view_us = rtc::TimeMicros() - start_us;
+  EXPECT_EQ(0u, checksum);
+  RTC_LOG(LS_INFO) << "Reading " << kNumPackets
+                   << " packets: RtpPacketReceived::Parse " << parse_us
+                   << " us, RtpPacketView " << view_us << " us.";
+}
+
 }  // namespace webrtc
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/rtp_rtcp/source/rtp_packet_view.h"
+
+#include "modules/rtp_rtcp/source/byte_io.h"
+#include "modules/rtp_rtcp/source/rtp_packet.h"
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+namespace {
+constexpr size_t kFixedHeaderSize = 12;
+constexpr uint8_t kRtpVersion = 2;
+constexpr uint16_t kOneByteExtensionId = 0xBEDE;
+constexpr size_t kOneByteHeaderSize = 1;
+
+bool IsValidRtpHeader(rtc::ArrayView<const uint8_t> packet) {
+  if (packet.size() < kFixedHeaderSize)
+    return false;
+  if ((packet[0] >> 6) != kRtpVersion)
+    return false;
+  const size_t num_csrcs = packet[0] & 0x0f;
+  return packet.size() >= kFixedHeaderSize + num_csrcs * 4;
+}
+}  // namespace
+
+RtpPacketView::RtpPacketView(rtc::ArrayView<const uint8_t> packet)
+    : RtpPacketView(packet, nullptr) {}
+
+RtpPacketView::RtpPacketView(rtc::ArrayView<const uint8_t> packet,
+                             const RtpHeaderExtensionMap* extensions)
+    : packet_(packet),
+      extensions_(extensions),
+      valid_(IsValidRtpHeader(packet)) {}
+
+bool RtpPacketView::Marker() const {
+  RTC_DCHECK(valid_);
+  return (packet_[1] & 0x80) != 0;
+}
+
+uint8_t RtpPacketView::PayloadType() const {
+  RTC_DCHECK(valid_);
+  return packet_[1] & 0x7f;
+}
+
+uint16_t RtpPacketView::SequenceNumber() const {
+  RTC_DCHECK(valid_);
+  return ByteReader<uint16_t>::ReadBigEndian(&packet_[2]);
+}
+
+uint32_t RtpPacketView::Timestamp() const {
+  RTC_DCHECK(valid_);
+  return ByteReader<uint32_t>::ReadBigEndian(&packet_[4]);
+}
+
+uint32_t RtpPacketView::Ssrc() const {
+  RTC_DCHECK(valid_);
+  return ByteReader<uint32_t>::ReadBigEndian(&packet_[8]);
+}
+
+size_t RtpPacketView::NumCsrcs() const {
+  RTC_DCHECK(valid_);
+  return packet_[0] & 0x0f;
+}
+
+uint32_t RtpPacketView::Csrc(size_t index) const {
+  RTC_DCHECK_LT(index, NumCsrcs());
+  return ByteReader<uint32_t>::ReadBigEndian(
+      &packet_[kFixedHeaderSize + index * 4]);
+}
+
+rtc::ArrayView<const uint8_t> RtpPacketView::GetRawExtension(int id) const {
+  RTC_DCHECK(valid_);
+  if (id == RtpHeaderExtensionMap::kInvalidId)
+    return nullptr;
+  RTC_DCHECK_GE(id, RtpPacket::kMinExtensionId);
+  RTC_DCHECK_LE(id, RtpPacket::kMaxExtensionId);
+
+  const bool has_extension = (packet_[0] & 0x10) != 0;
+  if (!has_extension)
+    return nullptr;
+  // See RtpPacket::ParseBuffer for the layout of the extension block; this
+  // applies the same validation, but only to the part of the block that is
+  // walked to find |id|.
+  const size_t profile_offset = kFixedHeaderSize + NumCsrcs() * 4;
+  const size_t extension_offset = profile_offset + 4;
+  if (extension_offset > packet_.size())
+    return nullptr;
+  if (ByteReader<uint16_t>::ReadBigEndian(&packet_[profile_offset]) !=
+      kOneByteExtensionId) {
+    return nullptr;
+  }
+  const size_t extensions_capacity =
+      4 * ByteReader<uint16_t>::ReadBigEndian(&packet_[profile_offset + 2]);
+  if (extension_offset + extensions_capacity > packet_.size())
+    return nullptr;
+
+  constexpr uint8_t kPaddingId = 0;
+  constexpr uint8_t kReservedId = 15;
+  const uint8_t* const extensions = &packet_[extension_offset];
+  rtc::ArrayView<const uint8_t> found;
+  size_t pos = 0;
+  while (pos + kOneByteHeaderSize < extensions_capacity) {
+    const int extension_id = extensions[pos] >> 4;
+    if (extension_id == kReservedId)
+      break;
+    if (extension_id == kPaddingId) {
+      ++pos;
+      continue;
+    }
+    const size_t length = 1 + (extensions[pos] & 0xf);
+    if (pos + kOneByteHeaderSize + length > extensions_capacity)
+      break;
+    if (extension_id == id)
+      found = rtc::MakeArrayView(extensions + pos + kOneByteHeaderSize, length);
+    pos += kOneByteHeaderSize + length;
+  }
+  return found;
+}
+
+rtc::ArrayView<const uint8_t> RtpPacketView::FindExtension(
+    RTPExtensionType type) const {
+  if (!extensions_)
+    return nullptr;
+  return GetRawExtension(extensions_->GetId(type));
+}
+
+}  // namespace webrtc
@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#ifndef MODULES_RTP_RTCP_SOURCE_RTP_PACKET_VIEW_H_
+#define MODULES_RTP_RTCP_SOURCE_RTP_PACKET_VIEW_H_
+
+#include "api/array_view.h"
+#include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "rtc_base/basictypes.h"
+
+namespace webrtc {
+
+// Read-only view of a serialized rtp packet, for paths that only need a few
+// fields of each packet, e.g. to route or forward it. Unlike RtpPacket, the
+// view doesn't copy the buffer and only validates the fixed header when it is
+// constructed. Header extensions are located in the buffer when asked for, so
+// reading the ssrc, sequence number and a single extension doesn't pay for
+// parsing all of them.
+class RtpPacketView {
+ public:
+  // |packet| must outlive the view. Typed extensions can only be read if
+  // |extensions| is provided, and are located by the id that |extensions| has
+  // for their type. |extensions| must outlive the view too.
+  explicit RtpPacketView(rtc::ArrayView<const uint8_t> packet);
+  RtpPacketView(rtc::ArrayView<const uint8_t> packet,
+                const RtpHeaderExtensionMap* extensions);
+
+  // False if the buffer is too short for the fixed header and csrc list, or
+  // isn't rtp version 2. Other accessors must not be used in that case.
+  bool IsValid() const { return valid_; }
+
+  // Header.
+  bool Marker() const;
+  uint8_t PayloadType() const;
+  uint16_t SequenceNumber() const;
+  uint32_t Timestamp() const;
+  uint32_t Ssrc() const;
+  size_t NumCsrcs() const;
+  uint32_t Csrc(size_t index) const;
+
+  // Header extensions.
+  template <typename Extension>
+  bool HasExtension() const;
+
+  template <typename Extension, typename... Values>
+  bool GetExtension(Values...) const;
+
+  // Returns the extension with |id| as negotiated with the remote peer, or an
+  // empty view if the packet doesn't have it, or if the extension block is
+  // malformed. If there are several extensions with the same id, the last one
+  // is returned, like RtpPacket does.
+  rtc::ArrayView<const uint8_t> GetRawExtension(int id) const;
+
+  rtc::ArrayView<const uint8_t> data() const { return packet_; }
+
+ private:
+  rtc::ArrayView<const uint8_t> FindExtension(RTPExtensionType type) const;
+
+  const rtc::ArrayView<const uint8_t> packet_;
+  const RtpHeaderExtensionMap* const extensions_;
+  const bool valid_;
+};
+
+template <typename Extension>
+bool RtpPacketView::HasExtension() const {
+  return !FindExtension(Extension::kId).empty();
+}
+
+template <typename Extension, typename... Values>
+bool RtpPacketView::GetExtension(Values... values) const {
+  auto raw = FindExtension(Extension::kId);
+  if (raw.empty())
+    return false;
+  return Extension::Parse(raw, values...);
+}
+
+}  // namespace webrtc
+
+#endif  // MODULES_RTP_RTCP_SOURCE_RTP_PACKET_VIEW_H_
@@ -392,6 +392,31 @@ TEST_F(VideoProcessorIntegrationTestLibvpx, MAYBE_SvcVP9) {
                               &quality_thresholds, nullptr, nullptr);
 }
 
+// Compares the decode speed of the spatial layers with one and with all cores.
+TEST_F(VideoProcessorIntegrationTestLibvpx, DISABLED_SvcVP9DecodeSpeed) {
+  config_.filename = "ConferenceMotion_1280_720_50";
+  config_.filepath = ResourcePath(config_.filename, "yuv");
+  config_.num_frames = 100;
+  config_.SetCodecSettings(cricket::kVp9CodecName, 1, 3, 3, true, true, false,
+                           kResilienceOn, 1280, 720);
+
+  std::vector<RateProfile> rate_profiles = {{1500, 30, config_.num_frames}};
+
+  printf("--> Summary\n");
+  printf("%9s %5s %6s %13s\n", "num_cores", "width", "height",
+         "dec_speed_fps");
+  for (bool use_single_core : {true, false}) {
+    config_.use_single_core = use_single_core;
+    ProcessFramesAndMaybeVerify(rate_profiles, nullptr, nullptr, nullptr,
+                                nullptr);
+    for (const auto& layer_stat : stats_.SliceAndCalcLayerVideoStatistic(
+             0, config_.num_frames - 1)) {
+      printf("%9zu %5zu %6zu %13.2f\n", config_.NumberOfCores(),
+             layer_stat.width, layer_stat.height, layer_stat.dec_speed_fps);
+    }
+  }
+}
+
 TEST_F(VideoProcessorIntegrationTestLibvpx, DISABLED_MultiresVP8RdPerf) {
   config_.filename = "FourPeople_1280x720_30";
   config_.filepath = ResourcePath(config_.filename, "yuv");
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <algorithm>
 #include <vector>
 
 #include "vpx/vpx_encoder.h"
@@ -34,6 +35,11 @@
 
 namespace webrtc {
 
+namespace {
+// A 4K frame has at most 8 tile columns, which are decoded on a thread each.
+const int kMaxNumTiles4kVideo = 8;
+}  // namespace
+
 // Only positive speeds, range for real-time coding currently is: 5 - 8.
 // Lower means slower/better quality, higher means fastest/lower quality.
 int GetCpuSpeed(int width, int height) {
@@ -905,13 +911,25 @@ int VP9DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
     decoder_ = new vpx_codec_ctx_t;
   }
   vpx_codec_dec_cfg_t cfg;
-  // Setting number of threads to a constant value (1)
-  cfg.threads = 1;
+  // The resolution of the stream isn't known until the first key frame is
+  // decoded, so the threads are set up for the highest resolution the cores
+  // allow. libvpx only uses as many of them as a frame has tile columns, or
+  // rows with row based multithreading.
+  cfg.threads = std::max(1, std::min(number_of_cores, kMaxNumTiles4kVideo));
   cfg.h = cfg.w = 0;  // set after decode
   vpx_codec_flags_t flags = 0;
   if (vpx_codec_dec_init(decoder_, vpx_codec_vp9_dx(), &cfg, flags)) {
     return WEBRTC_VIDEO_CODEC_MEMORY;
   }
+  if (cfg.threads > 1) {
+    // Decode the rows of a tile in parallel, so that low resolutions and
+    // streams with few tile columns also make use of the threads. This is
+    // only an optimization, so the decoder still works without it.
+    if (vpx_codec_control(decoder_, VP9D_SET_ROW_MT, 1)) {
+      RTC_LOG(LS_WARNING) << "Failed to enable row based multithreading, "
+                          << "decoding with tile based multithreading only.";
+    }
+  }
 
   if (!frame_buffer_pool_.InitializeVpxUsePool(decoder_)) {
     return WEBRTC_VIDEO_CODEC_MEMORY;
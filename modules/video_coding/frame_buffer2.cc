@@ -12,8 +12,9 @@
 
 #include <algorithm>
 #include <cstring>
-#include <queue>
+#include <limits>
 
+#include "common_types.h"  // NOLINT(build/include)
 #include "modules/video_coding/include/video_coding_defines.h"
 #include "modules/video_coding/jitter_estimator.h"
 #include "modules/video_coding/timing.h"
@@ -34,31 +35,72 @@ constexpr int kMaxFramesBuffered = 600;
 // Max number of decoded frame info that will be saved.
 constexpr int kMaxFramesHistory = 50;
 
+// Max number of frame infos, including decoded frames and frames that have
+// not been received yet but are referenced by buffered frames.
+constexpr int kMaxFrameInfos = 1024;
+
+// Number of positions in the index of the frame infos. Twice the number of
+// frame infos, so that lookups rarely probe more than a few positions.
+constexpr int kIndexSizeLog2 = 11;
+constexpr size_t kIndexSize = 1 << kIndexSizeLog2;
+static_assert(kIndexSize >= 2 * kMaxFrameInfos, "Index too small.");
+
 // The time it's allowed for a frame to be late to its rendering prediction and
 // still be rendered.
 constexpr int kMaxAllowedFrameDelayMs = 5;
 
 constexpr int64_t kLogNonDecodedIntervalMs = 5000;
+
+// The position in the index where the lookup of |id| starts. Consecutive
+// picture ids are spread over the index by Fibonacci hashing.
+size_t HomePosition(const VideoLayerFrameId& id) {
+  const uint64_t key =
+      static_cast<uint64_t>(id.picture_id) * kMaxSpatialLayers +
+      id.spatial_layer;
+  return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >>
+                             (64 - kIndexSizeLog2));
+}
+
+size_t NextPosition(size_t position) {
+  return (position + 1) & (kIndexSize - 1);
+}
 }  // namespace
 
+constexpr FrameBuffer::FrameIndex FrameBuffer::kNoFrame;
+constexpr FrameBuffer::LinkIndex FrameBuffer::kNoLink;
+constexpr size_t FrameBuffer::kMaxLinksPerFrame;
+
 FrameBuffer::FrameBuffer(Clock* clock,
                          VCMJitterEstimator* jitter_estimator,
                          VCMTiming* timing,
                          VCMReceiveStatisticsCallback* stats_callback)
-    : clock_(clock),
+    : frames_(kMaxFrameInfos),
+      first_frame_(kNoFrame),
+      last_frame_(kNoFrame),
+      free_frames_(0),
+      frame_index_(kIndexSize, kNoFrame),
+      clock_(clock),
       new_continuous_frame_event_(false, false),
       jitter_estimator_(jitter_estimator),
       timing_(timing),
       inter_frame_delay_(clock_->TimeInMilliseconds()),
       last_decoded_frame_timestamp_(0),
-      last_decoded_frame_it_(frames_.end()),
-      last_continuous_frame_it_(frames_.end()),
+      last_decoded_frame_(kNoFrame),
+      last_continuous_frame_(kNoFrame),
+      next_frame_(kNoFrame),
       num_frames_history_(0),
       num_frames_buffered_(0),
       stopped_(false),
       protection_mode_(kProtectionNack),
       stats_callback_(stats_callback),
-      last_log_non_decoded_ms_(-kLogNonDecodedIntervalMs) {}
+      last_log_non_decoded_ms_(-kLogNonDecodedIntervalMs) {
+  static_assert(kMaxFrameInfos * kMaxLinksPerFrame <=
+                    std::numeric_limits<LinkIndex>::max(),
+                "Too many frame infos for LinkIndex.");
+  for (size_t i = 0; i + 1 < frames_.size(); ++i)
+    frames_[i].next = static_cast<FrameIndex>(i + 1);
+  continuity_stack_.reserve(frames_.size());
+}
 
 FrameBuffer::~FrameBuffer() {}
 
@@ -80,56 +122,10 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
       if (stopped_)
         return kStopped;
 
-      wait_ms = max_wait_time_ms;
-
       // Need to hold |crit_| in order to use |frames_|, therefore we
-      // set it here in the loop instead of outside the loop in order to not
-      // acquire the lock unnecesserily.
-      next_frame_it_ = frames_.end();
-
-      // |frame_it| points to the first frame after the
-      // |last_decoded_frame_it_|.
-      auto frame_it = frames_.end();
-      if (last_decoded_frame_it_ == frames_.end()) {
-        frame_it = frames_.begin();
-      } else {
-        frame_it = last_decoded_frame_it_;
-        ++frame_it;
-      }
-
-      // |continuous_end_it| points to the first frame after the
-      // |last_continuous_frame_it_|.
-      auto continuous_end_it = last_continuous_frame_it_;
-      if (continuous_end_it != frames_.end())
-        ++continuous_end_it;
-
-      for (; frame_it != continuous_end_it && frame_it != frames_.end();
-           ++frame_it) {
-        if (!frame_it->second.continuous ||
-            frame_it->second.num_missing_decodable > 0) {
-          continue;
-        }
-
-        EncodedFrame* frame = frame_it->second.frame.get();
-
-        if (keyframe_required && !frame->is_keyframe())
-          continue;
-
-        next_frame_it_ = frame_it;
-        if (frame->RenderTime() == -1)
-          frame->SetRenderTime(timing_->RenderTimeMs(frame->timestamp, now_ms));
-        wait_ms = timing_->MaxWaitingTime(frame->RenderTime(), now_ms);
-
-        // This will cause the frame buffer to prefer high framerate rather
-        // than high resolution in the case of the decoder not decoding fast
-        // enough and the stream has multiple spatial and temporal layers.
-        // For multiple temporal layers it may cause non-base layer frames to be
-        // skipped if they are late.
-        if (wait_ms < -kMaxAllowedFrameDelayMs)
-          continue;
-
-        break;
-      }
+      // look for the next frame here in the loop instead of outside the loop
+      // in order to not acquire the lock unnecesserily.
+      wait_ms = FindNextFrame(now_ms, max_wait_time_ms, keyframe_required);
     }  // rtc::Critscope lock(&crit_);
 
     wait_ms = std::min<int64_t>(wait_ms, latest_return_time_ms - now_ms);
@@ -139,73 +135,14 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
   {
     rtc::CritScope lock(&crit_);
     now_ms = clock_->TimeInMilliseconds();
-    if (next_frame_it_ != frames_.end()) {
-      std::unique_ptr<EncodedFrame> frame =
-          std::move(next_frame_it_->second.frame);
-
-      if (!frame->delayed_by_retransmission()) {
-        int64_t frame_delay;
-
-        if (inter_frame_delay_.CalculateDelay(frame->timestamp, &frame_delay,
-                                              frame->ReceivedTime())) {
-          jitter_estimator_->UpdateEstimate(frame_delay, frame->size());
-        }
-
-        float rtt_mult = protection_mode_ == kProtectionNackFEC ? 0.0 : 1.0;
-        timing_->SetJitterDelay(jitter_estimator_->GetJitterEstimate(rtt_mult));
-        timing_->UpdateCurrentDelay(frame->RenderTime(), now_ms);
-      } else {
-        if (webrtc::field_trial::IsEnabled("WebRTC-AddRttToPlayoutDelay"))
-          jitter_estimator_->FrameNacked();
-      }
-
-      // Gracefully handle bad RTP timestamps and render time issues.
-      if (HasBadRenderTiming(*frame, now_ms)) {
-        jitter_estimator_->Reset();
-        timing_->Reset();
-        frame->SetRenderTime(timing_->RenderTimeMs(frame->timestamp, now_ms));
-      }
-
-      UpdateJitterDelay();
-      UpdateTimingFrameInfo();
-      PropagateDecodability(next_frame_it_->second);
-
-      // Sanity check for RTP timestamp monotonicity.
-      if (last_decoded_frame_it_ != frames_.end()) {
-        const VideoLayerFrameId& last_decoded_frame_key =
-            last_decoded_frame_it_->first;
-        const VideoLayerFrameId& frame_key = next_frame_it_->first;
-
-        const bool frame_is_higher_spatial_layer_of_last_decoded_frame =
-            last_decoded_frame_timestamp_ == frame->timestamp &&
-            last_decoded_frame_key.picture_id == frame_key.picture_id &&
-            last_decoded_frame_key.spatial_layer < frame_key.spatial_layer;
-
-        if (AheadOrAt(last_decoded_frame_timestamp_, frame->timestamp) &&
-            !frame_is_higher_spatial_layer_of_last_decoded_frame) {
-          // TODO(brandtr): Consider clearing the entire buffer when we hit
-          // these conditions.
-          RTC_LOG(LS_WARNING)
-              << "Frame with (timestamp:picture_id:spatial_id) ("
-              << frame->timestamp << ":" << frame->id.picture_id << ":"
-              << static_cast<int>(frame->id.spatial_layer) << ")"
-              << " sent to decoder after frame with"
-              << " (timestamp:picture_id:spatial_id) ("
-              << last_decoded_frame_timestamp_ << ":"
-              << last_decoded_frame_key.picture_id << ":"
-              << static_cast<int>(last_decoded_frame_key.spatial_layer) << ").";
-        }
-      }
-
-      AdvanceLastDecodedFrame(next_frame_it_);
-      last_decoded_frame_timestamp_ = frame->timestamp;
-      *frame_out = std::move(frame);
+    if (next_frame_ != kNoFrame) {
+      *frame_out = ExtractNextFrame(now_ms);
       return kFrameFound;
     }
   }
 
   if (latest_return_time_ms - now_ms > 0) {
-    // If |next_frame_it_ == frames_.end()| and there is still time left, it
+    // If |next_frame_ == kNoFrame| and there is still time left, it
     // means that the frame buffer was cleared as the thread in this function
     // was waiting to acquire |crit_| in order to return. Wait for the
     // remaining time and then return.
@@ -215,6 +152,134 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
   return kTimeout;
 }
 
+FrameBuffer::ReturnReason FrameBuffer::PollFrame(
+    std::unique_ptr<EncodedFrame>* frame_out,
+    int64_t* wait_ms) {
+  TRACE_EVENT0("webrtc", "FrameBuffer::PollFrame");
+  rtc::CritScope lock(&crit_);
+  if (stopped_)
+    return kStopped;
+
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  *wait_ms = FindNextFrame(now_ms, -1, false);
+  if (next_frame_ == kNoFrame)
+    return kTimeout;
+  if (*wait_ms > 0)
+    return kTimeout;
+
+  *frame_out = ExtractNextFrame(now_ms);
+  return kFrameFound;
+}
+
+int64_t FrameBuffer::FindNextFrame(int64_t now_ms,
+                                   int64_t max_wait_time_ms,
+                                   bool keyframe_required) {
+  int64_t wait_ms = max_wait_time_ms;
+  next_frame_ = kNoFrame;
+
+  // |frame_it| is the first frame after the |last_decoded_frame_|.
+  FrameIndex frame_it = last_decoded_frame_ == kNoFrame
+                            ? first_frame_
+                            : frames_[last_decoded_frame_].next;
+
+  // |continuous_end| is the first frame after the
+  // |last_continuous_frame_|.
+  FrameIndex continuous_end = kNoFrame;
+  if (last_continuous_frame_ != kNoFrame)
+    continuous_end = frames_[last_continuous_frame_].next;
+
+  for (; frame_it != continuous_end && frame_it != kNoFrame;
+       frame_it = frames_[frame_it].next) {
+    const FrameInfo& info = frames_[frame_it];
+    if (!info.continuous || info.num_missing_decodable > 0)
+      continue;
+
+    EncodedFrame* frame = info.frame.get();
+
+    if (keyframe_required && !frame->is_keyframe())
+      continue;
+
+    next_frame_ = frame_it;
+    if (frame->RenderTime() == -1)
+      frame->SetRenderTime(timing_->RenderTimeMs(frame->timestamp, now_ms));
+    wait_ms = timing_->MaxWaitingTime(frame->RenderTime(), now_ms);
+
+    // This will cause the frame buffer to prefer high framerate rather
+    // than high resolution in the case of the decoder not decoding fast
+    // enough and the stream has multiple spatial and temporal layers.
+    // For multiple temporal layers it may cause non-base layer frames to be
+    // skipped if they are late.
+    if (wait_ms < -kMaxAllowedFrameDelayMs)
+      continue;
+
+    break;
+  }
+  return wait_ms;
+}
+
+std::unique_ptr<EncodedFrame> FrameBuffer::ExtractNextFrame(int64_t now_ms) {
+  RTC_DCHECK_NE(next_frame_, kNoFrame);
+  std::unique_ptr<EncodedFrame> frame = std::move(frames_[next_frame_].frame);
+
+  if (!frame->delayed_by_retransmission()) {
+    int64_t frame_delay;
+
+    if (inter_frame_delay_.CalculateDelay(frame->timestamp, &frame_delay,
+                                          frame->ReceivedTime())) {
+      jitter_estimator_->UpdateEstimate(frame_delay, frame->size());
+    }
+
+    float rtt_mult = protection_mode_ == kProtectionNackFEC ? 0.0 : 1.0;
+    timing_->SetJitterDelay(jitter_estimator_->GetJitterEstimate(rtt_mult));
+    timing_->UpdateCurrentDelay(frame->RenderTime(), now_ms);
+  } else {
+    if (webrtc::field_trial::IsEnabled("WebRTC-AddRttToPlayoutDelay"))
+      jitter_estimator_->FrameNacked();
+  }
+
+  // Gracefully handle bad RTP timestamps and render time issues.
+  if (HasBadRenderTiming(*frame, now_ms)) {
+    jitter_estimator_->Reset();
+    timing_->Reset();
+    frame->SetRenderTime(timing_->RenderTimeMs(frame->timestamp, now_ms));
+  }
+
+  UpdateJitterDelay();
+  UpdateTimingFrameInfo();
+  PropagateDecodability(next_frame_);
+
+  // Sanity check for RTP timestamp monotonicity.
+  if (last_decoded_frame_ != kNoFrame) {
+    const VideoLayerFrameId& last_decoded_frame_key =
+        frames_[last_decoded_frame_].id;
+    const VideoLayerFrameId& frame_key = frames_[next_frame_].id;
+
+    const bool frame_is_higher_spatial_layer_of_last_decoded_frame =
+        last_decoded_frame_timestamp_ == frame->timestamp &&
+        last_decoded_frame_key.picture_id == frame_key.picture_id &&
+        last_decoded_frame_key.spatial_layer < frame_key.spatial_layer;
+
+    if (AheadOrAt(last_decoded_frame_timestamp_, frame->timestamp) &&
+        !frame_is_higher_spatial_layer_of_last_decoded_frame) {
+      // TODO(brandtr): Consider clearing the entire buffer when we hit
+      // these conditions.
+      RTC_LOG(LS_WARNING)
+          << "Frame with (timestamp:picture_id:spatial_id) ("
+          << frame->timestamp << ":" << frame->id.picture_id << ":"
+          << static_cast<int>(frame->id.spatial_layer) << ")"
+          << " sent to decoder after frame with"
+          << " (timestamp:picture_id:spatial_id) ("
+          << last_decoded_frame_timestamp_ << ":"
+          << last_decoded_frame_key.picture_id << ":"
+          << static_cast<int>(last_decoded_frame_key.spatial_layer) << ").";
+    }
+  }
+
+  AdvanceLastDecodedFrame(next_frame_);
+  last_decoded_frame_timestamp_ = frame->timestamp;
+  return frame;
+}
+
 bool FrameBuffer::HasBadRenderTiming(const EncodedFrame& frame,
                                      int64_t now_ms) {
   // Assume that render timing errors are due to changes in the video stream.
@@ -264,7 +329,7 @@ void FrameBuffer::UpdateRtt(int64_t rtt_ms) {
 }
 
 bool FrameBuffer::ValidReferences(const EncodedFrame& frame) const {
-  if (frame.id.picture_id < 0)
+  if (frame.id.picture_id < 0 || frame.id.spatial_layer >= kMaxSpatialLayers)
     return false;
 
   for (size_t i = 0; i < frame.num_references; ++i) {
@@ -307,9 +372,9 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
   rtc::CritScope lock(&crit_);
 
   int64_t last_continuous_picture_id =
-      last_continuous_frame_it_ == frames_.end()
+      last_continuous_frame_ == kNoFrame
           ? -1
-          : last_continuous_frame_it_->first.picture_id;
+          : frames_[last_continuous_frame_].id.picture_id;
 
   if (!ValidReferences(*frame)) {
     RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
@@ -337,8 +402,8 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
     }
   }
 
-  if (last_decoded_frame_it_ != frames_.end() &&
-      id <= last_decoded_frame_it_->first) {
+  if (last_decoded_frame_ != kNoFrame &&
+      id <= frames_[last_decoded_frame_].id) {
     if (AheadOf(frame->timestamp, last_decoded_frame_timestamp_) &&
         frame->is_keyframe()) {
       // If this frame has a newer timestamp but an earlier picture id then we
@@ -351,13 +416,14 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
       ClearFramesAndHistory();
       last_continuous_picture_id = -1;
     } else {
+      const VideoLayerFrameId& last_decoded_id =
+          frames_[last_decoded_frame_].id;
       RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
                           << id.picture_id << ":"
                           << static_cast<int>(id.spatial_layer)
                           << ") inserted after frame ("
-                          << last_decoded_frame_it_->first.picture_id << ":"
-                          << static_cast<int>(
-                                 last_decoded_frame_it_->first.spatial_layer)
+                          << last_decoded_id.picture_id << ":"
+                          << static_cast<int>(last_decoded_id.spatial_layer)
                           << ") was handed off for decoding, dropping frame.";
       return last_continuous_picture_id;
     }
@@ -366,17 +432,40 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
   // Test if inserting this frame would cause the order of the frames to become
   // ambiguous (covering more than half the interval of 2^16). This can happen
   // when the picture id make large jumps mid stream.
-  if (!frames_.empty() && id < frames_.begin()->first &&
-      frames_.rbegin()->first < id) {
+  if (first_frame_ != kNoFrame && id < frames_[first_frame_].id &&
+      frames_[last_frame_].id < id) {
     RTC_LOG(LS_WARNING)
         << "A jump in picture id was detected, clearing buffer.";
     ClearFramesAndHistory();
     last_continuous_picture_id = -1;
   }
 
-  auto info = frames_.emplace(id, FrameInfo()).first;
+  FrameIndex index = FindOrInsertFrame(id);
+  if (index == kNoFrame) {
+    // The buffered frames reference too many frames that have not been
+    // received.
+    if (frame->is_keyframe()) {
+      RTC_LOG(LS_WARNING) << "Inserting keyframe (picture_id:spatial_id) ("
+                          << id.picture_id << ":"
+                          << static_cast<int>(id.spatial_layer)
+                          << ") but there is no room for it, clearing"
+                          << " buffer and inserting the frame.";
+      ClearFramesAndHistory();
+      last_continuous_picture_id = -1;
+      index = FindOrInsertFrame(id);
+      RTC_DCHECK_NE(index, kNoFrame);
+    } else {
+      RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
+                          << id.picture_id << ":"
+                          << static_cast<int>(id.spatial_layer)
+                          << ") could not be inserted due to there being no"
+                          << " room for it, dropping frame.";
+      return last_continuous_picture_id;
+    }
+  }
+  FrameInfo& info = frames_[index];
 
-  if (info->second.frame) {
+  if (info.frame) {
     RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
                         << id.picture_id << ":"
                         << static_cast<int>(id.spatial_layer)
@@ -384,17 +473,17 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
     return last_continuous_picture_id;
   }
 
-  if (!UpdateFrameInfoWithIncomingFrame(*frame, info))
+  if (!UpdateFrameInfoWithIncomingFrame(*frame, index))
     return last_continuous_picture_id;
   UpdatePlayoutDelays(*frame);
 
-  info->second.frame = std::move(frame);
+  info.frame = std::move(frame);
   ++num_frames_buffered_;
 
-  if (info->second.num_missing_continuous == 0) {
-    info->second.continuous = true;
-    PropagateContinuity(info);
-    last_continuous_picture_id = last_continuous_frame_it_->first.picture_id;
+  if (info.num_missing_continuous == 0) {
+    info.continuous = true;
+    PropagateContinuity(index);
+    last_continuous_picture_id = frames_[last_continuous_frame_].id.picture_id;
 
     // Since we now have new continuous frames there might be a better frame
     // to return from NextFrame. Signal that thread so that it again can choose
@@ -405,99 +494,232 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
   return last_continuous_picture_id;
 }
 
-void FrameBuffer::PropagateContinuity(FrameMap::iterator start) {
+FrameBuffer::FrameIndex FrameBuffer::FindFrame(
+    const VideoLayerFrameId& id) const {
+  return frame_index_[FindIndexPosition(id)];
+}
+
+size_t FrameBuffer::FindIndexPosition(const VideoLayerFrameId& id) const {
+  // Linear probing. The index has more positions than there are frame infos,
+  // so there always is a free position that ends the lookup.
+  size_t position = HomePosition(id);
+  while (frame_index_[position] != kNoFrame &&
+         !(frames_[frame_index_[position]].id == id)) {
+    position = NextPosition(position);
+  }
+  return position;
+}
+
+void FrameBuffer::RemoveIndexPosition(size_t position) {
+  // Move later entries of the probe sequence back into the freed position
+  // when it is on their path, so that lookups never stop early.
+  size_t hole = position;
+  for (size_t next = NextPosition(hole); frame_index_[next] != kNoFrame;
+       next = NextPosition(next)) {
+    const size_t home = HomePosition(frames_[frame_index_[next]].id);
+    if (((next - home) & (kIndexSize - 1)) >=
+        ((next - hole) & (kIndexSize - 1))) {
+      frame_index_[hole] = frame_index_[next];
+      hole = next;
+    }
+  }
+  frame_index_[hole] = kNoFrame;
+}
+
+FrameBuffer::FrameIndex FrameBuffer::FindOrInsertFrame(
+    const VideoLayerFrameId& id) {
+  const size_t position = FindIndexPosition(id);
+  FrameIndex index = frame_index_[position];
+  if (index != kNoFrame)
+    return index;
+
+  if (free_frames_ == kNoFrame)
+    return kNoFrame;
+  index = free_frames_;
+  FrameInfo& info = frames_[index];
+  free_frames_ = info.next;
+  info.id = id;
+
+  // Frames are mostly inserted after all other frames, so look for the
+  // position in |id| order from the end.
+  FrameIndex prev = last_frame_;
+  while (prev != kNoFrame && id < frames_[prev].id)
+    prev = frames_[prev].prev;
+  info.prev = prev;
+  info.next = prev == kNoFrame ? first_frame_ : frames_[prev].next;
+  if (info.prev == kNoFrame)
+    first_frame_ = index;
+  else
+    frames_[info.prev].next = index;
+  if (info.next == kNoFrame)
+    last_frame_ = index;
+  else
+    frames_[info.next].prev = index;
+
+  frame_index_[position] = index;
+  return index;
+}
+
+FrameBuffer::FrameIndex FrameBuffer::EraseFrame(FrameIndex index) {
+  FrameInfo& info = frames_[index];
+  RemoveDependencies(index);
+
+  // The frames that depend on this frame are no longer updated by it.
+  LinkIndex link = info.first_dependent;
+  while (link != kNoLink) {
+    DependencyLink& dependency = LinkAt(link);
+    link = dependency.next;
+    dependency = DependencyLink();
+  }
+  info.first_dependent = kNoLink;
+
+  const FrameIndex next = info.next;
+  if (info.prev == kNoFrame)
+    first_frame_ = next;
+  else
+    frames_[info.prev].next = next;
+  if (next == kNoFrame)
+    last_frame_ = info.prev;
+  else
+    frames_[next].prev = info.prev;
+
+  const size_t position = FindIndexPosition(info.id);
+  RTC_DCHECK_EQ(frame_index_[position], index);
+  RemoveIndexPosition(position);
+
+  info.id = VideoLayerFrameId();
+  info.num_missing_continuous = 0;
+  info.num_missing_decodable = 0;
+  info.continuous = false;
+  info.frame.reset();
+  info.prev = kNoFrame;
+  info.next = free_frames_;
+  free_frames_ = index;
+  return next;
+}
+
+void FrameBuffer::AddDependency(FrameIndex index,
+                                size_t slot,
+                                FrameIndex referenced) {
+  RTC_DCHECK_LT(slot, kMaxLinksPerFrame);
+  const LinkIndex link =
+      static_cast<LinkIndex>(index * kMaxLinksPerFrame + slot);
+  DependencyLink& dependency = frames_[index].links[slot];
+  RTC_DCHECK_EQ(dependency.referenced, kNoFrame);
+  FrameInfo& referenced_info = frames_[referenced];
+
+  dependency.referenced = referenced;
+  dependency.prev = kNoLink;
+  dependency.next = referenced_info.first_dependent;
+  if (dependency.next != kNoLink)
+    LinkAt(dependency.next).prev = link;
+  referenced_info.first_dependent = link;
+}
+
+void FrameBuffer::RemoveDependencies(FrameIndex index) {
+  for (DependencyLink& dependency : frames_[index].links) {
+    if (dependency.referenced == kNoFrame)
+      continue;
+    if (dependency.prev == kNoLink)
+      frames_[dependency.referenced].first_dependent = dependency.next;
+    else
+      LinkAt(dependency.prev).next = dependency.next;
+    if (dependency.next != kNoLink)
+      LinkAt(dependency.next).prev = dependency.prev;
+    dependency = DependencyLink();
+  }
+}
+
+FrameBuffer::DependencyLink& FrameBuffer::LinkAt(LinkIndex link) {
+  return frames_[link / kMaxLinksPerFrame].links[link % kMaxLinksPerFrame];
+}
+
+void FrameBuffer::PropagateContinuity(FrameIndex start) {
   TRACE_EVENT0("webrtc", "FrameBuffer::PropagateContinuity");
-  RTC_DCHECK(start->second.continuous);
-  if (last_continuous_frame_it_ == frames_.end())
-    last_continuous_frame_it_ = start;
+  RTC_DCHECK(frames_[start].continuous);
+  if (last_continuous_frame_ == kNoFrame)
+    last_continuous_frame_ = start;
 
-  std::queue<FrameMap::iterator> continuous_frames;
-  continuous_frames.push(start);
+  RTC_DCHECK(continuity_stack_.empty());
+  continuity_stack_.push_back(start);
 
-  // A simple BFS to traverse continuous frames.
-  while (!continuous_frames.empty()) {
-    auto frame = continuous_frames.front();
-    continuous_frames.pop();
+  // A simple DFS to traverse continuous frames.
+  while (!continuity_stack_.empty()) {
+    const FrameIndex index = continuity_stack_.back();
+    continuity_stack_.pop_back();
 
-    if (last_continuous_frame_it_->first < frame->first)
-      last_continuous_frame_it_ = frame;
+    if (frames_[last_continuous_frame_].id < frames_[index].id)
+      last_continuous_frame_ = index;
 
     // Loop through all dependent frames, and if that frame no longer has
     // any unfulfilled dependencies then that frame is continuous as well.
-    for (size_t d = 0; d < frame->second.num_dependent_frames; ++d) {
-      auto frame_ref = frames_.find(frame->second.dependent_frames[d]);
-      RTC_DCHECK(frame_ref != frames_.end());
-
-      // TODO(philipel): Look into why we've seen this happen.
-      if (frame_ref != frames_.end()) {
-        --frame_ref->second.num_missing_continuous;
-        if (frame_ref->second.num_missing_continuous == 0) {
-          frame_ref->second.continuous = true;
-          continuous_frames.push(frame_ref);
-        }
+    for (LinkIndex link = frames_[index].first_dependent; link != kNoLink;
+         link = LinkAt(link).next) {
+      const FrameIndex dependent = link / kMaxLinksPerFrame;
+      FrameInfo& dependent_info = frames_[dependent];
+      --dependent_info.num_missing_continuous;
+      if (dependent_info.num_missing_continuous == 0) {
+        dependent_info.continuous = true;
+        continuity_stack_.push_back(dependent);
       }
     }
   }
 }
 
-void FrameBuffer::PropagateDecodability(const FrameInfo& info) {
+void FrameBuffer::PropagateDecodability(FrameIndex index) {
   TRACE_EVENT0("webrtc", "FrameBuffer::PropagateDecodability");
-  RTC_CHECK(info.num_dependent_frames < FrameInfo::kMaxNumDependentFrames);
-  for (size_t d = 0; d < info.num_dependent_frames; ++d) {
-    auto ref_info = frames_.find(info.dependent_frames[d]);
-    RTC_DCHECK(ref_info != frames_.end());
-    // TODO(philipel): Look into why we've seen this happen.
-    if (ref_info != frames_.end()) {
-      RTC_DCHECK_GT(ref_info->second.num_missing_decodable, 0U);
-      --ref_info->second.num_missing_decodable;
-    }
+  for (LinkIndex link = frames_[index].first_dependent; link != kNoLink;
+       link = LinkAt(link).next) {
+    FrameInfo& dependent_info = frames_[link / kMaxLinksPerFrame];
+    RTC_DCHECK_GT(dependent_info.num_missing_decodable, 0);
+    --dependent_info.num_missing_decodable;
   }
 }
 
-void FrameBuffer::AdvanceLastDecodedFrame(FrameMap::iterator decoded) {
+void FrameBuffer::AdvanceLastDecodedFrame(FrameIndex decoded) {
   TRACE_EVENT0("webrtc", "FrameBuffer::AdvanceLastDecodedFrame");
-  if (last_decoded_frame_it_ == frames_.end()) {
-    last_decoded_frame_it_ = frames_.begin();
+  if (last_decoded_frame_ == kNoFrame) {
+    last_decoded_frame_ = first_frame_;
   } else {
-    RTC_DCHECK(last_decoded_frame_it_->first < decoded->first);
-    ++last_decoded_frame_it_;
+    RTC_DCHECK(frames_[last_decoded_frame_].id < frames_[decoded].id);
+    last_decoded_frame_ = frames_[last_decoded_frame_].next;
   }
   --num_frames_buffered_;
   ++num_frames_history_;
 
   // First, delete non-decoded frames from the history.
-  while (last_decoded_frame_it_ != decoded) {
-    if (last_decoded_frame_it_->second.frame)
+  while (last_decoded_frame_ != decoded) {
+    if (frames_[last_decoded_frame_].frame)
       --num_frames_buffered_;
-    last_decoded_frame_it_ = frames_.erase(last_decoded_frame_it_);
+    last_decoded_frame_ = EraseFrame(last_decoded_frame_);
   }
 
   // Then remove old history if we have too much history saved.
   if (num_frames_history_ > kMaxFramesHistory) {
-    frames_.erase(frames_.begin());
+    EraseFrame(first_frame_);
     --num_frames_history_;
   }
 }
 
 bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
-                                                   FrameMap::iterator info) {
+                                                   FrameIndex index) {
   TRACE_EVENT0("webrtc", "FrameBuffer::UpdateFrameInfoWithIncomingFrame");
   const VideoLayerFrameId& id = frame.id;
-  info->second.num_missing_continuous = frame.num_references;
-  info->second.num_missing_decodable = frame.num_references;
+  FrameInfo& info = frames_[index];
+  info.num_missing_continuous = frame.num_references;
+  info.num_missing_decodable = frame.num_references;
 
-  RTC_DCHECK(last_decoded_frame_it_ == frames_.end() ||
-             last_decoded_frame_it_->first < info->first);
+  RTC_DCHECK(last_decoded_frame_ == kNoFrame ||
+             frames_[last_decoded_frame_].id < info.id);
 
   // Check how many dependencies that have already been fulfilled.
   for (size_t i = 0; i < frame.num_references; ++i) {
     VideoLayerFrameId ref_key(frame.references[i], frame.id.spatial_layer);
-    auto ref_info = frames_.find(ref_key);
 
     // Does |frame| depend on a frame earlier than the last decoded frame?
-    if (last_decoded_frame_it_ != frames_.end() &&
-        ref_key <= last_decoded_frame_it_->first) {
-      if (ref_info == frames_.end()) {
+    if (last_decoded_frame_ != kNoFrame &&
+        ref_key <= frames_[last_decoded_frame_].id) {
+      if (FindFrame(ref_key) == kNoFrame) {
         int64_t now_ms = clock_->TimeInMilliseconds();
         if (last_log_non_decoded_ms_ + kLogNonDecodedIntervalMs < now_ms) {
           RTC_LOG(LS_WARNING)
@@ -507,59 +729,65 @@ bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
               << " the last decoded frame, dropping frame.";
           last_log_non_decoded_ms_ = now_ms;
         }
+        RemoveDependencies(index);
         return false;
       }
 
-      --info->second.num_missing_continuous;
-      --info->second.num_missing_decodable;
+      --info.num_missing_continuous;
+      --info.num_missing_decodable;
     } else {
-      if (ref_info == frames_.end())
-        ref_info = frames_.insert(std::make_pair(ref_key, FrameInfo())).first;
+      FrameIndex ref_index = FindOrInsertFrame(ref_key);
+      if (ref_index == kNoFrame) {
+        RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
+                            << id.picture_id << ":"
+                            << static_cast<int>(id.spatial_layer)
+                            << ") references a frame there is no room for,"
+                            << " dropping frame.";
+        RemoveDependencies(index);
+        return false;
+      }
 
-      if (ref_info->second.continuous)
-        --info->second.num_missing_continuous;
+      if (frames_[ref_index].continuous)
+        --info.num_missing_continuous;
 
       // Add backwards reference so |frame| can be updated when new
       // frames are inserted or decoded.
-      ref_info->second.dependent_frames[ref_info->second.num_dependent_frames] =
-          id;
-      RTC_DCHECK_LT(ref_info->second.num_dependent_frames,
-                    (FrameInfo::kMaxNumDependentFrames - 1));
-      // TODO(philipel): Look into why this could happen and handle
-      // appropriately.
-      if (ref_info->second.num_dependent_frames <
-          (FrameInfo::kMaxNumDependentFrames - 1)) {
-        ++ref_info->second.num_dependent_frames;
-      }
+      AddDependency(index, i, ref_index);
+      RTC_DCHECK_LE(frames_[ref_index].num_missing_continuous,
+                    frames_[ref_index].num_missing_decodable);
     }
-    RTC_DCHECK_LE(ref_info->second.num_missing_continuous,
-                  ref_info->second.num_missing_decodable);
   }
 
   // Check if we have the lower spatial layer frame.
   if (frame.inter_layer_predicted) {
-    ++info->second.num_missing_continuous;
-    ++info->second.num_missing_decodable;
+    ++info.num_missing_continuous;
+    ++info.num_missing_decodable;
 
     VideoLayerFrameId ref_key(frame.id.picture_id, frame.id.spatial_layer - 1);
     // Gets or create the FrameInfo for the referenced frame.
-    auto ref_info = frames_.insert(std::make_pair(ref_key, FrameInfo())).first;
-    if (ref_info->second.continuous)
-      --info->second.num_missing_continuous;
+    FrameIndex ref_index = FindOrInsertFrame(ref_key);
+    if (ref_index == kNoFrame) {
+      RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
+                          << id.picture_id << ":"
+                          << static_cast<int>(id.spatial_layer)
+                          << ") references a frame there is no room for,"
+                          << " dropping frame.";
+      RemoveDependencies(index);
+      return false;
+    }
+    if (frames_[ref_index].continuous)
+      --info.num_missing_continuous;
 
-    if (ref_info == last_decoded_frame_it_) {
-      --info->second.num_missing_decodable;
+    if (ref_index == last_decoded_frame_) {
+      --info.num_missing_decodable;
     } else {
-      ref_info->second.dependent_frames[ref_info->second.num_dependent_frames] =
-          id;
-      ++ref_info->second.num_dependent_frames;
+      AddDependency(index, kMaxLinksPerFrame - 1, ref_index);
     }
-    RTC_DCHECK_LE(ref_info->second.num_missing_continuous,
-                  ref_info->second.num_missing_decodable);
+    RTC_DCHECK_LE(frames_[ref_index].num_missing_continuous,
+                  frames_[ref_index].num_missing_decodable);
   }
 
-  RTC_DCHECK_LE(info->second.num_missing_continuous,
-                info->second.num_missing_decodable);
+  RTC_DCHECK_LE(info.num_missing_continuous, info.num_missing_decodable);
 
   return true;
 }
@@ -594,10 +822,11 @@ void FrameBuffer::UpdateTimingFrameInfo() {
 
 void FrameBuffer::ClearFramesAndHistory() {
   TRACE_EVENT0("webrtc", "FrameBuffer::ClearFramesAndHistory");
-  frames_.clear();
-  last_decoded_frame_it_ = frames_.end();
-  last_continuous_frame_it_ = frames_.end();
-  next_frame_it_ = frames_.end();
+  while (first_frame_ != kNoFrame)
+    EraseFrame(first_frame_);
+  last_decoded_frame_ = kNoFrame;
+  last_continuous_frame_ = kNoFrame;
+  next_frame_ = kNoFrame;
   num_frames_history_ = 0;
   num_frames_buffered_ = 0;
 }
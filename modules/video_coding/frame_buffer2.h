@@ -12,9 +12,9 @@
 #define MODULES_VIDEO_CODING_FRAME_BUFFER2_H_
 
 #include <array>
-#include <map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "api/video/encoded_frame.h"
 #include "modules/video_coding/include/video_coding_defines.h"
@@ -61,6 +61,16 @@ class FrameBuffer {
                          std::unique_ptr<EncodedFrame>* frame_out,
                          bool keyframe_required = false);
 
+  // Get the next frame for decoding without waiting for it, for callers that
+  // schedule decoding themselves.
+  //  - If the next frame is due to be decoded it will return kFrameFound and
+  //    set |frame_out| to the frame.
+  //  - Otherwise it will return kTimeout and set |wait_ms| to the time until
+  //    the next frame is due, or to -1 if there is no decodable frame.
+  //  - If the FrameBuffer is stopped then it will return kStopped.
+  ReturnReason PollFrame(std::unique_ptr<EncodedFrame>* frame_out,
+                         int64_t* wait_ms);
+
   // Tells the FrameBuffer which protection mode that is in use. Affects
   // the frame timing.
   // TODO(philipel): Remove this when new timing calculations has been
@@ -79,40 +89,111 @@ class FrameBuffer {
   void UpdateRtt(int64_t rtt_ms);
 
  private:
+  // Index of a FrameInfo in |frames_|.
+  using FrameIndex = int16_t;
+  // Index of a DependencyLink, see LinkAt().
+  using LinkIndex = int16_t;
+
+  static constexpr FrameIndex kNoFrame = -1;
+  static constexpr LinkIndex kNoLink = -1;
+
+  // A frame can reference up to EncodedFrame::kMaxFrameReferences earlier
+  // pictures and the lower spatial layer of its own picture.
+  static constexpr size_t kMaxLinksPerFrame =
+      EncodedFrame::kMaxFrameReferences + 1;
+
+  // A direct dependency of a frame on an earlier frame. The links are stored
+  // in the dependent frame, and all links to the same frame form a list that
+  // starts in that frame, so a frame can have any number of dependent frames
+  // without allocating.
+  struct DependencyLink {
+    // The frame that is depended upon, or kNoFrame if the link is unused.
+    FrameIndex referenced = kNoFrame;
+    LinkIndex prev = kNoLink;
+    LinkIndex next = kNoLink;
+  };
+
   struct FrameInfo {
     FrameInfo();
     FrameInfo(FrameInfo&&);
     ~FrameInfo();
 
-    // The maximum number of frames that can depend on this frame.
-    static constexpr size_t kMaxNumDependentFrames = 8;
+    // Id of the frame, or a picture id of -1 if this FrameInfo is not in use.
+    VideoLayerFrameId id;
 
-    // Which other frames that have direct unfulfilled dependencies
-    // on this frame.
-    // TODO(philipel): Add simple modify/access functions to prevent adding too
-    // many |dependent_frames|.
-    VideoLayerFrameId dependent_frames[kMaxNumDependentFrames];
-    size_t num_dependent_frames = 0;
+    // The frames before and after this one in |id| order.
+    FrameIndex prev = kNoFrame;
+    FrameIndex next = kNoFrame;
+
+    // The first link of the list of frames that have direct unfulfilled
+    // dependencies on this frame.
+    LinkIndex first_dependent = kNoLink;
 
     // A frame is continiuous if it has all its referenced/indirectly
     // referenced frames.
     //
     // How many unfulfilled frames this frame have until it becomes continuous.
-    size_t num_missing_continuous = 0;
+    uint8_t num_missing_continuous = 0;
 
     // A frame is decodable if all its referenced frames have been decoded.
     //
     // How many unfulfilled frames this frame have until it becomes decodable.
-    size_t num_missing_decodable = 0;
+    uint8_t num_missing_decodable = 0;
 
     // If this frame is continuous or not.
     bool continuous = false;
 
+    // The frames this frame depends on.
+    DependencyLink links[kMaxLinksPerFrame];
+
     // The actual EncodedFrame.
     std::unique_ptr<EncodedFrame> frame;
   };
 
-  using FrameMap = std::map<VideoLayerFrameId, FrameInfo>;
+  // Returns the FrameInfo of |id|, or kNoFrame if there is none.
+  FrameIndex FindFrame(const VideoLayerFrameId& id) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the position of |id| in |frame_index_|, or the free position where
+  // it would be inserted.
+  size_t FindIndexPosition(const VideoLayerFrameId& id) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes the entry at |position| of |frame_index_|.
+  void RemoveIndexPosition(size_t position)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the FrameInfo of |id|, and creates it if there is none. Returns
+  // kNoFrame if all FrameInfos are in use.
+  FrameIndex FindOrInsertFrame(const VideoLayerFrameId& id)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes |index| from the table and returns the frame that followed it.
+  FrameIndex EraseFrame(FrameIndex index) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Makes |index| a dependent frame of |referenced|, using the link |slot| of
+  // |index|.
+  void AddDependency(FrameIndex index, size_t slot, FrameIndex referenced)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes the links of |index| from the dependent lists of the frames it
+  // references.
+  void RemoveDependencies(FrameIndex index)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  DependencyLink& LinkAt(LinkIndex link) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Sets |next_frame_| to the next frame to decode, if any, and returns how
+  // long to wait before decoding it, or |max_wait_time_ms| if there is none.
+  int64_t FindNextFrame(int64_t now_ms,
+                        int64_t max_wait_time_ms,
+                        bool keyframe_required)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes |next_frame_| from the buffer, updating the timing estimates, and
+  // returns it.
+  std::unique_ptr<EncodedFrame> ExtractNextFrame(int64_t now_ms)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Check that the references of |frame| are valid.
   bool ValidReferences(const EncodedFrame& frame) const;
@@ -124,23 +205,23 @@ class FrameBuffer {
 
   // Update all directly dependent and indirectly dependent frames and mark
   // them as continuous if all their references has been fulfilled.
-  void PropagateContinuity(FrameMap::iterator start)
+  void PropagateContinuity(FrameIndex start)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Marks the frame as decoded and updates all directly dependent frames.
-  void PropagateDecodability(const FrameInfo& info)
+  void PropagateDecodability(FrameIndex index)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
-  // Advances |last_decoded_frame_it_| to |decoded| and removes old
+  // Advances |last_decoded_frame_| to |decoded| and removes old
   // frame info.
-  void AdvanceLastDecodedFrame(FrameMap::iterator decoded)
+  void AdvanceLastDecodedFrame(FrameIndex decoded)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Update the corresponding FrameInfo of |frame| and all FrameInfos that
   // |frame| references.
   // Return false if |frame| will never be decodable, true otherwise.
   bool UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
-                                        FrameMap::iterator info)
+                                        FrameIndex index)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   void UpdateJitterDelay() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
@@ -152,7 +233,22 @@ class FrameBuffer {
   bool HasBadRenderTiming(const EncodedFrame& frame, int64_t now_ms)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
-  FrameMap frames_ RTC_GUARDED_BY(crit_);
+  // Fixed capacity storage for the buffered frames, the decoded frames kept
+  // as history and the frames that buffered frames are waiting for. The
+  // FrameInfos in use are linked in |id| order from |first_frame_| to
+  // |last_frame_|, and the unused ones through |next| from |free_frames_|.
+  std::vector<FrameInfo> frames_ RTC_GUARDED_BY(crit_);
+  FrameIndex first_frame_ RTC_GUARDED_BY(crit_);
+  FrameIndex last_frame_ RTC_GUARDED_BY(crit_);
+  FrameIndex free_frames_ RTC_GUARDED_BY(crit_);
+
+  // Open addressing hash table from the id of each FrameInfo in use to its
+  // index in |frames_|.
+  std::vector<FrameIndex> frame_index_ RTC_GUARDED_BY(crit_);
+
+  // Frames that became continuous and whose dependent frames still need to be
+  // updated, kept as a member so that PropagateContinuity doesn't allocate.
+  std::vector<FrameIndex> continuity_stack_ RTC_GUARDED_BY(crit_);
 
   rtc::CriticalSection crit_;
   Clock* const clock_;
@@ -161,9 +257,9 @@ class FrameBuffer {
   VCMTiming* const timing_ RTC_GUARDED_BY(crit_);
   VCMInterFrameDelay inter_frame_delay_ RTC_GUARDED_BY(crit_);
   uint32_t last_decoded_frame_timestamp_ RTC_GUARDED_BY(crit_);
-  FrameMap::iterator last_decoded_frame_it_ RTC_GUARDED_BY(crit_);
-  FrameMap::iterator last_continuous_frame_it_ RTC_GUARDED_BY(crit_);
-  FrameMap::iterator next_frame_it_ RTC_GUARDED_BY(crit_);
+  FrameIndex last_decoded_frame_ RTC_GUARDED_BY(crit_);
+  FrameIndex last_continuous_frame_ RTC_GUARDED_BY(crit_);
+  FrameIndex next_frame_ RTC_GUARDED_BY(crit_);
   int num_frames_history_ RTC_GUARDED_BY(crit_);
   int num_frames_buffered_ RTC_GUARDED_BY(crit_);
   bool stopped_ RTC_GUARDED_BY(crit_);
@@ -18,9 +18,11 @@
 #include "modules/video_coding/frame_object.h"
 #include "modules/video_coding/jitter_estimator.h"
 #include "modules/video_coding/timing.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/numerics/sequence_number_util.h"
 #include "rtc_base/platform_thread.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/clock.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
@@ -560,6 +562,26 @@ TEST_F(TestFrameBuffer2, KeyframeRequired) {
   CheckNoFrame(2);
 }
 
+TEST_F(TestFrameBuffer2, PollFrame) {
+  std::unique_ptr<EncodedFrame> frame;
+  int64_t wait_ms = 0;
+  EXPECT_EQ(FrameBuffer::kTimeout, buffer_.PollFrame(&frame, &wait_ms));
+  EXPECT_EQ(-1, wait_ms);
+
+  EXPECT_EQ(1, InsertFrame(1, 0, 1000, false));
+  EXPECT_EQ(FrameBuffer::kTimeout, buffer_.PollFrame(&frame, &wait_ms));
+  EXPECT_FALSE(frame);
+  EXPECT_GT(wait_ms, 0);
+
+  clock_.AdvanceTimeMilliseconds(wait_ms);
+  EXPECT_EQ(FrameBuffer::kFrameFound, buffer_.PollFrame(&frame, &wait_ms));
+  ASSERT_TRUE(frame);
+  EXPECT_EQ(1, frame->id.picture_id);
+
+  buffer_.Stop();
+  EXPECT_EQ(FrameBuffer::kStopped, buffer_.PollFrame(&frame, &wait_ms));
+}
+
 TEST_F(TestFrameBuffer2, KeyframeClearsFullBuffer) {
   const int kMaxBufferSize = 600;
 
@@ -575,5 +597,89 @@ TEST_F(TestFrameBuffer2, KeyframeClearsFullBuffer) {
   CheckFrame(1, kMaxBufferSize + 1, 0);
 }
 
+TEST_F(TestFrameBuffer2, ManyFramesDependOnMissingFrame) {
+  const int kNumDependentFrames = 20;
+  uint16_t pid = Rand();
+  uint32_t ts = Rand();
+
+  // All frames only reference |pid|, which arrives last.
+  for (int i = 1; i <= kNumDependentFrames; ++i)
+    EXPECT_EQ(-1, InsertFrame(pid + i, 0, ts + i * kFps10, false, pid));
+  EXPECT_EQ(pid + kNumDependentFrames, InsertFrame(pid, 0, ts, false));
+
+  for (int i = 0; i <= kNumDependentFrames; ++i) {
+    ExtractFrame();
+    CheckFrame(i, pid + i, 0);
+  }
+}
+
+TEST_F(TestFrameBuffer2, PictureIdsMultipleOf1024Apart) {
+  const uint16_t pid = 1000;
+  uint32_t ts = Rand();
+
+  // None of the frames is decoded before the next one is inserted.
+  EXPECT_EQ(pid, InsertFrame(pid, 0, ts, false));
+  EXPECT_EQ(pid + 1024, InsertFrame(pid + 1024, 0, ts + kFps10, false, pid));
+  EXPECT_EQ(pid + 2048,
+            InsertFrame(pid + 2048, 0, ts + 2 * kFps10, false, pid + 1024));
+
+  for (int i = 0; i < 3; ++i) {
+    ExtractFrame();
+    CheckFrame(i, pid + i * 1024, 0);
+  }
+}
+
+// VP9 SVC with three spatial and three temporal layers at 60 fps, decoded a
+// few superframes behind the receiver so that the buffer holds some frames.
+// Disabled because it only logs timings.
+TEST_F(TestFrameBuffer2,
+       DISABLED_Vp9SvcThreeSpatialThreeTemporalLayersBenchmark) {
+  const int kNumSpatialLayers = 3;
+  const int kFps = 60;
+  const int kNumSuperFrames = 60 * kFps;
+  const int kDecodeLag = 10;
+  // L3T3 temporal pattern: TL0, TL2, TL1, TL2.
+  const int kRefDistance[] = {4, 1, 2, 1};
+
+  VCMJitterEstimator jitter_estimator(&clock_);
+  FrameBuffer buffer(&clock_, &jitter_estimator, &timing_, nullptr);
+  int64_t insert_time_ns = 0;
+  int64_t extract_time_ns = 0;
+  for (int i = 0; i < kNumSuperFrames + kDecodeLag; ++i) {
+    for (int s = 0; s < kNumSpatialLayers && i < kNumSuperFrames; ++s) {
+      std::unique_ptr<FrameObjectFake> frame(new FrameObjectFake());
+      frame->id = VideoLayerFrameId(i, s);
+      frame->timestamp = i * 1000 / kFps * 90;
+      frame->inter_layer_predicted = s > 0;
+      if (i > 0) {
+        frame->num_references = 1;
+        frame->references[0] = i - kRefDistance[i % 4];
+      }
+      const int64_t start_ns = rtc::TimeNanos();
+      EXPECT_EQ(i, buffer.InsertFrame(std::move(frame)));
+      insert_time_ns += rtc::TimeNanos() - start_ns;
+    }
+
+    const int decode_index = i - kDecodeLag;
+    if (decode_index < 0)
+      continue;
+    clock_.AdvanceTimeMilliseconds(decode_index * 1000 / kFps -
+                                   clock_.TimeInMilliseconds());
+    for (int s = 0; s < kNumSpatialLayers; ++s) {
+      std::unique_ptr<EncodedFrame> frame;
+      const int64_t start_ns = rtc::TimeNanos();
+      ASSERT_EQ(FrameBuffer::kFrameFound, buffer.NextFrame(0, &frame));
+      extract_time_ns += rtc::TimeNanos() - start_ns;
+      ASSERT_EQ(decode_index, frame->id.picture_id);
+      ASSERT_EQ(s, frame->id.spatial_layer);
+    }
+  }
+
+  const int kNumFrames = kNumSuperFrames * kNumSpatialLayers;
+  RTC_LOG(LS_INFO) << "InsertFrame: " << insert_time_ns / kNumFrames
+                   << " ns/frame, NextFrame: " << extract_time_ns / kNumFrames
+                   << " ns/frame.";
+}
+
 }  // namespace video_coding
 }  // namespace webrtc
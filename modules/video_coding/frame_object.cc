@@ -10,6 +10,8 @@
 
 #include "modules/video_coding/frame_object.h"
 
+#include <string.h>
+
 #include "common_video/h264/h264_common.h"
 #include "modules/video_coding/packet_buffer.h"
 #include "rtc_base/checks.h"
@@ -49,22 +51,23 @@ RtpFrameObject::RtpFrameObject(PacketBuffer* packet_buffer,
   // as of the first packet's.
   SetPlayoutDelay(first_packet->video_header.playout_delay);
 
-  // Since FFmpeg use an optimized bitstream reader that reads in chunks of
-  // 32/64 bits we have to add at least that much padding to the buffer
-  // to make sure the decoder doesn't read out of bounds.
+  bool bitstream_taken =
+      packet_buffer_->TakeBitstream(*this, &payloads_, &fragments_);
+  RTC_DCHECK(bitstream_taken);
   // NOTE! EncodedImage::_size is the size of the buffer (think capacity of
   //       an std::vector) and EncodedImage::_length is the actual size of
   //       the bitstream (think size of an std::vector).
-  if (codec_type_ == kVideoCodecH264)
-    _size = frame_size + EncodedImage::kBufferPaddingBytesH264;
-  else
-    _size = frame_size;
-
-  _buffer = new uint8_t[_size];
   _length = frame_size;
-
-  bool bitstream_copied = GetBitstream(_buffer);
-  RTC_DCHECK(bitstream_copied);
+  if (codec_type_ == kVideoCodecH264) {
+    // The H264 decoder always needs a padded buffer, see
+    // MakeBitstreamContiguous().
+    MakeBitstreamContiguous();
+  } else if (payloads_.size() == 1) {
+    // A frame received in a single packet can use the payload as it is.
+    _buffer = payloads_[0].release();
+    _size = frame_size;
+    payloads_.clear();
+  }
   _encodedWidth = first_packet->width;
   _encodedHeight = first_packet->height;
 
@@ -140,6 +143,34 @@ bool RtpFrameObject::GetBitstream(uint8_t* destination) const {
   return packet_buffer_->GetBitstream(*this, destination);
 }
 
+rtc::ArrayView<const rtc::ArrayView<const uint8_t>>
+RtpFrameObject::GetBitstreamFragments() const {
+  return fragments_;
+}
+
+void RtpFrameObject::MakeBitstreamContiguous() {
+  if (_buffer)
+    return;
+
+  // Since FFmpeg use an optimized bitstream reader that reads in chunks of
+  // 32/64 bits we have to add at least that much padding to the buffer
+  // to make sure the decoder doesn't read out of bounds.
+  if (codec_type_ == kVideoCodecH264)
+    _size = _length + EncodedImage::kBufferPaddingBytesH264;
+  else
+    _size = _length;
+  _buffer = new uint8_t[_size];
+
+  size_t offset = 0;
+  for (const rtc::ArrayView<const uint8_t>& fragment : fragments_) {
+    RTC_DCHECK_LE(offset + fragment.size(), _length);
+    memcpy(_buffer + offset, fragment.data(), fragment.size());
+    offset += fragment.size();
+  }
+  fragments_.assign(1, rtc::ArrayView<const uint8_t>(_buffer, _length));
+  payloads_.clear();
+}
+
 uint32_t RtpFrameObject::Timestamp() const {
   return timestamp_;
 }
@@ -11,6 +11,10 @@
 #ifndef MODULES_VIDEO_CODING_FRAME_OBJECT_H_
 #define MODULES_VIDEO_CODING_FRAME_OBJECT_H_
 
+#include <memory>
+#include <vector>
+
+#include "api/array_view.h"
 #include "api/optional.h"
 #include "api/video/encoded_frame.h"
 #include "common_types.h"  // NOLINT(build/include)
@@ -37,6 +41,9 @@ class RtpFrameObject : public EncodedFrame {
   enum FrameType frame_type() const;
   VideoCodecType codec_type() const;
   bool GetBitstream(uint8_t* destination) const override;
+  rtc::ArrayView<const rtc::ArrayView<const uint8_t>> GetBitstreamFragments()
+      const override;
+  void MakeBitstreamContiguous() override;
   uint32_t Timestamp() const override;
   int64_t ReceivedTime() const override;
   int64_t RenderTime() const override;
@@ -52,6 +59,13 @@ class RtpFrameObject : public EncodedFrame {
   uint32_t timestamp_;
   int64_t received_time_;
 
+  // The packet payloads, taken over from the packet buffer when the frame is
+  // created so that the bitstream doesn't have to be copied. Released once the
+  // bitstream has been made contiguous.
+  std::vector<std::unique_ptr<uint8_t[]>> payloads_;
+  // Points into |payloads_|, or at |_buffer| once it holds the bitstream.
+  std::vector<rtc::ArrayView<const uint8_t>> fragments_;
+
   // Equal to times nacked of the packet with the highet times nacked
   // belonging to this frame.
   int times_nacked_;
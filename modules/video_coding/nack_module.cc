@@ -28,16 +28,92 @@ const int kProcessFrequency = 50;
 const int kProcessIntervalMs = 1000 / kProcessFrequency;
 const int kMaxReorderedPackets = 128;
 const int kNumReorderingBuckets = 10;
+// Must be a power of two larger than |kMaxNackPackets|, so that the nack list
+// always has room for the packets it holds.
+const size_t kNackListCapacity = 2048;
+const size_t kNumSeqNums = 1 << 16;
+const size_t kBitsPerWord = 64;
+
+bool GetBit(const std::vector<uint64_t>& bitmap, uint16_t seq_num) {
+  return (bitmap[seq_num / kBitsPerWord] >> (seq_num % kBitsPerWord)) & 1;
+}
+
+void SetBit(std::vector<uint64_t>* bitmap, uint16_t seq_num) {
+  (*bitmap)[seq_num / kBitsPerWord] |= uint64_t{1} << (seq_num % kBitsPerWord);
+}
+
+void ClearBit(std::vector<uint64_t>* bitmap, uint16_t seq_num) {
+  (*bitmap)[seq_num / kBitsPerWord] &=
+      ~(uint64_t{1} << (seq_num % kBitsPerWord));
+}
+
+// Returns the bits of the word holding |seq_num|, starting with the bit of
+// |seq_num|, and sets |num_bits| to how many of them are before |seq_num_end|.
+uint64_t GetWordBits(const std::vector<uint64_t>& bitmap,
+                     uint16_t seq_num,
+                     uint16_t seq_num_end,
+                     size_t* num_bits) {
+  const size_t bit = seq_num % kBitsPerWord;
+  *num_bits = std::min<size_t>(kBitsPerWord - bit,
+                               ForwardDiff(seq_num, seq_num_end));
+  const uint64_t mask = *num_bits == kBitsPerWord
+                            ? ~uint64_t{0}
+                            : (uint64_t{1} << *num_bits) - 1;
+  return (bitmap[seq_num / kBitsPerWord] >> bit) & mask;
+}
+
+// Clears the bits of the sequence numbers from |seq_num_begin| up to, but not
+// including, |seq_num_end|, a word at a time.
+void ClearBits(std::vector<uint64_t>* bitmap,
+               uint16_t seq_num_begin,
+               uint16_t seq_num_end) {
+  uint16_t seq_num = seq_num_begin;
+  while (seq_num != seq_num_end) {
+    size_t num_bits;
+    const uint64_t bits =
+        GetWordBits(*bitmap, seq_num, seq_num_end, &num_bits);
+    (*bitmap)[seq_num / kBitsPerWord] &= ~(bits << (seq_num % kBitsPerWord));
+    seq_num = static_cast<uint16_t>(seq_num + num_bits);
+  }
+}
+
+// Finds the first set bit from |seq_num_begin| up to, but not including,
+// |seq_num_end|.
+bool FindFirstBit(const std::vector<uint64_t>& bitmap,
+                  uint16_t seq_num_begin,
+                  uint16_t seq_num_end,
+                  uint16_t* found) {
+  uint16_t seq_num = seq_num_begin;
+  while (seq_num != seq_num_end) {
+    size_t num_bits;
+    uint64_t bits = GetWordBits(bitmap, seq_num, seq_num_end, &num_bits);
+    if (bits != 0) {
+      while ((bits & 1) == 0) {
+        bits >>= 1;
+        ++seq_num;
+      }
+      *found = seq_num;
+      return true;
+    }
+    seq_num = static_cast<uint16_t>(seq_num + num_bits);
+  }
+  return false;
+}
 }  // namespace
 
 NackModule::NackInfo::NackInfo()
-    : seq_num(0), send_at_seq_num(0), sent_at_time(-1), retries(0) {}
+    : sent_at_time(-1),
+      seq_num(0),
+      send_at_seq_num(0),
+      retries(0),
+      removed(false) {}
 
 NackModule::NackInfo::NackInfo(uint16_t seq_num, uint16_t send_at_seq_num)
-    : seq_num(seq_num),
+    : sent_at_time(-1),
+      seq_num(seq_num),
       send_at_seq_num(send_at_seq_num),
-      sent_at_time(-1),
-      retries(0) {}
+      retries(0),
+      removed(false) {}
 
 NackModule::NackModule(Clock* clock,
                        NackSender* nack_sender,
@@ -45,6 +121,14 @@ NackModule::NackModule(Clock* clock,
     : clock_(clock),
       nack_sender_(nack_sender),
       keyframe_request_sender_(keyframe_request_sender),
+      nack_list_(kNackListCapacity),
+      nack_list_begin_(0),
+      nack_list_end_(0),
+      nack_list_unsent_(0),
+      nack_list_size_(0),
+      nack_bitmap_(kNumSeqNums / kBitsPerWord),
+      keyframe_bitmap_(kNumSeqNums / kBitsPerWord),
+      keyframes_begin_(0),
       reordering_histogram_(kNumReorderingBuckets, kMaxReorderedPackets),
       initialized_(false),
       rtt_ms_(kDefaultRttMs),
@@ -65,8 +149,9 @@ int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe) {
 
   if (!initialized_) {
     newest_seq_num_ = seq_num;
+    keyframes_begin_ = seq_num;
     if (is_keyframe)
-      keyframe_list_.insert(seq_num);
+      SetBit(&keyframe_bitmap_, seq_num);
     initialized_ = true;
     return 0;
   }
@@ -78,11 +163,11 @@ int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe) {
 
   if (AheadOf(newest_seq_num_, seq_num)) {
     // An out of order packet has been received.
-    auto nack_list_it = nack_list_.find(seq_num);
     int nacks_sent_for_packet = 0;
-    if (nack_list_it != nack_list_.end()) {
-      nacks_sent_for_packet = nack_list_it->second.retries;
-      nack_list_.erase(nack_list_it);
+    if (GetBit(nack_bitmap_, seq_num)) {
+      size_t position = FindInNackList(seq_num);
+      nacks_sent_for_packet = NackInfoAt(position).retries;
+      RemoveFromNackList(position);
     }
     if (!is_retransmitted)
       UpdateReorderingStatistics(seq_num);
@@ -92,18 +177,21 @@ int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe) {
   newest_seq_num_ = seq_num;
 
   // Keep track of new keyframes.
-  if (is_keyframe)
-    keyframe_list_.insert(seq_num);
+  if (is_keyframe) {
+    // |keyframes_begin_| may be ahead of |seq_num| after ClearUpTo().
+    if (AheadOf(keyframes_begin_, seq_num))
+      keyframes_begin_ = seq_num;
+    SetBit(&keyframe_bitmap_, seq_num);
+  }
 
   // And remove old ones so we don't accumulate keyframes.
-  auto it = keyframe_list_.lower_bound(seq_num - kMaxPacketAge);
-  if (it != keyframe_list_.begin())
-    keyframe_list_.erase(keyframe_list_.begin(), it);
+  RemoveKeyFramesOlderThan(seq_num - kMaxPacketAge);
 
   // Are there any nacks that are waiting for this seq_num.
-  std::vector<uint16_t> nack_batch = GetNackBatch(kSeqNumOnly);
-  if (!nack_batch.empty())
-    nack_sender_->SendNack(nack_batch);
+  nack_batch_.clear();
+  GetNackBatch(kSeqNumOnly, &nack_batch_);
+  if (!nack_batch_.empty())
+    nack_sender_->SendNack(nack_batch_);
 
   return 0;
 }
@@ -116,9 +204,8 @@ int NackModule::OnReceivedPacket(const VCMPacket& packet) {
 
 void NackModule::ClearUpTo(uint16_t seq_num) {
   rtc::CritScope lock(&crit_);
-  nack_list_.erase(nack_list_.begin(), nack_list_.lower_bound(seq_num));
-  keyframe_list_.erase(keyframe_list_.begin(),
-                       keyframe_list_.lower_bound(seq_num));
+  RemoveNacksOlderThan(seq_num);
+  RemoveKeyFramesOlderThan(seq_num);
 }
 
 void NackModule::UpdateRtt(int64_t rtt_ms) {
@@ -128,8 +215,8 @@ void NackModule::UpdateRtt(int64_t rtt_ms) {
 
 void NackModule::Clear() {
   rtc::CritScope lock(&crit_);
-  nack_list_.clear();
-  keyframe_list_.clear();
+  ClearNackList();
+  ClearBits(&keyframe_bitmap_, keyframes_begin_, newest_seq_num_ + 1);
 }
 
 int64_t NackModule::TimeUntilNextProcess() {
@@ -142,7 +229,7 @@ void NackModule::Process() {
     std::vector<uint16_t> nack_batch;
     {
       rtc::CritScope lock(&crit_);
-      nack_batch = GetNackBatch(kTimeOnly);
+      GetNackBatch(kTimeOnly, &nack_batch);
     }
 
     if (!nack_batch.empty())
@@ -164,20 +251,24 @@ void NackModule::Process() {
 }
 
 bool NackModule::RemovePacketsUntilKeyFrame() {
-  while (!keyframe_list_.empty()) {
-    auto it = nack_list_.lower_bound(*keyframe_list_.begin());
-
-    if (it != nack_list_.begin()) {
+  // No keyframes are newer than |newest_seq_num_|.
+  if (AheadOf(keyframes_begin_, newest_seq_num_))
+    return false;
+
+  uint16_t keyframe;
+  while (FindFirstBit(keyframe_bitmap_, keyframes_begin_, newest_seq_num_ + 1,
+                      &keyframe)) {
+    if (nack_list_size_ > 0 &&
+        AheadOf(keyframe, NackInfoAt(nack_list_begin_).seq_num)) {
       // We have found a keyframe that actually is newer than at least one
       // packet in the nack list.
-      RTC_DCHECK(it != nack_list_.end());
-      nack_list_.erase(nack_list_.begin(), it);
+      RemoveNacksOlderThan(keyframe);
       return true;
     }
 
     // If this keyframe is so old it does not remove any packets from the list,
     // remove it from the list of keyframes and try the next keyframe.
-    keyframe_list_.erase(keyframe_list_.begin());
+    RemoveKeyFramesOlderThan(keyframe + 1);
   }
   return false;
 }
@@ -185,20 +276,19 @@ bool NackModule::RemovePacketsUntilKeyFrame() {
 void NackModule::AddPacketsToNack(uint16_t seq_num_start,
                                   uint16_t seq_num_end) {
   // Remove old packets.
-  auto it = nack_list_.lower_bound(seq_num_end - kMaxPacketAge);
-  nack_list_.erase(nack_list_.begin(), it);
+  RemoveNacksOlderThan(seq_num_end - kMaxPacketAge);
 
   // If the nack list is too large, remove packets from the nack list until
   // the latest first packet of a keyframe. If the list is still too large,
   // clear it and request a keyframe.
   uint16_t num_new_nacks = ForwardDiff(seq_num_start, seq_num_end);
-  if (nack_list_.size() + num_new_nacks > kMaxNackPackets) {
+  if (nack_list_size_ + num_new_nacks > kMaxNackPackets) {
     while (RemovePacketsUntilKeyFrame() &&
-           nack_list_.size() + num_new_nacks > kMaxNackPackets) {
+           nack_list_size_ + num_new_nacks > kMaxNackPackets) {
     }
 
-    if (nack_list_.size() + num_new_nacks > kMaxNackPackets) {
-      nack_list_.clear();
+    if (nack_list_size_ + num_new_nacks > kMaxNackPackets) {
+      ClearNackList();
       RTC_LOG(LS_WARNING) << "NACK list full, clearing NACK"
                              " list and requesting keyframe.";
       keyframe_request_sender_->RequestKeyFrame();
@@ -206,51 +296,154 @@ void NackModule::AddPacketsToNack(uint16_t seq_num_start,
     }
   }
 
+  if (nack_list_end_ - nack_list_begin_ + num_new_nacks > kNackListCapacity)
+    DropRemovedNacks(true);
+  RTC_DCHECK_LE(nack_list_end_ - nack_list_begin_ + num_new_nacks,
+                kNackListCapacity);
+
+  const int wait_number_of_packets = WaitNumberOfPackets(0.5);
   for (uint16_t seq_num = seq_num_start; seq_num != seq_num_end; ++seq_num) {
-    NackInfo nack_info(seq_num, seq_num + WaitNumberOfPackets(0.5));
-    RTC_DCHECK(nack_list_.find(seq_num) == nack_list_.end());
-    nack_list_[seq_num] = nack_info;
+    RTC_DCHECK(!GetBit(nack_bitmap_, seq_num));
+    NackInfoAt(nack_list_end_++) =
+        NackInfo(seq_num, seq_num + wait_number_of_packets);
+    SetBit(&nack_bitmap_, seq_num);
   }
+  nack_list_size_ += num_new_nacks;
 }
 
-std::vector<uint16_t> NackModule::GetNackBatch(NackFilterOptions options) {
+void NackModule::GetNackBatch(NackFilterOptions options,
+                              std::vector<uint16_t>* nack_batch) {
   bool consider_seq_num = options != kTimeOnly;
   bool consider_timestamp = options != kSeqNumOnly;
   int64_t now_ms = clock_->TimeInMilliseconds();
-  std::vector<uint16_t> nack_batch;
-  auto it = nack_list_.begin();
-  while (it != nack_list_.end()) {
-    if (consider_seq_num && it->second.sent_at_time == -1 &&
-        AheadOrAt(newest_seq_num_, it->second.send_at_seq_num)) {
-      nack_batch.emplace_back(it->second.seq_num);
-      ++it->second.retries;
-      it->second.sent_at_time = now_ms;
-      if (it->second.retries >= kMaxNackRetries) {
-        RTC_LOG(LS_WARNING) << "Sequence number " << it->second.seq_num
-                            << " removed from NACK list due to max retries.";
-        it = nack_list_.erase(it);
-      } else {
-        ++it;
-      }
+  // The packets before |nack_list_unsent_| can only be nacked again once
+  // enough time has passed.
+  const size_t begin = consider_timestamp ? nack_list_begin_ : nack_list_unsent_;
+  for (size_t position = begin; position != nack_list_end_; ++position) {
+    NackInfo& info = NackInfoAt(position);
+    if (info.removed)
       continue;
+    bool send_nack = false;
+    if (consider_seq_num && info.sent_at_time == -1 &&
+        AheadOrAt(newest_seq_num_, info.send_at_seq_num)) {
+      send_nack = true;
+    } else if (consider_timestamp && info.sent_at_time + rtt_ms_ <= now_ms) {
+      send_nack = true;
     }
-
-    if (consider_timestamp && it->second.sent_at_time + rtt_ms_ <= now_ms) {
-      nack_batch.emplace_back(it->second.seq_num);
-      ++it->second.retries;
-      it->second.sent_at_time = now_ms;
-      if (it->second.retries >= kMaxNackRetries) {
-        RTC_LOG(LS_WARNING) << "Sequence number " << it->second.seq_num
-                            << " removed from NACK list due to max retries.";
-        it = nack_list_.erase(it);
-      } else {
-        ++it;
-      }
+    if (!send_nack)
       continue;
+
+    nack_batch->push_back(info.seq_num);
+    ++info.retries;
+    info.sent_at_time = now_ms;
+    if (info.retries >= kMaxNackRetries) {
+      RTC_LOG(LS_WARNING) << "Sequence number " << info.seq_num
+                          << " removed from NACK list due to max retries.";
+      // The removed packets are dropped from the ring after the loop.
+      info.removed = true;
+      ClearBit(&nack_bitmap_, info.seq_num);
+      --nack_list_size_;
     }
-    ++it;
   }
-  return nack_batch;
+  DropRemovedNacks(false);
+
+  while (nack_list_unsent_ != nack_list_end_ &&
+         (NackInfoAt(nack_list_unsent_).removed ||
+          NackInfoAt(nack_list_unsent_).sent_at_time != -1)) {
+    ++nack_list_unsent_;
+  }
+}
+
+NackModule::NackInfo& NackModule::NackInfoAt(size_t position) {
+  return nack_list_[position & (kNackListCapacity - 1)];
+}
+
+size_t NackModule::FindInNackList(uint16_t seq_num) {
+  RTC_DCHECK(GetBit(nack_bitmap_, seq_num));
+  // The list is sorted, so compare the distances from the oldest packet.
+  const uint16_t oldest_seq_num = NackInfoAt(nack_list_begin_).seq_num;
+  const uint16_t distance = ForwardDiff(oldest_seq_num, seq_num);
+  size_t low = nack_list_begin_;
+  size_t high = nack_list_end_;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (ForwardDiff(oldest_seq_num, NackInfoAt(middle).seq_num) < distance)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  RTC_DCHECK_NE(low, nack_list_end_);
+  RTC_DCHECK_EQ(NackInfoAt(low).seq_num, seq_num);
+  return low;
+}
+
+void NackModule::RemoveFromNackList(size_t position) {
+  NackInfo& info = NackInfoAt(position);
+  RTC_DCHECK(!info.removed);
+  info.removed = true;
+  ClearBit(&nack_bitmap_, info.seq_num);
+  --nack_list_size_;
+  if (position == nack_list_begin_)
+    DropRemovedNacks(false);
+}
+
+void NackModule::RemoveNacksOlderThan(uint16_t seq_num) {
+  while (nack_list_begin_ != nack_list_end_ &&
+         AheadOf(seq_num, NackInfoAt(nack_list_begin_).seq_num)) {
+    NackInfo& info = NackInfoAt(nack_list_begin_++);
+    if (!info.removed) {
+      ClearBit(&nack_bitmap_, info.seq_num);
+      --nack_list_size_;
+    }
+  }
+  DropRemovedNacks(false);
+}
+
+void NackModule::DropRemovedNacks(bool compact) {
+  while (nack_list_begin_ != nack_list_end_ &&
+         NackInfoAt(nack_list_begin_).removed) {
+    ++nack_list_begin_;
+  }
+  nack_list_unsent_ = std::max(nack_list_unsent_, nack_list_begin_);
+  if (!compact)
+    return;
+
+  // Move the packets that are not removed towards the front, keeping their
+  // order.
+  size_t end = nack_list_begin_;
+  size_t unsent = nack_list_begin_;
+  for (size_t position = nack_list_begin_; position != nack_list_end_;
+       ++position) {
+    if (NackInfoAt(position).removed)
+      continue;
+    if (position != end)
+      NackInfoAt(end) = NackInfoAt(position);
+    ++end;
+    if (position < nack_list_unsent_)
+      unsent = end;
+  }
+  nack_list_end_ = end;
+  nack_list_unsent_ = unsent;
+  RTC_DCHECK_EQ(nack_list_end_ - nack_list_begin_, nack_list_size_);
+}
+
+void NackModule::ClearNackList() {
+  for (size_t position = nack_list_begin_; position != nack_list_end_;
+       ++position) {
+    const NackInfo& info = NackInfoAt(position);
+    if (!info.removed)
+      ClearBit(&nack_bitmap_, info.seq_num);
+  }
+  nack_list_begin_ = nack_list_end_;
+  nack_list_unsent_ = nack_list_end_;
+  nack_list_size_ = 0;
+}
+
+void NackModule::RemoveKeyFramesOlderThan(uint16_t seq_num) {
+  if (!AheadOf(seq_num, keyframes_begin_))
+    return;
+  ClearBits(&keyframe_bitmap_, keyframes_begin_, seq_num);
+  keyframes_begin_ = seq_num;
 }
 
 void NackModule::UpdateReorderingStatistics(uint16_t seq_num) {
@@ -11,9 +11,7 @@
 #ifndef MODULES_VIDEO_CODING_NACK_MODULE_H_
 #define MODULES_VIDEO_CODING_NACK_MODULE_H_
 
-#include <map>
 #include <vector>
-#include <set>
 
 #include "modules/include/module.h"
 #include "modules/video_coding/histogram.h"
@@ -54,10 +52,12 @@ class NackModule : public Module {
     NackInfo();
     NackInfo(uint16_t seq_num, uint16_t send_at_seq_num);
 
+    int64_t sent_at_time;
     uint16_t seq_num;
     uint16_t send_at_seq_num;
-    int64_t sent_at_time;
-    int retries;
+    uint8_t retries;
+    // Set when the packet has been received or given up on, see |nack_list_|.
+    bool removed;
   };
   void AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
@@ -65,7 +65,32 @@ class NackModule : public Module {
   // Removes packets from the nack list until the next keyframe. Returns true
   // if packets were removed.
   bool RemovePacketsUntilKeyFrame() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
-  std::vector<uint16_t> GetNackBatch(NackFilterOptions options)
+
+  // Appends the packets to nack now to |nack_batch|.
+  void GetNackBatch(NackFilterOptions options,
+                    std::vector<uint16_t>* nack_batch)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  NackInfo& NackInfoAt(size_t position) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the position of |seq_num| in the nack list, which must hold it.
+  size_t FindInNackList(uint16_t seq_num) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Marks the packet at |position| of the nack list as removed.
+  void RemoveFromNackList(size_t position) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes the packets older than |seq_num| from the nack list.
+  void RemoveNacksOlderThan(uint16_t seq_num)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Drops removed packets from the front of the nack list, or from all of it
+  // if |compact| is true.
+  void DropRemovedNacks(bool compact) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  void ClearNackList() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes the keyframes older than |seq_num| from the keyframe bitmap.
+  void RemoveKeyFramesOlderThan(uint16_t seq_num)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Update the reordering distribution.
@@ -85,10 +110,32 @@ class NackModule : public Module {
   // TODO(philipel): Some of the variables below are consistently used on a
   // known thread (e.g. see |initialized_|). Those probably do not need
   // synchronized access.
-  std::map<uint16_t, NackInfo, DescendingSeqNumComp<uint16_t>> nack_list_
-      RTC_GUARDED_BY(crit_);
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t>> keyframe_list_
-      RTC_GUARDED_BY(crit_);
+  // The packets to nack, in sequence number order, in a ring buffer of fixed
+  // capacity. Positions count up from the creation of the module; the packet
+  // at |nack_list_begin_| is the oldest one and is not removed. Packets that
+  // are received, or that are given up on, are only marked as removed and
+  // are dropped from the ring once they reach the front, or when the ring is
+  // full.
+  std::vector<NackInfo> nack_list_ RTC_GUARDED_BY(crit_);
+  size_t nack_list_begin_ RTC_GUARDED_BY(crit_);
+  size_t nack_list_end_ RTC_GUARDED_BY(crit_);
+  // The packets before this position have been nacked or removed.
+  size_t nack_list_unsent_ RTC_GUARDED_BY(crit_);
+  // Number of packets in the nack list that are not removed.
+  size_t nack_list_size_ RTC_GUARDED_BY(crit_);
+  // One bit per sequence number, set for the packets in the nack list that
+  // are not removed.
+  std::vector<uint64_t> nack_bitmap_ RTC_GUARDED_BY(crit_);
+
+  // One bit per sequence number, set for the first packets of keyframes. No
+  // bits are set for the packets before |keyframes_begin_|, which follows
+  // |newest_seq_num_| at most |kMaxPacketAge| packets behind.
+  std::vector<uint64_t> keyframe_bitmap_ RTC_GUARDED_BY(crit_);
+  uint16_t keyframes_begin_ RTC_GUARDED_BY(crit_);
+
+  // The nacks sent when a packet is received, kept to reuse its capacity.
+  std::vector<uint16_t> nack_batch_ RTC_GUARDED_BY(crit_);
+
   video_coding::Histogram reordering_histogram_ RTC_GUARDED_BY(crit_);
   bool initialized_ RTC_GUARDED_BY(crit_);
   int64_t rtt_ms_ RTC_GUARDED_BY(crit_);
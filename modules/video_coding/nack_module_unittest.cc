@@ -9,10 +9,15 @@
  */
 
 #include <cstring>
+#include <deque>
 #include <memory>
+#include <utility>
 
 #include "modules/video_coding/include/video_coding_defines.h"
 #include "modules/video_coding/nack_module.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/clock.h"
 #include "test/gtest.h"
 
@@ -314,4 +319,61 @@ TEST_F(TestNackModule, PacketNackCount) {
   EXPECT_EQ(0, nack_module_.OnReceivedPacket(packet));
 }
 
+// 10k packets per second with 10% loss in bursts of five packets on average,
+// both for the media packets and for the retransmissions, which arrive one rtt
+// after they are nacked.
+// Disabled by default; it only logs how long the NackModule takes.
+TEST_F(TestNackModule, DISABLED_BurstyLossBenchmark) {
+  const int kPacketsPerSecond = 10000;
+  const int kNumPackets = 60 * kPacketsPerSecond;
+  const int kProcessIntervalPackets = kPacketsPerSecond / 50;
+  const int kKeyFrameIntervalPackets = 3 * kPacketsPerSecond;
+  const int64_t kRttMs = 100;
+  // Two state loss model, where a lost packet is followed by another lost
+  // packet with 80% probability, for an average loss of 10%.
+  const double kLossToLoss = 0.8;
+  const double kReceivedToLoss = 1.0 / 45;
+
+  Random random(0x1234);
+  bool lost = false;
+  auto next_packet_lost = [&]() {
+    lost = random.Rand<double>() < (lost ? kLossToLoss : kReceivedToLoss);
+    return lost;
+  };
+  nack_module_.UpdateRtt(kRttMs);
+  // Retransmissions in the order they arrive, with their arrival times.
+  std::deque<std::pair<int64_t, uint16_t>> retransmissions;
+  int64_t num_nacks = 0;
+  int64_t time_ns = 0;
+  for (int i = 0; i < kNumPackets; ++i) {
+    clock_->AdvanceTimeMicroseconds(rtc::kNumMicrosecsPerSec /
+                                    kPacketsPerSecond);
+    const int64_t now_ms = clock_->TimeInMilliseconds();
+    const int64_t start_ns = rtc::TimeNanos();
+    while (!retransmissions.empty() &&
+           retransmissions.front().first <= now_ms) {
+      nack_module_.OnReceivedPacket(retransmissions.front().second, false);
+      retransmissions.pop_front();
+    }
+    if (!next_packet_lost()) {
+      nack_module_.OnReceivedPacket(static_cast<uint16_t>(i),
+                                    i % kKeyFrameIntervalPackets == 0);
+    }
+    if (i % kProcessIntervalPackets == 0)
+      nack_module_.Process();
+    time_ns += rtc::TimeNanos() - start_ns;
+
+    for (uint16_t seq_num : sent_nacks_) {
+      if (!next_packet_lost())
+        retransmissions.emplace_back(now_ms + kRttMs, seq_num);
+    }
+    num_nacks += sent_nacks_.size();
+    sent_nacks_.clear();
+  }
+
+  EXPECT_EQ(0, keyframes_requested_);
+  RTC_LOG(LS_INFO) << "Nacked " << num_nacks << " of " << kNumPackets
+                   << " packets, " << time_ns / kNumPackets << " ns/packet.";
+}
+
 }  // namespace webrtc
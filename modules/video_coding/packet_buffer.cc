@@ -412,14 +412,19 @@ void PacketBuffer::ReturnFrame(RtpFrameObject* frame) {
   }
 }
 
-bool PacketBuffer::GetBitstream(const RtpFrameObject& frame,
-                                uint8_t* destination) {
+bool PacketBuffer::TakeBitstream(
+    const RtpFrameObject& frame,
+    std::vector<std::unique_ptr<uint8_t[]>>* payloads,
+    std::vector<rtc::ArrayView<const uint8_t>>* fragments) {
   rtc::CritScope lock(&crit_);
 
   size_t index = frame.first_seq_num() % size_;
   size_t end = (frame.last_seq_num() + 1) % size_;
   uint16_t seq_num = frame.first_seq_num();
-  uint8_t* destination_end = destination + frame.size();
+  const size_t num_packets =
+      ForwardDiff<uint16_t>(frame.first_seq_num(), frame.last_seq_num()) + 1;
+  payloads->reserve(num_packets);
+  fragments->reserve(num_packets);
 
   do {
     if (!sequence_buffer_[index].used ||
@@ -428,21 +433,47 @@ bool PacketBuffer::GetBitstream(const RtpFrameObject& frame,
     }
 
     RTC_DCHECK_EQ(data_buffer_[index].seqNum, sequence_buffer_[index].seq_num);
-    size_t length = data_buffer_[index].sizeBytes;
-    if (destination + length > destination_end) {
-      RTC_LOG(LS_WARNING) << "Frame (" << frame.id.picture_id << ":"
-                          << static_cast<int>(frame.id.spatial_layer) << ")"
-                          << " bitstream buffer is not large enough.";
+    VCMPacket& packet = data_buffer_[index];
+    payloads->emplace_back(const_cast<uint8_t*>(packet.dataPtr));
+    fragments->emplace_back(packet.dataPtr, packet.sizeBytes);
+    packet.dataPtr = nullptr;
+    index = (index + 1) % size_;
+    ++seq_num;
+  } while (index != end);
+
+  return true;
+}
+
+bool PacketBuffer::GetBitstream(const RtpFrameObject& frame,
+                                uint8_t* destination) {
+  rtc::CritScope lock(&crit_);
+
+  size_t index = frame.first_seq_num() % size_;
+  size_t end = (frame.last_seq_num() + 1) % size_;
+  uint16_t seq_num = frame.first_seq_num();
+  do {
+    if (!sequence_buffer_[index].used ||
+        sequence_buffer_[index].seq_num != seq_num) {
       return false;
     }
-
-    const uint8_t* source = data_buffer_[index].dataPtr;
-    memcpy(destination, source, length);
-    destination += length;
     index = (index + 1) % size_;
     ++seq_num;
   } while (index != end);
 
+  // The payloads are owned by the frame once it has been created.
+  uint8_t* destination_end = destination + frame.size();
+  for (const rtc::ArrayView<const uint8_t>& fragment :
+       frame.GetBitstreamFragments()) {
+    if (destination + fragment.size() > destination_end) {
+      RTC_LOG(LS_WARNING) << "Frame (" << frame.id.picture_id << ":"
+                          << static_cast<int>(frame.id.spatial_layer) << ")"
+                          << " bitstream buffer is not large enough.";
+      return false;
+    }
+    memcpy(destination, fragment.data(), fragment.size());
+    destination += fragment.size();
+  }
+
   return true;
 }
 
@@ -16,6 +16,7 @@
 #include <set>
 #include <vector>
 
+#include "api/array_view.h"
 #include "modules/include/module_common_types.h"
 #include "modules/video_coding/packet.h"
 #include "modules/video_coding/rtp_frame_reference_finder.h"
@@ -113,7 +114,17 @@ class PacketBuffer {
   std::vector<std::unique_ptr<RtpFrameObject>> FindFrames(uint16_t seq_num)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
-  // Copy the bitstream for |frame| to |destination|.
+  // Moves the payloads of the packets of |frame| to |payloads|, so that the
+  // frame owns its bitstream without it being copied, and adds a view of each
+  // to |fragments|. The slots stay in use until the frame is returned.
+  // Virtual for testing.
+  virtual bool TakeBitstream(
+      const RtpFrameObject& frame,
+      std::vector<std::unique_ptr<uint8_t[]>>* payloads,
+      std::vector<rtc::ArrayView<const uint8_t>>* fragments);
+
+  // Copy the bitstream for |frame| to |destination|. Fails if the packets of
+  // |frame| have been cleared from the buffer.
   // Virtual for testing.
   virtual bool GetBitstream(const RtpFrameObject& frame, uint8_t* destination);
 
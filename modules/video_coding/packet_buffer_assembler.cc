@@ -0,0 +1,177 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/packet_buffer_assembler.h"
+
+#include <limits>
+#include <utility>
+
+#include "rtc_base/atomicops.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/numerics/safe_conversions.h"
+#include "rtc_base/numerics/sequence_number_util.h"
+#include "rtc_base/ptr_util.h"
+#include "rtc_base/timeutils.h"
+
+namespace webrtc {
+namespace video_coding {
+namespace {
+// Delays above this are kept in a map rather than in the histogram array.
+constexpr uint32_t kQueueingDelayLongTailUs = 10000;
+}  // namespace
+
+PacketBufferAssembler::PacketBufferAssembler(
+    rtc::scoped_refptr<PacketBuffer> packet_buffer,
+    size_t ring_size)
+    : packet_buffer_(std::move(packet_buffer)),
+      ring_(ring_size + 1),
+      queueing_delay_us_(kQueueingDelayLongTailUs),
+      task_queue_(rtc::MakeUnique<rtc::TaskQueue>(
+          "PacketAssembly",
+          rtc::TaskQueue::Priority::HIGH)) {
+  RTC_DCHECK_GT(ring_size, 0);
+  RTC_DCHECK_LT(ring_size, std::numeric_limits<int>::max());
+  drained_delays_us_.reserve(ring_size);
+}
+
+PacketBufferAssembler::~PacketBufferAssembler() {
+  // Stop the task queue before freeing the payloads it didn't get to.
+  task_queue_.reset();
+  const int size = static_cast<int>(ring_.size());
+  for (int i = read_index_; i != write_index_; i = (i + 1) % size) {
+    delete[] ring_[i].packet.dataPtr;
+    ring_[i].packet.dataPtr = nullptr;
+  }
+}
+
+bool PacketBufferAssembler::InsertPacket(VCMPacket* packet) {
+  return Push(packet, false);
+}
+
+void PacketBufferAssembler::PaddingReceived(uint16_t seq_num) {
+  VCMPacket padding;
+  padding.seqNum = seq_num;
+  Push(&padding, true);
+}
+
+void PacketBufferAssembler::ClearTo(uint16_t seq_num) {
+  // Packets that are still in the ring when this runs are older than
+  // |seq_num| or will be dropped by the PacketBuffer as such.
+  rtc::scoped_refptr<PacketBuffer> packet_buffer = packet_buffer_;
+  task_queue_->PostTask(
+      [packet_buffer, seq_num] { packet_buffer->ClearTo(seq_num); });
+}
+
+void PacketBufferAssembler::Flush() {
+  // Since there is only one producer, any Drain() it has posted runs before
+  // this task, so the ring is idle when it runs unless packets were left in it
+  // without waking up the task queue.
+  rtc::Event done(false, false);
+  task_queue_->PostTask([this, &done] {
+    if (rtc::AtomicOps::CompareAndSwap(&drain_pending_, 0, 1) == 0)
+      Drain();
+    done.Set();
+  });
+  done.Wait(rtc::Event::kForever);
+}
+
+PacketBufferAssembler::Stats PacketBufferAssembler::GetStats() {
+  Stats stats;
+  stats.num_packets = rtc::AtomicOps::AcquireLoad(&num_packets_);
+  stats.num_dropped_packets =
+      rtc::AtomicOps::AcquireLoad(&num_dropped_packets_);
+  rtc::CritScope lock(&stats_crit_);
+  stats.median_queueing_delay_us = queueing_delay_us_.GetPercentile(0.5f);
+  stats.p99_queueing_delay_us = queueing_delay_us_.GetPercentile(0.99f);
+  return stats;
+}
+
+bool PacketBufferAssembler::Push(VCMPacket* packet, bool is_padding) {
+  rtc::AtomicOps::Increment(&num_packets_);
+  const int size = static_cast<int>(ring_.size());
+  const int write_index = write_index_;
+  const int next_write_index = (write_index + 1) % size;
+  const int read_index = rtc::AtomicOps::AcquireLoad(&read_index_);
+  if (next_write_index == read_index) {
+    rtc::AtomicOps::Increment(&num_dropped_packets_);
+    delete[] packet->dataPtr;
+    packet->dataPtr = nullptr;
+    return false;
+  }
+
+  Entry& entry = ring_[write_index];
+  entry.packet = *packet;
+  entry.is_padding = is_padding;
+  entry.push_time_us = rtc::TimeMicros();
+  packet->dataPtr = nullptr;
+  rtc::AtomicOps::ReleaseStore(&write_index_, next_write_index);
+
+  // A packet that is newer than all packets pushed before it, and doesn't
+  // end a frame, can't complete a frame: the frame it belongs to still needs
+  // a later packet. Such packets are left in the ring until one that may
+  // complete a frame arrives, or the ring starts to fill up, which saves most
+  // of the wakeups. A reordered packet may fill the last gap of a frame whose
+  // end was pushed before it, so it always wakes the task queue.
+  const bool newest = !newest_pushed_seq_num_ ||
+                      AheadOf(packet->seqNum, *newest_pushed_seq_num_);
+  if (newest)
+    newest_pushed_seq_num_ = packet->seqNum;
+  const int num_queued = (next_write_index - read_index + size) % size;
+  if (newest && !packet->markerBit &&
+      num_queued < static_cast<int>(ring_.size() / 4)) {
+    return true;
+  }
+
+  // Only wake up the task queue if it isn't already draining the ring.
+  if (rtc::AtomicOps::CompareAndSwap(&drain_pending_, 0, 1) == 0)
+    task_queue_->PostTask([this] { Drain(); });
+  return true;
+}
+
+void PacketBufferAssembler::Drain() {
+  RTC_DCHECK(task_queue_->IsCurrent());
+  const int size = static_cast<int>(ring_.size());
+  int read_index = read_index_;
+  while (true) {
+    const int write_index = rtc::AtomicOps::AcquireLoad(&write_index_);
+    while (read_index != write_index) {
+      Entry& entry = ring_[read_index];
+      drained_delays_us_.push_back(rtc::saturated_cast<uint32_t>(
+          rtc::TimeMicros() - entry.push_time_us));
+      if (entry.is_padding)
+        packet_buffer_->PaddingReceived(entry.packet.seqNum);
+      else
+        packet_buffer_->InsertPacket(&entry.packet);
+      read_index = (read_index + 1) % size;
+      rtc::AtomicOps::ReleaseStore(&read_index_, read_index);
+    }
+    UpdateQueueingDelayStats();
+
+    // Go idle, unless a packet was pushed after the ring was found empty and
+    // its producer saw that a drain was still pending. The compare and swap
+    // orders the flag update before the check of |write_index_|.
+    rtc::AtomicOps::CompareAndSwap(&drain_pending_, 1, 0);
+    if (rtc::AtomicOps::AcquireLoad(&write_index_) == read_index ||
+        rtc::AtomicOps::CompareAndSwap(&drain_pending_, 0, 1) != 0) {
+      break;
+    }
+  }
+}
+
+void PacketBufferAssembler::UpdateQueueingDelayStats() {
+  rtc::CritScope lock(&stats_crit_);
+  for (uint32_t delay_us : drained_delays_us_)
+    queueing_delay_us_.Add(delay_us);
+  drained_delays_us_.clear();
+}
+
+}  // namespace video_coding
+}  // namespace webrtc
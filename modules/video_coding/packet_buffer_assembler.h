@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_VIDEO_CODING_PACKET_BUFFER_ASSEMBLER_H_
+#define MODULES_VIDEO_CODING_PACKET_BUFFER_ASSEMBLER_H_
+
+#include <memory>
+#include <vector>
+
+#include "api/optional.h"
+#include "modules/video_coding/packet.h"
+#include "modules/video_coding/packet_buffer.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/numerics/histogram_percentile_counter.h"
+#include "rtc_base/scoped_ref_ptr.h"
+#include "rtc_base/task_queue.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+namespace video_coding {
+
+// Runs a PacketBuffer on a task queue of its own, so that the thread that
+// receives the packets never waits for the PacketBuffer lock while frames are
+// being assembled or the buffer is being cleared from the decoder side.
+// Packets are handed over through a lock-free single producer, single
+// consumer ring, and the task queue is only woken up for packets that may
+// complete a frame. Frames are delivered on the task queue.
+class PacketBufferAssembler {
+ public:
+  struct Stats {
+    // Packets handed to InsertPacket() and PaddingReceived().
+    int num_packets = 0;
+    // Packets dropped because the ring was full.
+    int num_dropped_packets = 0;
+    // Time from a packet being pushed until it was inserted into the
+    // PacketBuffer.
+    rtc::Optional<uint32_t> median_queueing_delay_us;
+    rtc::Optional<uint32_t> p99_queueing_delay_us;
+  };
+
+  // |ring_size| is the number of packets that can be waiting for the task
+  // queue before packets are dropped.
+  PacketBufferAssembler(rtc::scoped_refptr<PacketBuffer> packet_buffer,
+                        size_t ring_size);
+  ~PacketBufferAssembler();
+
+  // Hands |packet| over to the task queue and takes ownership of
+  // |packet.dataPtr|, like PacketBuffer::InsertPacket. Returns false if the
+  // ring is full, in which case the packet is dropped. InsertPacket() and
+  // PaddingReceived() must be called from one thread at a time.
+  bool InsertPacket(VCMPacket* packet);
+  void PaddingReceived(uint16_t seq_num);
+
+  // May be called from any thread.
+  void ClearTo(uint16_t seq_num);
+
+  // Inserts the packets pushed so far into the PacketBuffer, and blocks until
+  // that is done. Must be called from the thread that calls InsertPacket().
+  void Flush();
+
+  Stats GetStats();
+
+ private:
+  struct Entry {
+    VCMPacket packet;
+    bool is_padding = false;
+    int64_t push_time_us = 0;
+  };
+
+  bool Push(VCMPacket* packet, bool is_padding);
+  // Inserts the packets in the ring into the PacketBuffer, until the ring is
+  // empty. Runs on |task_queue_|.
+  void Drain();
+  void UpdateQueueingDelayStats();
+
+  const rtc::scoped_refptr<PacketBuffer> packet_buffer_;
+
+  // Has one more entry than the number of packets it can hold, so that a
+  // full ring can be told apart from an empty one.
+  std::vector<Entry> ring_;
+  // Index of the next entry to write. Only written by the producer.
+  volatile int write_index_ = 0;
+  // Index of the next entry to read. Only written by the task queue.
+  volatile int read_index_ = 0;
+  // 1 while a Drain() task is posted or running.
+  volatile int drain_pending_ = 0;
+  // The newest sequence number pushed so far. Only used by the producer.
+  rtc::Optional<uint16_t> newest_pushed_seq_num_;
+  volatile int num_packets_ = 0;
+  volatile int num_dropped_packets_ = 0;
+
+  // Queueing delays of the packets drained since the last call to
+  // UpdateQueueingDelayStats(), to keep |stats_crit_| off the per packet path.
+  // Only used on |task_queue_|.
+  std::vector<uint32_t> drained_delays_us_;
+  rtc::CriticalSection stats_crit_;
+  rtc::HistogramPercentileCounter queueing_delay_us_
+      RTC_GUARDED_BY(stats_crit_);
+
+  std::unique_ptr<rtc::TaskQueue> task_queue_;
+};
+
+}  // namespace video_coding
+}  // namespace webrtc
+
+#endif  // MODULES_VIDEO_CODING_PACKET_BUFFER_ASSEMBLER_H_
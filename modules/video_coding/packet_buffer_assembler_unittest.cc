@@ -0,0 +1,246 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "modules/video_coding/frame_object.h"
+#include "modules/video_coding/packet_buffer.h"
+#include "modules/video_coding/packet_buffer_assembler.h"
+#include "rtc_base/atomicops.h"
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/clock.h"
+#include "system_wrappers/include/sleep.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace video_coding {
+namespace {
+
+constexpr int kStartSize = 64;
+constexpr int kMaxSize = 2048;
+
+VCMPacket CreatePacket(uint16_t seq_num, bool first, bool last) {
+  VCMPacket packet;
+  packet.codec = kVideoCodecGeneric;
+  packet.seqNum = seq_num;
+  packet.timestamp = seq_num;
+  packet.frameType = first ? kVideoFrameKey : kVideoFrameDelta;
+  packet.is_first_packet_in_frame = first;
+  packet.markerBit = last;
+  packet.sizeBytes = 100;
+  packet.dataPtr = new uint8_t[packet.sizeBytes]();
+  return packet;
+}
+
+// Counts received frames, and keeps track of the last sequence number of the
+// last one, like a decoder would before calling ClearTo.
+class FrameCounter : public OnReceivedFrameCallback {
+ public:
+  void OnReceivedFrame(std::unique_ptr<RtpFrameObject> frame) override {
+    rtc::AtomicOps::ReleaseStore(&last_seq_num_, frame->last_seq_num());
+    rtc::AtomicOps::Increment(&num_frames_);
+    frame_received_.Set();
+  }
+
+  int num_frames() const { return rtc::AtomicOps::AcquireLoad(&num_frames_); }
+  int last_seq_num() const {
+    return rtc::AtomicOps::AcquireLoad(&last_seq_num_);
+  }
+  bool WaitForFrame() { return frame_received_.Wait(1000); }
+
+ private:
+  volatile int num_frames_ = 0;
+  volatile int last_seq_num_ = -1;
+  rtc::Event frame_received_{false, false};
+};
+
+// Blocks the task queue on the first frame until released.
+class BlockingFrameCallback : public OnReceivedFrameCallback {
+ public:
+  void OnReceivedFrame(std::unique_ptr<RtpFrameObject> frame) override {
+    frame_received_.Set();
+    release_.Wait(rtc::Event::kForever);
+  }
+
+  rtc::Event frame_received_{false, false};
+  rtc::Event release_{true, false};
+};
+
+}  // namespace
+
+TEST(PacketBufferAssemblerTest, AssemblesFramesOnTaskQueue) {
+  FrameCounter frames;
+  PacketBufferAssembler assembler(
+      PacketBuffer::Create(Clock::GetRealTimeClock(), kStartSize, kMaxSize,
+                           &frames),
+      16);
+  VCMPacket first = CreatePacket(100, true, false);
+  VCMPacket second = CreatePacket(101, false, false);
+  VCMPacket third = CreatePacket(102, false, true);
+  EXPECT_TRUE(assembler.InsertPacket(&first));
+  EXPECT_EQ(nullptr, first.dataPtr);
+  EXPECT_TRUE(assembler.InsertPacket(&second));
+  EXPECT_TRUE(assembler.InsertPacket(&third));
+
+  ASSERT_TRUE(frames.WaitForFrame());
+  EXPECT_EQ(1, frames.num_frames());
+  EXPECT_EQ(102, frames.last_seq_num());
+
+  PacketBufferAssembler::Stats stats = assembler.GetStats();
+  EXPECT_EQ(3, stats.num_packets);
+  EXPECT_EQ(0, stats.num_dropped_packets);
+  EXPECT_TRUE(stats.median_queueing_delay_us);
+  EXPECT_TRUE(stats.p99_queueing_delay_us);
+}
+
+TEST(PacketBufferAssemblerTest, ReorderedPacketCompletesFrame) {
+  FrameCounter frames;
+  rtc::scoped_refptr<PacketBuffer> packet_buffer = PacketBuffer::Create(
+      Clock::GetRealTimeClock(), kStartSize, kMaxSize, &frames);
+  PacketBufferAssembler assembler(packet_buffer, 16);
+  VCMPacket last = CreatePacket(102, false, true);
+  VCMPacket first = CreatePacket(100, true, false);
+  VCMPacket second = CreatePacket(101, false, false);
+  EXPECT_TRUE(assembler.InsertPacket(&last));
+  EXPECT_TRUE(assembler.InsertPacket(&first));
+
+  // Let the task queue drain the ring and go idle, so that it isn't still
+  // draining when the next packet is pushed.
+  assembler.Flush();
+  ASSERT_TRUE(packet_buffer->LastReceivedKeyframePacketMs());
+  EXPECT_EQ(0, frames.num_frames());
+
+  // Follows the previous packet in sequence without ending a frame, but
+  // completes the frame that |last| ends.
+  EXPECT_TRUE(assembler.InsertPacket(&second));
+
+  ASSERT_TRUE(frames.WaitForFrame());
+  EXPECT_EQ(1, frames.num_frames());
+  EXPECT_EQ(102, frames.last_seq_num());
+}
+
+TEST(PacketBufferAssemblerTest, DropsPacketsWhenRingIsFull) {
+  const size_t kRingSize = 4;
+  BlockingFrameCallback callback;
+  PacketBufferAssembler assembler(
+      PacketBuffer::Create(Clock::GetRealTimeClock(), kStartSize, kMaxSize,
+                           &callback),
+      kRingSize);
+  VCMPacket packet = CreatePacket(0, true, true);
+  EXPECT_TRUE(assembler.InsertPacket(&packet));
+  ASSERT_TRUE(callback.frame_received_.Wait(1000));
+
+  // The task queue is stuck delivering the first frame, whose packet still
+  // holds its entry in the ring.
+  for (size_t i = 1; i < kRingSize; ++i) {
+    packet = CreatePacket(i, true, true);
+    EXPECT_TRUE(assembler.InsertPacket(&packet));
+  }
+  packet = CreatePacket(kRingSize, true, true);
+  EXPECT_FALSE(assembler.InsertPacket(&packet));
+  EXPECT_EQ(nullptr, packet.dataPtr);
+  EXPECT_EQ(1, assembler.GetStats().num_dropped_packets);
+  callback.release_.Set();
+}
+
+// Inserts 20000 packets per second, in frames of ten packets, while another
+// thread clears the buffer up to the last received frame, and compares the
+// time the inserting thread spends per packet when it inserts into the
+// PacketBuffer itself and when it hands the packets to a
+// PacketBufferAssembler.
+// Disabled because it is timing dependent. Use it for benchmarking when needed.
+TEST(PacketBufferAssemblerBenchmark, DISABLED_InsertWithConcurrentClearTo) {
+  const int kPacketsPerSecond = 20000;
+  const int kPacketsPerFrame = 10;
+  const int kNumPackets = kPacketsPerSecond / 2;
+  const int kPacketsPerMs = kPacketsPerSecond / 1000;
+
+  struct ClearContext {
+    FrameCounter* frames;
+    PacketBuffer* packet_buffer;
+    PacketBufferAssembler* assembler;
+    volatile int stop;
+  };
+  auto clear_loop = [](void* obj) {
+    ClearContext* context = static_cast<ClearContext*>(obj);
+    while (!rtc::AtomicOps::AcquireLoad(&context->stop)) {
+      int seq_num = context->frames->last_seq_num();
+      if (seq_num >= 0) {
+        if (context->assembler)
+          context->assembler->ClearTo(seq_num);
+        else
+          context->packet_buffer->ClearTo(seq_num);
+      }
+      // Roughly one decoded frame per frame received.
+      SleepMs(1);
+    }
+  };
+
+  for (bool use_assembler : {false, true}) {
+    FrameCounter frames;
+    rtc::scoped_refptr<PacketBuffer> packet_buffer = PacketBuffer::Create(
+        Clock::GetRealTimeClock(), kStartSize, kMaxSize, &frames);
+    std::unique_ptr<PacketBufferAssembler> assembler;
+    if (use_assembler)
+      assembler.reset(new PacketBufferAssembler(packet_buffer, 256));
+
+    ClearContext context = {&frames, packet_buffer.get(), assembler.get(), 0};
+    rtc::PlatformThread clear_thread(clear_loop, &context, "ClearTo");
+    clear_thread.Start();
+
+    std::vector<int64_t> insert_time_ns;
+    insert_time_ns.reserve(kNumPackets);
+    for (int i = 0; i < kNumPackets; ++i) {
+      VCMPacket packet =
+          CreatePacket(static_cast<uint16_t>(i), i % kPacketsPerFrame == 0,
+                       i % kPacketsPerFrame == kPacketsPerFrame - 1);
+      const int64_t start_ns = rtc::TimeNanos();
+      if (assembler)
+        assembler->InsertPacket(&packet);
+      else
+        packet_buffer->InsertPacket(&packet);
+      insert_time_ns.push_back(rtc::TimeNanos() - start_ns);
+      if (i % kPacketsPerMs == kPacketsPerMs - 1)
+        SleepMs(1);
+    }
+
+    rtc::AtomicOps::ReleaseStore(&context.stop, 1);
+    clear_thread.Stop();
+    int dropped_packets = 0;
+    rtc::Optional<uint32_t> p99_queueing_delay_us;
+    if (assembler) {
+      PacketBufferAssembler::Stats stats = assembler->GetStats();
+      dropped_packets = stats.num_dropped_packets;
+      p99_queueing_delay_us = stats.p99_queueing_delay_us;
+      // Waits for the task queue.
+      assembler.reset();
+    }
+    EXPECT_GT(frames.num_frames(), 0);
+
+    std::sort(insert_time_ns.begin(), insert_time_ns.end());
+    RTC_LOG(LS_INFO) << (use_assembler ? "Assembler" : "PacketBuffer")
+                     << ": insert time median "
+                     << insert_time_ns[insert_time_ns.size() / 2]
+                     << " ns, p99 "
+                     << insert_time_ns[insert_time_ns.size() * 99 / 100]
+                     << " ns, max " << insert_time_ns.back() << " ns, "
+                     << frames.num_frames() << " frames, " << dropped_packets
+                     << " dropped packets, p99 queueing delay "
+                     << p99_queueing_delay_us.value_or(0) << " us.";
+  }
+}
+
+}  // namespace video_coding
+}  // namespace webrtc
@@ -38,6 +38,13 @@ class FakePacketBuffer : public PacketBuffer {
     return true;
   }
 
+  bool TakeBitstream(
+      const RtpFrameObject& frame,
+      std::vector<std::unique_ptr<uint8_t[]>>* payloads,
+      std::vector<rtc::ArrayView<const uint8_t>>* fragments) override {
+    return true;
+  }
+
   bool GetBitstream(const RtpFrameObject& frame,
                     uint8_t* destination) override {
     return true;
@@ -463,6 +463,59 @@ TEST_F(TestPacketBuffer, GetBitstreamOneFrameOnePacket) {
   EXPECT_EQ(memcmp(result, data, sizeof(bitstream_data)), 0);
 }
 
+TEST_F(TestPacketBuffer, OnePacketFrameUsesPayloadWithoutCopy) {
+  const uint8_t kData[] = "a frame in one packet";
+  uint8_t* data = new uint8_t[sizeof(kData)];
+  memcpy(data, kData, sizeof(kData));
+
+  EXPECT_TRUE(Insert(0, kKeyFrame, kFirst, kLast, sizeof(kData), data));
+
+  ASSERT_EQ(1UL, frames_from_callback_.size());
+  RtpFrameObject* frame = frames_from_callback_[0].get();
+  EXPECT_EQ(data, frame->Buffer());
+  EXPECT_EQ(sizeof(kData), frame->Length());
+  ASSERT_EQ(1UL, frame->GetBitstreamFragments().size());
+  EXPECT_EQ(data, frame->GetBitstreamFragments()[0].data());
+}
+
+TEST_F(TestPacketBuffer, BitstreamFragmentsReferencePayloads) {
+  const uint8_t kFirstData[] = {0x01, 0x02, 0x03};
+  const uint8_t kSecondData[] = {0x04, 0x05};
+  uint8_t* first = new uint8_t[sizeof(kFirstData)];
+  uint8_t* second = new uint8_t[sizeof(kSecondData)];
+  memcpy(first, kFirstData, sizeof(kFirstData));
+  memcpy(second, kSecondData, sizeof(kSecondData));
+  const uint16_t seq_num = Rand();
+
+  EXPECT_TRUE(Insert(seq_num, kKeyFrame, kFirst, kNotLast, sizeof(kFirstData),
+                     first));
+  EXPECT_TRUE(Insert(seq_num + 1, kKeyFrame, kNotFirst, kLast,
+                     sizeof(kSecondData), second));
+
+  ASSERT_EQ(1UL, frames_from_callback_.size());
+  RtpFrameObject* frame = frames_from_callback_[seq_num].get();
+  // Not copied until it has to be contiguous.
+  EXPECT_EQ(nullptr, frame->Buffer());
+  rtc::ArrayView<const rtc::ArrayView<const uint8_t>> fragments =
+      frame->GetBitstreamFragments();
+  ASSERT_EQ(2UL, fragments.size());
+  EXPECT_EQ(first, fragments[0].data());
+  EXPECT_EQ(sizeof(kFirstData), fragments[0].size());
+  EXPECT_EQ(second, fragments[1].data());
+  EXPECT_EQ(sizeof(kSecondData), fragments[1].size());
+
+  // The frame owns the payloads, so clearing the buffer doesn't affect them.
+  packet_buffer_->Clear();
+  frame->MakeBitstreamContiguous();
+  ASSERT_NE(nullptr, frame->Buffer());
+  EXPECT_EQ(sizeof(kFirstData) + sizeof(kSecondData), frame->Length());
+  EXPECT_EQ(0, memcmp(frame->Buffer(), kFirstData, sizeof(kFirstData)));
+  EXPECT_EQ(0, memcmp(frame->Buffer() + sizeof(kFirstData), kSecondData,
+                      sizeof(kSecondData)));
+  ASSERT_EQ(1UL, frame->GetBitstreamFragments().size());
+  EXPECT_EQ(frame->Buffer(), frame->GetBitstreamFragments()[0].data());
+}
+
 TEST_F(TestPacketBuffer, GetBitstreamOneFrameFullBuffer) {
   uint8_t* data_arr[kStartSize];
   uint8_t expected[kStartSize];
@@ -614,7 +667,7 @@ TEST_P(TestPacketBufferH264Parameterized, GetBitstreamBufferPadding) {
   EXPECT_EQ(frames_from_callback_[seq_num]->EncodedImage()._size,
             sizeof(data_data) + EncodedImage::kBufferPaddingBytesH264);
   EXPECT_TRUE(frames_from_callback_[seq_num]->GetBitstream(result.get()));
-  EXPECT_EQ(memcmp(result.get(), data, sizeof(data_data)), 0);
+  EXPECT_EQ(memcmp(result.get(), data_data, sizeof(data_data)), 0);
 }
 
 TEST_F(TestPacketBuffer, FreeSlotsOnFrameDestruction) {
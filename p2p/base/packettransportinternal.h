@@ -19,6 +19,7 @@
 #include "api/ortc/packettransportinterface.h"
 #include "p2p/base/port.h"
 #include "rtc_base/asyncpacketsocket.h"
+#include "rtc_base/copyonwritebuffer.h"
 #include "rtc_base/networkroute.h"
 #include "rtc_base/sigslot.h"
 #include "rtc_base/socket.h"
@@ -89,6 +90,15 @@ class PacketTransportInternal : public virtual webrtc::PacketTransportInterface,
                    int>
       SignalReadPacket;
 
+  // Signalled instead of SignalReadPacket for a packet in |buffer|, if a slot
+  // is connected. The slot may take over the buffer by moving from it rather
+  // than copying the packet, so at most one slot may be connected.
+  sigslot::signal4<PacketTransportInternal*,
+                   rtc::CopyOnWriteBuffer*,
+                   const rtc::PacketTime&,
+                   int>
+      SignalReadPacketBuffer;
+
   // Signalled each time a packet is sent on this channel.
   sigslot::signal2<PacketTransportInternal*, const rtc::SentPacket&>
       SignalSentPacket;
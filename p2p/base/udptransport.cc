@@ -28,6 +28,8 @@ UdpTransport::UdpTransport(const std::string& transport_name,
     : transport_name_(transport_name), socket_(std::move(socket)) {
   RTC_DCHECK(socket_);
   socket_->SignalReadPacket.connect(this, &UdpTransport::OnSocketReadPacket);
+  socket_->SignalReadPacketBuffer.connect(
+      this, &UdpTransport::OnSocketReadPacketBuffer);
   socket_->SignalSentPacket.connect(this, &UdpTransport::OnSocketSentPacket);
 }
 
@@ -104,6 +106,10 @@ rtc::Optional<rtc::NetworkRoute> UdpTransport::network_route() const {
 }
 
 int UdpTransport::SetOption(rtc::Socket::Option opt, int value) {
+  // Receive batching is handled by the socket itself, so pass it through.
+  if (opt == rtc::Socket::OPT_RECV_BATCH_SIZE) {
+    return socket_->SetOption(opt, value);
+  }
   return 0;
 }
 
@@ -124,6 +130,20 @@ void UdpTransport::OnSocketReadPacket(rtc::AsyncPacketSocket* socket,
   SignalReadPacket(this, data, len, packet_time, 0);
 }
 
+void UdpTransport::OnSocketReadPacketBuffer(
+    rtc::AsyncPacketSocket* socket,
+    rtc::CopyOnWriteBuffer* buffer,
+    const rtc::SocketAddress& remote_addr,
+    const rtc::PacketTime& packet_time) {
+  // No thread_checker in high frequency network function.
+  if (!SignalReadPacketBuffer.is_empty()) {
+    SignalReadPacketBuffer(this, buffer, packet_time, 0);
+  } else {
+    SignalReadPacket(this, buffer->cdata<char>(), buffer->size(), packet_time,
+                     0);
+  }
+}
+
 void UdpTransport::OnSocketSentPacket(rtc::AsyncPacketSocket* socket,
                                       const rtc::SentPacket& packet) {
   RTC_DCHECK_EQ(socket_.get(), socket);
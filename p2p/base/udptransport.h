@@ -22,6 +22,7 @@
 
 namespace rtc {
 class AsyncPacketSocket;
+class CopyOnWriteBuffer;
 struct PacketTime;
 struct SentPacket;
 class SocketAddress;
@@ -72,6 +73,10 @@ class UdpTransport : public rtc::PacketTransportInternal,
                           size_t len,
                           const rtc::SocketAddress& remote_addr,
                           const rtc::PacketTime& packet_time);
+  void OnSocketReadPacketBuffer(rtc::AsyncPacketSocket* socket,
+                                rtc::CopyOnWriteBuffer* buffer,
+                                const rtc::SocketAddress& remote_addr,
+                                const rtc::PacketTime& packet_time);
   void OnSocketSentPacket(rtc::AsyncPacketSocket* socket,
                           const rtc::SentPacket& packet);
   bool IsLocalConsistent();
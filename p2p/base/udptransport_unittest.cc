@@ -18,6 +18,7 @@
 #include "p2p/base/packettransportinternal.h"
 #include "p2p/base/udptransport.h"
 #include "rtc_base/asyncpacketsocket.h"
+#include "rtc_base/copyonwritebuffer.h"
 #include "rtc_base/gunit.h"
 #include "rtc_base/ipaddress.h"
 #include "rtc_base/socketaddress.h"
@@ -95,6 +96,17 @@ class UdpTransportTest : public testing::Test, public sigslot::has_slots<> {
       ch_packets_.push_front(std::string(data, len));
     }
 
+    void OnReadPacketBuffer(rtc::PacketTransportInternal* transport,
+                            rtc::CopyOnWriteBuffer* buffer,
+                            const rtc::PacketTime& packet_time,
+                            int flags) {
+      num_received_buffers_++;
+      ch_packets_.push_front(
+          std::string(buffer->cdata<char>(), buffer->size()));
+      // Take the buffer over, like RtpTransport does.
+      received_buffers_.push_back(std::move(*buffer));
+    }
+
     void OnSentPacket(rtc::PacketTransportInternal* transport,
                       const rtc::SentPacket&) {
       num_sig_sent_packets_++;
@@ -110,8 +122,11 @@ class UdpTransportTest : public testing::Test, public sigslot::has_slots<> {
     }
 
     std::list<std::string> ch_packets_;
+    std::vector<rtc::CopyOnWriteBuffer> received_buffers_;
     std::unique_ptr<UdpTransport> ch_;
     uint32_t num_received_packets_ = 0;   // Increases on SignalReadPacket.
+    // Increases on SignalReadPacketBuffer.
+    uint32_t num_received_buffers_ = 0;
     uint32_t num_sig_sent_packets_ = 0;   // Increases on SignalSentPacket.
     uint32_t num_sig_writable_ = 0;       // Increases on SignalWritable.
     uint32_t num_sig_ready_to_send_ = 0;  // Increases on SignalReadyToSend.
@@ -166,6 +181,28 @@ TEST_F(UdpTransportTest, SendRecvBasic) {
   TestSendRecv();
 }
 
+// With receive batching, packets are read into pooled buffers, which are
+// passed on through SignalReadPacketBuffer when it is connected.
+TEST_F(UdpTransportTest, PassesReceiveBuffersWhenBatching) {
+  uint16_t port;
+  ep2_.GetLocalPort(&port);
+  rtc::SocketAddress addr2 = rtc::SocketAddress("127.0.0.1", port);
+  EXPECT_TRUE(ep1_.ch_->SetRemoteAddress(addr2));
+  EXPECT_EQ(0, ep2_.ch_->SetOption(rtc::Socket::OPT_RECV_BATCH_SIZE, 4));
+  ep2_.ch_->SignalReadPacketBuffer.connect(&ep2_,
+                                           &Endpoint::OnReadPacketBuffer);
+
+  static const char* data = "ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890";
+  int len = static_cast<int>(strlen(data));
+  // The socket refills the slots whose buffers were taken over.
+  for (uint32_t i = 0; i < 5; ++i) {
+    EXPECT_EQ_WAIT(len, ep1_.SendData(data, len), kTimeoutMs);
+    EXPECT_TRUE_WAIT(ep2_.CheckData(data, len), kTimeoutMs);
+    EXPECT_EQ(i + 1u, ep2_.num_received_buffers_);
+  }
+  EXPECT_EQ(0u, ep2_.num_received_packets_);
+}
+
 // Test the signals and state methods used internally by causing a UdpTransport
 // to send a packet to itself.
 TEST_F(UdpTransportTest, StatusAndSignals) {
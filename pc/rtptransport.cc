@@ -10,6 +10,8 @@
 
 #include "pc/rtptransport.h"
 
+#include <utility>
+
 #include "media/base/rtputils.h"
 #include "p2p/base/p2pconstants.h"
 #include "p2p/base/packettransportinterface.h"
@@ -32,6 +34,7 @@ void RtpTransport::SetRtpPacketTransport(
   if (rtp_packet_transport_) {
     rtp_packet_transport_->SignalReadyToSend.disconnect(this);
     rtp_packet_transport_->SignalReadPacket.disconnect(this);
+    rtp_packet_transport_->SignalReadPacketBuffer.disconnect(this);
     rtp_packet_transport_->SignalNetworkRouteChanged.disconnect(this);
     rtp_packet_transport_->SignalWritableState.disconnect(this);
     rtp_packet_transport_->SignalSentPacket.disconnect(this);
@@ -43,6 +46,8 @@ void RtpTransport::SetRtpPacketTransport(
         this, &RtpTransport::OnReadyToSend);
     new_packet_transport->SignalReadPacket.connect(this,
                                                    &RtpTransport::OnReadPacket);
+    new_packet_transport->SignalReadPacketBuffer.connect(
+        this, &RtpTransport::OnReadPacketBuffer);
     new_packet_transport->SignalNetworkRouteChanged.connect(
         this, &RtpTransport::OnNetworkRouteChange);
     new_packet_transport->SignalWritableState.connect(
@@ -68,6 +73,7 @@ void RtpTransport::SetRtcpPacketTransport(
   if (rtcp_packet_transport_) {
     rtcp_packet_transport_->SignalReadyToSend.disconnect(this);
     rtcp_packet_transport_->SignalReadPacket.disconnect(this);
+    rtcp_packet_transport_->SignalReadPacketBuffer.disconnect(this);
     rtcp_packet_transport_->SignalNetworkRouteChanged.disconnect(this);
     rtcp_packet_transport_->SignalWritableState.disconnect(this);
     rtcp_packet_transport_->SignalSentPacket.disconnect(this);
@@ -79,6 +85,8 @@ void RtpTransport::SetRtcpPacketTransport(
         this, &RtpTransport::OnReadyToSend);
     new_packet_transport->SignalReadPacket.connect(this,
                                                    &RtpTransport::OnReadPacket);
+    new_packet_transport->SignalReadPacketBuffer.connect(
+        this, &RtpTransport::OnReadPacketBuffer);
     new_packet_transport->SignalNetworkRouteChanged.connect(
         this, &RtpTransport::OnNetworkRouteChange);
     new_packet_transport->SignalWritableState.connect(
@@ -235,18 +243,40 @@ void RtpTransport::OnReadPacket(rtc::PacketTransportInternal* transport,
     return;
   }
 
+  rtc::CopyOnWriteBuffer packet(data, len);
+  OnRtpOrRtcpPacket(transport, &packet, packet_time);
+}
+
+void RtpTransport::OnReadPacketBuffer(rtc::PacketTransportInternal* transport,
+                                      rtc::CopyOnWriteBuffer* buffer,
+                                      const rtc::PacketTime& packet_time,
+                                      int flags) {
+  TRACE_EVENT0("webrtc", "RtpTransport::OnReadPacketBuffer");
+
+  if (!cricket::IsRtpPacket(buffer->cdata(), buffer->size()) &&
+      !IsRtcp(buffer->cdata<char>(), static_cast<int>(buffer->size()))) {
+    return;
+  }
+
+  // Take over the buffer the packet was read into rather than copying it.
+  rtc::CopyOnWriteBuffer packet(std::move(*buffer));
+  OnRtpOrRtcpPacket(transport, &packet, packet_time);
+}
+
+void RtpTransport::OnRtpOrRtcpPacket(rtc::PacketTransportInternal* transport,
+                                     rtc::CopyOnWriteBuffer* packet,
+                                     const rtc::PacketTime& packet_time) {
   // When using RTCP multiplexing we might get RTCP packets on the RTP
   // transport. We check the RTP payload type to determine if it is RTCP.
   bool rtcp = transport == rtcp_packet_transport() ||
-              IsRtcp(data, static_cast<int>(len));
-  rtc::CopyOnWriteBuffer packet(data, len);
+              IsRtcp(packet->cdata<char>(), static_cast<int>(packet->size()));
 
-  if (!WantsPacket(rtcp, &packet)) {
+  if (!WantsPacket(rtcp, packet)) {
     return;
   }
 
   // This mutates |packet| if it is protected.
-  SignalPacketReceived(rtcp, &packet, packet_time);
+  SignalPacketReceived(rtcp, packet, packet_time);
 }
 
 bool RtpTransport::WantsPacket(bool rtcp,
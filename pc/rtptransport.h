@@ -107,6 +107,13 @@ class RtpTransport : public RtpTransportInternal {
                     size_t len,
                     const rtc::PacketTime& packet_time,
                     int flags);
+  void OnReadPacketBuffer(rtc::PacketTransportInternal* transport,
+                          rtc::CopyOnWriteBuffer* buffer,
+                          const rtc::PacketTime& packet_time,
+                          int flags);
+  void OnRtpOrRtcpPacket(rtc::PacketTransportInternal* transport,
+                         rtc::CopyOnWriteBuffer* packet,
+                         const rtc::PacketTime& packet_time);
 
   bool WantsPacket(bool rtcp, const rtc::CopyOnWriteBuffer* packet);
 
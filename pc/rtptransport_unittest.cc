@@ -14,7 +14,9 @@
 #include "p2p/base/fakepackettransport.h"
 #include "pc/rtptransport.h"
 #include "pc/rtptransporttestutil.h"
+#include "rtc_base/copyonwritebufferpool.h"
 #include "rtc_base/gunit.h"
+#include "rtc_base/logging.h"
 
 namespace webrtc {
 
@@ -326,4 +328,62 @@ TEST(RtpTransportTest, SignalHandledRtpPayloadType) {
   EXPECT_EQ(0, observer.rtcp_count());
 }
 
+// Records how many payload bytes were copied on the way from the buffer a
+// packet was received into to SignalPacketReceived.
+class CopiedBytesCounter : public sigslot::has_slots<> {
+ public:
+  explicit CopiedBytesCounter(RtpTransportInternal* transport) {
+    transport->SignalPacketReceived.connect(
+        this, &CopiedBytesCounter::OnPacketReceived);
+  }
+  void set_source(const uint8_t* source) { source_ = source; }
+  size_t bytes_copied() const { return bytes_copied_; }
+
+ private:
+  void OnPacketReceived(bool rtcp,
+                        rtc::CopyOnWriteBuffer* packet,
+                        const rtc::PacketTime&) {
+    if (packet->cdata() != source_)
+      bytes_copied_ += packet->size();
+  }
+
+  const uint8_t* source_ = nullptr;
+  size_t bytes_copied_ = 0;
+};
+
+// Feeds packets read into pooled buffers to RtpTransport, through
+// SignalReadPacket and through SignalReadPacketBuffer, and reports bytes
+// copied per packet.
+TEST(RtpTransportTest, TakesOverBufferOfReadPacketBuffer) {
+  const int kNumPackets = 100;
+  RtpTransport transport(kMuxEnabled);
+  CopiedBytesCounter counter(&transport);
+  rtc::FakePacketTransport fake_rtp("fake_rtp");
+  transport.SetRtpPacketTransport(&fake_rtp);
+  rtc::CopyOnWriteBufferPool pool(1500, 4);
+
+  for (bool pass_buffer : {false, true}) {
+    size_t bytes_copied_before = counter.bytes_copied();
+    for (int i = 0; i < kNumPackets; ++i) {
+      rtc::CopyOnWriteBuffer buffer = pool.CreateBuffer(kRtpLen);
+      memcpy(buffer.data(), kRtpData, kRtpLen);
+      counter.set_source(buffer.cdata());
+      if (pass_buffer) {
+        fake_rtp.SignalReadPacketBuffer(&fake_rtp, &buffer, rtc::PacketTime(),
+                                        0);
+      } else {
+        fake_rtp.SignalReadPacket(&fake_rtp, buffer.cdata<char>(), kRtpLen,
+                                  rtc::PacketTime(), 0);
+      }
+    }
+    size_t bytes_copied = counter.bytes_copied() - bytes_copied_before;
+    RTC_LOG(LS_INFO) << "Receive buffer " << (pass_buffer ? "" : "not ")
+                     << "passed: " << bytes_copied / kNumPackets
+                     << " bytes copied per packet.";
+    EXPECT_EQ(pass_buffer ? 0u : kNumPackets * kRtpLen, bytes_copied);
+  }
+  // Taken-over buffers go back to the pool once the packet is released.
+  EXPECT_EQ(1u, pool.num_allocated_buffers());
+}
+
 }  // namespace webrtc
@@ -10,14 +10,19 @@
 
 #include "pc/srtpsession.h"
 
+#include <algorithm>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "api/fakemetricsobserver.h"
 #include "media/base/fakertp.h"
 #include "pc/srtptestutil.h"
 #include "rtc_base/gunit.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/ptr_util.h"
 #include "rtc_base/sslstreamadapter.h"  // For rtc::SRTP_*
+#include "rtc_base/timeutils.h"
 #include "third_party/libsrtp/include/srtp.h"
 
 namespace rtc {
@@ -242,4 +247,69 @@ TEST_F(SrtpSessionTest, TestReplay) {
       s1_.ProtectRtp(rtp_packet_, rtp_len_, sizeof(rtp_packet_), &out_len));
 }
 
+// Measures packets/sec protected and unprotected, for AES-CM and AES-GCM.
+// Disabled because it only logs timings.
+class SrtpSessionThroughputTest
+    : public testing::TestWithParam<std::pair<int, std::string>> {};
+
+TEST_P(SrtpSessionThroughputTest, DISABLED_ProtectUnprotectRtp) {
+  static const uint8_t kTestKeyGcm128[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ12";
+  const int cs = GetParam().first;
+  const std::string& cs_name = GetParam().second;
+  const uint8_t* key = IsGcmCryptoSuite(cs) ? kTestKeyGcm128 : kTestKey1;
+  const int key_len = IsGcmCryptoSuite(cs) ? 28 : kTestKeyLen;
+  const size_t kNumPackets = 20000;
+  const size_t kPayloadSize = 1200;
+  const size_t kPacketSize = 12 + kPayloadSize + rtp_auth_tag_len(cs_name);
+
+  cricket::SrtpSession send_session;
+  cricket::SrtpSession recv_session;
+  ASSERT_TRUE(
+      send_session.SetSend(cs, key, key_len, kEncryptedHeaderExtensionIds));
+  ASSERT_TRUE(
+      recv_session.SetRecv(cs, key, key_len, kEncryptedHeaderExtensionIds));
+  std::vector<CopyOnWriteBuffer> packets;
+  packets.reserve(kNumPackets);
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    packets.emplace_back(kPcmuFrame, 12, kPacketSize);
+    packets.back().SetSize(12 + kPayloadSize);
+    memset(packets.back().data() + 12, 0x5a, kPayloadSize);
+    SetBE16(packets.back().data() + 2, static_cast<uint16_t>(i));
+  }
+
+  int64_t start_us = TimeMicros();
+  for (CopyOnWriteBuffer& packet : packets) {
+    int out_len = 0;
+    EXPECT_TRUE(send_session.ProtectRtp(
+        packet.data(), static_cast<int>(packet.size()),
+        static_cast<int>(packet.capacity()), &out_len));
+    packet.SetSize(out_len);
+  }
+  const int64_t protect_us = std::max<int64_t>(TimeMicros() - start_us, 1);
+
+  start_us = TimeMicros();
+  for (CopyOnWriteBuffer& packet : packets) {
+    int out_len = 0;
+    EXPECT_TRUE(recv_session.UnprotectRtp(
+        packet.data(), static_cast<int>(packet.size()), &out_len));
+    packet.SetSize(out_len);
+  }
+  const int64_t unprotect_us = std::max<int64_t>(TimeMicros() - start_us, 1);
+
+  RTC_LOG(LS_INFO) << cs_name << ": protect "
+                   << kNumPackets * kNumMicrosecsPerSec / protect_us
+                   << " packets/s, unprotect "
+                   << kNumPackets * kNumMicrosecsPerSec / unprotect_us
+                   << " packets/s.";
+}
+
+INSTANTIATE_TEST_CASE_P(
+    CipherSuites,
+    SrtpSessionThroughputTest,
+    ::testing::Values(
+        std::make_pair(SRTP_AES128_CM_SHA1_80,
+                       std::string(CS_AES_CM_128_HMAC_SHA1_80)),
+        std::make_pair(SRTP_AEAD_AES_128_GCM,
+                       std::string(CS_AEAD_AES_128_GCM))));
+
 }  // namespace rtc
@@ -10,6 +10,8 @@
 
 #include "rtc_base/asyncpacketsocket.h"
 
+#include "rtc_base/checks.h"
+
 namespace rtc {
 
 PacketTimeUpdateParams::PacketTimeUpdateParams() = default;
@@ -28,6 +30,17 @@ AsyncPacketSocket::AsyncPacketSocket() = default;
 
 AsyncPacketSocket::~AsyncPacketSocket() = default;
 
+int AsyncPacketSocket::SendToBatch(ArrayView<const PacketToSend> packets) {
+  int sent = 0;
+  for (const PacketToSend& packet : packets) {
+    RTC_DCHECK(packet.options);
+    if (SendTo(packet.data, packet.size, packet.address, *packet.options) < 0)
+      break;
+    ++sent;
+  }
+  return (sent > 0 || packets.empty()) ? sent : -1;
+}
+
 void CopySocketInformationToPacketInfo(size_t packet_size_bytes,
                                        const AsyncPacketSocket& socket_from,
                                        rtc::PacketInfo* info) {
@@ -11,7 +11,9 @@
 #ifndef RTC_BASE_ASYNCPACKETSOCKET_H_
 #define RTC_BASE_ASYNCPACKETSOCKET_H_
 
+#include "api/array_view.h"
 #include "rtc_base/constructormagic.h"
+#include "rtc_base/copyonwritebuffer.h"
 #include "rtc_base/dscp.h"
 #include "rtc_base/sigslot.h"
 #include "rtc_base/socket.h"
@@ -68,6 +70,15 @@ inline PacketTime CreatePacketTime(int64_t not_before) {
   return PacketTime(TimeMicros(), not_before);
 }
 
+// A packet to be sent by AsyncPacketSocket::SendToBatch(). |options| must be
+// non-null and stay valid for the duration of the call.
+struct PacketToSend {
+  const void* data = nullptr;
+  size_t size = 0;
+  SocketAddress address;
+  const PacketOptions* options = nullptr;
+};
+
 // Provides the ability to receive packets asynchronously. Sends are not
 // buffered since it is acceptable to drop packets under high load.
 class AsyncPacketSocket : public sigslot::has_slots<> {
@@ -94,6 +105,11 @@ class AsyncPacketSocket : public sigslot::has_slots<> {
   virtual int Send(const void *pv, size_t cb, const PacketOptions& options) = 0;
   virtual int SendTo(const void *pv, size_t cb, const SocketAddress& addr,
                      const PacketOptions& options) = 0;
+  // Sends several packets, possibly with a single system call. Returns the
+  // number of packets sent, which may be less than |packets.size()|, or -1 if
+  // the first packet could not be sent. The default implementation calls
+  // SendTo() once per packet.
+  virtual int SendToBatch(ArrayView<const PacketToSend> packets);
 
   // Close the socket.
   virtual int Close() = 0;
@@ -116,6 +132,14 @@ class AsyncPacketSocket : public sigslot::has_slots<> {
                    const SocketAddress&,
                    const PacketTime&> SignalReadPacket;
 
+  // Emitted instead of SignalReadPacket for a packet that was read into
+  // |buffer|, if a slot is connected. The slot may take over the buffer by
+  // moving from it rather than copying the packet, so at most one slot may be
+  // connected. Only emitted by sockets that read into CopyOnWriteBuffers.
+  sigslot::signal4<AsyncPacketSocket*, CopyOnWriteBuffer*,
+                   const SocketAddress&,
+                   const PacketTime&> SignalReadPacketBuffer;
+
   // Emitted each time a packet is sent.
   sigslot::signal2<AsyncPacketSocket*, const SentPacket&> SignalSentPacket;
 
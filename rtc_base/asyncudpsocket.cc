@@ -9,12 +9,18 @@
  */
 
 #include "rtc_base/asyncudpsocket.h"
+
+#include <algorithm>
+
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 
 namespace rtc {
 
 static const int BUF_SIZE = 64 * 1024;
+// Keeps each datagram slot of a receive batch at 2 KB or more, which is
+// larger than any packet sent over an Ethernet-sized MTU.
+static const size_t kMaxRecvBatchSize = 32;
 
 AsyncUDPSocket* AsyncUDPSocket::Create(
     AsyncSocket* socket,
@@ -80,6 +86,35 @@ int AsyncUDPSocket::SendTo(const void *pv, size_t cb,
   return ret;
 }
 
+int AsyncUDPSocket::SendToBatch(ArrayView<const PacketToSend> packets) {
+  int64_t send_time_ms = rtc::TimeMillis();
+  send_batch_.resize(packets.size());
+  for (size_t i = 0; i < packets.size(); ++i) {
+    send_batch_[i].data = packets[i].data;
+    send_batch_[i].size = packets[i].size;
+    send_batch_[i].address = packets[i].address;
+  }
+  size_t total_sent = 0;
+  int ret = 0;
+  while (total_sent < send_batch_.size()) {
+    ret = socket_->SendToBatch(ArrayView<const DatagramToSend>(
+        send_batch_.data() + total_sent, send_batch_.size() - total_sent));
+    if (ret <= 0)
+      break;
+    const size_t batch_end = total_sent + static_cast<size_t>(ret);
+    for (size_t i = total_sent; i < batch_end; ++i) {
+      rtc::SentPacket sent_packet(packets[i].options->packet_id, send_time_ms,
+                                  packets[i].options->info_signaled_after_sent);
+      CopySocketInformationToPacketInfo(packets[i].size, *this,
+                                        &sent_packet.info);
+      sent_packet.info.remote_socket_address = packets[i].address;
+      SignalSentPacket(this, sent_packet);
+    }
+    total_sent = batch_end;
+  }
+  return total_sent > 0 ? static_cast<int>(total_sent) : ret;
+}
+
 int AsyncUDPSocket::Close() {
   return socket_->Close();
 }
@@ -89,11 +124,27 @@ AsyncUDPSocket::State AsyncUDPSocket::GetState() const {
 }
 
 int AsyncUDPSocket::GetOption(Socket::Option opt, int* value) {
+  if (opt == Socket::OPT_RECV_BATCH_SIZE) {
+    *value = static_cast<int>(recv_batch_size_);
+    return 0;
+  }
   return socket_->GetOption(opt, value);
 }
 
 int AsyncUDPSocket::SetOption(Socket::Option opt, int value) {
-  return socket_->SetOption(opt, value);
+  if (opt == Socket::OPT_RECV_BATCH_SIZE) {
+    if (value < 1)
+      return -1;
+    recv_batch_size_ = std::min(static_cast<size_t>(value), kMaxRecvBatchSize);
+    UpdateRecvBatch();
+    return 0;
+  }
+  int ret = socket_->SetOption(opt, value);
+  if (ret == 0 && opt == Socket::OPT_UDP_GRO) {
+    recv_gro_ = (value != 0);
+    UpdateRecvBatch();
+  }
+  return ret;
 }
 
 int AsyncUDPSocket::GetError() const {
@@ -107,6 +158,11 @@ void AsyncUDPSocket::SetError(int error) {
 void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
   RTC_DCHECK(socket_.get() == socket);
 
+  if (!recv_batch_.empty()) {
+    ReadBatch();
+    return;
+  }
+
   SocketAddress remote_addr;
   int64_t timestamp;
   int len = socket_->RecvFrom(buf_, size_, &remote_addr, &timestamp);
@@ -129,6 +185,90 @@ void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
       (timestamp > -1 ? PacketTime(timestamp, 0) : CreatePacketTime(0)));
 }
 
+void AsyncUDPSocket::ReadBatch() {
+  if (recv_pool_) {
+    // Refill slots whose buffers were taken over by a consumer.
+    for (size_t i = 0; i < recv_batch_.size(); ++i) {
+      CopyOnWriteBuffer& buffer = recv_buffers_[i];
+      if (buffer.capacity() == 0) {
+        buffer = recv_pool_->CreateBuffer(recv_pool_->buffer_capacity());
+      } else {
+        buffer.SetSize(buffer.capacity());
+      }
+      recv_batch_[i].buffer = buffer.data();
+      recv_batch_[i].capacity = buffer.size();
+    }
+  }
+  int count = socket_->RecvFromBatch(recv_batch_);
+  if (count < 0) {
+    // See OnReadEvent() for why errors are only logged.
+    SocketAddress local_addr = socket_->GetLocalAddress();
+    RTC_LOG(LS_INFO) << "AsyncUDPSocket[" << local_addr.ToSensitiveString()
+                     << "] batched receive failed with error "
+                     << socket_->GetError();
+    return;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    const ReceivedDatagram& datagram = recv_batch_[i];
+    if (datagram.truncated) {
+      RTC_LOG(LS_WARNING) << "Dropping datagram from "
+                          << datagram.address.ToSensitiveString()
+                          << " larger than " << datagram.capacity
+                          << " bytes in batched receive mode.";
+      continue;
+    }
+    const PacketTime packet_time = datagram.timestamp > -1
+                                       ? PacketTime(datagram.timestamp, 0)
+                                       : CreatePacketTime(0);
+    const char* data = static_cast<const char*>(datagram.buffer);
+    if (recv_pool_) {
+      RTC_DCHECK_EQ(0u, datagram.segment_size);
+      CopyOnWriteBuffer& buffer = recv_buffers_[i];
+      buffer.SetSize(datagram.size);
+      if (!SignalReadPacketBuffer.is_empty()) {
+        SignalReadPacketBuffer(this, &buffer, datagram.address, packet_time);
+      } else {
+        SignalReadPacket(this, buffer.cdata<char>(), datagram.size,
+                         datagram.address, packet_time);
+      }
+      continue;
+    }
+    // Split datagrams coalesced by generic receive offload back up.
+    const size_t segment_size =
+        datagram.segment_size > 0 ? datagram.segment_size : datagram.size;
+    size_t offset = 0;
+    do {
+      size_t len = std::min(segment_size, datagram.size - offset);
+      SignalReadPacket(this, data + offset, len, datagram.address,
+                       packet_time);
+      offset += len;
+    } while (offset < datagram.size);
+  }
+}
+
+void AsyncUDPSocket::UpdateRecvBatch() {
+  recv_pool_.reset();
+  recv_buffers_.clear();
+  if (recv_gro_) {
+    // With generic receive offload, a single read may return up to 64 KB of
+    // coalesced datagrams, so the whole buffer is used as one slot.
+    recv_batch_.resize(1);
+    recv_batch_[0].buffer = buf_;
+    recv_batch_[0].capacity = size_;
+    return;
+  }
+  if (recv_batch_size_ <= 1) {
+    recv_batch_.clear();
+    return;
+  }
+  // Keep enough buffers around for a few batches to be in flight upstream.
+  recv_pool_.reset(new CopyOnWriteBufferPool(size_ / recv_batch_size_,
+                                             4 * recv_batch_size_));
+  recv_buffers_.resize(recv_batch_size_);
+  recv_batch_.resize(recv_batch_size_);
+}
+
 void AsyncUDPSocket::OnWriteEvent(AsyncSocket* socket) {
   SignalReadyToSend(this);
 }
@@ -12,14 +12,28 @@
 #define RTC_BASE_ASYNCUDPSOCKET_H_
 
 #include <memory>
+#include <vector>
 
 #include "rtc_base/asyncpacketsocket.h"
+#include "rtc_base/copyonwritebufferpool.h"
 #include "rtc_base/socketfactory.h"
 
 namespace rtc {
 
 // Provides the ability to receive packets asynchronously.  Sends are not
 // buffered since it is acceptable to drop packets under high load.
+//
+// Setting Socket::OPT_RECV_BATCH_SIZE to a value larger than one makes the
+// socket drain up to that many datagrams per read event, using a single
+// system call where the underlying socket supports it (see
+// Socket::RecvFromBatch()). In that mode the receive buffer is split evenly
+// between the datagrams of a batch, and larger datagrams are dropped.
+// Setting Socket::OPT_UDP_GRO also reads through RecvFromBatch(), so that
+// datagrams coalesced by the kernel are split up again before being signaled.
+//
+// In batched mode without GRO, datagrams are read straight into pooled
+// CopyOnWriteBuffers, which are handed to SignalReadPacketBuffer if it is
+// connected.
 class AsyncUDPSocket : public AsyncPacketSocket {
  public:
   // Binds |socket| and creates AsyncUDPSocket for it. Takes ownership
@@ -43,6 +57,7 @@ class AsyncUDPSocket : public AsyncPacketSocket {
              size_t cb,
              const SocketAddress& addr,
              const rtc::PacketOptions& options) override;
+  int SendToBatch(ArrayView<const PacketToSend> packets) override;
   int Close() override;
 
   State GetState() const override;
@@ -56,10 +71,22 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   void OnReadEvent(AsyncSocket* socket);
   // Called when the underlying socket is ready to send.
   void OnWriteEvent(AsyncSocket* socket);
+  // Reads up to |recv_batch_size_| datagrams in one go.
+  void ReadBatch();
+  // Lays out |recv_batch_| over |buf_| according to the batching options.
+  void UpdateRecvBatch();
 
   std::unique_ptr<AsyncSocket> socket_;
   char* buf_;
   size_t size_;
+  size_t recv_batch_size_ = 1;
+  bool recv_gro_ = false;
+  std::vector<ReceivedDatagram> recv_batch_;
+  // Per-slot receive buffers and their pool; only used in batched mode
+  // without GRO. A slot is empty after its buffer has been taken over.
+  std::unique_ptr<CopyOnWriteBufferPool> recv_pool_;
+  std::vector<CopyOnWriteBuffer> recv_buffers_;
+  std::vector<DatagramToSend> send_batch_;
 };
 
 }  // namespace rtc
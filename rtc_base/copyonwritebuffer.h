@@ -224,6 +224,14 @@ class CopyOnWriteBuffer {
   }
 
  private:
+  friend class CopyOnWriteBufferPool;
+
+  // Wraps storage handed out by CopyOnWriteBufferPool.
+  explicit CopyOnWriteBuffer(scoped_refptr<RefCountedObject<Buffer>> buffer)
+      : buffer_(std::move(buffer)) {
+    RTC_DCHECK(IsConsistent());
+  }
+
   // Create a copy of the underlying data if it is referenced from other Buffer
   // objects.
   void CloneDataIfReferenced(size_t new_capacity);
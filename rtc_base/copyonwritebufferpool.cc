@@ -0,0 +1,133 @@
+/*
+ *  Copyright 2018 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/copyonwritebufferpool.h"
+
+#include <utility>
+#include <vector>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/refcount.h"
+#include "rtc_base/refcountedobject.h"
+
+namespace rtc {
+
+// Storage for released buffers. Shared between the pool and the buffers it
+// has handed out, so that buffers can be released after the pool is gone.
+class CopyOnWriteBufferPool::FreeList : public RefCountInterface {
+ public:
+  explicit FreeList(size_t max_free_buffers)
+      : max_free_buffers_(max_free_buffers) {}
+
+  // Returns a released buffer, or null if there is none.
+  PooledBuffer* Pop();
+  void Push(PooledBuffer* buffer);
+
+  size_t num_allocated_buffers() const {
+    CritScope cs(&crit_);
+    return num_allocated_buffers_;
+  }
+  void OnBufferAllocated() {
+    CritScope cs(&crit_);
+    ++num_allocated_buffers_;
+  }
+
+ protected:
+  ~FreeList() override;
+
+ private:
+  const size_t max_free_buffers_;
+  CriticalSection crit_;
+  std::vector<PooledBuffer*> buffers_ RTC_GUARDED_BY(crit_);
+  size_t num_allocated_buffers_ RTC_GUARDED_BY(crit_) = 0;
+};
+
+// A buffer that goes back to its free list instead of being deleted when the
+// last reference to it is dropped.
+class CopyOnWriteBufferPool::PooledBuffer : public RefCountedObject<Buffer> {
+ public:
+  explicit PooledBuffer(size_t capacity)
+      : RefCountedObject<Buffer>(0, capacity) {}
+  ~PooledBuffer() override = default;
+
+  void set_free_list(scoped_refptr<FreeList> free_list) {
+    free_list_ = std::move(free_list);
+  }
+
+  RefCountReleaseStatus Release() const override {
+    const auto status = ref_count_.DecRef();
+    if (status == RefCountReleaseStatus::kDroppedLastRef) {
+      PooledBuffer* self = const_cast<PooledBuffer*>(this);
+      // Don't keep the free list alive while sitting on it, or it would
+      // never be destroyed. |free_list| may delete |self| when it goes out of
+      // scope, so nothing may touch members after Push().
+      scoped_refptr<FreeList> free_list = std::move(self->free_list_);
+      free_list->Push(self);
+    }
+    return status;
+  }
+
+ private:
+  scoped_refptr<FreeList> free_list_;
+};
+
+CopyOnWriteBufferPool::PooledBuffer* CopyOnWriteBufferPool::FreeList::Pop() {
+  CritScope cs(&crit_);
+  if (buffers_.empty())
+    return nullptr;
+  PooledBuffer* buffer = buffers_.back();
+  buffers_.pop_back();
+  return buffer;
+}
+
+void CopyOnWriteBufferPool::FreeList::Push(PooledBuffer* buffer) {
+  {
+    CritScope cs(&crit_);
+    if (buffers_.size() < max_free_buffers_) {
+      buffers_.push_back(buffer);
+      return;
+    }
+  }
+  delete buffer;
+}
+
+CopyOnWriteBufferPool::FreeList::~FreeList() {
+  for (PooledBuffer* buffer : buffers_)
+    delete buffer;
+}
+
+CopyOnWriteBufferPool::CopyOnWriteBufferPool(size_t buffer_capacity,
+                                             size_t max_free_buffers)
+    : buffer_capacity_(buffer_capacity),
+      free_list_(new RefCountedObject<FreeList>(max_free_buffers)) {
+  RTC_DCHECK_GT(buffer_capacity_, 0);
+}
+
+CopyOnWriteBufferPool::~CopyOnWriteBufferPool() = default;
+
+CopyOnWriteBuffer CopyOnWriteBufferPool::CreateBuffer(size_t size) {
+  RTC_DCHECK_LE(size, buffer_capacity_);
+  PooledBuffer* buffer = free_list_->Pop();
+  if (!buffer) {
+    buffer = new PooledBuffer(buffer_capacity_);
+    free_list_->OnBufferAllocated();
+  }
+  buffer->set_free_list(free_list_);
+  // A reused buffer keeps its previous contents; callers overwrite them.
+  buffer->SetSize(size);
+  return CopyOnWriteBuffer(scoped_refptr<RefCountedObject<Buffer>>(buffer));
+}
+
+size_t CopyOnWriteBufferPool::num_allocated_buffers() const {
+  return free_list_->num_allocated_buffers();
+}
+
+}  // namespace rtc
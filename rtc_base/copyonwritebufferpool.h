@@ -0,0 +1,54 @@
+/*
+ *  Copyright 2018 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_COPYONWRITEBUFFERPOOL_H_
+#define RTC_BASE_COPYONWRITEBUFFERPOOL_H_
+
+#include <stddef.h>
+
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/copyonwritebuffer.h"
+#include "rtc_base/scoped_ref_ptr.h"
+
+namespace rtc {
+
+// Hands out CopyOnWriteBuffers whose storage is recycled: when the last
+// CopyOnWriteBuffer referencing a pooled buffer goes away, the storage goes
+// back to the pool instead of being freed. Buffers may be released on any
+// thread, and may outlive the pool.
+class CopyOnWriteBufferPool {
+ public:
+  // Buffers are allocated with |buffer_capacity| bytes. At most
+  // |max_free_buffers| released buffers are kept for reuse.
+  CopyOnWriteBufferPool(size_t buffer_capacity, size_t max_free_buffers);
+  ~CopyOnWriteBufferPool();
+
+  // Returns a buffer of |size| bytes with uninitialized contents. |size| must
+  // not exceed buffer_capacity().
+  CopyOnWriteBuffer CreateBuffer(size_t size);
+
+  size_t buffer_capacity() const { return buffer_capacity_; }
+
+  // Number of buffers allocated since the pool was created.
+  size_t num_allocated_buffers() const;
+
+ private:
+  class FreeList;
+  class PooledBuffer;
+
+  const size_t buffer_capacity_;
+  const scoped_refptr<FreeList> free_list_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(CopyOnWriteBufferPool);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_COPYONWRITEBUFFERPOOL_H_
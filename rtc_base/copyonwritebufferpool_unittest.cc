@@ -0,0 +1,80 @@
+/*
+ *  Copyright 2018 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <vector>
+
+#include "rtc_base/copyonwritebufferpool.h"
+#include "rtc_base/gunit.h"
+
+namespace rtc {
+
+TEST(CopyOnWriteBufferPoolTest, CreatesBufferOfRequestedSize) {
+  CopyOnWriteBufferPool pool(1500, 4);
+  CopyOnWriteBuffer buffer = pool.CreateBuffer(100);
+  EXPECT_EQ(100u, buffer.size());
+  EXPECT_EQ(1500u, buffer.capacity());
+}
+
+TEST(CopyOnWriteBufferPoolTest, ReusesReleasedBuffers) {
+  CopyOnWriteBufferPool pool(1500, 4);
+  const uint8_t* data;
+  {
+    CopyOnWriteBuffer buffer = pool.CreateBuffer(10);
+    data = buffer.cdata();
+  }
+  CopyOnWriteBuffer buffer = pool.CreateBuffer(20);
+  EXPECT_EQ(data, buffer.cdata());
+  EXPECT_EQ(20u, buffer.size());
+  EXPECT_EQ(1u, pool.num_allocated_buffers());
+}
+
+TEST(CopyOnWriteBufferPoolTest, DoesNotReuseSharedBuffers) {
+  CopyOnWriteBufferPool pool(1500, 4);
+  CopyOnWriteBuffer buffer = pool.CreateBuffer(10);
+  CopyOnWriteBuffer copy = buffer;
+  buffer = CopyOnWriteBuffer();
+  CopyOnWriteBuffer other = pool.CreateBuffer(10);
+  EXPECT_NE(copy.cdata(), other.cdata());
+  EXPECT_EQ(2u, pool.num_allocated_buffers());
+}
+
+TEST(CopyOnWriteBufferPoolTest, WritingToUnsharedBufferDoesNotCopy) {
+  CopyOnWriteBufferPool pool(1500, 4);
+  CopyOnWriteBuffer buffer = pool.CreateBuffer(10);
+  const uint8_t* data = buffer.cdata();
+  buffer.data()[0] = 1;
+  buffer.SetSize(5);
+  EXPECT_EQ(data, buffer.cdata());
+}
+
+TEST(CopyOnWriteBufferPoolTest, KeepsAtMostMaxFreeBuffers) {
+  CopyOnWriteBufferPool pool(1500, 2);
+  std::vector<CopyOnWriteBuffer> buffers;
+  for (int i = 0; i < 4; ++i)
+    buffers.push_back(pool.CreateBuffer(10));
+  buffers.clear();
+  for (int i = 0; i < 4; ++i)
+    buffers.push_back(pool.CreateBuffer(10));
+  EXPECT_EQ(6u, pool.num_allocated_buffers());
+}
+
+TEST(CopyOnWriteBufferPoolTest, BuffersMayOutlivePool) {
+  std::unique_ptr<CopyOnWriteBufferPool> pool(
+      new CopyOnWriteBufferPool(1500, 4));
+  CopyOnWriteBuffer released = pool->CreateBuffer(10);
+  CopyOnWriteBuffer outstanding = pool->CreateBuffer(10);
+  released = CopyOnWriteBuffer();
+  pool.reset();
+  outstanding.data()[0] = 1;
+  EXPECT_EQ(10u, outstanding.size());
+}
+
+}  // namespace rtc
@@ -69,6 +69,19 @@ typedef void* SockOptArg;
 
 #endif  // WEBRTC_POSIX
 
+#if defined(WEBRTC_USE_MMSG)
+// Until these are integrated from linux/udp.h to netinet/udp.h.
+#if !defined(SOL_UDP)
+#define SOL_UDP 17
+#endif
+#if !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+#if !defined(UDP_GRO)
+#define UDP_GRO 104
+#endif
+#endif  // WEBRTC_USE_MMSG
+
 #if defined(WEBRTC_POSIX) && !defined(WEBRTC_MAC) && !defined(__native_client__)
 
 int64_t GetSocketRecvTimestamp(int socket) {
@@ -143,6 +156,15 @@ static const int ICMP_HEADER_SIZE = 8u;
 static const int ICMP_PING_TIMEOUT_MILLIS = 10000u;
 #endif
 
+#if defined(WEBRTC_USE_MMSG)
+// Upper bound on the number of datagrams handled by one recvmmsg/sendmmsg.
+static const size_t kMaxDatagramBatchSize = 64;
+// Limits of one UDP segmentation offload send: the kernel accepts at most 64
+// segments, and the coalesced payload must fit in a single UDP datagram.
+static const size_t kMaxGsoSegments = 64;
+static const size_t kMaxGsoPayloadSize = 65000;
+#endif
+
 PhysicalSocket::PhysicalSocket(PhysicalSocketServer* ss, SOCKET s)
   : ss_(ss), s_(s), error_(0),
     state_((s == INVALID_SOCKET) ? CS_CLOSED : CS_CONNECTED),
@@ -319,6 +341,12 @@ AsyncSocket::ConnState PhysicalSocket::GetState() const {
 }
 
 int PhysicalSocket::GetOption(Option opt, int* value) {
+#if defined(WEBRTC_USE_MMSG)
+  if (opt == OPT_UDP_GSO) {
+    *value = udp_gso_ ? 1 : 0;
+    return 0;
+  }
+#endif
   int slevel;
   int sopt;
   if (TranslateOption(opt, &slevel, &sopt) == -1)
@@ -343,7 +371,28 @@ int PhysicalSocket::SetOption(Option opt, int value) {
     value = (value) ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT;
 #endif
   }
+#if defined(WEBRTC_USE_MMSG)
+  if (opt == OPT_UDP_GSO) {
+    // There is nothing to set; just check that the kernel knows about
+    // UDP_SEGMENT before using it on sends.
+    int segment_size = 0;
+    socklen_t optlen = sizeof(segment_size);
+    if (value && ::getsockopt(s_, slevel, sopt, (SockOptArg)&segment_size,
+                              &optlen) != 0) {
+      UpdateLastError();
+      return -1;
+    }
+    udp_gso_ = (value != 0);
+    return 0;
+  }
+  int ret = ::setsockopt(s_, slevel, sopt, (SockOptArg)&value, sizeof(value));
+  if (ret == 0 && opt == OPT_UDP_GRO) {
+    udp_gro_ = (value != 0);
+  }
+  return ret;
+#else
   return ::setsockopt(s_, slevel, sopt, (SockOptArg)&value, sizeof(value));
+#endif
 }
 
 int PhysicalSocket::Send(const void* pv, size_t cb) {
@@ -432,7 +481,7 @@ int PhysicalSocket::RecvFrom(void* buffer,
   sockaddr_storage addr_storage;
   socklen_t addr_len = sizeof(addr_storage);
   sockaddr* addr = reinterpret_cast<sockaddr*>(&addr_storage);
-  int received = ::recvfrom(s_, static_cast<char*>(buffer),
+  int received = DoRecvFrom(s_, static_cast<char*>(buffer),
                             static_cast<int>(length), 0, addr, &addr_len);
   if (timestamp) {
     *timestamp = GetSocketRecvTimestamp(s_);
@@ -451,6 +500,154 @@ int PhysicalSocket::RecvFrom(void* buffer,
   return received;
 }
 
+#if defined(WEBRTC_USE_MMSG)
+
+int PhysicalSocket::RecvFromBatch(ArrayView<ReceivedDatagram> datagrams) {
+  if (datagrams.empty())
+    return 0;
+  const size_t count = std::min(datagrams.size(), kMaxDatagramBatchSize);
+  struct mmsghdr msgs[kMaxDatagramBatchSize];
+  struct iovec iovs[kMaxDatagramBatchSize];
+  sockaddr_storage addrs[kMaxDatagramBatchSize];
+  // Receives the segment size of datagrams coalesced by UDP_GRO.
+  union {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+  } controls[kMaxDatagramBatchSize];
+  memset(msgs, 0, count * sizeof(msgs[0]));
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = datagrams[i].buffer;
+    iovs[i].iov_len = datagrams[i].capacity;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    if (udp_gro_) {
+      msgs[i].msg_hdr.msg_control = controls[i].buf;
+      msgs[i].msg_hdr.msg_controllen = sizeof(controls[i].buf);
+    }
+  }
+  // MSG_WAITFORONE makes the call return as soon as the socket queue is
+  // drained, once at least one datagram has been read.
+  int received = DoRecvMmsg(s_, msgs, static_cast<unsigned int>(count),
+                            MSG_WAITFORONE);
+  UpdateLastError();
+  for (int i = 0; i < received; ++i) {
+    ReceivedDatagram& datagram = datagrams[i];
+    datagram.size = msgs[i].msg_len;
+    datagram.truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    // The SIOCGSTAMP ioctl only reports the time of the last datagram, so
+    // per-datagram timestamps are not available in batched mode.
+    datagram.timestamp = -1;
+    datagram.segment_size = 0;
+    SocketAddressFromSockAddrStorage(addrs[i], &datagram.address);
+    if (!udp_gro_)
+      continue;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg;
+         cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+        int segment_size;
+        memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+        if (segment_size > 0 &&
+            static_cast<size_t>(segment_size) < datagram.size) {
+          datagram.segment_size = segment_size;
+        }
+      }
+    }
+  }
+  int error = GetError();
+  bool success = (received >= 0) || IsBlockingError(error);
+  if (udp_ || success) {
+    EnableEvents(DE_READ);
+  }
+  if (!success) {
+    RTC_LOG_F(LS_VERBOSE) << "Error = " << error;
+  }
+  return received;
+}
+
+int PhysicalSocket::SendToBatch(ArrayView<const DatagramToSend> datagrams) {
+  if (datagrams.empty())
+    return 0;
+  const size_t count = std::min(datagrams.size(), kMaxDatagramBatchSize);
+  struct mmsghdr msgs[kMaxDatagramBatchSize];
+  struct iovec iovs[kMaxDatagramBatchSize];
+  sockaddr_storage addrs[kMaxDatagramBatchSize];
+  union {
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+    struct cmsghdr align;
+  } controls[kMaxDatagramBatchSize];
+  // Index of the first datagram carried by each message.
+  size_t first_datagram[kMaxDatagramBatchSize + 1];
+  memset(msgs, 0, count * sizeof(msgs[0]));
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = const_cast<void*>(datagrams[i].data);
+    iovs[i].iov_len = datagrams[i].size;
+  }
+
+  // Without segmentation offload, every datagram is a message of its own.
+  // With it, runs of datagrams to the same address that share a size (the
+  // last one may be shorter) are gathered into one message, which the kernel
+  // or the NIC splits up again.
+  size_t num_msgs = 0;
+  size_t i = 0;
+  while (i < count) {
+    const size_t first = i;
+    const size_t segment_size = datagrams[first].size;
+    size_t payload_size = segment_size;
+    ++i;
+    while (udp_gso_ && i < count && segment_size > 0 &&
+           i - first < kMaxGsoSegments &&
+           datagrams[i].size <= segment_size &&
+           payload_size + datagrams[i].size <= kMaxGsoPayloadSize &&
+           datagrams[i].address == datagrams[first].address) {
+      payload_size += datagrams[i].size;
+      ++i;
+      if (datagrams[i - 1].size < segment_size)
+        break;
+    }
+    struct msghdr& hdr = msgs[num_msgs].msg_hdr;
+    hdr.msg_iov = &iovs[first];
+    hdr.msg_iovlen = i - first;
+    hdr.msg_name = &addrs[num_msgs];
+    hdr.msg_namelen = static_cast<socklen_t>(
+        datagrams[first].address.ToSockAddrStorage(&addrs[num_msgs]));
+    if (i - first > 1) {
+      hdr.msg_control = controls[num_msgs].buf;
+      hdr.msg_controllen = sizeof(controls[num_msgs].buf);
+      struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      uint16_t gso_size = static_cast<uint16_t>(segment_size);
+      memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+    }
+    first_datagram[num_msgs] = first;
+    ++num_msgs;
+  }
+  first_datagram[num_msgs] = count;
+
+  // Suppress SIGPIPE. See PhysicalSocket::Send() for explanation.
+  int sent = DoSendMmsg(s_, msgs, static_cast<unsigned int>(num_msgs),
+                        MSG_NOSIGNAL);
+  UpdateLastError();
+  if (sent < 0 && udp_gso_ && GetError() == EIO) {
+    // The egress device can't checksum offloaded segments; stop using
+    // segmentation offload and try again without it.
+    RTC_LOG(LS_WARNING) << "UDP segmentation offload failed; disabling it.";
+    udp_gso_ = false;
+    return SendToBatch(datagrams);
+  }
+  MaybeRemapSendError();
+  if ((sent >= 0 && sent < static_cast<int>(num_msgs)) ||
+      (sent < 0 && IsBlockingError(GetError()))) {
+    EnableEvents(DE_WRITE);
+  }
+  return sent > 0 ? static_cast<int>(first_datagram[sent]) : sent;
+}
+
+#endif  // WEBRTC_USE_MMSG
+
 int PhysicalSocket::Listen(int backlog) {
   int err = ::listen(s_, backlog);
   UpdateLastError();
@@ -515,6 +712,31 @@ int PhysicalSocket::DoSendTo(SOCKET socket,
   return ::sendto(socket, buf, len, flags, dest_addr, addrlen);
 }
 
+int PhysicalSocket::DoRecvFrom(SOCKET socket,
+                               char* buf,
+                               int len,
+                               int flags,
+                               struct sockaddr* src_addr,
+                               socklen_t* addrlen) {
+  return ::recvfrom(socket, buf, len, flags, src_addr, addrlen);
+}
+
+#if defined(WEBRTC_USE_MMSG)
+int PhysicalSocket::DoRecvMmsg(SOCKET socket,
+                               struct mmsghdr* msgs,
+                               unsigned int vlen,
+                               int flags) {
+  return ::recvmmsg(socket, msgs, vlen, flags, nullptr);
+}
+
+int PhysicalSocket::DoSendMmsg(SOCKET socket,
+                               struct mmsghdr* msgs,
+                               unsigned int vlen,
+                               int flags) {
+  return ::sendmmsg(socket, msgs, vlen, flags);
+}
+#endif  // WEBRTC_USE_MMSG
+
 void PhysicalSocket::OnResolveResult(AsyncResolverInterface* resolver) {
   if (resolver != resolver_) {
     return;
@@ -593,7 +815,26 @@ int PhysicalSocket::TranslateOption(Option opt, int* slevel, int* sopt) {
       RTC_LOG(LS_WARNING) << "Socket::OPT_DSCP not supported.";
       return -1;
     case OPT_RTP_SENDTIME_EXTN_ID:
+    case OPT_RECV_BATCH_SIZE:
       return -1;  // No logging is necessary as this not a OS socket option.
+    case OPT_UDP_GSO:
+#if defined(WEBRTC_USE_MMSG)
+      *slevel = SOL_UDP;
+      *sopt = UDP_SEGMENT;
+      break;
+#else
+      RTC_LOG(LS_WARNING) << "Socket::OPT_UDP_GSO not supported.";
+      return -1;
+#endif
+    case OPT_UDP_GRO:
+#if defined(WEBRTC_USE_MMSG)
+      *slevel = SOL_UDP;
+      *sopt = UDP_GRO;
+      break;
+#else
+      RTC_LOG(LS_WARNING) << "Socket::OPT_UDP_GRO not supported.";
+      return -1;
+#endif
     default:
       RTC_NOTREACHED();
       return -1;
@@ -16,6 +16,11 @@
 #define WEBRTC_USE_EPOLL 1
 #endif
 
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+// recvmmsg/sendmmsg are used for batched datagram I/O.
+#define WEBRTC_USE_MMSG 1
+#endif
+
 #include <memory>
 #include <set>
 #include <vector>
@@ -167,6 +172,11 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
                SocketAddress* out_addr,
                int64_t* timestamp) override;
 
+#if defined(WEBRTC_USE_MMSG)
+  int RecvFromBatch(ArrayView<ReceivedDatagram> datagrams) override;
+  int SendToBatch(ArrayView<const DatagramToSend> datagrams) override;
+#endif
+
   int Listen(int backlog) override;
   AsyncSocket* Accept(SocketAddress* out_addr) override;
 
@@ -187,6 +197,18 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
   virtual int DoSendTo(SOCKET socket, const char* buf, int len, int flags,
                        const struct sockaddr* dest_addr, socklen_t addrlen);
 
+  // Make virtual so ::recvfrom can be overwritten in tests.
+  virtual int DoRecvFrom(SOCKET socket, char* buf, int len, int flags,
+                         struct sockaddr* src_addr, socklen_t* addrlen);
+
+#if defined(WEBRTC_USE_MMSG)
+  // Make virtual so ::recvmmsg and ::sendmmsg can be overwritten in tests.
+  virtual int DoRecvMmsg(SOCKET socket, struct mmsghdr* msgs,
+                         unsigned int vlen, int flags);
+  virtual int DoSendMmsg(SOCKET socket, struct mmsghdr* msgs,
+                         unsigned int vlen, int flags);
+#endif
+
   void OnResolveResult(AsyncResolverInterface* resolver);
 
   void UpdateLastError();
@@ -202,6 +224,11 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
   PhysicalSocketServer* ss_;
   SOCKET s_;
   bool udp_;
+#if defined(WEBRTC_USE_MMSG)
+  // Set through OPT_UDP_GSO and OPT_UDP_GRO.
+  bool udp_gso_ = false;
+  bool udp_gro_ = false;
+#endif
   CriticalSection crit_;
   int error_ RTC_GUARDED_BY(crit_);
   ConnState state_;
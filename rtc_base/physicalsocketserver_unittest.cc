@@ -8,9 +8,11 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
 #include <memory>
 #include <signal.h>
 #include <stdarg.h>
+#include <vector>
 
 #include "rtc_base/gunit.h"
 #include "rtc_base/logging.h"
@@ -19,6 +21,7 @@
 #include "rtc_base/socket_unittest.h"
 #include "rtc_base/testutils.h"
 #include "rtc_base/thread.h"
+#include "rtc_base/timeutils.h"
 
 namespace rtc {
 
@@ -51,6 +54,14 @@ class FakeSocketDispatcher : public SocketDispatcher {
   int DoSend(SOCKET socket, const char* buf, int len, int flags) override;
   int DoSendTo(SOCKET socket, const char* buf, int len, int flags,
                const struct sockaddr* dest_addr, socklen_t addrlen) override;
+  int DoRecvFrom(SOCKET socket, char* buf, int len, int flags,
+                 struct sockaddr* src_addr, socklen_t* addrlen) override;
+#if defined(WEBRTC_USE_MMSG)
+  int DoRecvMmsg(SOCKET socket, struct mmsghdr* msgs, unsigned int vlen,
+                 int flags) override;
+  int DoSendMmsg(SOCKET socket, struct mmsghdr* msgs, unsigned int vlen,
+                 int flags) override;
+#endif
 };
 
 class FakePhysicalSocketServer : public PhysicalSocketServer {
@@ -118,6 +129,10 @@ class PhysicalSocketTest : public SocketTest {
   void SetMaxSendSize(int max_size) { max_send_size_ = max_size; }
   int MaxSendSize() const { return max_send_size_; }
 
+  // Number of send and receive system calls made on datagram sockets.
+  void CountSendCall() { ++num_send_calls_; }
+  void CountRecvCall() { ++num_recv_calls_; }
+
  protected:
   PhysicalSocketTest()
     : server_(new FakePhysicalSocketServer(this)),
@@ -127,11 +142,18 @@ class PhysicalSocketTest : public SocketTest {
 
   void ConnectInternalAcceptError(const IPAddress& loopback);
   void WritableAfterPartialWrite(const IPAddress& loopback);
+  void UdpBatch(const IPAddress& loopback);
+  void UdpSegmentationOffload(const IPAddress& loopback);
+  void UdpLoopbackThroughput(const IPAddress& loopback,
+                             bool batched,
+                             bool offload);
 
   std::unique_ptr<FakePhysicalSocketServer> server_;
   rtc::AutoSocketServerThread thread_;
   bool fail_accept_;
   int max_send_size_;
+  int num_send_calls_ = 0;
+  int num_recv_calls_ = 0;
 };
 
 SOCKET FakeSocketDispatcher::DoAccept(SOCKET socket,
@@ -165,10 +187,38 @@ int FakeSocketDispatcher::DoSendTo(SOCKET socket, const char* buf, int len,
     len = std::min(len, ss->GetTest()->MaxSendSize());
   }
 
+  ss->GetTest()->CountSendCall();
   return SocketDispatcher::DoSendTo(socket, buf, len, flags, dest_addr,
       addrlen);
 }
 
+int FakeSocketDispatcher::DoRecvFrom(SOCKET socket, char* buf, int len,
+    int flags, struct sockaddr* src_addr, socklen_t* addrlen) {
+  FakePhysicalSocketServer* ss =
+      static_cast<FakePhysicalSocketServer*>(socketserver());
+  ss->GetTest()->CountRecvCall();
+  return SocketDispatcher::DoRecvFrom(socket, buf, len, flags, src_addr,
+      addrlen);
+}
+
+#if defined(WEBRTC_USE_MMSG)
+int FakeSocketDispatcher::DoRecvMmsg(SOCKET socket, struct mmsghdr* msgs,
+    unsigned int vlen, int flags) {
+  FakePhysicalSocketServer* ss =
+      static_cast<FakePhysicalSocketServer*>(socketserver());
+  ss->GetTest()->CountRecvCall();
+  return SocketDispatcher::DoRecvMmsg(socket, msgs, vlen, flags);
+}
+
+int FakeSocketDispatcher::DoSendMmsg(SOCKET socket, struct mmsghdr* msgs,
+    unsigned int vlen, int flags) {
+  FakePhysicalSocketServer* ss =
+      static_cast<FakePhysicalSocketServer*>(socketserver());
+  ss->GetTest()->CountSendCall();
+  return SocketDispatcher::DoSendMmsg(socket, msgs, vlen, flags);
+}
+#endif
+
 TEST_F(PhysicalSocketTest, TestConnectIPv4) {
   MAYBE_SKIP_IPV4;
   SocketTest::TestConnectIPv4();
@@ -434,6 +484,228 @@ TEST_F(PhysicalSocketTest, MAYBE_TestUdpReadyToSendIPv6) {
   SocketTest::TestUdpReadyToSendIPv6();
 }
 
+void PhysicalSocketTest::UdpBatch(const IPAddress& loopback) {
+  const size_t kNumPackets = 8;
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(loopback, 0)));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(loopback, 0)));
+
+  char payloads[kNumPackets][16];
+  DatagramToSend outgoing[kNumPackets];
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    memset(payloads[i], static_cast<int>('a' + i), sizeof(payloads[i]));
+    outgoing[i].data = payloads[i];
+    outgoing[i].size = i + 1;
+    outgoing[i].address = receiver->GetLocalAddress();
+  }
+  num_send_calls_ = 0;
+  EXPECT_EQ(static_cast<int>(kNumPackets), sender->SendToBatch(outgoing));
+
+  char buffers[kNumPackets + 1][32];
+  ReceivedDatagram incoming[kNumPackets + 1];
+  for (size_t i = 0; i < kNumPackets + 1; ++i) {
+    incoming[i].buffer = buffers[i];
+    incoming[i].capacity = sizeof(buffers[i]);
+  }
+  num_recv_calls_ = 0;
+  // Asking for more datagrams than are queued must not block.
+  EXPECT_EQ(static_cast<int>(kNumPackets), receiver->RecvFromBatch(incoming));
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(i + 1, incoming[i].size);
+    EXPECT_FALSE(incoming[i].truncated);
+    EXPECT_EQ(0, memcmp(payloads[i], buffers[i], incoming[i].size));
+    EXPECT_EQ(sender->GetLocalAddress(), incoming[i].address);
+  }
+#if defined(WEBRTC_USE_MMSG)
+  EXPECT_EQ(1, num_send_calls_);
+  EXPECT_EQ(1, num_recv_calls_);
+#endif
+
+  EXPECT_EQ(-1, receiver->RecvFromBatch(incoming));
+  EXPECT_TRUE(receiver->IsBlocking());
+}
+
+TEST_F(PhysicalSocketTest, TestUdpBatchIPv4) {
+  MAYBE_SKIP_IPV4;
+  UdpBatch(kIPv4Loopback);
+}
+
+TEST_F(PhysicalSocketTest, TestUdpBatchIPv6) {
+  MAYBE_SKIP_IPV6;
+  UdpBatch(kIPv6Loopback);
+}
+
+#if defined(WEBRTC_USE_MMSG)
+void PhysicalSocketTest::UdpSegmentationOffload(const IPAddress& loopback) {
+  const size_t kSegmentSize = 1000;
+  const size_t kNumPackets = 17;
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(loopback, 0)));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(loopback, 0)));
+  if (sender->SetOption(Socket::OPT_UDP_GSO, 1) != 0 ||
+      receiver->SetOption(Socket::OPT_UDP_GRO, 1) != 0) {
+    RTC_LOG(LS_INFO) << "No UDP segmentation offload... skipping";
+    return;
+  }
+  int value = 0;
+  EXPECT_EQ(0, sender->GetOption(Socket::OPT_UDP_GSO, &value));
+  EXPECT_EQ(1, value);
+
+  // All packets but the last one share a size, so one message carries them.
+  std::vector<char> payload(kNumPackets * kSegmentSize);
+  DatagramToSend outgoing[kNumPackets];
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    memset(&payload[i * kSegmentSize], static_cast<int>(i), kSegmentSize);
+    outgoing[i].data = &payload[i * kSegmentSize];
+    outgoing[i].size = (i == kNumPackets - 1) ? kSegmentSize / 2
+                                              : kSegmentSize;
+    outgoing[i].address = receiver->GetLocalAddress();
+  }
+  num_send_calls_ = 0;
+  EXPECT_EQ(static_cast<int>(kNumPackets), sender->SendToBatch(outgoing));
+  EXPECT_EQ(1, num_send_calls_);
+
+  // The receiver may get the packets coalesced or one by one.
+  std::vector<char> buffer(64 * 1024);
+  ReceivedDatagram incoming[1];
+  incoming[0].buffer = buffer.data();
+  incoming[0].capacity = buffer.size();
+  size_t num_received = 0;
+  while (num_received < kNumPackets &&
+         receiver->RecvFromBatch(incoming) == 1) {
+    const size_t segment_size = incoming[0].segment_size > 0
+                                    ? incoming[0].segment_size
+                                    : incoming[0].size;
+    for (size_t offset = 0; offset < incoming[0].size;
+         offset += segment_size) {
+      size_t len = std::min(segment_size, incoming[0].size - offset);
+      EXPECT_EQ(outgoing[num_received].size, len);
+      EXPECT_EQ(0, memcmp(outgoing[num_received].data, &buffer[offset], len));
+      ++num_received;
+    }
+  }
+  EXPECT_EQ(kNumPackets, num_received);
+}
+
+TEST_F(PhysicalSocketTest, TestUdpSegmentationOffloadIPv4) {
+  MAYBE_SKIP_IPV4;
+  UdpSegmentationOffload(kIPv4Loopback);
+}
+
+TEST_F(PhysicalSocketTest, TestUdpSegmentationOffloadIPv6) {
+  MAYBE_SKIP_IPV6;
+  UdpSegmentationOffload(kIPv6Loopback);
+}
+#endif
+
+// Pushes packets through a loopback socket pair and reports packets per
+// second and system calls per packet, with and without batching and
+// segmentation offload.
+void PhysicalSocketTest::UdpLoopbackThroughput(const IPAddress& loopback,
+                                               bool batched,
+                                               bool offload) {
+  const size_t kBatchSize = 32;
+  const size_t kNumBatches = 500;
+  const size_t kPacketSize = 1200;
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(loopback, 0)));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(loopback, 0)));
+  const SocketAddress destination = receiver->GetLocalAddress();
+  if (offload && (sender->SetOption(Socket::OPT_UDP_GSO, 1) != 0 ||
+                  receiver->SetOption(Socket::OPT_UDP_GRO, 1) != 0)) {
+    RTC_LOG(LS_INFO) << "No UDP segmentation offload... skipping";
+    return;
+  }
+
+  std::vector<char> payload(kPacketSize, 'x');
+  // Coalesced reads need room for a full-sized UDP datagram.
+  const size_t slot_size = offload ? 64 * 1024 : kPacketSize;
+  std::vector<char> buffers(kBatchSize * slot_size);
+  DatagramToSend outgoing[kBatchSize];
+  ReceivedDatagram incoming[kBatchSize];
+  for (size_t i = 0; i < kBatchSize; ++i) {
+    outgoing[i].data = payload.data();
+    outgoing[i].size = payload.size();
+    outgoing[i].address = destination;
+    incoming[i].buffer = &buffers[i * slot_size];
+    incoming[i].capacity = slot_size;
+  }
+
+  num_send_calls_ = 0;
+  num_recv_calls_ = 0;
+  size_t num_received = 0;
+  int64_t start_us = TimeMicros();
+  for (size_t batch = 0; batch < kNumBatches; ++batch) {
+    size_t received_in_batch = 0;
+    if (batched) {
+      ASSERT_EQ(static_cast<int>(kBatchSize), sender->SendToBatch(outgoing));
+      while (received_in_batch < kBatchSize) {
+        int ret = receiver->RecvFromBatch(incoming);
+        if (ret < 0)
+          break;
+        for (int i = 0; i < ret; ++i) {
+          received_in_batch +=
+              incoming[i].segment_size > 0
+                  ? (incoming[i].size + incoming[i].segment_size - 1) /
+                        incoming[i].segment_size
+                  : 1;
+        }
+      }
+    } else {
+      for (size_t i = 0; i < kBatchSize; ++i) {
+        ASSERT_EQ(static_cast<int>(kPacketSize),
+                  sender->SendTo(payload.data(), payload.size(), destination));
+      }
+      while (received_in_batch < kBatchSize &&
+             receiver->RecvFrom(buffers.data(), kPacketSize, nullptr,
+                                nullptr) >= 0) {
+        ++received_in_batch;
+      }
+    }
+    num_received += received_in_batch;
+  }
+  int64_t elapsed_us = std::max<int64_t>(TimeMicros() - start_us, 1);
+
+  const size_t num_sent = kBatchSize * kNumBatches;
+  EXPECT_EQ(num_sent, num_received);
+  RTC_LOG(LS_INFO) << (batched ? "Batched" : "Unbatched")
+                   << (offload ? " offloaded" : "") << " UDP loopback: "
+                   << num_received * kNumMicrosecsPerSec / elapsed_us
+                   << " packets/s, "
+                   << static_cast<double>(num_send_calls_) / num_sent
+                   << " send syscalls/packet, "
+                   << static_cast<double>(num_recv_calls_) /
+                          std::max<size_t>(num_received, 1)
+                   << " recv syscalls/packet.";
+}
+
+// The throughput tests are disabled because they only log timings.
+TEST_F(PhysicalSocketTest, DISABLED_UdpLoopbackThroughputUnbatchedIPv4) {
+  MAYBE_SKIP_IPV4;
+  UdpLoopbackThroughput(kIPv4Loopback, false, false);
+}
+
+TEST_F(PhysicalSocketTest, DISABLED_UdpLoopbackThroughputBatchedIPv4) {
+  MAYBE_SKIP_IPV4;
+  UdpLoopbackThroughput(kIPv4Loopback, true, false);
+}
+
+#if defined(WEBRTC_USE_MMSG)
+TEST_F(PhysicalSocketTest, DISABLED_UdpLoopbackThroughputOffloadedIPv4) {
+  MAYBE_SKIP_IPV4;
+  UdpLoopbackThroughput(kIPv4Loopback, true, true);
+}
+#endif
+
 TEST_F(PhysicalSocketTest, TestGetSetOptionsIPv4) {
   MAYBE_SKIP_IPV4;
   SocketTest::TestGetSetOptionsIPv4();
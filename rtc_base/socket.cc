@@ -24,4 +24,29 @@ SentPacket::SentPacket(int packet_id,
                        const rtc::PacketInfo& info)
     : packet_id(packet_id), send_time_ms(send_time_ms), info(info) {}
 
+int Socket::RecvFromBatch(ArrayView<ReceivedDatagram> datagrams) {
+  int received = 0;
+  for (ReceivedDatagram& datagram : datagrams) {
+    int len = RecvFrom(datagram.buffer, datagram.capacity, &datagram.address,
+                       &datagram.timestamp);
+    if (len < 0)
+      break;
+    datagram.size = static_cast<size_t>(len);
+    datagram.truncated = false;
+    datagram.segment_size = 0;
+    ++received;
+  }
+  return (received > 0 || datagrams.empty()) ? received : SOCKET_ERROR;
+}
+
+int Socket::SendToBatch(ArrayView<const DatagramToSend> datagrams) {
+  int sent = 0;
+  for (const DatagramToSend& datagram : datagrams) {
+    if (SendTo(datagram.data, datagram.size, datagram.address) < 0)
+      break;
+    ++sent;
+  }
+  return (sent > 0 || datagrams.empty()) ? sent : SOCKET_ERROR;
+}
+
 }  // namespace rtc
@@ -25,6 +25,7 @@
 #include "rtc_base/win32.h"
 #endif
 
+#include "api/array_view.h"
 #include "api/optional.h"
 #include "rtc_base/basictypes.h"
 #include "rtc_base/constructormagic.h"
@@ -166,6 +167,29 @@ struct SentPacket {
   rtc::PacketInfo info;
 };
 
+// A datagram to be filled in by Socket::RecvFromBatch(). |buffer| and
+// |capacity| are provided by the caller; the remaining fields are outputs.
+struct ReceivedDatagram {
+  void* buffer = nullptr;
+  size_t capacity = 0;
+  size_t size = 0;
+  // Set if the datagram was larger than |capacity| and has been cut short.
+  bool truncated = false;
+  // If non-zero, |buffer| holds several datagrams of this size coalesced by
+  // UDP generic receive offload; the last one may be shorter.
+  size_t segment_size = 0;
+  SocketAddress address;
+  // Receive time in microseconds, or -1 if not available.
+  int64_t timestamp = -1;
+};
+
+// A datagram to be sent by Socket::SendToBatch().
+struct DatagramToSend {
+  const void* data = nullptr;
+  size_t size = 0;
+  SocketAddress address;
+};
+
 // General interface for the socket implementations of various networks.  The
 // methods match those of normal UNIX sockets very closely.
 class Socket {
@@ -190,6 +214,13 @@ class Socket {
                        size_t cb,
                        SocketAddress* paddr,
                        int64_t* timestamp) = 0;
+  // Batched versions of RecvFrom() and SendTo(), intended for datagram
+  // sockets. Both return the number of datagrams received or sent, which may
+  // be less than |datagrams.size()|, or SOCKET_ERROR if the first one failed.
+  // The default implementations make one RecvFrom()/SendTo() call per
+  // datagram; implementations that can do better should override them.
+  virtual int RecvFromBatch(ArrayView<ReceivedDatagram> datagrams);
+  virtual int SendToBatch(ArrayView<const DatagramToSend> datagrams);
   virtual int Listen(int backlog) = 0;
   virtual Socket *Accept(SocketAddress *paddr) = 0;
   virtual int Close() = 0;
@@ -214,6 +245,13 @@ class Socket {
     OPT_RTP_SENDTIME_EXTN_ID,  // This is a non-traditional socket option param.
                                // This is specific to libjingle and will be used
                                // if SendTime option is needed at socket level.
+    OPT_RECV_BATCH_SIZE,  // Maximum number of datagrams an AsyncUDPSocket
+                          // reads per read event. Not an OS socket option.
+    OPT_UDP_GSO,  // Whether SendToBatch() may coalesce same-size datagrams
+                  // to one destination using UDP segmentation offload.
+    OPT_UDP_GRO,  // Whether the kernel may coalesce received datagrams
+                  // (UDP generic receive offload). Coalesced datagrams are
+                  // only reported correctly by RecvFromBatch().
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
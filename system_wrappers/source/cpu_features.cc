@@ -37,6 +37,15 @@ static inline void __cpuid(int cpu_info[4], int info_type) {
         "=d"(cpu_info[3])
       : "a"(info_type));
 }
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile(
+      "mov %%ebx, %%edi\n"
+      "cpuid\n"
+      "xchg %%edi, %%ebx\n"
+      : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]),
+        "=d"(cpu_info[3])
+      : "a"(info_type), "c"(sub_type));
+}
 #else
 static inline void __cpuid(int cpu_info[4], int info_type) {
   __asm__ volatile("cpuid\n"
@@ -44,7 +53,19 @@ static inline void __cpuid(int cpu_info[4], int info_type) {
                      "=d"(cpu_info[3])
                    : "a"(info_type));
 }
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile("cpuid\n"
+                   : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]),
+                     "=d"(cpu_info[3])
+                   : "a"(info_type), "c"(sub_type));
+}
 #endif
+// Reads the XCR0 register, which tells which register states the OS saves.
+static inline uint64_t _xgetbv(uint32_t xcr) {
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(xcr));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
 #endif  // _MSC_VER
 #endif  // WEBRTC_ARCH_X86_FAMILY
 
@@ -59,6 +80,21 @@ static int GetCPUInfo(CPUFeature feature) {
   if (feature == kSSE3) {
     return 0 != (cpu_info[2] & 0x00000001);
   }
+  if (feature == kAVX2 || feature == kFMA3) {
+    // AVX2 and FMA3 also need the OS to save the YMM registers (OSXSAVE and
+    // XCR0).
+    const bool has_osxsave = 0 != (cpu_info[2] & 0x08000000);
+    const bool has_avx = 0 != (cpu_info[2] & 0x10000000);
+    if (!has_osxsave || !has_avx || (_xgetbv(0) & 0x6) != 0x6) {
+      return 0;
+    }
+    if (feature == kFMA3) {
+      return 0 != (cpu_info[2] & 0x00001000);
+    }
+    int cpu_info7[4];
+    __cpuidex(cpu_info7, 7, 0);
+    return 0 != (cpu_info7[1] & 0x00000020);
+  }
   return 0;
 }
 #else
@@ -46,6 +46,9 @@ namespace {
 //                 crbug.com/752886
 constexpr int kPacketBufferStartSize = 512;
 constexpr int kPacketBufferMaxSixe = 2048;
+// Number of packets that can wait for the packet assembly task queue, 12.8 ms
+// worth at 20000 packets per second.
+constexpr size_t kPacketAssemblyRingSize = 256;
 }
 
 std::unique_ptr<RtpRtcp> CreateRtpRtcpModule(
@@ -154,6 +157,10 @@ RtpVideoStreamReceiver::RtpVideoStreamReceiver(
   packet_buffer_ = video_coding::PacketBuffer::Create(
       clock_, kPacketBufferStartSize, kPacketBufferMaxSixe, this);
   reference_finder_.reset(new video_coding::RtpFrameReferenceFinder(this));
+  if (field_trial::IsEnabled("WebRTC-Video-PacketAssemblyQueue")) {
+    packet_assembler_.reset(new video_coding::PacketBufferAssembler(
+        packet_buffer_, kPacketAssemblyRingSize));
+  }
 }
 
 RtpVideoStreamReceiver::~RtpVideoStreamReceiver() {
@@ -167,6 +174,8 @@ RtpVideoStreamReceiver::~RtpVideoStreamReceiver() {
 
   packet_router_->RemoveReceiveRtpModule(rtp_rtcp_.get());
   UpdateHistograms();
+  // Stop delivering frames before the members they are delivered to go away.
+  packet_assembler_.reset();
 }
 
 bool RtpVideoStreamReceiver::AddReceiveCodec(
@@ -239,7 +248,10 @@ int32_t RtpVideoStreamReceiver::OnReceivedPayloadData(
     packet.dataPtr = data;
   }
 
-  packet_buffer_->InsertPacket(&packet);
+  if (packet_assembler_)
+    packet_assembler_->InsertPacket(&packet);
+  else
+    packet_buffer_->InsertPacket(&packet);
   return 0;
 }
 
@@ -436,7 +448,10 @@ void RtpVideoStreamReceiver::ParseAndHandleEncapsulatingHeader(
 // correctly calculate frame references.
 void RtpVideoStreamReceiver::NotifyReceiverOfEmptyPacket(uint16_t seq_num) {
   reference_finder_->PaddingReceived(seq_num);
-  packet_buffer_->PaddingReceived(seq_num);
+  if (packet_assembler_)
+    packet_assembler_->PaddingReceived(seq_num);
+  else
+    packet_buffer_->PaddingReceived(seq_num);
 }
 
 void RtpVideoStreamReceiver::NotifyReceiverOfFecPacket(
@@ -512,7 +527,10 @@ void RtpVideoStreamReceiver::FrameDecoded(int64_t picture_id) {
     }
   }
   if (seq_num != -1) {
-    packet_buffer_->ClearTo(seq_num);
+    if (packet_assembler_)
+      packet_assembler_->ClearTo(seq_num);
+    else
+      packet_buffer_->ClearTo(seq_num);
     reference_finder_->ClearTo(seq_num);
   }
 }
@@ -561,6 +579,28 @@ bool RtpVideoStreamReceiver::IsPacketRetransmitted(const RTPHeader& header,
 }
 
 void RtpVideoStreamReceiver::UpdateHistograms() {
+  if (packet_assembler_) {
+    video_coding::PacketBufferAssembler::Stats stats =
+        packet_assembler_->GetStats();
+    // Packets dropped because the ring to the assembly task queue was full.
+    if (stats.num_packets > 0) {
+      RTC_HISTOGRAM_PERCENTAGE(
+          "WebRTC.Video.PacketAssembly.RingFullDropsInPercent",
+          static_cast<int>(static_cast<int64_t>(stats.num_dropped_packets) *
+                           100 / stats.num_packets));
+    }
+    if (stats.median_queueing_delay_us) {
+      RTC_HISTOGRAM_COUNTS_10000(
+          "WebRTC.Video.PacketAssembly.MedianQueueingDelayUs",
+          *stats.median_queueing_delay_us);
+    }
+    if (stats.p99_queueing_delay_us) {
+      RTC_HISTOGRAM_COUNTS_100000(
+          "WebRTC.Video.PacketAssembly.P99QueueingDelayUs",
+          *stats.p99_queueing_delay_us);
+    }
+  }
+
   FecPacketCounter counter = ulpfec_receiver_->GetPacketCounter();
   if (counter.first_packet_time_ms == -1)
     return;
@@ -29,6 +29,7 @@
 #include "modules/video_coding/h264_sps_pps_tracker.h"
 #include "modules/video_coding/include/video_coding_defines.h"
 #include "modules/video_coding/packet_buffer.h"
+#include "modules/video_coding/packet_buffer_assembler.h"
 #include "modules/video_coding/rtp_frame_reference_finder.h"
 #include "rtc_base/constructormagic.h"
 #include "rtc_base/criticalsection.h"
@@ -187,6 +188,10 @@ class RtpVideoStreamReceiver : public RtpData,
   std::unique_ptr<NackModule> nack_module_;
   rtc::scoped_refptr<video_coding::PacketBuffer> packet_buffer_;
   std::unique_ptr<video_coding::RtpFrameReferenceFinder> reference_finder_;
+  // Set if packets are handed over to a task queue of their own to be
+  // assembled into frames, instead of being inserted into |packet_buffer_| on
+  // the network thread.
+  std::unique_ptr<video_coding::PacketBufferAssembler> packet_assembler_;
   rtc::CriticalSection last_seq_num_cs_;
   std::map<int64_t, uint16_t> last_seq_num_for_pic_id_
       RTC_GUARDED_BY(last_seq_num_cs_);
@@ -0,0 +1,209 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "video/shared_decode_executor.h"
+
+#include <string>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+
+namespace webrtc {
+
+// A decode thread and the streams assigned to it.
+class SharedDecodeExecutor::Worker {
+ public:
+  Worker(Clock* clock, const std::string& thread_name)
+      : clock_(clock),
+        wake_up_(false, false),
+        thread_(&Run, this, thread_name.c_str(), rtc::kHighestPriority) {
+    thread_.Start();
+  }
+
+  ~Worker() {
+    {
+      rtc::CritScope lock(&crit_);
+      RTC_DCHECK(entries_.empty());
+      stopped_ = true;
+    }
+    wake_up_.Set();
+    thread_.Stop();
+  }
+
+  size_t num_streams() const {
+    rtc::CritScope lock(&crit_);
+    return entries_.size();
+  }
+
+  void AddStream(Stream* stream) {
+    rtc::CritScope lock(&crit_);
+    RTC_DCHECK(entries_.find(stream) == entries_.end());
+    Schedule(stream, &entries_[stream], clock_->TimeInMilliseconds());
+  }
+
+  void RemoveStream(Stream* stream) {
+    {
+      rtc::CritScope lock(&crit_);
+      auto it = entries_.find(stream);
+      RTC_DCHECK(it != entries_.end());
+      if (it->second.scheduled)
+        queue_.erase(it->second.queue_it);
+      entries_.erase(it);
+    }
+    // Streams only run with |run_crit_| held, so once it is acquired here
+    // |stream| has returned and won't run again.
+    rtc::CritScope lock(&run_crit_);
+  }
+
+  void WakeUp(Stream* stream) {
+    rtc::CritScope lock(&crit_);
+    auto it = entries_.find(stream);
+    if (it == entries_.end())
+      return;
+    Entry& entry = it->second;
+    if (!entry.scheduled) {
+      // Running, reschedule it right away once it returns.
+      entry.woken = true;
+      return;
+    }
+    const int64_t now_ms = clock_->TimeInMilliseconds();
+    if (entry.queue_it->first <= now_ms)
+      return;
+    queue_.erase(entry.queue_it);
+    Schedule(stream, &entry, now_ms);
+  }
+
+ private:
+  struct Entry {
+    // False while the stream is running.
+    bool scheduled = false;
+    // Set if the stream was woken up while it was running.
+    bool woken = false;
+    std::multimap<int64_t, Stream*>::iterator queue_it;
+  };
+
+  static void Run(void* obj) {
+    while (static_cast<Worker*>(obj)->Process()) {
+    }
+  }
+
+  // Runs the stream that has been due for the longest, if any, or else waits
+  // until the next stream is due. Returns false when the worker is stopped.
+  bool Process() {
+    int64_t wait_ms = rtc::Event::kForever;
+    {
+      rtc::CritScope run_lock(&run_crit_);
+      Stream* stream = nullptr;
+      {
+        rtc::CritScope lock(&crit_);
+        if (stopped_)
+          return false;
+        if (!queue_.empty()) {
+          const int64_t now_ms = clock_->TimeInMilliseconds();
+          if (queue_.begin()->first <= now_ms) {
+            stream = queue_.begin()->second;
+            queue_.erase(queue_.begin());
+            entries_[stream].scheduled = false;
+          } else {
+            wait_ms = queue_.begin()->first - now_ms;
+          }
+        }
+      }
+
+      if (stream) {
+        int64_t run_at_ms = stream->DecodeNextFrame();
+        rtc::CritScope lock(&crit_);
+        auto it = entries_.find(stream);
+        // Streams that are removed while they run are not rescheduled.
+        if (it != entries_.end()) {
+          if (it->second.woken)
+            run_at_ms = clock_->TimeInMilliseconds();
+          Schedule(stream, &it->second, run_at_ms);
+        }
+        return true;
+      }
+    }
+    wake_up_.Wait(static_cast<int>(wait_ms));
+    return true;
+  }
+
+  void Schedule(Stream* stream, Entry* entry, int64_t run_at_ms)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_) {
+    entry->scheduled = true;
+    entry->woken = false;
+    entry->queue_it = queue_.emplace(run_at_ms, stream);
+    // The thread may be waiting for a stream that is due later.
+    if (entry->queue_it == queue_.begin())
+      wake_up_.Set();
+  }
+
+  Clock* const clock_;
+  rtc::Event wake_up_;
+  rtc::PlatformThread thread_;
+
+  // Held while a stream runs.
+  rtc::CriticalSection run_crit_;
+
+  rtc::CriticalSection crit_;
+  bool stopped_ RTC_GUARDED_BY(crit_) = false;
+  std::map<Stream*, Entry> entries_ RTC_GUARDED_BY(crit_);
+  // The streams that aren't running, by the time they want to run at.
+  std::multimap<int64_t, Stream*> queue_ RTC_GUARDED_BY(crit_);
+};
+
+SharedDecodeExecutor::SharedDecodeExecutor(Clock* clock, int num_threads) {
+  RTC_DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(
+        new Worker(clock, "SharedDecodingThread" + std::to_string(i)));
+  }
+}
+
+SharedDecodeExecutor::~SharedDecodeExecutor() {
+  RTC_DCHECK(stream_workers_.empty());
+}
+
+void SharedDecodeExecutor::AddStream(Stream* stream) {
+  rtc::CritScope lock(&crit_);
+  RTC_DCHECK(stream_workers_.find(stream) == stream_workers_.end());
+  // Streams stay on the same thread, so spread them evenly when they're
+  // added.
+  Worker* worker = workers_[0].get();
+  for (const auto& candidate : workers_) {
+    if (candidate->num_streams() < worker->num_streams())
+      worker = candidate.get();
+  }
+  stream_workers_[stream] = worker;
+  worker->AddStream(stream);
+}
+
+void SharedDecodeExecutor::RemoveStream(Stream* stream) {
+  Worker* worker;
+  {
+    rtc::CritScope lock(&crit_);
+    auto it = stream_workers_.find(stream);
+    RTC_DCHECK(it != stream_workers_.end());
+    worker = it->second;
+    stream_workers_.erase(it);
+  }
+  // Not holding |crit_|, so that other streams can be woken up while this
+  // waits for |stream| to return.
+  worker->RemoveStream(stream);
+}
+
+void SharedDecodeExecutor::WakeUp(Stream* stream) {
+  rtc::CritScope lock(&crit_);
+  auto it = stream_workers_.find(stream);
+  if (it != stream_workers_.end())
+    it->second->WakeUp(stream);
+}
+
+}  // namespace webrtc
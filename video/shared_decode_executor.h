@@ -0,0 +1,69 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VIDEO_SHARED_DECODE_EXECUTOR_H_
+#define VIDEO_SHARED_DECODE_EXECUTOR_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/thread_annotations.h"
+#include "system_wrappers/include/clock.h"
+
+namespace webrtc {
+
+// Decodes the frames of many video receive streams on a fixed number of
+// threads, instead of on a thread per stream. Each stream is assigned to one
+// of the threads when it is added, so that its frames are decoded in order
+// and its decoder is always called on the same thread. A thread runs its
+// streams in order of the time they asked to run at, which for a receive
+// stream is when its next frame should be decoded according to its
+// VCMTiming, so the stream that is the most behind goes first.
+class SharedDecodeExecutor {
+ public:
+  class Stream {
+   public:
+    // Decodes the next frame if it is due. Returns the time, in milliseconds,
+    // at which the stream wants to run again unless it is woken up before.
+    virtual int64_t DecodeNextFrame() = 0;
+
+   protected:
+    virtual ~Stream() {}
+  };
+
+  SharedDecodeExecutor(Clock* clock, int num_threads);
+  ~SharedDecodeExecutor();
+
+  // Starts running |stream|, as soon as possible. |stream| must be removed
+  // before it is destroyed.
+  void AddStream(Stream* stream);
+
+  // Stops running |stream|. If |stream| is running, waits for it to return.
+  // Must not be called from DecodeNextFrame().
+  void RemoveStream(Stream* stream);
+
+  // Runs |stream| as soon as possible, e.g. when it has received a frame.
+  // Does nothing if |stream| isn't added.
+  void WakeUp(Stream* stream);
+
+ private:
+  class Worker;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  rtc::CriticalSection crit_;
+  std::map<Stream*, Worker*> stream_workers_ RTC_GUARDED_BY(crit_);
+};
+
+}  // namespace webrtc
+
+#endif  // VIDEO_SHARED_DECODE_EXECUTOR_H_
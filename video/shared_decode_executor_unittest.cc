@@ -0,0 +1,294 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "video/shared_decode_executor.h"
+
+#include <memory>
+#include <vector>
+
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/clock.h"
+#include "system_wrappers/include/cpu_info.h"
+#include "system_wrappers/include/sleep.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kTimeoutMs = 1000;
+constexpr int64_t kStartTimeMs = 1000;
+
+// Records its runs. Asks to run again at |run_at_ms| the first time, and then
+// only when woken up.
+class FakeStream : public SharedDecodeExecutor::Stream {
+ public:
+  FakeStream(int id,
+             int64_t run_at_ms,
+             rtc::CriticalSection* crit,
+             std::vector<int>* runs)
+      : id_(id), run_at_ms_(run_at_ms), crit_(crit), runs_(runs) {}
+
+  int64_t DecodeNextFrame() override {
+    {
+      rtc::CritScope lock(crit_);
+      runs_->push_back(id_);
+    }
+    ran_.Set();
+    int64_t run_at_ms = run_at_ms_;
+    run_at_ms_ = kNeverMs;
+    return run_at_ms;
+  }
+
+  bool WaitForRun() { return ran_.Wait(kTimeoutMs); }
+
+ private:
+  static constexpr int64_t kNeverMs = 1000000;
+
+  const int id_;
+  int64_t run_at_ms_;
+  rtc::CriticalSection* const crit_;
+  std::vector<int>* const runs_;
+  rtc::Event ran_{false, false};
+};
+
+// Decodes a frame every |frame_interval_ms|, busy waiting for
+// |decode_time_us| to simulate the decoder.
+class FakeDecodingStream : public SharedDecodeExecutor::Stream {
+ public:
+  static constexpr int64_t kMaxLateMs = 10;
+
+  FakeDecodingStream(Clock* clock,
+                     int64_t first_frame_ms,
+                     int64_t frame_interval_ms,
+                     int64_t decode_time_us)
+      : clock_(clock),
+        frame_interval_ms_(frame_interval_ms),
+        decode_time_us_(decode_time_us),
+        next_frame_ms_(first_frame_ms) {}
+
+  int64_t DecodeNextFrame() override {
+    if (clock_->TimeInMilliseconds() < next_frame_ms_)
+      return next_frame_ms_;
+    if (clock_->TimeInMilliseconds() > next_frame_ms_ + kMaxLateMs)
+      ++num_late_frames_;
+    ++num_decoded_frames_;
+    const int64_t decoded_us = rtc::TimeMicros() + decode_time_us_;
+    while (rtc::TimeMicros() < decoded_us) {
+    }
+    next_frame_ms_ += frame_interval_ms_;
+    return next_frame_ms_;
+  }
+
+  int num_decoded_frames() const { return num_decoded_frames_; }
+  int num_late_frames() const { return num_late_frames_; }
+
+ private:
+  Clock* const clock_;
+  const int64_t frame_interval_ms_;
+  const int64_t decode_time_us_;
+  int64_t next_frame_ms_;
+  int num_decoded_frames_ = 0;
+  int num_late_frames_ = 0;
+};
+
+constexpr int64_t FakeDecodingStream::kMaxLateMs;
+
+// Runs a stream on a thread of its own, like VideoReceiveStream does without
+// a SharedDecodeExecutor.
+class DecodeThread {
+ public:
+  DecodeThread(Clock* clock, SharedDecodeExecutor::Stream* stream)
+      : clock_(clock),
+        stream_(stream),
+        thread_(&Run, this, "DecodingThread", rtc::kHighestPriority) {
+    thread_.Start();
+  }
+
+  ~DecodeThread() {
+    stopped_ = true;
+    stop_.Set();
+    thread_.Stop();
+  }
+
+ private:
+  static void Run(void* obj) {
+    DecodeThread* decode_thread = static_cast<DecodeThread*>(obj);
+    while (!decode_thread->stopped_) {
+      int64_t wait_ms = decode_thread->stream_->DecodeNextFrame() -
+                        decode_thread->clock_->TimeInMilliseconds();
+      if (wait_ms > 0)
+        decode_thread->stop_.Wait(static_cast<int>(wait_ms));
+    }
+  }
+
+  Clock* const clock_;
+  SharedDecodeExecutor::Stream* const stream_;
+  volatile bool stopped_ = false;
+  rtc::Event stop_{false, false};
+  rtc::PlatformThread thread_;
+};
+
+}  // namespace
+
+TEST(SharedDecodeExecutorTest, RunsAddedStream) {
+  SimulatedClock clock(kStartTimeMs * 1000);
+  SharedDecodeExecutor executor(&clock, 2);
+  rtc::CriticalSection crit;
+  std::vector<int> runs;
+  FakeStream stream(1, kStartTimeMs + 1000, &crit, &runs);
+
+  executor.AddStream(&stream);
+  EXPECT_TRUE(stream.WaitForRun());
+  executor.RemoveStream(&stream);
+
+  rtc::CritScope lock(&crit);
+  EXPECT_EQ(std::vector<int>({1}), runs);
+}
+
+TEST(SharedDecodeExecutorTest, RunsStreamWhenDue) {
+  SimulatedClock clock(kStartTimeMs * 1000);
+  SharedDecodeExecutor executor(&clock, 1);
+  rtc::CriticalSection crit;
+  std::vector<int> runs;
+  FakeStream stream(1, kStartTimeMs + 10, &crit, &runs);
+
+  executor.AddStream(&stream);
+  EXPECT_TRUE(stream.WaitForRun());
+  clock.AdvanceTimeMilliseconds(10);
+  EXPECT_TRUE(stream.WaitForRun());
+  executor.RemoveStream(&stream);
+}
+
+TEST(SharedDecodeExecutorTest, WakeUpRunsStream) {
+  SimulatedClock clock(kStartTimeMs * 1000);
+  SharedDecodeExecutor executor(&clock, 1);
+  rtc::CriticalSection crit;
+  std::vector<int> runs;
+  FakeStream stream(1, 100000, &crit, &runs);
+
+  executor.AddStream(&stream);
+  EXPECT_TRUE(stream.WaitForRun());
+  executor.WakeUp(&stream);
+  EXPECT_TRUE(stream.WaitForRun());
+  executor.RemoveStream(&stream);
+
+  rtc::CritScope lock(&crit);
+  EXPECT_EQ(2u, runs.size());
+}
+
+TEST(SharedDecodeExecutorTest, RunsDueStreamsInOrderOfDeadline) {
+  SimulatedClock clock(kStartTimeMs * 1000);
+  SharedDecodeExecutor executor(&clock, 1);
+  rtc::CriticalSection crit;
+  std::vector<int> runs;
+  FakeStream stream1(1, kStartTimeMs + 5, &crit, &runs);
+  FakeStream stream2(2, kStartTimeMs + 2, &crit, &runs);
+  FakeStream stream3(3, kStartTimeMs + 8, &crit, &runs);
+
+  executor.AddStream(&stream1);
+  executor.AddStream(&stream2);
+  executor.AddStream(&stream3);
+  EXPECT_TRUE(stream1.WaitForRun());
+  EXPECT_TRUE(stream2.WaitForRun());
+  EXPECT_TRUE(stream3.WaitForRun());
+
+  // All streams become due at once.
+  clock.AdvanceTimeMilliseconds(10);
+  EXPECT_TRUE(stream1.WaitForRun());
+  EXPECT_TRUE(stream2.WaitForRun());
+  EXPECT_TRUE(stream3.WaitForRun());
+  executor.RemoveStream(&stream1);
+  executor.RemoveStream(&stream2);
+  executor.RemoveStream(&stream3);
+
+  rtc::CritScope lock(&crit);
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 2, 1, 3}), runs);
+}
+
+TEST(SharedDecodeExecutorTest, RemoveStreamWaitsForRunningStream) {
+  class SlowStream : public SharedDecodeExecutor::Stream {
+   public:
+    int64_t DecodeNextFrame() override {
+      started.Set();
+      SleepMs(50);
+      returned = true;
+      return 100000;
+    }
+
+    rtc::Event started{false, false};
+    volatile bool returned = false;
+  };
+
+  SharedDecodeExecutor executor(Clock::GetRealTimeClock(), 1);
+  SlowStream stream;
+  executor.AddStream(&stream);
+  ASSERT_TRUE(stream.started.Wait(kTimeoutMs));
+  executor.RemoveStream(&stream);
+  EXPECT_TRUE(stream.returned);
+}
+
+// Many streams at 30 fps, decoded either on a thread per stream or on an
+// executor with a thread per core.
+// Disabled because it takes too long to run routinely, and only logs timings.
+TEST(SharedDecodeExecutorTest, DISABLED_ManyStreamsBenchmark) {
+  const int kNumStreams = 200;
+  const int kFrameIntervalMs = 1000 / 30;
+  const int kDecodeTimeUs = 100;
+  const int kDurationMs = 1000;
+  const int num_cores = CpuInfo::DetectNumberOfCores();
+  Clock* clock = Clock::GetRealTimeClock();
+
+  for (bool shared : {false, true}) {
+    std::vector<std::unique_ptr<FakeDecodingStream>> streams;
+    const int64_t start_ms = clock->TimeInMilliseconds();
+    for (int i = 0; i < kNumStreams; ++i) {
+      streams.emplace_back(new FakeDecodingStream(
+          clock, start_ms + i * kFrameIntervalMs / kNumStreams,
+          kFrameIntervalMs, kDecodeTimeUs));
+    }
+
+    if (shared) {
+      SharedDecodeExecutor executor(clock, num_cores);
+      for (const auto& stream : streams)
+        executor.AddStream(stream.get());
+      SleepMs(kDurationMs);
+      for (const auto& stream : streams)
+        executor.RemoveStream(stream.get());
+    } else {
+      std::vector<std::unique_ptr<DecodeThread>> threads;
+      for (const auto& stream : streams)
+        threads.emplace_back(new DecodeThread(clock, stream.get()));
+      SleepMs(kDurationMs);
+      threads.clear();
+    }
+
+    const int64_t elapsed_ms = clock->TimeInMilliseconds() - start_ms;
+    int num_decoded_frames = 0;
+    int num_late_frames = 0;
+    for (const auto& stream : streams) {
+      num_decoded_frames += stream->num_decoded_frames();
+      num_late_frames += stream->num_late_frames();
+    }
+    EXPECT_GT(num_decoded_frames, 0);
+    RTC_LOG(LS_INFO) << (shared ? "Shared executor with " : "Thread per stream")
+                     << (shared ? std::to_string(num_cores) + " threads" : "")
+                     << ": " << num_decoded_frames * 1000 / elapsed_ms
+                     << " frames/s, "
+                     << num_late_frames * 100.0 / num_decoded_frames
+                     << "% more than " << FakeDecodingStream::kMaxLateMs
+                     << " ms late.";
+  }
+}
+
+}  // namespace webrtc
@@ -12,6 +12,7 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <utility>
@@ -44,6 +45,9 @@
 namespace webrtc {
 
 namespace {
+constexpr int kMaxWaitForFrameMs = 3000;
+constexpr int kMaxWaitForKeyFrameMs = 200;
+
 VideoCodec CreateDecoderVideoCodec(const VideoReceiveStream::Decoder& decoder) {
   VideoCodec codec;
   memset(&codec, 0, sizeof(codec));
@@ -85,7 +89,8 @@ VideoReceiveStream::VideoReceiveStream(
     PacketRouter* packet_router,
     VideoReceiveStream::Config config,
     ProcessThread* process_thread,
-    CallStats* call_stats)
+    CallStats* call_stats,
+    SharedDecodeExecutor* decode_executor)
     : transport_adapter_(config.rtcp_send_transport),
       config_(std::move(config)),
       num_cpu_cores_(num_cpu_cores),
@@ -95,6 +100,7 @@ VideoReceiveStream::VideoReceiveStream(
                      this,
                      "DecodingThread",
                      rtc::kHighestPriority),
+      decode_executor_(decode_executor),
       call_stats_(call_stats),
       rtp_receive_statistics_(ReceiveStatistics::Create(clock_)),
       timing_(new VCMTiming(clock_)),
@@ -173,7 +179,7 @@ void VideoReceiveStream::SetSync(Syncable* audio_syncable) {
 
 void VideoReceiveStream::Start() {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&worker_sequence_checker_);
-  if (decode_thread_.IsRunning())
+  if (decode_thread_.IsRunning() || decoding_on_executor_)
     return;
 
   bool protected_by_fec = config_.rtp.protected_by_flexfec ||
@@ -224,7 +230,13 @@ void VideoReceiveStream::Start() {
   // Start the decode thread
   video_receiver_.DecoderThreadStarting();
   stats_proxy_.DecoderThreadStarting();
-  decode_thread_.Start();
+  if (decode_executor_) {
+    frame_timeout_ms_ = clock_->TimeInMilliseconds() + kMaxWaitForKeyFrameMs;
+    decoding_on_executor_ = true;
+    decode_executor_->AddStream(this);
+  } else {
+    decode_thread_.Start();
+  }
   rtp_video_stream_receiver_.StartReceive();
 }
 
@@ -239,13 +251,18 @@ void VideoReceiveStream::Stop() {
   call_stats_->DeregisterStatsObserver(this);
   process_thread_->DeRegisterModule(&video_receiver_);
 
-  if (decode_thread_.IsRunning()) {
+  if (decode_thread_.IsRunning() || decoding_on_executor_) {
     // TriggerDecoderShutdown will release any waiting decoder thread and make
     // it stop immediately, instead of waiting for a timeout. Needs to be called
     // before joining the decoder thread.
     video_receiver_.TriggerDecoderShutdown();
 
-    decode_thread_.Stop();
+    if (decoding_on_executor_) {
+      decode_executor_->RemoveStream(this);
+      decoding_on_executor_ = false;
+    } else {
+      decode_thread_.Stop();
+    }
     video_receiver_.DecoderThreadStopped();
     stats_proxy_.DecoderThreadStopped();
     // Deregister external decoders so they are no longer running during
@@ -357,6 +374,8 @@ void VideoReceiveStream::OnCompleteFrame(
   int64_t last_continuous_pid = frame_buffer_->InsertFrame(std::move(frame));
   if (last_continuous_pid != -1)
     rtp_video_stream_receiver_.FrameContinuous(last_continuous_pid);
+  if (decode_executor_)
+    decode_executor_->WakeUp(this);
 }
 
 void VideoReceiveStream::OnRttUpdate(int64_t avg_rtt_ms, int64_t max_rtt_ms) {
@@ -413,9 +432,6 @@ void VideoReceiveStream::DecodeThreadFunction(void* ptr) {
 
 bool VideoReceiveStream::Decode() {
   TRACE_EVENT0("webrtc", "VideoReceiveStream::Decode");
-  static const int kMaxWaitForFrameMs = 3000;
-  static const int kMaxWaitForKeyFrameMs = 200;
-
   int wait_ms = keyframe_required_ ? kMaxWaitForKeyFrameMs : kMaxWaitForFrameMs;
   std::unique_ptr<video_coding::EncodedFrame> frame;
   // TODO(philipel): Call NextFrame with |keyframe_required| argument when
@@ -428,52 +444,94 @@ bool VideoReceiveStream::Decode() {
   }
 
   if (frame) {
-    int64_t now_ms = clock_->TimeInMilliseconds();
     RTC_DCHECK_EQ(res, video_coding::FrameBuffer::ReturnReason::kFrameFound);
-    int decode_result = video_receiver_.Decode(frame.get());
-    if (decode_result == WEBRTC_VIDEO_CODEC_OK ||
-        decode_result == WEBRTC_VIDEO_CODEC_OK_REQUEST_KEYFRAME) {
-      keyframe_required_ = false;
-      frame_decoded_ = true;
-      rtp_video_stream_receiver_.FrameDecoded(frame->id.picture_id);
-
-      if (decode_result == WEBRTC_VIDEO_CODEC_OK_REQUEST_KEYFRAME)
-        RequestKeyFrame();
-    } else if (!frame_decoded_ || !keyframe_required_ ||
-               (last_keyframe_request_ms_ + kMaxWaitForKeyFrameMs < now_ms)) {
-      keyframe_required_ = true;
-      // TODO(philipel): Remove this keyframe request when downstream project
-      //                 has been fixed.
-      RequestKeyFrame();
-      last_keyframe_request_ms_ = now_ms;
-    }
+    HandleEncodedFrame(std::move(frame));
   } else {
     RTC_DCHECK_EQ(res, video_coding::FrameBuffer::ReturnReason::kTimeout);
-    int64_t now_ms = clock_->TimeInMilliseconds();
-    rtc::Optional<int64_t> last_packet_ms =
-        rtp_video_stream_receiver_.LastReceivedPacketMs();
-    rtc::Optional<int64_t> last_keyframe_packet_ms =
-        rtp_video_stream_receiver_.LastReceivedKeyframePacketMs();
-
-    // To avoid spamming keyframe requests for a stream that is not active we
-    // check if we have received a packet within the last 5 seconds.
-    bool stream_is_active = last_packet_ms && now_ms - *last_packet_ms < 5000;
-    if (!stream_is_active)
-      stats_proxy_.OnStreamInactive();
-
-    // If we recently have been receiving packets belonging to a keyframe then
-    // we assume a keyframe is currently being received.
-    bool receiving_keyframe =
-        last_keyframe_packet_ms &&
-        now_ms - *last_keyframe_packet_ms < kMaxWaitForKeyFrameMs;
-
-    if (stream_is_active && !receiving_keyframe) {
-      RTC_LOG(LS_WARNING) << "No decodable frame in " << wait_ms
-                          << " ms, requesting keyframe.";
-      RequestKeyFrame();
-    }
+    HandleFrameTimeout(wait_ms);
   }
   return true;
 }
+
+int64_t VideoReceiveStream::DecodeNextFrame() {
+  TRACE_EVENT0("webrtc", "VideoReceiveStream::DecodeNextFrame");
+  std::unique_ptr<video_coding::EncodedFrame> frame;
+  int64_t frame_wait_ms = -1;
+  video_coding::FrameBuffer::ReturnReason res =
+      frame_buffer_->PollFrame(&frame, &frame_wait_ms);
+  int64_t now_ms = clock_->TimeInMilliseconds();
+
+  if (res == video_coding::FrameBuffer::ReturnReason::kStopped)
+    return now_ms + kMaxWaitForFrameMs;
+
+  if (frame) {
+    HandleEncodedFrame(std::move(frame));
+    now_ms = clock_->TimeInMilliseconds();
+    frame_timeout_ms_ = now_ms + (keyframe_required_ ? kMaxWaitForKeyFrameMs
+                                                     : kMaxWaitForFrameMs);
+    // There may be more frames that are due.
+    return now_ms;
+  }
+
+  if (now_ms >= frame_timeout_ms_) {
+    int wait_ms =
+        keyframe_required_ ? kMaxWaitForKeyFrameMs : kMaxWaitForFrameMs;
+    HandleFrameTimeout(wait_ms);
+    frame_timeout_ms_ = now_ms + wait_ms;
+  }
+  if (frame_wait_ms == -1)
+    return frame_timeout_ms_;
+  return std::min(now_ms + frame_wait_ms, frame_timeout_ms_);
+}
+
+void VideoReceiveStream::HandleEncodedFrame(
+    std::unique_ptr<video_coding::EncodedFrame> frame) {
+  int64_t now_ms = clock_->TimeInMilliseconds();
+  // None of the decoders take a fragmented bitstream yet.
+  frame->MakeBitstreamContiguous();
+  int decode_result = video_receiver_.Decode(frame.get());
+  if (decode_result == WEBRTC_VIDEO_CODEC_OK ||
+      decode_result == WEBRTC_VIDEO_CODEC_OK_REQUEST_KEYFRAME) {
+    keyframe_required_ = false;
+    frame_decoded_ = true;
+    rtp_video_stream_receiver_.FrameDecoded(frame->id.picture_id);
+
+    if (decode_result == WEBRTC_VIDEO_CODEC_OK_REQUEST_KEYFRAME)
+      RequestKeyFrame();
+  } else if (!frame_decoded_ || !keyframe_required_ ||
+             (last_keyframe_request_ms_ + kMaxWaitForKeyFrameMs < now_ms)) {
+    keyframe_required_ = true;
+    // TODO(philipel): Remove this keyframe request when downstream project
+    //                 has been fixed.
+    RequestKeyFrame();
+    last_keyframe_request_ms_ = now_ms;
+  }
+}
+
+void VideoReceiveStream::HandleFrameTimeout(int wait_ms) {
+  int64_t now_ms = clock_->TimeInMilliseconds();
+  rtc::Optional<int64_t> last_packet_ms =
+      rtp_video_stream_receiver_.LastReceivedPacketMs();
+  rtc::Optional<int64_t> last_keyframe_packet_ms =
+      rtp_video_stream_receiver_.LastReceivedKeyframePacketMs();
+
+  // To avoid spamming keyframe requests for a stream that is not active we
+  // check if we have received a packet within the last 5 seconds.
+  bool stream_is_active = last_packet_ms && now_ms - *last_packet_ms < 5000;
+  if (!stream_is_active)
+    stats_proxy_.OnStreamInactive();
+
+  // If we recently have been receiving packets belonging to a keyframe then
+  // we assume a keyframe is currently being received.
+  bool receiving_keyframe =
+      last_keyframe_packet_ms &&
+      now_ms - *last_keyframe_packet_ms < kMaxWaitForKeyFrameMs;
+
+  if (stream_is_active && !receiving_keyframe) {
+    RTC_LOG(LS_WARNING) << "No decodable frame in " << wait_ms
+                        << " ms, requesting keyframe.";
+    RequestKeyFrame();
+  }
+}
 }  // namespace internal
 }  // namespace webrtc
@@ -26,6 +26,7 @@
 #include "video/receive_statistics_proxy.h"
 #include "video/rtp_streams_synchronizer.h"
 #include "video/rtp_video_stream_receiver.h"
+#include "video/shared_decode_executor.h"
 #include "video/transport_adapter.h"
 #include "video/video_stream_decoder.h"
 
@@ -50,14 +51,17 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
                            public KeyFrameRequestSender,
                            public video_coding::OnCompleteFrameCallback,
                            public Syncable,
-                           public CallStatsObserver {
+                           public CallStatsObserver,
+                           public SharedDecodeExecutor::Stream {
  public:
+  // If |decode_executor| is null, the stream decodes on a thread of its own.
   VideoReceiveStream(RtpStreamReceiverControllerInterface* receiver_controller,
                      int num_cpu_cores,
                      PacketRouter* packet_router,
                      VideoReceiveStream::Config config,
                      ProcessThread* process_thread,
-                     CallStats* call_stats);
+                     CallStats* call_stats,
+                     SharedDecodeExecutor* decode_executor);
   ~VideoReceiveStream() override;
 
   const Config& config() const { return config_; }
@@ -112,9 +116,14 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
   uint32_t GetPlayoutTimestamp() const override;
   void SetMinimumPlayoutDelay(int delay_ms) override;
 
+  // Implements SharedDecodeExecutor::Stream.
+  int64_t DecodeNextFrame() override;
+
  private:
   static void DecodeThreadFunction(void* ptr);
   bool Decode();
+  void HandleEncodedFrame(std::unique_ptr<video_coding::EncodedFrame> frame);
+  void HandleFrameTimeout(int wait_ms);
 
   rtc::SequencedTaskChecker worker_sequence_checker_;
   rtc::SequencedTaskChecker module_process_sequence_checker_;
@@ -126,6 +135,9 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
   Clock* const clock_;
 
   rtc::PlatformThread decode_thread_;
+  SharedDecodeExecutor* const decode_executor_;
+  // Set while the stream is added to |decode_executor_|.
+  bool decoding_on_executor_ = false;
 
   CallStats* const call_stats_;
 
@@ -160,6 +172,10 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
   bool frame_decoded_ = false;
 
   int64_t last_keyframe_request_ms_ = 0;
+
+  // When decoding on |decode_executor_|, the time at which to give up waiting
+  // for a decodable frame, like NextFrame() does on the decode thread.
+  int64_t frame_timeout_ms_ = 0;
 };
 }  // namespace internal
 }  // namespace webrtc
@@ -198,6 +198,7 @@ VideoStreamDecoderImpl::DecodeResult VideoStreamDecoderImpl::DecodeNextFrame(
               Add<kDecodeTimeMemory>(next_start_time_index_, 1);
         });
 
+    frame->MakeBitstreamContiguous();
     int32_t decode_result =
         decoder->Decode(frame->EncodedImage(),
                         false,    // missing_frame
@@ -354,6 +354,10 @@ VideoStreamEncoder::VideoStreamEncoder(
       captured_frame_count_(0),
       dropped_frame_count_(0),
       bitrate_observer_(nullptr),
+      posted_frames_waiting_for_encode_queue_(0),
+      encode_queue_(settings.pipelined_encoding
+                        ? new rtc::TaskQueue("EncodeQueue")
+                        : nullptr),
       encoder_queue_("EncoderQueue") {
   RTC_DCHECK(stats_proxy);
   RTC_DCHECK(overuse_detector_);
@@ -380,6 +384,7 @@ void VideoStreamEncoder::Stop() {
     overuse_detector_->StopCheckForOveruse();
     rate_allocator_.reset();
     bitrate_observer_ = nullptr;
+    FlushEncodeQueue();
     video_sender_.RegisterExternalEncoder(nullptr, false);
     quality_scaler_ = nullptr;
     shutdown_event_.Set();
@@ -497,6 +502,9 @@ void VideoStreamEncoder::ConfigureEncoderOnTaskQueue(
 // "soft" reconfiguration.
 void VideoStreamEncoder::ReconfigureEncoder() {
   RTC_DCHECK(pending_encoder_reconfiguration_);
+  // Frames of the old configuration are encoded before the encoder is
+  // reconfigured, as when they are encoded on |encoder_queue_|.
+  FlushEncodeQueue();
   std::vector<VideoStream> streams =
       encoder_config_.video_stream_factory->CreateEncoderStreams(
           last_frame_info_->width, last_frame_info_->height, encoder_config_);
@@ -794,7 +802,57 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
 
   overuse_detector_->FrameCaptured(out_frame, time_when_posted_us);
 
-  video_sender_.AddVideoFrame(out_frame, nullptr);
+  if (!encode_queue_) {
+    video_sender_.AddVideoFrame(out_frame, nullptr);
+    return;
+  }
+
+  // Convert the frame here rather than in VideoSender, so that it overlaps
+  // with encoding the previous frame.
+  if (out_frame.video_frame_buffer()->type() ==
+          VideoFrameBuffer::Type::kNative &&
+      settings_.encoder && !settings_.encoder->SupportsNativeHandle()) {
+    rtc::scoped_refptr<I420BufferInterface> converted_buffer =
+        out_frame.video_frame_buffer()->ToI420();
+    if (!converted_buffer) {
+      RTC_LOG(LS_ERROR) << "Frame conversion failed, dropping frame.";
+      return;
+    }
+    VideoFrame converted_frame(converted_buffer, out_frame.timestamp(),
+                               out_frame.render_time_ms(),
+                               out_frame.rotation());
+    converted_frame.set_ntp_time_ms(out_frame.ntp_time_ms());
+    out_frame = converted_frame;
+  }
+  PostFrameToEncodeQueue(out_frame);
+}
+
+void VideoStreamEncoder::PostFrameToEncodeQueue(const VideoFrame& frame) {
+  RTC_DCHECK_RUN_ON(&encoder_queue_);
+  ++posted_frames_waiting_for_encode_queue_;
+  encode_queue_->PostTask([this, frame] {
+    RTC_DCHECK_RUN_ON(encode_queue_.get());
+    const int posted_frames_waiting_for_encode_queue =
+        posted_frames_waiting_for_encode_queue_.fetch_sub(1);
+    RTC_DCHECK_GT(posted_frames_waiting_for_encode_queue, 0);
+    if (posted_frames_waiting_for_encode_queue > 1) {
+      // There is a newer frame in flight. Do not encode this frame.
+      RTC_LOG(LS_VERBOSE)
+          << "Frame dropped due to that the encoder is blocked.";
+      stats_proxy_->OnFrameDroppedInEncoderQueue();
+      return;
+    }
+    video_sender_.AddVideoFrame(frame, nullptr);
+  });
+}
+
+void VideoStreamEncoder::FlushEncodeQueue() {
+  RTC_DCHECK_RUN_ON(&encoder_queue_);
+  if (!encode_queue_)
+    return;
+  rtc::Event flushed(false, false);
+  encode_queue_->PostTask([&flushed] { flushed.Set(); });
+  flushed.Wait(rtc::Event::kForever);
 }
 
 void VideoStreamEncoder::SendKeyFrame() {
@@ -149,6 +149,11 @@ class VideoStreamEncoder : public rtc::VideoSinkInterface<VideoFrame>,
 
   void EncodeVideoFrame(const VideoFrame& frame,
                         int64_t time_when_posted_in_ms);
+  // Encodes |frame| on |encode_queue_|, unless a newer frame is posted before
+  // it gets to run.
+  void PostFrameToEncodeQueue(const VideoFrame& frame);
+  // Waits for the frames posted to |encode_queue_| to be encoded.
+  void FlushEncodeQueue();
   // Indicates wether frame should be dropped because the pixel count is too
   // large for the current bitrate configuration.
   bool DropDueToSize(uint32_t pixel_count) const RTC_RUN_ON(&encoder_queue_);
@@ -217,7 +222,10 @@ class VideoStreamEncoder : public rtc::VideoSinkInterface<VideoFrame>,
   EncoderSink* sink_;
   const VideoSendStream::Config::EncoderSettings settings_;
 
-  vcm::VideoSender video_sender_ RTC_GUARDED_BY(&encoder_queue_);
+  // Frames are added on |encode_queue_| in pipelined mode, and everything else
+  // is done on |encoder_queue_|. VideoSender serializes the calls to the
+  // encoder.
+  vcm::VideoSender video_sender_;
   const std::unique_ptr<OveruseFrameDetector> overuse_detector_
       RTC_PT_GUARDED_BY(&encoder_queue_);
   std::unique_ptr<QualityScaler> quality_scaler_
@@ -295,6 +303,12 @@ class VideoStreamEncoder : public rtc::VideoSinkInterface<VideoFrame>,
   rtc::Optional<int64_t> last_parameters_update_ms_
       RTC_GUARDED_BY(&encoder_queue_);
 
+  // Set in pipelined mode, where frames are encoded on |encode_queue_| while
+  // the next frame is prepared on |encoder_queue_|. Destroyed after
+  // |encoder_queue_|, which posts to it.
+  std::atomic<int> posted_frames_waiting_for_encode_queue_;
+  const std::unique_ptr<rtc::TaskQueue> encode_queue_;
+
   // All public methods are proxied to |encoder_queue_|. It must must be
   // destroyed first to make sure no tasks are run that use other members.
   rtc::TaskQueue encoder_queue_;
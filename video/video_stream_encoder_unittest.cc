@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <map>
 #include <utility>
 
 #include "api/video/i420_buffer.h"
@@ -255,6 +256,89 @@ class MockableSendStatisticsProxy : public SendStatisticsProxy {
   rtc::Optional<VideoSendStream::Stats> mock_stats_ RTC_GUARDED_BY(lock_);
 };
 
+// A native buffer that takes |conversion_time_ms| to convert to I420.
+class SlowNativeBuffer : public VideoFrameBuffer {
+ public:
+  SlowNativeBuffer(int width, int height, int conversion_time_ms)
+      : width_(width),
+        height_(height),
+        conversion_time_ms_(conversion_time_ms) {}
+
+  Type type() const override { return Type::kNative; }
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+
+  rtc::scoped_refptr<I420BufferInterface> ToI420() override {
+    SleepMs(conversion_time_ms_);
+    return I420Buffer::Create(width_, height_);
+  }
+
+ private:
+  const int width_;
+  const int height_;
+  const int conversion_time_ms_;
+};
+
+class SlowEncoder : public test::FakeEncoder {
+ public:
+  SlowEncoder(Clock* clock, int encode_time_ms)
+      : FakeEncoder(clock), encode_time_ms_(encode_time_ms) {}
+
+  int32_t Encode(const VideoFrame& input_image,
+                 const CodecSpecificInfo* codec_specific_info,
+                 const std::vector<FrameType>* frame_types) override {
+    SleepMs(encode_time_ms_);
+    return FakeEncoder::Encode(input_image, codec_specific_info, frame_types);
+  }
+
+ private:
+  const int encode_time_ms_;
+};
+
+// Measures the time from capture to encoded frame.
+class LatencySink : public VideoStreamEncoder::EncoderSink {
+ public:
+  explicit LatencySink(Clock* clock) : clock_(clock) {}
+
+  void OnFrameCaptured(int64_t ntp_time_ms) {
+    rtc::CritScope lock(&crit_);
+    capture_times_ms_[ntp_time_ms * 90] = clock_->TimeInMilliseconds();
+  }
+
+  int num_encoded_frames() const {
+    rtc::CritScope lock(&crit_);
+    return num_encoded_frames_;
+  }
+
+  int64_t average_latency_ms() const {
+    rtc::CritScope lock(&crit_);
+    return num_encoded_frames_ > 0 ? total_latency_ms_ / num_encoded_frames_
+                                   : 0;
+  }
+
+ private:
+  Result OnEncodedImage(const EncodedImage& encoded_image,
+                        const CodecSpecificInfo* codec_specific_info,
+                        const RTPFragmentationHeader* fragmentation) override {
+    rtc::CritScope lock(&crit_);
+    auto it = capture_times_ms_.find(encoded_image._timeStamp);
+    if (it != capture_times_ms_.end()) {
+      ++num_encoded_frames_;
+      total_latency_ms_ += clock_->TimeInMilliseconds() - it->second;
+    }
+    return Result(Result::OK, encoded_image._timeStamp);
+  }
+
+  void OnEncoderConfigurationChanged(std::vector<VideoStream> streams,
+                                     int min_transmit_bitrate_bps) override {}
+
+  Clock* const clock_;
+  rtc::CriticalSection crit_;
+  std::map<uint32_t, int64_t> capture_times_ms_ RTC_GUARDED_BY(crit_);
+  int num_encoded_frames_ RTC_GUARDED_BY(crit_) = 0;
+  int64_t total_latency_ms_ RTC_GUARDED_BY(crit_) = 0;
+};
+
 class MockBitrateObserver : public VideoBitrateAllocationObserver {
  public:
   MOCK_METHOD1(OnBitrateAllocationUpdated, void(const BitrateAllocation&));
@@ -780,6 +864,85 @@ TEST_F(VideoStreamEncoderTest, DropsPendingFramesOnSlowEncode) {
   video_stream_encoder_->Stop();
 }
 
+TEST_F(VideoStreamEncoderTest, PipelinedEncodingEncodesFramesInOrder) {
+  video_send_config_.encoder_settings.pipelined_encoding = true;
+  ConfigureEncoder(video_encoder_config_.Copy(), true /* nack_enabled */);
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+
+  for (int64_t ntp_time_ms = 1; ntp_time_ms <= 3; ++ntp_time_ms) {
+    video_source_.IncomingCapturedFrame(CreateFrame(ntp_time_ms, nullptr));
+    WaitForEncodedFrame(ntp_time_ms);
+  }
+
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest,
+       PipelinedEncodingDropsPendingFramesOnSlowEncode) {
+  video_send_config_.encoder_settings.pipelined_encoding = true;
+  ConfigureEncoder(video_encoder_config_.Copy(), true /* nack_enabled */);
+  video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+
+  fake_encoder_.BlockNextEncode();
+  video_source_.IncomingCapturedFrame(CreateFrame(1, nullptr));
+  WaitForEncodedFrame(1);
+  // Here, the encode queue is blocked in the TestEncoder waiting for a call to
+  // ContinueEncode, but the frames are still prepared on the encoder queue.
+  video_source_.IncomingCapturedFrame(CreateFrame(2, nullptr));
+  video_source_.IncomingCapturedFrame(CreateFrame(3, nullptr));
+  video_source_.IncomingCapturedFrame(CreateFrame(4, nullptr));
+  video_stream_encoder_->WaitUntilTaskQueueIsIdle();
+  fake_encoder_.ContinueEncode();
+  WaitForEncodedFrame(4);
+  EXPECT_EQ(2, stats_proxy_->GetStats().frames_dropped_by_encoder_queue);
+
+  video_stream_encoder_->Stop();
+}
+
+// Captures frames that are slow to convert to I420 at 60 fps, for an encoder
+// that is slow as well, and logs the encoded frame rate and the latency from
+// capture to encoded frame with and without pipelined encoding.
+// Disabled because it sleeps in real time for seconds. Use it for benchmarking
+// when needed.
+TEST_F(VideoStreamEncoderTest,
+       DISABLED_PipelinedEncodingWithSlowEncoderBenchmark) {
+  const int kNumFrames = 60;
+  const int kFrameIntervalMs = 1000 / 60;
+  const int kConversionTimeMs = 10;
+  const int kEncodeTimeMs = 15;
+  Clock* clock = Clock::GetRealTimeClock();
+  SlowEncoder slow_encoder(clock, kEncodeTimeMs);
+  video_send_config_.encoder_settings.encoder = &slow_encoder;
+
+  for (bool pipelined : {false, true}) {
+    video_send_config_.encoder_settings.pipelined_encoding = pipelined;
+    ConfigureEncoder(video_encoder_config_.Copy(), true /* nack_enabled */);
+    LatencySink latency_sink(clock);
+    video_stream_encoder_->SetSink(&latency_sink, false /* rotation_applied */);
+    video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);
+
+    const int64_t start_ms = clock->TimeInMilliseconds();
+    for (int i = 1; i <= kNumFrames; ++i) {
+      VideoFrame frame(new rtc::RefCountedObject<SlowNativeBuffer>(
+                           codec_width_, codec_height_, kConversionTimeMs),
+                       99, 99, kVideoRotation_0);
+      frame.set_ntp_time_ms(i);
+      latency_sink.OnFrameCaptured(frame.ntp_time_ms());
+      video_source_.IncomingCapturedFrame(frame);
+      SleepMs(kFrameIntervalMs);
+    }
+    video_stream_encoder_->Stop();
+    const int64_t elapsed_ms = clock->TimeInMilliseconds() - start_ms;
+
+    EXPECT_GT(latency_sink.num_encoded_frames(), 0);
+    RTC_LOG(LS_INFO) << (pipelined ? "Pipelined" : "Sequential") << ": "
+                     << latency_sink.num_encoded_frames() * 1000 / elapsed_ms
+                     << " fps, " << latency_sink.average_latency_ms()
+                     << " ms from capture to encoded frame.";
+  }
+  video_send_config_.encoder_settings.encoder = &fake_encoder_;
+}
+
 TEST_F(VideoStreamEncoderTest,
        ConfigureEncoderTriggersOnEncoderConfigurationChanged) {
   video_stream_encoder_->OnBitrateUpdated(kTargetBitrateBps, 0, 0);